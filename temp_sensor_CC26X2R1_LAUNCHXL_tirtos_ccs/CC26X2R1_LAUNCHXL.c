@@ -679,9 +679,9 @@ const uint_least8_t I2C_count = CC26X2R1_LAUNCHXL_I2CCOUNT;
 #include <ti/drivers/nvs/NVSSPI25X.h>
 #include <ti/drivers/nvs/NVSCC26XX.h>
 
-#define NVS_REGIONS_BASE 0x52000
+#define NVS_REGIONS_BASE 0x4E000
 #define SECTORSIZE       0x2000
-#define REGIONSIZE       (SECTORSIZE * 2)
+#define REGIONSIZE       (SECTORSIZE * 4)
 
 #ifndef Board_EXCLUDE_NVS_INTERNAL_FLASH
 
@@ -0,0 +1,392 @@
+/******************************************************************************
+
+ @file cbor.c
+
+ @brief Minimal CBOR (RFC 7049) writer and reader for compact payloads
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+/******************************************************************************
+ Includes
+ *****************************************************************************/
+#include <stddef.h>
+#include <string.h>
+
+#include "cbor.h"
+
+/******************************************************************************
+ Constants and definitions
+ *****************************************************************************/
+
+/* Additional information of the initial byte */
+#define CBOR_AI_UINT8           24
+#define CBOR_AI_UINT16          25
+#define CBOR_AI_UINT32          26
+
+/******************************************************************************
+ Local Functions
+ *****************************************************************************/
+
+/**
+ * @brief Writes the head of an item in its shortest form.
+ *
+ * @param writer writer state
+ * @param major  major type
+ * @param value  value, length, count or tag
+ *
+ * @return None
+ */
+static void Cbor_putHead(Cbor_writer_t *writer, uint8_t major, uint32_t value)
+{
+    uint8_t head[5];
+    uint8_t len;
+
+    if(value < CBOR_AI_UINT8)
+    {
+        head[0] = (uint8_t)value;
+        len = 1;
+    }
+    else if(value <= UINT8_MAX)
+    {
+        head[0] = CBOR_AI_UINT8;
+        head[1] = (uint8_t)value;
+        len = 2;
+    }
+    else if(value <= UINT16_MAX)
+    {
+        head[0] = CBOR_AI_UINT16;
+        head[1] = (uint8_t)(value >> 8);
+        head[2] = (uint8_t)value;
+        len = 3;
+    }
+    else
+    {
+        head[0] = CBOR_AI_UINT32;
+        head[1] = (uint8_t)(value >> 24);
+        head[2] = (uint8_t)(value >> 16);
+        head[3] = (uint8_t)(value >> 8);
+        head[4] = (uint8_t)value;
+        len = 5;
+    }
+    head[0] |= (uint8_t)(major << 5);
+
+    if(writer->error || (len > writer->size - writer->len))
+    {
+        writer->error = true;
+        return;
+    }
+
+    memcpy(&writer->buf[writer->len], head, len);
+    writer->len += len;
+}
+
+/******************************************************************************
+ External Functions
+ *****************************************************************************/
+
+/*
+ * Documented in cbor.h
+ */
+void Cbor_writerInit(Cbor_writer_t *writer, uint8_t *buf, uint16_t size)
+{
+    writer->buf   = buf;
+    writer->size  = size;
+    writer->len   = 0;
+    writer->error = false;
+}
+
+/*
+ * Documented in cbor.h
+ */
+uint16_t Cbor_writerLen(const Cbor_writer_t *writer)
+{
+    return writer->error ? 0 : writer->len;
+}
+
+/*
+ * Documented in cbor.h
+ */
+void Cbor_putUint(Cbor_writer_t *writer, uint32_t value)
+{
+    Cbor_putHead(writer, CBOR_UINT, value);
+}
+
+/*
+ * Documented in cbor.h
+ */
+void Cbor_putInt(Cbor_writer_t *writer, int32_t value)
+{
+    if(value < 0)
+    {
+        /* -1 - value, without overflow for INT32_MIN */
+        Cbor_putHead(writer, CBOR_NEGINT, ~(uint32_t)value);
+    }
+    else
+    {
+        Cbor_putHead(writer, CBOR_UINT, (uint32_t)value);
+    }
+}
+
+/*
+ * Documented in cbor.h
+ */
+void Cbor_putText(Cbor_writer_t *writer, const char *text, uint16_t len)
+{
+    Cbor_putHead(writer, CBOR_TEXT, len);
+
+    if(writer->error || (len > writer->size - writer->len))
+    {
+        writer->error = true;
+        return;
+    }
+
+    memcpy(&writer->buf[writer->len], text, len);
+    writer->len += len;
+}
+
+/*
+ * Documented in cbor.h
+ */
+void Cbor_putArray(Cbor_writer_t *writer, uint16_t count)
+{
+    Cbor_putHead(writer, CBOR_ARRAY, count);
+}
+
+/*
+ * Documented in cbor.h
+ */
+void Cbor_putMap(Cbor_writer_t *writer, uint16_t count)
+{
+    Cbor_putHead(writer, CBOR_MAP, count);
+}
+
+/*
+ * Documented in cbor.h
+ */
+void Cbor_putTag(Cbor_writer_t *writer, uint32_t tag)
+{
+    Cbor_putHead(writer, CBOR_TAG, tag);
+}
+
+/*
+ * Documented in cbor.h
+ */
+void Cbor_readerInit(Cbor_reader_t *reader, const uint8_t *buf, uint16_t len)
+{
+    reader->buf   = buf;
+    reader->len   = len;
+    reader->pos   = 0;
+    reader->error = false;
+}
+
+/*
+ * Documented in cbor.h
+ */
+bool Cbor_getHead(Cbor_reader_t *reader, uint8_t *major, uint32_t *value)
+{
+    uint8_t ai;
+    uint8_t len;
+
+    if(reader->error || (reader->pos >= reader->len))
+    {
+        reader->error = true;
+        return false;
+    }
+
+    *major = reader->buf[reader->pos] >> 5;
+    ai = reader->buf[reader->pos] & 0x1F;
+    reader->pos++;
+
+    if(ai < CBOR_AI_UINT8)
+    {
+        *value = ai;
+        return true;
+    }
+
+    switch(ai)
+    {
+    case CBOR_AI_UINT8:
+        len = 1;
+        break;
+    case CBOR_AI_UINT16:
+        len = 2;
+        break;
+    case CBOR_AI_UINT32:
+        len = 4;
+        break;
+    default:
+        /* 64 bit values and indefinite lengths */
+        reader->error = true;
+        return false;
+    }
+
+    if((CBOR_SIMPLE == *major) && (ai != CBOR_AI_UINT8))
+    {
+        /* floats */
+        reader->error = true;
+        return false;
+    }
+
+    if(len > reader->len - reader->pos)
+    {
+        reader->error = true;
+        return false;
+    }
+
+    *value = 0;
+    while(len-- != 0)
+    {
+        *value = (*value << 8) | reader->buf[reader->pos++];
+    }
+
+    return true;
+}
+
+/*
+ * Documented in cbor.h
+ */
+bool Cbor_getUint(Cbor_reader_t *reader, uint32_t *value)
+{
+    uint8_t major;
+
+    return (Cbor_getHead(reader, &major, value) && (CBOR_UINT == major));
+}
+
+/*
+ * Documented in cbor.h
+ */
+bool Cbor_getInt(Cbor_reader_t *reader, int32_t *value)
+{
+    uint8_t major;
+    uint32_t head;
+
+    if(!Cbor_getHead(reader, &major, &head) || (head > INT32_MAX))
+    {
+        return false;
+    }
+
+    switch(major)
+    {
+    case CBOR_UINT:
+        *value = (int32_t)head;
+        return true;
+    case CBOR_NEGINT:
+        *value = -1 - (int32_t)head;
+        return true;
+    default:
+        return false;
+    }
+}
+
+/*
+ * Documented in cbor.h
+ */
+bool Cbor_getText(Cbor_reader_t *reader, const char **text, uint16_t *len)
+{
+    uint8_t major;
+    uint32_t head;
+
+    if(!Cbor_getHead(reader, &major, &head) || (major != CBOR_TEXT))
+    {
+        return false;
+    }
+
+    if(head > (uint32_t)(reader->len - reader->pos))
+    {
+        reader->error = true;
+        return false;
+    }
+
+    *text = (const char *)&reader->buf[reader->pos];
+    *len = (uint16_t)head;
+    reader->pos += (uint16_t)head;
+
+    return true;
+}
+
+/*
+ * Documented in cbor.h
+ */
+bool Cbor_skip(Cbor_reader_t *reader)
+{
+    uint32_t items = 1;
+    uint8_t major;
+    uint32_t value;
+
+    while(items != 0)
+    {
+        if(!Cbor_getHead(reader, &major, &value))
+        {
+            return false;
+        }
+        items--;
+
+        switch(major)
+        {
+        case CBOR_BYTES:
+        case CBOR_TEXT:
+            if(value > (uint32_t)(reader->len - reader->pos))
+            {
+                reader->error = true;
+                return false;
+            }
+            reader->pos += (uint16_t)value;
+            break;
+        case CBOR_ARRAY:
+        case CBOR_MAP:
+            /* a count that cannot fit the remaining bytes is malformed */
+            if(value > (uint32_t)(reader->len - reader->pos))
+            {
+                reader->error = true;
+                return false;
+            }
+            items += (CBOR_MAP == major) ? (2 * value) : value;
+            break;
+        case CBOR_TAG:
+            items++;
+            break;
+        default:
+            break;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,239 @@
+/******************************************************************************
+
+ @file cbor.h
+
+ @brief Minimal CBOR (RFC 7049) writer and reader for compact payloads
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+#ifndef CBOR_H
+#define CBOR_H
+
+/******************************************************************************
+ Includes
+ *****************************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************
+ Constants and definitions
+ *****************************************************************************/
+
+/* Major types */
+#define CBOR_UINT               0
+#define CBOR_NEGINT             1
+#define CBOR_BYTES              2
+#define CBOR_TEXT               3
+#define CBOR_ARRAY              4
+#define CBOR_MAP                5
+#define CBOR_TAG                6
+#define CBOR_SIMPLE             7
+
+/* Tag of a decimal fraction, [exponent, mantissa] */
+#define CBOR_TAG_DECIMAL_FRACTION 4
+
+/******************************************************************************
+ Typedefs
+ *****************************************************************************/
+
+/* Writer state, items that do not fit set the error flag */
+typedef struct
+{
+    uint8_t  *buf;
+    uint16_t size;
+    uint16_t len;
+    bool     error;
+} Cbor_writer_t;
+
+/* Reader state, a malformed or unsupported item sets the error flag */
+typedef struct
+{
+    const uint8_t *buf;
+    uint16_t len;
+    uint16_t pos;
+    bool     error;
+} Cbor_reader_t;
+
+/******************************************************************************
+ External Functions
+ *****************************************************************************/
+/**
+ * @brief   Initialize a writer.
+ *
+ * @param   writer - writer state
+ * @param   buf    - output buffer
+ * @param   size   - size of the output buffer
+ */
+extern void Cbor_writerInit(Cbor_writer_t *writer, uint8_t *buf,
+                            uint16_t size);
+
+/**
+ * @brief   Length of the encoded items.
+ *
+ * @param   writer - writer state
+ *
+ * @return  Length in bytes, 0 if an item did not fit
+ */
+extern uint16_t Cbor_writerLen(const Cbor_writer_t *writer);
+
+/**
+ * @brief   Write an unsigned integer.
+ *
+ * @param   writer - writer state
+ * @param   value  - value
+ */
+extern void Cbor_putUint(Cbor_writer_t *writer, uint32_t value);
+
+/**
+ * @brief   Write a signed integer.
+ *
+ * @param   writer - writer state
+ * @param   value  - value
+ */
+extern void Cbor_putInt(Cbor_writer_t *writer, int32_t value);
+
+/**
+ * @brief   Write a text string.
+ *
+ * @param   writer - writer state
+ * @param   text   - UTF-8 text, not terminated
+ * @param   len    - length of the text in bytes
+ */
+extern void Cbor_putText(Cbor_writer_t *writer, const char *text,
+                         uint16_t len);
+
+/**
+ * @brief   Start an array, followed by its items.
+ *
+ * @param   writer - writer state
+ * @param   count  - number of items
+ */
+extern void Cbor_putArray(Cbor_writer_t *writer, uint16_t count);
+
+/**
+ * @brief   Start a map, followed by its keys and values.
+ *
+ * @param   writer - writer state
+ * @param   count  - number of key and value pairs
+ */
+extern void Cbor_putMap(Cbor_writer_t *writer, uint16_t count);
+
+/**
+ * @brief   Write a tag, followed by the tagged item.
+ *
+ * @param   writer - writer state
+ * @param   tag    - tag number
+ */
+extern void Cbor_putTag(Cbor_writer_t *writer, uint32_t tag);
+
+/**
+ * @brief   Initialize a reader.
+ *
+ * @param   reader - reader state
+ * @param   buf    - encoded items
+ * @param   len    - length of the encoded items
+ */
+extern void Cbor_readerInit(Cbor_reader_t *reader, const uint8_t *buf,
+                            uint16_t len);
+
+/**
+ * @brief   Read the head of the next item. Values above 32 bits,
+ *          indefinite lengths and floats are not supported.
+ *
+ * @param   reader - reader state
+ * @param   major  - major type of the item
+ * @param   value  - value, length, count or tag of the item
+ *
+ * @return  true if successful
+ */
+extern bool Cbor_getHead(Cbor_reader_t *reader, uint8_t *major,
+                         uint32_t *value);
+
+/**
+ * @brief   Read an unsigned integer.
+ *
+ * @param   reader - reader state
+ * @param   value  - value
+ *
+ * @return  true if the next item is an unsigned integer
+ */
+extern bool Cbor_getUint(Cbor_reader_t *reader, uint32_t *value);
+
+/**
+ * @brief   Read a signed integer.
+ *
+ * @param   reader - reader state
+ * @param   value  - value
+ *
+ * @return  true if the next item is an integer in the int32_t range
+ */
+extern bool Cbor_getInt(Cbor_reader_t *reader, int32_t *value);
+
+/**
+ * @brief   Read a text string, without copying it.
+ *
+ * @param   reader - reader state
+ * @param   text   - start of the text in the encoded items
+ * @param   len    - length of the text in bytes
+ *
+ * @return  true if the next item is a text string
+ */
+extern bool Cbor_getText(Cbor_reader_t *reader, const char **text,
+                         uint16_t *len);
+
+/**
+ * @brief   Skip the next item, including the items it contains.
+ *
+ * @param   reader - reader state
+ *
+ * @return  true if successful
+ */
+extern bool Cbor_skip(Cbor_reader_t *reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CBOR_H */
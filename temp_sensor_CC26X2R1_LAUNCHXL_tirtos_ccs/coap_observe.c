@@ -0,0 +1,455 @@
+/******************************************************************************
+
+ @file coap_observe.c
+
+ @brief CoAP Observe (RFC 7641) support for the application resources
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+/******************************************************************************
+ Includes
+ *****************************************************************************/
+#include <stddef.h>
+#include <string.h>
+
+#include <openthread/coap.h>
+#include <openthread/message.h>
+#include <openthread/platform/alarm-milli.h>
+
+#include "utils/code_utils.h"
+#include "coap_observe.h"
+
+/******************************************************************************
+ Constants and definitions
+ *****************************************************************************/
+
+#if (COAP_OBSERVE_CON_EVERY < 1) || (COAP_OBSERVE_CON_EVERY > 255)
+#error "COAP_OBSERVE_CON_EVERY must be 1 to 255"
+#endif
+
+#if (COAP_OBSERVE_MAX_LOST < 1) || (COAP_OBSERVE_MAX_LOST > 255)
+#error "COAP_OBSERVE_MAX_LOST must be 1 to 255"
+#endif
+
+/* Observe option values of a request */
+#define COAP_OBSERVE_REGISTER       0
+#define COAP_OBSERVE_DEREGISTER     1
+
+/* Observe sequence numbers are 24 bits */
+#define COAP_OBSERVE_SEQ_MASK       0x00FFFFFF
+
+/******************************************************************************
+ Local Functions
+ *****************************************************************************/
+
+/**
+ * @brief Appends an unsigned integer option in its shortest encoding.
+ *
+ * @param header CoAP header
+ * @param number option number
+ * @param value  option value
+ *
+ * @return OT_ERROR_NONE if successful, else error code
+ */
+static otError CoapObserve_appendUint(otCoapHeader *header, uint16_t number,
+                                      uint32_t value)
+{
+    otCoapOption option;
+    uint8_t buf[sizeof(uint32_t)];
+    uint8_t len = 0;
+    uint8_t shift;
+
+    for(shift = 24; ; shift -= 8)
+    {
+        if((len != 0) || ((uint8_t)(value >> shift) != 0))
+        {
+            buf[len++] = (uint8_t)(value >> shift);
+        }
+        if(0 == shift)
+        {
+            break;
+        }
+    }
+
+    option.mNumber = number;
+    option.mLength = len;
+    option.mValue  = buf;
+
+    return otCoapHeaderAppendOption(header, &option);
+}
+
+/**
+ * @brief Finds the observer registered from a client endpoint.
+ *
+ * @param obs          observer list
+ * @param aMessageInfo message info of the request
+ *
+ * @return The observer, NULL if not found
+ */
+static CoapObserve_observer_t *CoapObserve_find(CoapObserve_t *obs,
+                                                const otMessageInfo *aMessageInfo)
+{
+    uint8_t i;
+
+    for(i = 0; i < COAP_OBSERVE_MAX_OBSERVERS; i++)
+    {
+        CoapObserve_observer_t *observer = &obs->observers[i];
+
+        if(observer->inUse && (observer->port == aMessageInfo->mPeerPort) &&
+           (0 == memcmp(&observer->addr, &aMessageInfo->mPeerAddr,
+                        sizeof(observer->addr))))
+        {
+            return observer;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Response handler of a confirmable notification. A reset means the
+ *        client no longer knows the observation, so the observer is removed.
+ *        So is an observer that left COAP_OBSERVE_MAX_LOST confirmable
+ *        notifications in a row unanswered.
+ *
+ *        The CoAP layer ends an acknowledged notification with a response
+ *        timeout too, at the retransmission that the ACK saved. An
+ *        unanswered one times out after the last retransmission, no sooner
+ *        than COAP_OBSERVE_LOST_TIME after it was sent.
+ *
+ * @param aContext     the observer
+ * @param aHeader      header of the response, if any
+ * @param aMessage     response, if any
+ * @param aMessageInfo message info of the response, if any
+ * @param aResult      result of the exchange
+ *
+ * @return None
+ */
+static void CoapObserve_handleResponse(void *aContext, otCoapHeader *aHeader,
+                                       otMessage *aMessage,
+                                       const otMessageInfo *aMessageInfo,
+                                       otError aResult)
+{
+    CoapObserve_observer_t *observer = (CoapObserve_observer_t *)aContext;
+    uint32_t elapsed = otPlatAlarmMilliGetNow() - observer->conSent;
+
+    observer->conPending = false;
+    if(OT_ERROR_ABORT == aResult)
+    {
+        observer->inUse = false;
+    }
+    else if((OT_ERROR_RESPONSE_TIMEOUT == aResult) &&
+            (elapsed >= COAP_OBSERVE_LOST_TIME))
+    {
+        /* the client is gone, or no longer knows the observation */
+        if(++observer->lostCount >= COAP_OBSERVE_MAX_LOST)
+        {
+            observer->inUse = false;
+        }
+    }
+    else
+    {
+        observer->lostCount = 0;
+    }
+
+    (void)aHeader;
+    (void)aMessage;
+    (void)aMessageInfo;
+}
+
+/**
+ * @brief Sends a notification to one observer.
+ *
+ * @param obs      observer list
+ * @param observer observer to notify
+ * @param payload  representation of the resource, in the observer's format
+ * @param len      length of the representation
+ * @param now      time in milliseconds
+ *
+ * @return OT_ERROR_NONE if successful, else error code
+ */
+static otError CoapObserve_send(CoapObserve_t *obs,
+                                CoapObserve_observer_t *observer,
+                                const uint8_t *payload, uint16_t len,
+                                uint32_t now)
+{
+    otError error = OT_ERROR_NONE;
+    otMessage *message = NULL;
+    otMessageInfo messageInfo;
+    otCoapHeader header;
+    /* one confirmable notification at a time, the others go out NON */
+    bool con = (!observer->conPending &&
+                ((observer->nonCount + 1 >= COAP_OBSERVE_CON_EVERY) ||
+                 (now - observer->conTime >= COAP_OBSERVE_CON_INTERVAL)));
+
+    otCoapHeaderInit(&header, con ? OT_COAP_TYPE_CONFIRMABLE :
+                                    OT_COAP_TYPE_NON_CONFIRMABLE,
+                     OT_COAP_CODE_CONTENT);
+    otCoapHeaderSetToken(&header, observer->token, observer->tokenLen);
+    error = CoapObserve_appendUint(&header, OT_COAP_OPTION_OBSERVE, obs->seq);
+    otEXPECT(OT_ERROR_NONE == error);
+    error = CoapObserve_appendUint(&header, OT_COAP_OPTION_CONTENT_FORMAT,
+                                   observer->format);
+    otEXPECT(OT_ERROR_NONE == error);
+    error = CoapObserve_appendUint(&header, OT_COAP_OPTION_MAX_AGE,
+                                   obs->maxAge);
+    otEXPECT(OT_ERROR_NONE == error);
+    otCoapHeaderSetPayloadMarker(&header);
+
+    message = otCoapNewMessage(obs->instance, &header);
+    otEXPECT_ACTION(message != NULL, error = OT_ERROR_NO_BUFS);
+    error = otMessageAppend(message, payload, len);
+    otEXPECT(OT_ERROR_NONE == error);
+
+    memset(&messageInfo, 0, sizeof(messageInfo));
+    messageInfo.mPeerAddr = observer->addr;
+    messageInfo.mPeerPort = observer->port;
+    messageInfo.mInterfaceId = OT_NETIF_INTERFACE_ID_THREAD;
+
+    error = otCoapSendRequest(obs->instance, message, &messageInfo,
+                              con ? CoapObserve_handleResponse : NULL,
+                              con ? observer : NULL);
+    otEXPECT(OT_ERROR_NONE == error);
+
+    if(con)
+    {
+        observer->conPending = true;
+        observer->conTime = now;
+        observer->conSent = otPlatAlarmMilliGetNow();
+        observer->nonCount = 0;
+    }
+    else if(observer->nonCount < UINT8_MAX)
+    {
+        observer->nonCount++;
+    }
+
+exit:
+
+    if(error != OT_ERROR_NONE && message != NULL)
+    {
+        otMessageFree(message);
+    }
+    return error;
+}
+
+/******************************************************************************
+ External Functions
+ *****************************************************************************/
+
+/*
+ * Documented in coap_observe.h
+ */
+void CoapObserve_init(CoapObserve_t *obs, otInstance *instance,
+                      uint32_t maxAge)
+{
+    memset(obs, 0, sizeof(*obs));
+    obs->instance = instance;
+    obs->maxAge   = maxAge;
+}
+
+/*
+ * Documented in coap_observe.h
+ */
+bool CoapObserve_getOption(otCoapHeader *aHeader, uint16_t number,
+                           uint32_t *value)
+{
+    const otCoapOption *option;
+    uint16_t i;
+
+    for(option = otCoapHeaderGetFirstOption(aHeader); option != NULL;
+        option = otCoapHeaderGetNextOption(aHeader))
+    {
+        if(number == option->mNumber)
+        {
+            *value = 0;
+            for(i = 0; (i < option->mLength) && (i < sizeof(uint32_t)); i++)
+            {
+                *value = (*value << 8) | option->mValue[i];
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Documented in coap_observe.h
+ */
+bool CoapObserve_request(CoapObserve_t *obs, otCoapHeader *aHeader,
+                         const otMessageInfo *aMessageInfo,
+                         otCoapHeader *aResponseHeader,
+                         uint16_t format, uint32_t now)
+{
+    CoapObserve_observer_t *observer = CoapObserve_find(obs, aMessageInfo);
+    uint8_t tokenLen = otCoapHeaderGetTokenLength(aHeader);
+    uint32_t observe;
+    uint8_t i;
+
+    if(!CoapObserve_getOption(aHeader, OT_COAP_OPTION_OBSERVE, &observe) ||
+       (tokenLen > OT_COAP_MAX_TOKEN_LENGTH))
+    {
+        /* a plain GET */
+        observer = NULL;
+    }
+    else if(COAP_OBSERVE_DEREGISTER == observe)
+    {
+        if((observer != NULL) && (observer->tokenLen == tokenLen) &&
+           (0 == memcmp(observer->token, otCoapHeaderGetToken(aHeader),
+                        tokenLen)))
+        {
+            observer->inUse = false;
+        }
+        observer = NULL;
+    }
+    else if(observe != COAP_OBSERVE_REGISTER)
+    {
+        observer = NULL;
+    }
+    else if(NULL == observer)
+    {
+        /* a slot waiting for an ACK still belongs to its last observer */
+        for(i = 0; i < COAP_OBSERVE_MAX_OBSERVERS; i++)
+        {
+            if(!obs->observers[i].inUse && !obs->observers[i].conPending)
+            {
+                observer = &obs->observers[i];
+                observer->addr = aMessageInfo->mPeerAddr;
+                observer->port = aMessageInfo->mPeerPort;
+                observer->nonCount = 0;
+                observer->lostCount = 0;
+                observer->conTime = now;
+                break;
+            }
+        }
+    }
+
+    if(observer != NULL)
+    {
+        memcpy(observer->token, otCoapHeaderGetToken(aHeader), tokenLen);
+        observer->tokenLen = tokenLen;
+        observer->format = format;
+        observer->inUse = true;
+
+        if(CoapObserve_appendUint(aResponseHeader, OT_COAP_OPTION_OBSERVE,
+                                  obs->seq) != OT_ERROR_NONE)
+        {
+            observer->inUse = false;
+            return false;
+        }
+    }
+
+    if((CoapObserve_appendUint(aResponseHeader, OT_COAP_OPTION_CONTENT_FORMAT,
+                               format) != OT_ERROR_NONE) ||
+       ((observer != NULL) &&
+        (CoapObserve_appendUint(aResponseHeader, OT_COAP_OPTION_MAX_AGE,
+                                obs->maxAge) != OT_ERROR_NONE)))
+    {
+        if(observer != NULL)
+        {
+            observer->inUse = false;
+        }
+        return false;
+    }
+
+    return (observer != NULL);
+}
+
+/*
+ * Documented in coap_observe.h
+ */
+uint8_t CoapObserve_count(const CoapObserve_t *obs)
+{
+    uint8_t i;
+    uint8_t count = 0;
+
+    for(i = 0; i < COAP_OBSERVE_MAX_OBSERVERS; i++)
+    {
+        if(obs->observers[i].inUse)
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/*
+ * Documented in coap_observe.h
+ */
+uint8_t CoapObserve_notify(CoapObserve_t *obs,
+                           CoapObserve_encodeCB_t encode,
+                           uint32_t now)
+{
+    uint8_t payload[COAP_OBSERVE_PAYLOAD_MAX];
+    uint16_t len = 0;
+    uint32_t format = UINT32_MAX;
+    uint8_t i;
+    uint8_t sent = 0;
+
+    obs->seq = (obs->seq + 1) & COAP_OBSERVE_SEQ_MASK;
+
+    for(i = 0; i < COAP_OBSERVE_MAX_OBSERVERS; i++)
+    {
+        CoapObserve_observer_t *observer = &obs->observers[i];
+
+        if(!observer->inUse)
+        {
+            continue;
+        }
+
+        /* observers are few, re-encode when the format changes */
+        if(observer->format != format)
+        {
+            format = observer->format;
+            len = encode(observer->format, payload, sizeof(payload));
+        }
+
+        if((len != 0) &&
+           (OT_ERROR_NONE == CoapObserve_send(obs, observer, payload, len,
+                                              now)))
+        {
+            sent++;
+        }
+    }
+
+    return sent;
+}
@@ -0,0 +1,227 @@
+/******************************************************************************
+
+ @file coap_observe.h
+
+ @brief CoAP Observe (RFC 7641) support for the application resources
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+#ifndef COAP_OBSERVE_H
+#define COAP_OBSERVE_H
+
+/******************************************************************************
+ Includes
+ *****************************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <openthread/coap.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************
+ Constants and definitions
+ *****************************************************************************/
+
+/* Observers of one resource */
+#ifndef COAP_OBSERVE_MAX_OBSERVERS
+#define COAP_OBSERVE_MAX_OBSERVERS  4
+#endif
+
+/* Every Nth notification to an observer is confirmable */
+#ifndef COAP_OBSERVE_CON_EVERY
+#define COAP_OBSERVE_CON_EVERY      8
+#endif
+
+/* Longest time in milliseconds between two confirmable notifications */
+#ifndef COAP_OBSERVE_CON_INTERVAL
+#define COAP_OBSERVE_CON_INTERVAL   3600000
+#endif
+
+/* Confirmable notifications in a row that go unanswered before the observer
+ * is removed (RFC 7641 section 4.5) */
+#ifndef COAP_OBSERVE_MAX_LOST
+#define COAP_OBSERVE_MAX_LOST       1
+#endif
+
+/* A confirmable notification that times out this many milliseconds or more
+ * after it was sent went unanswered (MAX_TRANSMIT_SPAN of RFC 7252) */
+#ifndef COAP_OBSERVE_LOST_TIME
+#define COAP_OBSERVE_LOST_TIME      45000
+#endif
+
+/* Largest representation of a resource in a notification */
+#ifndef COAP_OBSERVE_PAYLOAD_MAX
+#define COAP_OBSERVE_PAYLOAD_MAX    32
+#endif
+
+/******************************************************************************
+ Typedefs
+ *****************************************************************************/
+
+/* One observer of a resource */
+typedef struct
+{
+    otIp6Address addr;       /* client address */
+    uint16_t     port;       /* client port */
+    uint8_t      token[OT_COAP_MAX_TOKEN_LENGTH]; /* token of the observation */
+    uint8_t      tokenLen;
+    uint16_t     format;     /* Content-Format of the notifications */
+    uint8_t      nonCount;   /* non-confirmable notifications since the last CON */
+    uint8_t      lostCount;  /* unanswered confirmable notifications in a row */
+    uint32_t     conTime;    /* time of the last confirmable notification */
+    uint32_t     conSent;    /* CoAP layer time the pending CON was sent */
+    bool         inUse;
+    bool         conPending; /* a confirmable notification waits for its ACK */
+} CoapObserve_observer_t;
+
+/* Observers of one resource */
+typedef struct
+{
+    otInstance *instance;
+    uint32_t    seq;         /* sequence number of the last notification */
+    uint32_t    maxAge;      /* Max-Age of the notifications in seconds */
+    CoapObserve_observer_t observers[COAP_OBSERVE_MAX_OBSERVERS];
+} CoapObserve_t;
+
+/**
+ * @brief   Encodes the representation of a resource.
+ *
+ * @param   format - Content-Format to encode in
+ * @param   buf    - output buffer
+ * @param   size   - size of the output buffer
+ *
+ * @return  Length of the representation, 0 if the format is not supported
+ */
+typedef uint16_t (*CoapObserve_encodeCB_t)(uint16_t format, uint8_t *buf,
+                                           uint16_t size);
+
+/******************************************************************************
+ External Functions
+ *****************************************************************************/
+/**
+ * @brief   Initialize the observer list of a resource.
+ *
+ * @param   obs      - observer list
+ * @param   instance - OpenThread instance to send the notifications on
+ * @param   maxAge   - Max-Age of the notifications in seconds, should cover
+ *                     the longest time between two notifications
+ */
+extern void CoapObserve_init(CoapObserve_t *obs, otInstance *instance,
+                             uint32_t maxAge);
+
+/**
+ * @brief   Read an unsigned integer option of a request, such as Accept.
+ *
+ * @param   aHeader - request header
+ * @param   number  - option number
+ * @param   value   - option value
+ *
+ * @return  true if the request has the option
+ */
+extern bool CoapObserve_getOption(otCoapHeader *aHeader, uint16_t number,
+                                  uint32_t *value);
+
+/**
+ * @brief   Process the Observe option of a GET request to the resource.
+ *          Observe 0 registers the client, or updates its token and format
+ *          if it is registered already, Observe 1 deregisters it. The
+ *          Content-Format option is appended to the response header, with
+ *          the Observe and Max-Age options if the client is registered. A
+ *          full list answers as to a plain GET.
+ *
+ *          Must be called from the CoAP resource handler, before the payload
+ *          marker is set.
+ *
+ * @param   obs            - observer list
+ * @param   aHeader        - request header
+ * @param   aMessageInfo   - request message info
+ * @param   aResponseHeader - response header
+ * @param   format         - Content-Format of the response and notifications
+ * @param   now            - time in milliseconds
+ *
+ * @return  true if the client is registered
+ */
+extern bool CoapObserve_request(CoapObserve_t *obs, otCoapHeader *aHeader,
+                                const otMessageInfo *aMessageInfo,
+                                otCoapHeader *aResponseHeader,
+                                uint16_t format, uint32_t now);
+
+/**
+ * @brief   Number of registered observers.
+ *
+ * @param   obs - observer list
+ *
+ * @return  Number of observers
+ */
+extern uint8_t CoapObserve_count(const CoapObserve_t *obs);
+
+/**
+ * @brief   Send a notification with a new representation of the resource to
+ *          all observers. Notifications are non-confirmable, except every
+ *          COAP_OBSERVE_CON_EVERY-th one and the first one after
+ *          COAP_OBSERVE_CON_INTERVAL, which check that the observer is still
+ *          interested. An observer that resets a confirmable notification, or
+ *          leaves COAP_OBSERVE_MAX_LOST of them in a row unanswered, is
+ *          removed.
+ *
+ *          Must be called with the OpenThread stack locked.
+ *
+ *          The representation is encoded once for each Content-Format the
+ *          observers asked for.
+ *
+ * @param   obs     - observer list
+ * @param   encode  - encodes the representation of the resource
+ * @param   now     - time in milliseconds
+ *
+ * @return  Number of notifications sent
+ */
+extern uint8_t CoapObserve_notify(CoapObserve_t *obs,
+                                  CoapObserve_encodeCB_t encode,
+                                  uint32_t now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COAP_OBSERVE_H */
@@ -0,0 +1,135 @@
+/******************************************************************************
+
+ @file coap_template.c
+
+ @brief Prebuilt CoAP request templates for repeated sends
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+/******************************************************************************
+ Includes
+ *****************************************************************************/
+#include <stddef.h>
+#include <string.h>
+
+#include <openthread/coap.h>
+#include <openthread/message.h>
+
+#include "otsupport/otrtosapi.h"
+#include "utils/code_utils.h"
+#include "coap_template.h"
+
+/******************************************************************************
+ External Functions
+ *****************************************************************************/
+
+/*
+ * Documented in coap_template.h
+ */
+otError CoapTemplate_init(CoapTemplate_t *tmpl, otInstance *instance,
+                          otCoapType type, otCoapCode code,
+                          const char *uriPath)
+{
+    otError error;
+
+    memset(&tmpl->messageInfo, 0, sizeof(tmpl->messageInfo));
+    tmpl->messageInfo.mInterfaceId = OT_NETIF_INTERFACE_ID_THREAD;
+    tmpl->instance = instance;
+
+    OtRtosApi_lock();
+    otCoapHeaderInit(&tmpl->header, type, code);
+    otCoapHeaderGenerateToken(&tmpl->header, COAP_TEMPLATE_TOKEN_LEN);
+    error = otCoapHeaderAppendUriPathOptions(&tmpl->header, uriPath);
+    if(OT_ERROR_NONE == error)
+    {
+        otCoapHeaderSetPayloadMarker(&tmpl->header);
+    }
+    OtRtosApi_unlock();
+
+    return error;
+}
+
+/*
+ * Documented in coap_template.h
+ */
+void CoapTemplate_setPeer(CoapTemplate_t *tmpl, const otIp6Address *addr,
+                          uint16_t port)
+{
+    tmpl->messageInfo.mPeerAddr = *addr;
+    tmpl->messageInfo.mPeerPort = port;
+}
+
+/*
+ * Documented in coap_template.h
+ */
+otError CoapTemplate_send(const CoapTemplate_t *tmpl, const void *payload,
+                          uint16_t len)
+{
+    otError error = OT_ERROR_NONE;
+    otMessage *message = NULL;
+
+    if(0 == len)
+    {
+        /* the payload marker must be followed by a payload */
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    OtRtosApi_lock();
+
+    message = otCoapNewMessage(tmpl->instance, &tmpl->header);
+    otEXPECT_ACTION(message != NULL, error = OT_ERROR_NO_BUFS);
+
+    error = otMessageAppend(message, payload, len);
+    otEXPECT(OT_ERROR_NONE == error);
+
+    error = otCoapSendRequest(tmpl->instance, message, &tmpl->messageInfo,
+                              NULL, NULL);
+
+exit:
+
+    if(error != OT_ERROR_NONE && message != NULL)
+    {
+        otMessageFree(message);
+    }
+
+    OtRtosApi_unlock();
+    return error;
+}
@@ -0,0 +1,133 @@
+/******************************************************************************
+
+ @file coap_template.h
+
+ @brief Prebuilt CoAP request templates for repeated sends
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+#ifndef COAP_TEMPLATE_H
+#define COAP_TEMPLATE_H
+
+/******************************************************************************
+ Includes
+ *****************************************************************************/
+#include <stdint.h>
+
+#include <openthread/coap.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************
+ Constants and definitions
+ *****************************************************************************/
+
+/* Token length of the templates */
+#ifndef COAP_TEMPLATE_TOKEN_LEN
+#define COAP_TEMPLATE_TOKEN_LEN     2
+#endif
+
+/******************************************************************************
+ Typedefs
+ *****************************************************************************/
+
+/* Request to one destination and URI, built once and sent many times */
+typedef struct
+{
+    otInstance    *instance;
+    otCoapHeader  header;      /* header, token, options and payload marker */
+    otMessageInfo messageInfo; /* destination */
+} CoapTemplate_t;
+
+/******************************************************************************
+ External Functions
+ *****************************************************************************/
+/**
+ * @brief   Build the header of a request template. The token is generated
+ *          once and shared by all requests sent from the template, so the
+ *          template is meant for requests that expect no response, such as
+ *          non-confirmable reports.
+ *
+ *          Locks the OpenThread stack.
+ *
+ * @param   tmpl     - template
+ * @param   instance - OpenThread instance
+ * @param   type     - message type
+ * @param   code     - request code
+ * @param   uriPath  - URI path of the request
+ *
+ * @return  OT_ERROR_NONE if successful, else error code
+ */
+extern otError CoapTemplate_init(CoapTemplate_t *tmpl, otInstance *instance,
+                                 otCoapType type, otCoapCode code,
+                                 const char *uriPath);
+
+/**
+ * @brief   Set the destination of a template, on the Thread interface.
+ *
+ * @param   tmpl - template
+ * @param   addr - destination address
+ * @param   port - destination port
+ */
+extern void CoapTemplate_setPeer(CoapTemplate_t *tmpl,
+                                 const otIp6Address *addr, uint16_t port);
+
+/**
+ * @brief   Send a request from a template with a payload. The message is
+ *          cloned from the prebuilt header, filled and sent with the
+ *          OpenThread stack locked once.
+ *
+ * @param   tmpl    - template
+ * @param   payload - payload of the request
+ * @param   len     - length of the payload, not 0
+ *
+ * @return  OT_ERROR_NONE if the request was sent, else error code
+ */
+extern otError CoapTemplate_send(const CoapTemplate_t *tmpl,
+                                 const void *payload, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COAP_TEMPLATE_H */
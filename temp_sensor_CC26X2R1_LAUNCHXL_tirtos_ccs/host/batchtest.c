@@ -0,0 +1,262 @@
+/******************************************************************************
+
+ @file batchtest.c
+
+ @brief Decoder test of the batched temperature report payload
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+//*****************************************************************************
+// Overview
+//*****************************************************************************
+/*
+Fills sample rings of report_batch.c of random sizes with random numbers of
+samples, at random intervals and across the wrap of the millisecond clock,
+encodes them as the sensor reports them and decodes the payload as the
+receiver does. The decoded report must hold the newest samples of the ring,
+oldest first, with their values and their times to the 100 ms of the age
+unit. A fixed report is compared byte by byte with the layout in README.md,
+and truncated or otherwise malformed payloads must be rejected.
+*/
+
+//*****************************************************************************
+// Includes
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "report_batch.h"
+
+//*****************************************************************************
+// Constants and Definitions
+//*****************************************************************************
+
+#define BATCH_TESTS     100000  // Random reports checked
+#define BATCH_MAXSIZE   32      // Largest ring tested
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static ReportBatch_sample_t ring[BATCH_MAXSIZE];
+static ReportBatch_sample_t added[3 * BATCH_MAXSIZE];
+static ReportBatch_sample_t decoded[BATCH_MAXSIZE];
+static uint8_t payload[REPORT_BATCH_LEN(BATCH_MAXSIZE) + 1];
+
+// Samples of 70 and -5 F at 1 s and 11 s, reported at 21.05 s
+static const uint8_t golden[] = {
+    0x01, 0x02, 0x00, 0x00, 0x52, 0x3A,
+    0x00, 0xC8, 0x00, 0x46,
+    0x00, 0x64, 0xFF, 0xFB,
+};
+
+//*****************************************************************************
+// Functions
+//*****************************************************************************
+
+static int batchGolden(void)
+{
+    ReportBatch_t batch;
+    uint32_t now;
+    uint16_t len;
+
+    ReportBatch_init(&batch, ring, 4);
+    ReportBatch_add(&batch, 70, 1000);
+    ReportBatch_add(&batch, -5, 11000);
+    len = ReportBatch_encode(&batch, payload, 21050);
+    if ((len != sizeof(golden)) || (memcmp(payload, golden, len) != 0))
+    {
+        printf("FAIL: payload does not match the documented layout\n");
+        return (1);
+    }
+
+    if ((ReportBatch_decode(golden, sizeof(golden), &now, decoded, 4) != 2) ||
+        (now != 21050) ||
+        (decoded[0].time != 1050) || (decoded[0].value != 70) ||
+        (decoded[1].time != 11050) || (decoded[1].value != -5))
+    {
+        printf("FAIL: documented payload decoded wrong\n");
+        return (1);
+    }
+
+    ReportBatch_clear(&batch);
+    len = ReportBatch_encode(&batch, payload, 30000);
+    if ((len != REPORT_BATCH_HDR_LEN) ||
+        (ReportBatch_decode(payload, len, &now, decoded, 4) != 0))
+    {
+        printf("FAIL: cleared ring still reports samples\n");
+        return (1);
+    }
+
+    return (0);
+}
+
+static int batchMalformed(void)
+{
+    uint8_t bad[sizeof(golden) + 1];
+    uint32_t now;
+    uint16_t len;
+
+    // Every truncation, one byte too many, a wrong format or count
+    for (len = 0; len <= sizeof(bad); len++)
+    {
+        memcpy(bad, golden, sizeof(golden));
+        bad[sizeof(golden)] = 0;
+        if ((len != sizeof(golden)) &&
+            (ReportBatch_decode(bad, len, &now, decoded, 4) != -1))
+        {
+            printf("FAIL: %u byte payload accepted\n", len);
+            return (1);
+        }
+    }
+
+    memcpy(bad, golden, sizeof(golden));
+    bad[0] = REPORT_BATCH_FORMAT + 1;
+    if (ReportBatch_decode(bad, sizeof(golden), &now, decoded, 4) != -1)
+    {
+        printf("FAIL: unknown format accepted\n");
+        return (1);
+    }
+
+    memcpy(bad, golden, sizeof(golden));
+    bad[1] = 3;
+    if (ReportBatch_decode(bad, sizeof(golden), &now, decoded, 4) != -1)
+    {
+        printf("FAIL: sample count beyond the payload accepted\n");
+        return (1);
+    }
+
+    if (ReportBatch_decode(golden, sizeof(golden), &now, decoded, 1) != -1)
+    {
+        printf("FAIL: more samples than the receiver has room for\n");
+        return (1);
+    }
+
+    return (0);
+}
+
+static int batchRandom(unsigned long t)
+{
+    ReportBatch_t batch;
+    uint8_t size = 1 + rand() % BATCH_MAXSIZE;
+    int n = rand() % (3 * size + 1);
+    uint32_t time = 0xFFF00000U + (uint32_t)rand() * 2;
+    uint32_t now;
+    int expect = (n < size) ? n : size;
+    int count;
+    int i;
+
+    ReportBatch_init(&batch, ring, size);
+    for (i = 0; i < n; i++)
+    {
+        // mostly seconds apart, sometimes longer than the largest age
+        time += (rand() % 16 == 0) ? (uint32_t)rand() % 10000000U :
+                                     (uint32_t)rand() % 20000U;
+        added[i].time = time;
+        added[i].value = (int16_t)rand();
+        ReportBatch_add(&batch, added[i].value, time);
+    }
+    now = time + rand() % 60000;
+
+    if (ReportBatch_encode(&batch, payload, now) != REPORT_BATCH_LEN(expect))
+    {
+        printf("FAIL: report %lu, ring of %u with %d samples: length\n",
+               t, size, n);
+        return (1);
+    }
+
+    count = ReportBatch_decode(payload, REPORT_BATCH_LEN(expect), &now,
+                               decoded, size);
+    if (count != expect)
+    {
+        printf("FAIL: report %lu, ring of %u with %d samples: decoded %d\n",
+               t, size, n, count);
+        return (1);
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        const ReportBatch_sample_t *orig = &added[n - count + i];
+        uint32_t age = now - orig->time;
+        uint32_t late = decoded[i].time - orig->time;
+
+        if ((decoded[i].value != orig->value) ||
+            ((age < (REPORT_BATCH_AGE_MAX + 1) * REPORT_BATCH_AGE_UNIT) ?
+             (late >= REPORT_BATCH_AGE_UNIT) :
+             (decoded[i].time !=
+              now - REPORT_BATCH_AGE_MAX * REPORT_BATCH_AGE_UNIT)))
+        {
+            printf("FAIL: report %lu, sample %d: %d at %u decoded as "
+                   "%d at %u\n", t, i, orig->value, orig->time,
+                   decoded[i].value, decoded[i].time);
+            return (1);
+        }
+    }
+
+    return (0);
+}
+
+int main(void)
+{
+    unsigned long t;
+
+    if (batchGolden() || batchMalformed())
+    {
+        return (1);
+    }
+
+    srand(1);
+    for (t = 0; t < BATCH_TESTS; t++)
+    {
+        if (batchRandom(t))
+        {
+            return (1);
+        }
+    }
+
+    printf("Batched reports: %d random reports decoded, %d byte payload "
+           "for %d samples\n", BATCH_TESTS, REPORT_BATCH_LEN(8), 8);
+
+    return (0);
+}
@@ -0,0 +1,498 @@
+/******************************************************************************
+
+ @file cbortest.c
+
+ @brief Test of the CBOR writer and reader
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+//*****************************************************************************
+// Overview
+//*****************************************************************************
+/*
+Checks cbor.c against the examples of RFC 7049 appendix A, then writes
+random sequences of items and reads them back. The temperature map of
+README.md is written as tempsensor.c writes it and read back as a client
+reads it, and the largest map must fit a notification
+(COAP_OBSERVE_PAYLOAD_MAX). Items that do not fit the writer's buffer must
+fail the whole write, and the reader must reject malformed and unsupported
+input and never read past its end, also on random bytes.
+*/
+
+//*****************************************************************************
+// Includes
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cbor.h"
+#include "coap_observe.h"
+
+//*****************************************************************************
+// Constants and Definitions
+//*****************************************************************************
+
+#define CBOR_TESTS      100000  // Random item sequences written and read
+#define CBOR_ITEMS      16      // Most items in a sequence
+#define CBOR_FUZZ       200000  // Random inputs read
+#define CBOR_BUFLEN     256
+
+//*****************************************************************************
+// Typedefs
+//*****************************************************************************
+
+// RFC 7049 appendix A example of an integer
+typedef struct
+{
+    int64_t value;
+    const char *hex;
+} cborExample_t;
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static const cborExample_t examples[] = {
+    { 0, "00" }, { 1, "01" }, { 10, "0a" }, { 23, "17" }, { 24, "1818" },
+    { 25, "1819" }, { 100, "1864" }, { 1000, "1903e8" },
+    { 1000000, "1a000f4240" }, { 4294967295LL, "1affffffff" },
+    { -1, "20" }, { -10, "29" }, { -100, "3863" }, { -1000, "3903e7" },
+    { INT32_MIN, "3a7fffffff" }, { INT32_MAX, "1a7fffffff" },
+};
+
+static uint8_t buf[CBOR_BUFLEN];
+static uint8_t expect[CBOR_BUFLEN];
+
+//*****************************************************************************
+// Functions
+//*****************************************************************************
+
+static void cborCheck(int ok, const char *what)
+{
+    if (!ok)
+    {
+        printf("FAIL: %s\n", what);
+        exit(1);
+    }
+}
+
+static uint16_t cborHex(const char *hex, uint8_t *out)
+{
+    uint16_t len = 0;
+    unsigned byte;
+
+    while ((hex[0] != '\0') && (sscanf(hex, "%2x", &byte) == 1))
+    {
+        out[len++] = (uint8_t)byte;
+        hex += 2;
+    }
+
+    return (len);
+}
+
+static void cborExamples(void)
+{
+    Cbor_writer_t writer;
+    Cbor_reader_t reader;
+    uint16_t len;
+    uint32_t u;
+    int32_t i;
+    size_t k;
+
+    for (k = 0; k < sizeof(examples) / sizeof(examples[0]); k++)
+    {
+        int64_t value = examples[k].value;
+
+        len = cborHex(examples[k].hex, expect);
+        Cbor_writerInit(&writer, buf, sizeof(buf));
+        if (value > INT32_MAX)
+        {
+            Cbor_putUint(&writer, (uint32_t)value);
+        }
+        else
+        {
+            Cbor_putInt(&writer, (int32_t)value);
+        }
+        if ((Cbor_writerLen(&writer) != len) || (memcmp(buf, expect, len)))
+        {
+            printf("FAIL: %lld is not written as %s\n", (long long)value,
+                   examples[k].hex);
+            exit(1);
+        }
+
+        Cbor_readerInit(&reader, buf, len);
+        if (value > INT32_MAX)
+        {
+            cborCheck(Cbor_getUint(&reader, &u) && (u == value),
+                      "example read back as unsigned");
+        }
+        else
+        {
+            cborCheck(Cbor_getInt(&reader, &i) && (i == value),
+                      "example read back as signed");
+        }
+        cborCheck(reader.pos == len, "example not read to its end");
+    }
+
+    // "IETF", 4([-2, 27315]) and {1: 2, 3: 4}
+    Cbor_writerInit(&writer, buf, sizeof(buf));
+    Cbor_putText(&writer, "IETF", 4);
+    Cbor_putTag(&writer, CBOR_TAG_DECIMAL_FRACTION);
+    Cbor_putArray(&writer, 2);
+    Cbor_putInt(&writer, -2);
+    Cbor_putInt(&writer, 27315);
+    Cbor_putMap(&writer, 2);
+    Cbor_putUint(&writer, 1);
+    Cbor_putUint(&writer, 2);
+    Cbor_putUint(&writer, 3);
+    Cbor_putUint(&writer, 4);
+    len = cborHex("6449455446" "c48221196ab3" "a201020304", expect);
+    cborCheck((Cbor_writerLen(&writer) == len) &&
+              (memcmp(buf, expect, len) == 0),
+              "text, tag, array or map examples");
+}
+
+static void cborOverflow(void)
+{
+    Cbor_writer_t writer;
+    uint16_t size;
+
+    // a text needs its head too
+    Cbor_writerInit(&writer, buf, 4);
+    Cbor_putText(&writer, "IETF", 4);
+    cborCheck(Cbor_writerLen(&writer) == 0, "text without room for its head");
+
+    // an item that does not fit fails the items after it too
+    Cbor_writerInit(&writer, buf, 5);
+    Cbor_putUint(&writer, 1);
+    Cbor_putUint(&writer, 1000000);
+    cborCheck(Cbor_writerLen(&writer) == 0, "value without room");
+    Cbor_putUint(&writer, 1);
+    cborCheck(Cbor_writerLen(&writer) == 0, "write after an overflow");
+
+    // every size short of the whole sequence fails, without writing past it
+    for (size = 0; size < 11; size++)
+    {
+        memset(buf, 0xEE, sizeof(buf));
+        Cbor_writerInit(&writer, buf, size);
+        Cbor_putText(&writer, "IETF", 4);
+        Cbor_putInt(&writer, INT32_MIN);
+        Cbor_putUint(&writer, 0);
+        cborCheck(Cbor_writerLen(&writer) == 0, "short buffer accepted");
+        cborCheck(buf[size] == 0xEE, "write past the end of the buffer");
+    }
+}
+
+// The temperature map of tempsensor.c, with its README.md example
+static void cborTemperature(void)
+{
+    static const uint32_t keys[] = { 1, 2, 3, 4, 5 };
+    Cbor_writer_t writer;
+    Cbor_reader_t reader;
+    const char *text;
+    uint16_t len;
+    uint32_t count;
+    uint32_t u;
+    int32_t i;
+    uint8_t major;
+    uint8_t k;
+
+    Cbor_writerInit(&writer, buf, COAP_OBSERVE_PAYLOAD_MAX);
+    Cbor_putMap(&writer, 5);
+    Cbor_putUint(&writer, keys[0]);
+    Cbor_putTag(&writer, CBOR_TAG_DECIMAL_FRACTION);
+    Cbor_putArray(&writer, 2);
+    Cbor_putInt(&writer, 0);
+    Cbor_putInt(&writer, 21);
+    Cbor_putUint(&writer, keys[1]);
+    Cbor_putText(&writer, "Cel", 3);
+    Cbor_putUint(&writer, keys[2]);
+    Cbor_putUint(&writer, 123456789);
+    Cbor_putUint(&writer, keys[3]);
+    Cbor_putUint(&writer, 300);
+    Cbor_putUint(&writer, keys[4]);
+    Cbor_putUint(&writer, 0);
+    len = cborHex("a5" "01c4820015" "026343656c" "031a075bcd15" "0419012c"
+                  "0500", expect);
+    cborCheck((len == 23) && (Cbor_writerLen(&writer) == len) &&
+              (memcmp(buf, expect, len) == 0),
+              "temperature map of README.md");
+
+    // read as a client does, skipping keys it does not know
+    Cbor_readerInit(&reader, buf, len);
+    cborCheck(Cbor_getHead(&reader, &major, &count) && (major == CBOR_MAP) &&
+              (count == 5), "temperature map head");
+    for (k = 0; k < count; k++)
+    {
+        cborCheck(Cbor_getUint(&reader, &u) && (u == keys[k]), "map key");
+        switch (u)
+        {
+            case 1:
+                cborCheck(Cbor_getHead(&reader, &major, &u) &&
+                          (major == CBOR_TAG) &&
+                          (u == CBOR_TAG_DECIMAL_FRACTION) &&
+                          Cbor_getHead(&reader, &major, &u) &&
+                          (major == CBOR_ARRAY) && (u == 2) &&
+                          Cbor_getInt(&reader, &i) && (i == 0) &&
+                          Cbor_getInt(&reader, &i) && (i == 21),
+                          "temperature value");
+                break;
+            case 2:
+                cborCheck(Cbor_getText(&reader, &text, &len) &&
+                          (len == 3) && (memcmp(text, "Cel", 3) == 0),
+                          "temperature unit");
+                break;
+            case 3:
+                cborCheck(Cbor_getUint(&reader, &u) && (u == 123456789),
+                          "sample time");
+                break;
+            default:
+                cborCheck(Cbor_skip(&reader), "skip of a map value");
+                break;
+        }
+    }
+    cborCheck(!reader.error && (reader.pos == reader.len),
+              "temperature map not read to its end");
+
+    // the largest map fits a notification
+    Cbor_writerInit(&writer, buf, COAP_OBSERVE_PAYLOAD_MAX);
+    Cbor_putMap(&writer, 5);
+    Cbor_putUint(&writer, 1);
+    Cbor_putTag(&writer, CBOR_TAG_DECIMAL_FRACTION);
+    Cbor_putArray(&writer, 2);
+    Cbor_putInt(&writer, 0);
+    Cbor_putInt(&writer, INT32_MIN);
+    Cbor_putUint(&writer, 2);
+    Cbor_putText(&writer, "Cel", 3);
+    Cbor_putUint(&writer, 3);
+    Cbor_putUint(&writer, UINT32_MAX);
+    Cbor_putUint(&writer, 4);
+    Cbor_putUint(&writer, UINT32_MAX);
+    Cbor_putUint(&writer, 5);
+    Cbor_putUint(&writer, UINT8_MAX);
+    cborCheck(Cbor_writerLen(&writer) != 0,
+              "largest temperature map does not fit a notification");
+}
+
+// Nested items are skipped as a whole
+static void cborSkip(void)
+{
+    Cbor_reader_t reader;
+    uint16_t len;
+    uint32_t u;
+
+    // {1: [1, [2, 3], {"a": 1}], 2: 4([-2, 500])} then 3
+    len = cborHex("a2" "0183018202" "03a1616101" "02c482211901f4" "03", buf);
+    Cbor_readerInit(&reader, buf, len);
+    cborCheck(Cbor_skip(&reader) && Cbor_getUint(&reader, &u) && (u == 3) &&
+              (reader.pos == len), "skip of nested items");
+
+    Cbor_readerInit(&reader, buf, len - 2);
+    cborCheck(!Cbor_skip(&reader), "skip of items cut short");
+}
+
+static void cborMalformed(void)
+{
+    static const char *const bad[] = {
+        "6449455446",           // text cut short (read with len - 1)
+        "1b0000000100000000",   // 64 bit value
+        "9f01ff",               // indefinite length array
+        "fa47c35000",           // float
+        "9a7fffffff",           // array count beyond the input
+        "19ff",                 // value cut short
+        "1c",                   // reserved additional information
+    };
+    Cbor_reader_t reader;
+    const char *text;
+    uint16_t len;
+    uint32_t u;
+    int32_t i;
+    size_t k;
+
+    for (k = 0; k < sizeof(bad) / sizeof(bad[0]); k++)
+    {
+        len = cborHex(bad[k], buf);
+        Cbor_readerInit(&reader, buf, (k == 0) ? len - 1 : len);
+        if (Cbor_skip(&reader) || !reader.error)
+        {
+            printf("FAIL: malformed %s accepted\n", bad[k]);
+            exit(1);
+        }
+    }
+
+    len = cborHex("6449455446", buf);
+    Cbor_readerInit(&reader, buf, len - 1);
+    cborCheck(!Cbor_getText(&reader, &text, &len) && reader.error,
+              "text cut short read");
+
+    len = cborHex("1a80000000", buf);
+    Cbor_readerInit(&reader, buf, len);
+    cborCheck(!Cbor_getInt(&reader, &i), "integer beyond int32_t read");
+
+    len = cborHex("20", buf);
+    Cbor_readerInit(&reader, buf, len);
+    cborCheck(!Cbor_getUint(&reader, &u), "negative integer read unsigned");
+
+    // simple values are skipped, the end of the input is an error
+    len = cborHex("f5f6", buf);
+    Cbor_readerInit(&reader, buf, len);
+    cborCheck(Cbor_skip(&reader) && Cbor_skip(&reader) && !Cbor_skip(&reader),
+              "simple values");
+}
+
+// Writes a random sequence of items, and reads it back
+static void cborRandom(unsigned long t)
+{
+    uint8_t kinds[CBOR_ITEMS];
+    uint32_t values[CBOR_ITEMS];
+    char text[CBOR_ITEMS][8];
+    Cbor_writer_t writer;
+    Cbor_reader_t reader;
+    const char *s;
+    uint8_t n = 1 + rand() % CBOR_ITEMS;
+    uint16_t len;
+    uint32_t u;
+    int32_t i;
+    uint8_t k;
+
+    Cbor_writerInit(&writer, buf, sizeof(buf));
+    for (k = 0; k < n; k++)
+    {
+        // values of every head length
+        values[k] = ((uint32_t)rand() << 16 ^ rand()) >> (rand() % 32);
+        kinds[k] = rand() % 3;
+        switch (kinds[k])
+        {
+            case 0:
+                Cbor_putUint(&writer, values[k]);
+                break;
+            case 1:
+                Cbor_putInt(&writer, (int32_t)values[k]);
+                break;
+            default:
+                values[k] %= sizeof(text[k]);
+                memset(text[k], 'a' + k, values[k]);
+                Cbor_putText(&writer, text[k], values[k]);
+                break;
+        }
+    }
+    len = Cbor_writerLen(&writer);
+
+    Cbor_readerInit(&reader, buf, len);
+    for (k = 0; k < n; k++)
+    {
+        int ok;
+
+        switch (kinds[k])
+        {
+            case 0:
+                ok = Cbor_getUint(&reader, &u) && (u == values[k]);
+                break;
+            case 1:
+                ok = Cbor_getInt(&reader, &i) && (i == (int32_t)values[k]);
+                break;
+            default:
+                ok = Cbor_getText(&reader, &s, &len) &&
+                     (len == values[k]) && (memcmp(s, text[k], len) == 0);
+                break;
+        }
+        if (!ok)
+        {
+            printf("FAIL: sequence %lu, item %u of kind %u, value %u\n", t,
+                   k, kinds[k], values[k]);
+            exit(1);
+        }
+    }
+    cborCheck(reader.pos == reader.len, "random sequence not read to its end");
+}
+
+// The reader must stop within random input
+static void cborFuzz(void)
+{
+    Cbor_reader_t reader;
+    uint8_t *in;
+    unsigned long t;
+    uint16_t len;
+    uint16_t k;
+
+    for (t = 0; t < CBOR_FUZZ; t++)
+    {
+        len = rand() % 12;
+        // exactly sized, so that a read past the end is seen by ASan
+        in = malloc((len != 0) ? len : 1);
+        for (k = 0; k < len; k++)
+        {
+            in[k] = rand();
+        }
+        Cbor_readerInit(&reader, in, len);
+        while (Cbor_skip(&reader))
+        {
+        }
+        cborCheck(reader.pos <= len, "read past the end of the input");
+        free(in);
+    }
+}
+
+int main(void)
+{
+    unsigned long t;
+
+    cborExamples();
+    cborOverflow();
+    cborTemperature();
+    cborSkip();
+    cborMalformed();
+
+    srand(1);
+    for (t = 0; t < CBOR_TESTS; t++)
+    {
+        cborRandom(t);
+    }
+    cborFuzz();
+
+    printf("CBOR: RFC 7049 examples, %d random sequences and %d random "
+           "inputs\n", CBOR_TESTS, CBOR_FUZZ);
+
+    return (0);
+}
@@ -0,0 +1,344 @@
+/******************************************************************************
+
+ @file coapbench.c
+
+ @brief Benchmark of the CoAP request templates
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+//*****************************************************************************
+// Overview
+//*****************************************************************************
+/*
+Sends the same report with CoapTemplate_send() of coap_template.c and with
+the sequence tempSensorReport() used before the templates, which built the
+header, token, Uri-Path options and payload marker for every report and
+took the stack lock around each step. Both run against the OpenThread
+stand-in of hostcoap.c, which counts the lock round-trips.
+
+It checks that the two send the same message, apart from the message ID and
+the token, that a template send takes the lock once, also when it fails,
+makes every stack call with the lock held and leaks no message buffer. It
+then times -n reports each way and reports the time and the lock
+round-trips per report.
+*/
+
+//*****************************************************************************
+// Includes
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <openthread/coap.h>
+#include <openthread/message.h>
+
+#include "otsupport/otrtosapi.h"
+#include "utils/code_utils.h"
+#include "coap_template.h"
+#include "hostcoap.h"
+#include "report_batch.h"
+
+//*****************************************************************************
+// Constants and Definitions
+//*****************************************************************************
+
+#define BENCH_URI       "evaq/id"   // THERMOSTAT_TEMP_URI
+#define BENCH_REPORTS   1000000     // Default reports timed each way
+#define BENCH_SAMPLES   8           // Samples of the report payload
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static otInstance *instance = (otInstance *)&instance;
+static const otIp6Address peer = {
+    { { 0xFD, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFE, 0, 0xB4, 0x01 } }
+};
+static uint8_t payload[REPORT_BATCH_LEN(BENCH_SAMPLES)];
+
+//*****************************************************************************
+// Functions
+//*****************************************************************************
+
+static void benchUsage(void)
+{
+    fprintf(stderr,
+            "usage: coapbench [options]\n"
+            "  -n count   reports timed each way (default %d)\n",
+            BENCH_REPORTS);
+    exit(2);
+}
+
+static void benchCheck(int ok, const char *what)
+{
+    if (!ok)
+    {
+        printf("FAIL: %s\n", what);
+        exit(1);
+    }
+}
+
+static double benchNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1e9 + ts.tv_nsec);
+}
+
+// The report request as tempSensorReport() sent it before the templates
+static otError benchRebuilt(const uint8_t *data, uint16_t len)
+{
+    otError error = OT_ERROR_NONE;
+    otMessage *requestMessage = NULL;
+    otMessageInfo messageInfo;
+    otCoapHeader requestHeader;
+
+    OtRtosApi_lock();
+    otCoapHeaderInit(&requestHeader, OT_COAP_TYPE_NON_CONFIRMABLE,
+                     OT_COAP_CODE_POST);
+    otCoapHeaderGenerateToken(&requestHeader, COAP_TEMPLATE_TOKEN_LEN);
+    error = otCoapHeaderAppendUriPathOptions(&requestHeader, BENCH_URI);
+    OtRtosApi_unlock();
+    otEXPECT(OT_ERROR_NONE == error);
+
+    OtRtosApi_lock();
+    otCoapHeaderSetPayloadMarker(&requestHeader);
+    requestMessage = otCoapNewMessage(instance, &requestHeader);
+    OtRtosApi_unlock();
+    otEXPECT_ACTION(requestMessage != NULL, error = OT_ERROR_NO_BUFS);
+
+    OtRtosApi_lock();
+    error = otMessageAppend(requestMessage, data, len);
+    OtRtosApi_unlock();
+    otEXPECT(OT_ERROR_NONE == error);
+
+    memset(&messageInfo, 0, sizeof(messageInfo));
+    messageInfo.mPeerAddr = peer;
+    messageInfo.mPeerPort = OT_DEFAULT_COAP_PORT;
+    messageInfo.mInterfaceId = OT_NETIF_INTERFACE_ID_THREAD;
+
+    OtRtosApi_lock();
+    error = otCoapSendRequest(instance, requestMessage, &messageInfo, NULL,
+                              NULL);
+    OtRtosApi_unlock();
+
+exit:
+
+    if (error != OT_ERROR_NONE && requestMessage != NULL)
+    {
+        OtRtosApi_lock();
+        otMessageFree(requestMessage);
+        OtRtosApi_unlock();
+    }
+    return (error);
+}
+
+// The last message sent, parsed as the thermostat receives it
+static const HOSTCOAP_sent_t *benchLast(otCoapHeader *header,
+                                        const uint8_t **data, uint16_t *len)
+{
+    HOSTCOAP_counts_t counts;
+    const HOSTCOAP_sent_t *sent;
+
+    HOSTCOAP_getCounts(&counts);
+    sent = HOSTCOAP_sent(counts.sent - 1);
+    benchCheck((sent != NULL) &&
+               (HOSTCOAP_parse(sent, header, data, len) == OT_ERROR_NONE),
+               "sent message does not parse");
+    return (sent);
+}
+
+static void benchSame(CoapTemplate_t *tmpl)
+{
+    otCoapHeader oldHdr;
+    otCoapHeader newHdr;
+    const HOSTCOAP_sent_t *sent;
+    const otCoapOption *oldOpt;
+    const otCoapOption *newOpt;
+    const uint8_t *oldData;
+    const uint8_t *newData;
+    otMessageInfo oldInfo;
+    uint16_t oldLen;
+    uint16_t newLen;
+
+    benchCheck(benchRebuilt(payload, sizeof(payload)) == OT_ERROR_NONE,
+               "rebuilt report not sent");
+    sent = benchLast(&oldHdr, &oldData, &oldLen);
+    oldInfo = sent->info;
+    benchCheck(CoapTemplate_send(tmpl, payload, sizeof(payload)) ==
+               OT_ERROR_NONE, "template report not sent");
+    sent = benchLast(&newHdr, &newData, &newLen);
+
+    benchCheck((otCoapHeaderGetType(&newHdr) == otCoapHeaderGetType(&oldHdr)) &&
+               (otCoapHeaderGetCode(&newHdr) == otCoapHeaderGetCode(&oldHdr)) &&
+               (otCoapHeaderGetTokenLength(&newHdr) ==
+                otCoapHeaderGetTokenLength(&oldHdr)) &&
+               (otCoapHeaderGetMessageId(&newHdr) !=
+                otCoapHeaderGetMessageId(&oldHdr)),
+               "type, code, token length or message ID differ");
+
+    for (oldOpt = otCoapHeaderGetFirstOption(&oldHdr),
+         newOpt = otCoapHeaderGetFirstOption(&newHdr);
+         (oldOpt != NULL) && (newOpt != NULL);
+         oldOpt = otCoapHeaderGetNextOption(&oldHdr),
+         newOpt = otCoapHeaderGetNextOption(&newHdr))
+    {
+        benchCheck((newOpt->mNumber == oldOpt->mNumber) &&
+                   (newOpt->mLength == oldOpt->mLength) &&
+                   (memcmp(newOpt->mValue, oldOpt->mValue,
+                           newOpt->mLength) == 0), "options differ");
+    }
+    benchCheck((oldOpt == NULL) && (newOpt == NULL), "option count differs");
+
+    benchCheck((newLen == oldLen) && (memcmp(newData, oldData, newLen) == 0),
+               "payloads differ");
+    benchCheck((memcmp(&sent->info.mPeerAddr, &oldInfo.mPeerAddr,
+                       sizeof(oldInfo.mPeerAddr)) == 0) &&
+               (sent->info.mPeerPort == oldInfo.mPeerPort) &&
+               (sent->info.mInterfaceId == oldInfo.mInterfaceId),
+               "destinations differ");
+}
+
+static void benchFailures(CoapTemplate_t *tmpl)
+{
+    HOSTCOAP_counts_t counts;
+
+    // an empty payload is refused before the stack is locked
+    HOSTCOAP_reset();
+    benchCheck(CoapTemplate_send(tmpl, payload, 0) == OT_ERROR_INVALID_ARGS,
+               "empty payload sent");
+    HOSTCOAP_getCounts(&counts);
+    benchCheck(counts.locks == 0, "empty payload locked the stack");
+
+    // out of message buffers, or a payload too large for the message
+    HOSTCOAP_allocLimit(0);
+    benchCheck(CoapTemplate_send(tmpl, payload, sizeof(payload)) ==
+               OT_ERROR_NO_BUFS, "send without a message buffer");
+    HOSTCOAP_reset();
+    benchCheck(CoapTemplate_send(tmpl, payload, HOSTCOAP_MSG_MAX) ==
+               OT_ERROR_NO_BUFS, "send of a payload larger than a message");
+    HOSTCOAP_getCounts(&counts);
+    benchCheck((counts.locks == 1) && (counts.inUse == 0) &&
+               (counts.sent == 0), "failed send locked twice or leaked");
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long reports = BENCH_REPORTS;
+    HOSTCOAP_counts_t counts;
+    CoapTemplate_t tmpl;
+    ReportBatch_sample_t ring[BENCH_SAMPLES];
+    ReportBatch_t batch;
+    double oldNs;
+    double newNs;
+    uint32_t oldLocks;
+    unsigned long i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': reports = strtoul(optarg, NULL, 0); break;
+            default: benchUsage();
+        }
+    }
+    if ((optind != argc) || (reports == 0))
+    {
+        benchUsage();
+    }
+
+    // a full batched report, as tempsensor.c sends it
+    ReportBatch_init(&batch, ring, BENCH_SAMPLES);
+    for (i = 0; i < BENCH_SAMPLES; i++)
+    {
+        ReportBatch_add(&batch, (int16_t)(68 + i % 3), i * 10000);
+    }
+    ReportBatch_encode(&batch, payload, BENCH_SAMPLES * 10000);
+
+    HOSTCOAP_reset();
+    benchCheck(CoapTemplate_init(&tmpl, instance,
+                                 OT_COAP_TYPE_NON_CONFIRMABLE,
+                                 OT_COAP_CODE_POST, BENCH_URI) ==
+               OT_ERROR_NONE, "template not built");
+    CoapTemplate_setPeer(&tmpl, &peer, OT_DEFAULT_COAP_PORT);
+
+    benchSame(&tmpl);
+    benchFailures(&tmpl);
+
+    HOSTCOAP_reset();
+    newNs = benchNow();
+    for (i = 0; i < reports; i++)
+    {
+        benchRebuilt(payload, sizeof(payload));
+    }
+    oldNs = benchNow() - newNs;
+    HOSTCOAP_getCounts(&counts);
+    oldLocks = counts.locks;
+
+    HOSTCOAP_reset();
+    newNs = benchNow();
+    for (i = 0; i < reports; i++)
+    {
+        CoapTemplate_send(&tmpl, payload, sizeof(payload));
+    }
+    newNs = benchNow() - newNs;
+    HOSTCOAP_getCounts(&counts);
+
+    benchCheck((counts.sent == reports) && (counts.unlocked == 0) &&
+               (counts.inUse == 0), "template reports lost, unlocked or "
+               "leaked");
+    benchCheck(counts.locks == reports, "template send locked more than once");
+
+    printf("%lu reports of %zu bytes:\n", reports, sizeof(payload));
+    printf("  rebuilt:  %6.1f ns/report, %.1f locks/report\n",
+           oldNs / reports, (double)oldLocks / reports);
+    printf("  template: %6.1f ns/report, %.1f locks/report\n",
+           newNs / reports, (double)counts.locks / reports);
+
+    return (0);
+}
@@ -0,0 +1,169 @@
+/******************************************************************************
+
+ @file crctest.c
+
+ @brief Equivalence test and benchmark of the NV CRC8
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+//*****************************************************************************
+// Overview
+//*****************************************************************************
+/*
+Checks crc_update() of crc.c against a bit by bit CRC8 with the same
+parameters (polynomial 0x97, no reflection, no final XOR) on random data of
+random lengths and alignments, also split into several updates as the NV
+driver does, then measures its speed on NV item sized buffers.
+
+The Makefile builds it once for each CRC_SLICE: crctest-1 is the byte at a
+time table of the original driver, crctest-4 and crctest-8 the slice-by-N
+tables.
+*/
+
+//*****************************************************************************
+// Includes
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "crc.h"
+
+//*****************************************************************************
+// Constants and Definitions
+//*****************************************************************************
+
+#define CRC_POLY        0x97
+#define CRC_TESTS       200000  // Random buffers checked
+#define CRC_MAXLEN      300     // Longest random buffer
+#define CRC_BENCHBYTES  50000000 // Bytes processed per benchmark length
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static uint8_t buf[CRC_MAXLEN + 8];
+
+// Item sizes of the benchmark, from a short header-only item up to 200 bytes
+static const size_t benchLens[] = { 7, 16, 32, 64, 128, 200 };
+
+//*****************************************************************************
+// Functions
+//*****************************************************************************
+
+static crc_t crcBitwise(crc_t crc, const uint8_t *pData, size_t len)
+{
+    uint8_t i;
+
+    while (len--)
+    {
+        crc ^= *pData++;
+        for (i = 0; i < 8; i++)
+        {
+            crc = (crc & 0x80) ? (crc_t)((crc << 1) ^ CRC_POLY) :
+                                 (crc_t)(crc << 1);
+        }
+    }
+
+    return (crc);
+}
+
+static double crcNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1e9 + ts.tv_nsec);
+}
+
+int main(void)
+{
+    volatile crc_t sink = 0;
+    unsigned long t;
+    size_t k;
+
+    srand(1);
+    for (t = 0; t < CRC_TESTS; t++)
+    {
+        size_t len = rand() % (CRC_MAXLEN + 1);
+        size_t ofs = rand() % 8;
+        size_t split = (len != 0) ? rand() % (len + 1) : 0;
+        crc_t crc0 = rand() & 0xFF;
+        crc_t whole;
+        crc_t parts;
+        size_t i;
+
+        for (i = 0; i < len; i++)
+        {
+            buf[ofs + i] = rand();
+        }
+        whole = crc_update(crc0, buf + ofs, len);
+        parts = crc_update(crc_update(crc0, buf + ofs, split),
+                           buf + ofs + split, len - split);
+        if ((whole != crcBitwise(crc0, buf + ofs, len)) || (parts != whole))
+        {
+            printf("FAIL: CRC_SLICE %d, length %zu at offset %zu, "
+                   "split at %zu\n", CRC_SLICE, len, ofs, split);
+            return (1);
+        }
+    }
+    printf("CRC_SLICE %d: %d random buffers match the bitwise CRC8\n",
+           CRC_SLICE, CRC_TESTS);
+
+    for (k = 0; k < sizeof(benchLens) / sizeof(benchLens[0]); k++)
+    {
+        unsigned long reps = CRC_BENCHBYTES / benchLens[k];
+        double ns = crcNow();
+
+        for (t = 0; t < reps; t++)
+        {
+            sink ^= crc_update(sink, buf + (t & 7), benchLens[k]);
+        }
+        ns = crcNow() - ns;
+        printf("  %3zu byte items: %6.3f ns/byte, %7.1f MB/s\n",
+               benchLens[k], ns / ((double)reps * benchLens[k]),
+               (double)reps * benchLens[k] * 1e3 / ns);
+    }
+
+    return (0);
+}
@@ -0,0 +1,624 @@
+/******************************************************************************
+
+ @file hostcoap.c
+
+ @brief Host stand-in for the OpenThread CoAP API and stack lock
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+//*****************************************************************************
+// Overview
+//*****************************************************************************
+/*
+The CoAP modules of the application are built for Linux against this file,
+which stands in for the OpenThread CoAP and message API, the millisecond
+alarm and OtRtosApi.
+
+Headers are built in the CoAP wire format (RFC 7252), as OpenThread does:
+options must be appended in ascending order and take the shortest delta
+and length encoding, and a header that outgrows OT_COAP_HEADER_MAX_LENGTH
+fails with OT_ERROR_NO_BUFS. Messages come from a pool of HOSTCOAP_MESSAGES
+buffers, and HOSTCOAP_allocLimit() makes allocations fail as when the stack
+is out of buffers. A sent message is not put on the air but kept by the loopback, with
+its destination and response handler, where a test reads it back with
+HOSTCOAP_parse() as the peer would and calls the response handler as the
+CoAP layer would.
+
+OtRtosApi is a recursive mutex, as on the target, that counts the lock
+round-trips. Message allocation, append, free and send count the calls made
+without the lock held.
+*/
+
+//*****************************************************************************
+// Includes
+//*****************************************************************************
+
+#include <pthread.h>
+#include <string.h>
+
+#include <openthread/coap.h>
+#include <openthread/message.h>
+#include <openthread/platform/alarm-milli.h>
+
+#include "otsupport/otrtosapi.h"
+#include "hostcoap.h"
+
+//*****************************************************************************
+// Constants and Definitions
+//*****************************************************************************
+
+#define HOSTCOAP_VERSION   0x40  // Version 1
+#define HOSTCOAP_MARKER    0xFF  // Payload marker
+#define HOSTCOAP_HDR_LEN   4     // Fixed part of the header
+
+//*****************************************************************************
+// Typedefs
+//*****************************************************************************
+
+struct otMessage
+{
+    uint8_t bytes[HOSTCOAP_MSG_MAX];
+    uint16_t len;
+    bool inUse;
+};
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static struct otMessage HOSTCOAP_pool[HOSTCOAP_MESSAGES];
+static int64_t HOSTCOAP_allocs = -1;
+static HOSTCOAP_sent_t HOSTCOAP_kept[HOSTCOAP_KEPT];
+static HOSTCOAP_counts_t HOSTCOAP_counts;
+static uint32_t HOSTCOAP_now;
+static uint16_t HOSTCOAP_messageId;
+static uint32_t HOSTCOAP_token = 1;
+
+static pthread_mutex_t HOSTCOAP_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static uint32_t HOSTCOAP_depth;
+
+//*****************************************************************************
+// Local functions
+//*****************************************************************************
+
+/**
+ * @fn      HOSTCOAP_checkLock
+ *
+ * @brief   Counts a call to the stack made without the stack lock
+ *
+ * @return  none
+ */
+static void HOSTCOAP_checkLock(void)
+{
+    if (HOSTCOAP_depth == 0)
+    {
+        HOSTCOAP_counts.unlocked++;
+    }
+}
+
+/**
+ * @fn      HOSTCOAP_putExt
+ *
+ * @brief   Encodes the extended bytes of an option delta or length
+ *
+ * @param   p - output
+ * @param   value - option delta or length
+ *
+ * @return  number of bytes written
+ */
+static uint8_t HOSTCOAP_putExt(uint8_t *p, uint16_t value)
+{
+    if (value < 13)
+    {
+        return (0);
+    }
+    if (value < 269)
+    {
+        p[0] = (uint8_t)(value - 13);
+        return (1);
+    }
+    p[0] = (uint8_t)((value - 269) >> 8);
+    p[1] = (uint8_t)(value - 269);
+    return (2);
+}
+
+/**
+ * @fn      HOSTCOAP_nibble
+ *
+ * @brief   Returns the 4 bit field of an option delta or length
+ *
+ * @param   value - option delta or length
+ *
+ * @return  field value
+ */
+static uint8_t HOSTCOAP_nibble(uint16_t value)
+{
+    return ((value < 13) ? (uint8_t)value : (value < 269) ? 13 : 14);
+}
+
+/**
+ * @fn      HOSTCOAP_getExt
+ *
+ * @brief   Decodes an option delta or length from its 4 bit field and
+ *          extended bytes
+ *
+ * @param   bytes - message
+ * @param   end - end of the options
+ * @param   ofs - offset of the extended bytes, advanced past them
+ * @param   nibble - 4 bit field
+ * @param   value - returns the delta or length
+ *
+ * @return  false if the encoding is malformed
+ */
+static bool HOSTCOAP_getExt(const uint8_t *bytes, uint16_t end, uint16_t *ofs,
+                            uint8_t nibble, uint16_t *value)
+{
+    if (nibble < 13)
+    {
+        *value = nibble;
+    }
+    else if ((nibble == 13) && (*ofs + 1 <= end))
+    {
+        *value = bytes[*ofs] + 13;
+        *ofs += 1;
+    }
+    else if ((nibble == 14) && (*ofs + 2 <= end))
+    {
+        *value = ((bytes[*ofs] << 8) | bytes[*ofs + 1]) + 269;
+        *ofs += 2;
+    }
+    else
+    {
+        return (false);
+    }
+
+    return (true);
+}
+
+//*****************************************************************************
+// OpenThread CoAP header API
+//*****************************************************************************
+
+void otCoapHeaderInit(otCoapHeader *aHeader, otCoapType aType,
+                      otCoapCode aCode)
+{
+    memset(aHeader, 0, sizeof(*aHeader));
+    aHeader->mBytes[0] = HOSTCOAP_VERSION | aType;
+    aHeader->mBytes[1] = aCode;
+    aHeader->mHeaderLength = HOSTCOAP_HDR_LEN;
+}
+
+void otCoapHeaderSetToken(otCoapHeader *aHeader, const uint8_t *aToken,
+                          uint8_t aTokenLength)
+{
+    aHeader->mBytes[0] = (aHeader->mBytes[0] & 0xF0) | aTokenLength;
+    memcpy(&aHeader->mBytes[HOSTCOAP_HDR_LEN], aToken, aTokenLength);
+    aHeader->mHeaderLength = HOSTCOAP_HDR_LEN + aTokenLength;
+}
+
+void otCoapHeaderGenerateToken(otCoapHeader *aHeader, uint8_t aTokenLength)
+{
+    uint8_t token[OT_COAP_MAX_TOKEN_LENGTH];
+    uint8_t i;
+
+    for (i = 0; i < aTokenLength; i++)
+    {
+        HOSTCOAP_token = HOSTCOAP_token * 1103515245 + 12345;
+        token[i] = (uint8_t)(HOSTCOAP_token >> 16);
+    }
+    otCoapHeaderSetToken(aHeader, token, aTokenLength);
+}
+
+otError otCoapHeaderAppendOption(otCoapHeader *aHeader,
+                                 const otCoapOption *aOption)
+{
+    uint8_t *p = &aHeader->mBytes[aHeader->mHeaderLength];
+    uint16_t delta = aOption->mNumber - aHeader->mOptionLast;
+    uint16_t len = aOption->mLength;
+
+    if (aOption->mNumber < aHeader->mOptionLast)
+    {
+        return (OT_ERROR_INVALID_ARGS);
+    }
+    if (aHeader->mHeaderLength + 5 + len > OT_COAP_HEADER_MAX_LENGTH)
+    {
+        return (OT_ERROR_NO_BUFS);
+    }
+
+    *p++ = (HOSTCOAP_nibble(delta) << 4) | HOSTCOAP_nibble(len);
+    p += HOSTCOAP_putExt(p, delta);
+    p += HOSTCOAP_putExt(p, len);
+    memcpy(p, aOption->mValue, len);
+    p += len;
+
+    aHeader->mHeaderLength = p - aHeader->mBytes;
+    aHeader->mOptionLast = aOption->mNumber;
+    return (OT_ERROR_NONE);
+}
+
+otError otCoapHeaderAppendUriPathOptions(otCoapHeader *aHeader,
+                                         const char *aUriPath)
+{
+    otCoapOption option;
+    const char *end;
+    otError error;
+
+    option.mNumber = OT_COAP_OPTION_URI_PATH;
+    do
+    {
+        end = strchr(aUriPath, '/');
+        option.mLength = (end != NULL) ? end - aUriPath : strlen(aUriPath);
+        option.mValue = (const uint8_t *)aUriPath;
+        error = otCoapHeaderAppendOption(aHeader, &option);
+        aUriPath = end + 1;
+    } while ((error == OT_ERROR_NONE) && (end != NULL));
+
+    return (error);
+}
+
+void otCoapHeaderSetPayloadMarker(otCoapHeader *aHeader)
+{
+    if (aHeader->mHeaderLength < OT_COAP_HEADER_MAX_LENGTH)
+    {
+        aHeader->mBytes[aHeader->mHeaderLength++] = HOSTCOAP_MARKER;
+    }
+}
+
+void otCoapHeaderSetMessageId(otCoapHeader *aHeader, uint16_t aMessageId)
+{
+    aHeader->mBytes[2] = (uint8_t)(aMessageId >> 8);
+    aHeader->mBytes[3] = (uint8_t)aMessageId;
+}
+
+otCoapType otCoapHeaderGetType(const otCoapHeader *aHeader)
+{
+    return ((otCoapType)(aHeader->mBytes[0] & 0x30));
+}
+
+otCoapCode otCoapHeaderGetCode(const otCoapHeader *aHeader)
+{
+    return ((otCoapCode)aHeader->mBytes[1]);
+}
+
+uint16_t otCoapHeaderGetMessageId(const otCoapHeader *aHeader)
+{
+    return ((aHeader->mBytes[2] << 8) | aHeader->mBytes[3]);
+}
+
+uint8_t otCoapHeaderGetTokenLength(const otCoapHeader *aHeader)
+{
+    return (aHeader->mBytes[0] & 0x0F);
+}
+
+const uint8_t *otCoapHeaderGetToken(const otCoapHeader *aHeader)
+{
+    return (&aHeader->mBytes[HOSTCOAP_HDR_LEN]);
+}
+
+const otCoapOption *otCoapHeaderGetFirstOption(otCoapHeader *aHeader)
+{
+    aHeader->mFirstOptionOffset = HOSTCOAP_HDR_LEN +
+                                  otCoapHeaderGetTokenLength(aHeader);
+    aHeader->mNextOptionOffset = aHeader->mFirstOptionOffset;
+    aHeader->mOption.mNumber = 0;
+
+    return (otCoapHeaderGetNextOption(aHeader));
+}
+
+const otCoapOption *otCoapHeaderGetNextOption(otCoapHeader *aHeader)
+{
+    const uint8_t *bytes = aHeader->mBytes;
+    uint16_t end = aHeader->mHeaderLength;
+    uint16_t ofs = aHeader->mNextOptionOffset;
+    uint16_t delta;
+    uint16_t len;
+
+    if ((ofs >= end) || (bytes[ofs] == HOSTCOAP_MARKER))
+    {
+        return (NULL);
+    }
+
+    ofs++;
+    if (!HOSTCOAP_getExt(bytes, end, &ofs, bytes[ofs - 1] >> 4, &delta) ||
+        !HOSTCOAP_getExt(bytes, end, &ofs, bytes[ofs - 1] & 0x0F, &len) ||
+        (ofs + len > end))
+    {
+        // stop at a malformed option, HOSTCOAP_parse() rejects it
+        return (NULL);
+    }
+
+    aHeader->mOption.mNumber += delta;
+    aHeader->mOption.mLength = len;
+    aHeader->mOption.mValue = &bytes[ofs];
+    aHeader->mNextOptionOffset = ofs + len;
+
+    return (&aHeader->mOption);
+}
+
+//*****************************************************************************
+// OpenThread message and CoAP API
+//*****************************************************************************
+
+otMessage *otCoapNewMessage(otInstance *aInstance,
+                            const otCoapHeader *aHeader)
+{
+    uint8_t i;
+
+    (void)aInstance;
+    HOSTCOAP_checkLock();
+    if (HOSTCOAP_allocs == 0)
+    {
+        return (NULL);
+    }
+
+    for (i = 0; i < HOSTCOAP_MESSAGES; i++)
+    {
+        struct otMessage *message = &HOSTCOAP_pool[i];
+
+        if (!message->inUse)
+        {
+            message->inUse = true;
+            memcpy(message->bytes, aHeader->mBytes, aHeader->mHeaderLength);
+            message->len = aHeader->mHeaderLength;
+            if (HOSTCOAP_allocs > 0)
+            {
+                HOSTCOAP_allocs--;
+            }
+            HOSTCOAP_counts.messages++;
+            HOSTCOAP_counts.inUse++;
+            return (message);
+        }
+    }
+
+    return (NULL);
+}
+
+otError otMessageAppend(otMessage *aMessage, const void *aBuf,
+                        uint16_t aLength)
+{
+    HOSTCOAP_checkLock();
+    if (aMessage->len + aLength > HOSTCOAP_MSG_MAX)
+    {
+        return (OT_ERROR_NO_BUFS);
+    }
+
+    memcpy(&aMessage->bytes[aMessage->len], aBuf, aLength);
+    aMessage->len += aLength;
+    return (OT_ERROR_NONE);
+}
+
+uint16_t otMessageGetLength(otMessage *aMessage)
+{
+    HOSTCOAP_checkLock();
+    return (aMessage->len);
+}
+
+void otMessageFree(otMessage *aMessage)
+{
+    HOSTCOAP_checkLock();
+    if (aMessage->inUse)
+    {
+        aMessage->inUse = false;
+        HOSTCOAP_counts.inUse--;
+    }
+}
+
+/**
+ * @fn      HOSTCOAP_send
+ *
+ * @brief   Puts a message on the loopback and frees it
+ *
+ * @param   aMessage - message, header first
+ * @param   aMessageInfo - destination
+ * @param   aHandler - response handler, NULL if none
+ * @param   aContext - context of the response handler
+ * @param   response - sent as a response
+ *
+ * @return  OT_ERROR_NONE
+ */
+static otError HOSTCOAP_send(otMessage *aMessage,
+                             const otMessageInfo *aMessageInfo,
+                             otCoapResponseHandler aHandler, void *aContext,
+                             bool response)
+{
+    HOSTCOAP_sent_t *sent = &HOSTCOAP_kept[HOSTCOAP_counts.sent %
+                                           HOSTCOAP_KEPT];
+
+    HOSTCOAP_checkLock();
+    memcpy(sent->bytes, aMessage->bytes, aMessage->len);
+    sent->len = aMessage->len;
+    sent->info = *aMessageInfo;
+    sent->handler = aHandler;
+    sent->context = aContext;
+    sent->response = response;
+    HOSTCOAP_counts.sent++;
+
+    otMessageFree(aMessage);
+    return (OT_ERROR_NONE);
+}
+
+otError otCoapSendRequest(otInstance *aInstance, otMessage *aMessage,
+                          const otMessageInfo *aMessageInfo,
+                          otCoapResponseHandler aHandler, void *aContext)
+{
+    (void)aInstance;
+    HOSTCOAP_messageId++;
+    aMessage->bytes[2] = (uint8_t)(HOSTCOAP_messageId >> 8);
+    aMessage->bytes[3] = (uint8_t)HOSTCOAP_messageId;
+
+    return (HOSTCOAP_send(aMessage, aMessageInfo, aHandler, aContext, false));
+}
+
+otError otCoapSendResponse(otInstance *aInstance, otMessage *aMessage,
+                           const otMessageInfo *aMessageInfo)
+{
+    (void)aInstance;
+    return (HOSTCOAP_send(aMessage, aMessageInfo, NULL, NULL, true));
+}
+
+uint32_t otPlatAlarmMilliGetNow(void)
+{
+    return (HOSTCOAP_now);
+}
+
+//*****************************************************************************
+// OtRtosApi
+//*****************************************************************************
+
+void OtRtosApi_init(void)
+{
+}
+
+void OtRtosApi_lock(void)
+{
+    pthread_mutex_lock(&HOSTCOAP_mutex);
+    HOSTCOAP_depth++;
+    HOSTCOAP_counts.locks++;
+}
+
+void OtRtosApi_unlock(void)
+{
+    HOSTCOAP_depth--;
+    pthread_mutex_unlock(&HOSTCOAP_mutex);
+}
+
+//*****************************************************************************
+// Functions
+//*****************************************************************************
+
+/*
+ * Documented in hostcoap.h
+ */
+void HOSTCOAP_reset(void)
+{
+    memset(HOSTCOAP_pool, 0, sizeof(HOSTCOAP_pool));
+    memset(&HOSTCOAP_counts, 0, sizeof(HOSTCOAP_counts));
+    HOSTCOAP_allocs = -1;
+    HOSTCOAP_now = 0;
+}
+
+/*
+ * Documented in hostcoap.h
+ */
+void HOSTCOAP_allocLimit(uint32_t count)
+{
+    HOSTCOAP_allocs = count;
+}
+
+/*
+ * Documented in hostcoap.h
+ */
+void HOSTCOAP_setTime(uint32_t ms)
+{
+    HOSTCOAP_now = ms;
+}
+
+/*
+ * Documented in hostcoap.h
+ */
+const HOSTCOAP_sent_t *HOSTCOAP_sent(uint32_t n)
+{
+    if ((n >= HOSTCOAP_counts.sent) ||
+        (HOSTCOAP_counts.sent - n > HOSTCOAP_KEPT))
+    {
+        return (NULL);
+    }
+
+    return (&HOSTCOAP_kept[n % HOSTCOAP_KEPT]);
+}
+
+/*
+ * Documented in hostcoap.h
+ */
+otError HOSTCOAP_parse(const HOSTCOAP_sent_t *sent, otCoapHeader *header,
+                       const uint8_t **payload, uint16_t *len)
+{
+    uint16_t end = (sent->len < OT_COAP_HEADER_MAX_LENGTH) ?
+                   sent->len : OT_COAP_HEADER_MAX_LENGTH;
+    const otCoapOption *option;
+
+    memset(header, 0, sizeof(*header));
+    memcpy(header->mBytes, sent->bytes, end);
+    header->mHeaderLength = end;
+    if ((sent->len < HOSTCOAP_HDR_LEN) ||
+        ((sent->bytes[0] & 0xC0) != HOSTCOAP_VERSION) ||
+        (otCoapHeaderGetTokenLength(header) > OT_COAP_MAX_TOKEN_LENGTH) ||
+        (HOSTCOAP_HDR_LEN + otCoapHeaderGetTokenLength(header) > end))
+    {
+        return (OT_ERROR_PARSE);
+    }
+
+    // walk the options up to the payload marker or the end of the message
+    for (option = otCoapHeaderGetFirstOption(header); option != NULL;
+         option = otCoapHeaderGetNextOption(header))
+    {
+    }
+    if ((header->mNextOptionOffset < end) &&
+        (header->mBytes[header->mNextOptionOffset] != HOSTCOAP_MARKER))
+    {
+        return (OT_ERROR_PARSE);
+    }
+
+    header->mHeaderLength = header->mNextOptionOffset;
+    *payload = &sent->bytes[header->mHeaderLength];
+    *len = sent->len - header->mHeaderLength;
+    if (*len != 0)
+    {
+        // the marker must be followed by a payload
+        if (*len == 1)
+        {
+            return (OT_ERROR_PARSE);
+        }
+        header->mHeaderLength++;
+        (*payload)++;
+        (*len)--;
+    }
+
+    return (OT_ERROR_NONE);
+}
+
+/*
+ * Documented in hostcoap.h
+ */
+void HOSTCOAP_getCounts(HOSTCOAP_counts_t *pCounts)
+{
+    *pCounts = HOSTCOAP_counts;
+}
@@ -0,0 +1,175 @@
+/******************************************************************************
+
+ @file hostcoap.h
+
+ @brief Host stand-in for the OpenThread CoAP API and stack lock
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+#ifndef HOSTCOAP_H
+#define HOSTCOAP_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <openthread/coap.h>
+
+//*****************************************************************************
+// Constants and Definitions
+//*****************************************************************************
+
+#define HOSTCOAP_MESSAGES  8     // Message buffers of the stand-in stack
+#define HOSTCOAP_MSG_MAX   256   // Largest message
+#define HOSTCOAP_KEPT      64    // Sent messages kept by the loopback
+
+//*****************************************************************************
+// Typedefs
+//*****************************************************************************
+
+// A message sent through the loopback
+typedef struct
+{
+    uint8_t bytes[HOSTCOAP_MSG_MAX];        // CoAP message, header first
+    uint16_t len;
+    otMessageInfo info;                     // Destination
+    otCoapResponseHandler handler;          // Response handler of a request
+    void *context;
+    bool response;                          // Sent by otCoapSendResponse()
+} HOSTCOAP_sent_t;
+
+// Calls counted since the last HOSTCOAP_reset()
+typedef struct
+{
+    uint32_t locks;                         // OtRtosApi_lock() calls
+    uint32_t unlocked;                      // Message calls made without
+                                            // the stack lock
+    uint32_t messages;                      // Messages allocated
+    uint32_t sent;                          // Messages sent
+    uint32_t inUse;                         // Message buffers in use
+} HOSTCOAP_counts_t;
+
+//*****************************************************************************
+// Functions
+//*****************************************************************************
+
+/**
+ * @fn      HOSTCOAP_reset
+ *
+ * @brief   Frees every message buffer, forgets the sent messages, clears the
+ *          counters and sets the millisecond clock to 0
+ *
+ * @return  none
+ */
+extern void HOSTCOAP_reset(void);
+
+/**
+ * @fn      HOSTCOAP_allocLimit
+ *
+ * @brief   Lets count more otCoapNewMessage() calls succeed, the later ones
+ *          fail as if the stack were out of message buffers, until
+ *          HOSTCOAP_reset()
+ *
+ * @param   count - messages that can still be allocated
+ *
+ * @return  none
+ */
+extern void HOSTCOAP_allocLimit(uint32_t count);
+
+/**
+ * @fn      HOSTCOAP_setTime
+ *
+ * @brief   Sets the time of otPlatAlarmMilliGetNow()
+ *
+ * @param   ms - milliseconds
+ *
+ * @return  none
+ */
+extern void HOSTCOAP_setTime(uint32_t ms);
+
+/**
+ * @fn      HOSTCOAP_sent
+ *
+ * @brief   Returns a message sent since HOSTCOAP_reset(), the last
+ *          HOSTCOAP_KEPT ones are kept
+ *
+ * @param   n - message number, from 0
+ *
+ * @return  the message, NULL if it was not sent or not kept
+ */
+extern const HOSTCOAP_sent_t *HOSTCOAP_sent(uint32_t n);
+
+/**
+ * @fn      HOSTCOAP_parse
+ *
+ * @brief   Parses a sent message as its receiver does, for the
+ *          otCoapHeaderGet functions
+ *
+ * @param   sent - sent message
+ * @param   header - returns the header
+ * @param   payload - returns the payload
+ * @param   len - returns the payload length
+ *
+ * @return  OT_ERROR_NONE, or OT_ERROR_PARSE if the message is malformed
+ */
+extern otError HOSTCOAP_parse(const HOSTCOAP_sent_t *sent,
+                              otCoapHeader *header, const uint8_t **payload,
+                              uint16_t *len);
+
+/**
+ * @fn      HOSTCOAP_getCounts
+ *
+ * @brief   Reads the call counters
+ *
+ * @param   pCounts - pointer to caller's counter structure
+ *
+ * @return  none
+ */
+extern void HOSTCOAP_getCounts(HOSTCOAP_counts_t *pCounts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOSTCOAP_H */
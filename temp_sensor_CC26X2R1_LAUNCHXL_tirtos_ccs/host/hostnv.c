@@ -0,0 +1,439 @@
+/******************************************************************************
+
+ @file hostnv.c
+
+ @brief RAM or file backed NVS stand-in for host builds of the NV drivers
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+//*****************************************************************************
+// Overview
+//*****************************************************************************
+/*
+The NV drivers are built for Linux against this file, which stands in for the
+NVS driver, GateMutexPri, Clock and the Hwi gate of TI-RTOS.
+
+The Flash is a mapping at HOSTNV_BASE, anonymous shared memory or a file, so
+that a forked process works on the Flash of its parent and the driver can read
+it in place. Writes only clear bits, as on Flash, and erases set a page to
+0xFF. Every write and erase of NVOCTP passes through NVOCTP_FLASHHOOK, which
+counts it and stops the process when a power loss is armed for it. Reads
+are counted too, with the most of them in progress at once and the writes
+and erases that were done while a read was in progress, for concurrency
+tests of builds that do not read in place (NVOCTP_MAPPED=0).
+
+GateMutexPri is a recursive mutex, without priority inheritance. Clock ticks
+are 10 us, as in release.cfg.
+*/
+
+//*****************************************************************************
+// Includes
+//*****************************************************************************
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <ti/drivers/NVS.h>
+#include <ti/sysbios/gates/GateMutexPri.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Clock.h>
+
+#include "hostnv.h"
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE MAP_FIXED
+#endif
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static uint8_t *HOSTNV_mem;
+static uint32_t HOSTNV_len;
+static int32_t HOSTNV_fail = -1;
+static bool HOSTNV_torn;
+static bool HOSTNV_tearNext;
+static HOSTNV_counts_t HOSTNV_counts;
+static uint32_t HOSTNV_delay;
+static uint32_t HOSTNV_readers;
+
+// The Hwi gate of every module
+pthread_mutex_t HOSTNV_hwiMutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+//*****************************************************************************
+// Local functions
+//*****************************************************************************
+
+/**
+ * @fn      HOSTNV_checkReaders
+ *
+ * @brief   Counts a write or erase done while a read is in progress
+ *
+ * @return  none
+ */
+static void HOSTNV_checkReaders(void)
+{
+    if (__atomic_load_n(&HOSTNV_readers, __ATOMIC_SEQ_CST) != 0)
+    {
+        __atomic_add_fetch(&HOSTNV_counts.opsInRead, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+/**
+ * @fn      HOSTNV_tear
+ *
+ * @brief   Ends the process after the torn part of a failing operation
+ *
+ * @return  none
+ */
+static void HOSTNV_tear(void)
+{
+    if (HOSTNV_tearNext)
+    {
+        if (HOSTNV_mem != NULL)
+        {
+            msync(HOSTNV_mem, HOSTNV_len, MS_SYNC);
+        }
+        _exit(HOSTNV_POWERFAIL);
+    }
+}
+
+//*****************************************************************************
+// Stand-in API
+//*****************************************************************************
+
+void HOSTNV_open(const char *path, uint8_t pages)
+{
+    int fd = -1;
+    int flags = MAP_SHARED | MAP_FIXED_NOREPLACE;
+    struct stat st;
+    void *addr;
+
+    if ((pages == 0) || (pages > HOSTNV_MAXPAGES))
+    {
+        fprintf(stderr, "hostnv: 1 to %d pages\n", HOSTNV_MAXPAGES);
+        exit(2);
+    }
+    HOSTNV_len = (uint32_t)pages * HOSTNV_SECTORSIZE;
+
+    if (path != NULL)
+    {
+        fd = open(path, O_RDWR | O_CREAT, 0644);
+        if ((fd < 0) || fstat(fd, &st))
+        {
+            perror(path);
+            exit(2);
+        }
+        if (st.st_size < HOSTNV_len)
+        {
+            // Pages beyond the end of the file are erased
+            uint8_t erased[HOSTNV_SECTORSIZE];
+            off_t pos = st.st_size;
+
+            memset(erased, 0xFF, sizeof(erased));
+            while (pos < HOSTNV_len)
+            {
+                size_t n = HOSTNV_len - pos;
+
+                n = (n > sizeof(erased)) ? sizeof(erased) : n;
+                if (pwrite(fd, erased, n, pos) != (ssize_t)n)
+                {
+                    perror(path);
+                    exit(2);
+                }
+                pos += n;
+            }
+        }
+    }
+    else
+    {
+        flags |= MAP_ANONYMOUS;
+    }
+
+    addr = mmap((void *)HOSTNV_BASE, HOSTNV_len, PROT_READ | PROT_WRITE,
+                flags, fd, 0);
+    if (addr != (void *)HOSTNV_BASE)
+    {
+        fprintf(stderr, "hostnv: can't map the Flash at 0x%x\n", HOSTNV_BASE);
+        exit(2);
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    else
+    {
+        memset(addr, 0xFF, HOSTNV_len);
+    }
+    HOSTNV_mem = addr;
+}
+
+uint8_t *HOSTNV_flash(void)
+{
+    return (HOSTNV_mem);
+}
+
+uint32_t HOSTNV_size(void)
+{
+    return (HOSTNV_len);
+}
+
+void HOSTNV_failAt(int32_t op, bool torn)
+{
+    HOSTNV_fail = op;
+    HOSTNV_torn = torn;
+}
+
+void HOSTNV_readDelay(uint32_t usecs)
+{
+    HOSTNV_delay = usecs;
+}
+
+void HOSTNV_getCounts(HOSTNV_counts_t *pCounts)
+{
+    *pCounts = HOSTNV_counts;
+}
+
+void HOSTNV_clearCounts(void)
+{
+    uint32_t ops = HOSTNV_counts.ops;
+
+    memset(&HOSTNV_counts, 0, sizeof(HOSTNV_counts));
+    HOSTNV_counts.ops = ops;
+}
+
+void HOSTNV_flashOp(uint8_t pg, uint16_t ofs, uint16_t len)
+{
+    (void)pg;
+    (void)ofs;
+    (void)len;
+
+    if ((HOSTNV_fail >= 0) && (HOSTNV_counts.ops == (uint32_t)HOSTNV_fail))
+    {
+        if (!HOSTNV_torn)
+        {
+            _exit(HOSTNV_POWERFAIL);
+        }
+        HOSTNV_tearNext = true;
+    }
+    HOSTNV_counts.ops++;
+}
+
+uint64_t HOSTNV_usecs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+//*****************************************************************************
+// NVS
+//*****************************************************************************
+
+void NVS_init(void)
+{
+}
+
+NVS_Handle NVS_open(uint_least8_t index, NVS_Params *params)
+{
+    (void)params;
+
+    return ((index == 0) && (HOSTNV_mem != NULL) ?
+            (NVS_Handle)HOSTNV_mem : NULL);
+}
+
+void NVS_getAttrs(NVS_Handle handle, NVS_Attrs *attrs)
+{
+    (void)handle;
+
+    attrs->regionBase = HOSTNV_mem;
+    attrs->regionSize = HOSTNV_len;
+    attrs->sectorSize = HOSTNV_SECTORSIZE;
+}
+
+int_fast16_t NVS_read(NVS_Handle handle, size_t offset, void *buffer,
+                      size_t bufferSize)
+{
+    uint32_t readers;
+    uint32_t most;
+
+    (void)handle;
+
+    if ((offset + bufferSize) > HOSTNV_len)
+    {
+        return (NVS_STATUS_INV_OFFSET);
+    }
+
+    readers = __atomic_add_fetch(&HOSTNV_readers, 1, __ATOMIC_SEQ_CST);
+    most = __atomic_load_n(&HOSTNV_counts.maxReaders, __ATOMIC_SEQ_CST);
+    while ((readers > most) &&
+           !__atomic_compare_exchange_n(&HOSTNV_counts.maxReaders, &most,
+                                        readers, false, __ATOMIC_SEQ_CST,
+                                        __ATOMIC_SEQ_CST))
+    {
+    }
+    if (HOSTNV_delay != 0)
+    {
+        usleep(HOSTNV_delay);
+    }
+    memcpy(buffer, HOSTNV_mem + offset, bufferSize);
+    __atomic_add_fetch(&HOSTNV_counts.reads, 1, __ATOMIC_SEQ_CST);
+    __atomic_sub_fetch(&HOSTNV_readers, 1, __ATOMIC_SEQ_CST);
+
+    return (NVS_STATUS_SUCCESS);
+}
+
+int_fast16_t NVS_write(NVS_Handle handle, size_t offset, void *buffer,
+                       size_t bufferSize, uint_fast16_t flags)
+{
+    const uint8_t *pSrc = buffer;
+    size_t i;
+
+    (void)handle;
+
+    if ((offset + bufferSize) > HOSTNV_len)
+    {
+        return (NVS_STATUS_INV_OFFSET);
+    }
+    HOSTNV_checkReaders();
+    if (HOSTNV_tearNext)
+    {
+        bufferSize /= 2;
+    }
+
+    // Programming only clears bits
+    for (i = 0; i < bufferSize; i++)
+    {
+        HOSTNV_mem[offset + i] &= pSrc[i];
+    }
+    HOSTNV_tear();
+
+    HOSTNV_counts.writes++;
+    HOSTNV_counts.bytes += bufferSize;
+
+    if ((flags & NVS_WRITE_POST_VERIFY) &&
+        memcmp(HOSTNV_mem + offset, pSrc, bufferSize))
+    {
+        return (NVS_STATUS_ERROR);
+    }
+    return (NVS_STATUS_SUCCESS);
+}
+
+int_fast16_t NVS_erase(NVS_Handle handle, size_t offset, size_t size)
+{
+    (void)handle;
+
+    if ((offset % HOSTNV_SECTORSIZE) || (size % HOSTNV_SECTORSIZE) ||
+        ((offset + size) > HOSTNV_len))
+    {
+        return (NVS_STATUS_INV_ALIGNMENT);
+    }
+    HOSTNV_checkReaders();
+    if (HOSTNV_tearNext)
+    {
+        size /= 2;
+    }
+
+    memset(HOSTNV_mem + offset, 0xFF, size);
+    HOSTNV_tear();
+
+    HOSTNV_counts.erases++;
+    for (; size > 0; size -= HOSTNV_SECTORSIZE)
+    {
+        HOSTNV_counts.pageErases[offset / HOSTNV_SECTORSIZE]++;
+        offset += HOSTNV_SECTORSIZE;
+    }
+    return (NVS_STATUS_SUCCESS);
+}
+
+//*****************************************************************************
+// GateMutexPri and Clock
+//*****************************************************************************
+
+void GateMutexPri_Params_init(GateMutexPri_Params *params)
+{
+    memset(params, 0, sizeof(*params));
+}
+
+GateMutexPri_Handle GateMutexPri_create(const GateMutexPri_Params *params,
+                                        Error_Block *eb)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutex_t *pMutex = malloc(sizeof(*pMutex));
+
+    (void)params;
+    (void)eb;
+
+    if (pMutex != NULL)
+    {
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(pMutex, &attr);
+        pthread_mutexattr_destroy(&attr);
+    }
+    return ((GateMutexPri_Handle)pMutex);
+}
+
+IArg GateMutexPri_enter(GateMutexPri_Handle handle)
+{
+    pthread_mutex_lock((pthread_mutex_t *)handle);
+    return (0);
+}
+
+void GateMutexPri_leave(GateMutexPri_Handle handle, IArg key)
+{
+    (void)key;
+
+    pthread_mutex_unlock((pthread_mutex_t *)handle);
+}
+
+UInt32 Clock_getTicks(void)
+{
+    return ((UInt32)(HOSTNV_usecs() / 10));
+}
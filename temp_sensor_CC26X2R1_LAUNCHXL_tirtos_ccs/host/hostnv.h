@@ -0,0 +1,202 @@
+/******************************************************************************
+
+ @file hostnv.h
+
+ @brief RAM or file backed NVS stand-in for host builds of the NV drivers
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+#ifndef HOSTNV_H
+#define HOSTNV_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//*****************************************************************************
+// Constants and Definitions
+//*****************************************************************************
+
+// The driver reads Flash in place at (page << 13), so the stand-in Flash is
+// mapped at the NVS_REGIONS_BASE of CC26X2R1_LAUNCHXL.c
+#define HOSTNV_BASE        0x4E000
+#define HOSTNV_SECTORSIZE  0x2000
+#define HOSTNV_MAXPAGES    16
+
+// Exit status of a process stopped by an injected power loss
+#define HOSTNV_POWERFAIL   99
+
+// Counts and power loss injection at every write and erase of the driver
+#define NVOCTP_FLASHHOOK(pg, ofs, len) HOSTNV_flashOp((pg), (ofs), (len));
+
+//*****************************************************************************
+// Typedefs
+//*****************************************************************************
+
+// Flash operations done since the last HOSTNV_clearCounts()
+typedef struct
+{
+    uint32_t writes;                        // NVS_write() calls
+    uint32_t erases;                        // NVS_erase() calls
+    uint64_t bytes;                         // Bytes written
+    uint32_t pageErases[HOSTNV_MAXPAGES];   // Erases of each page
+    uint32_t reads;                         // NVS_read() calls
+    uint32_t maxReaders;                    // Most NVS_read() calls at once
+    uint32_t opsInRead;                     // Writes and erases done while
+                                            // an NVS_read() was in progress
+    uint32_t ops;                           // Writes and erases, from open
+} HOSTNV_counts_t;
+
+//*****************************************************************************
+// Functions
+//*****************************************************************************
+
+/**
+ * @fn      HOSTNV_open
+ *
+ * @brief   Maps the stand-in Flash. A file is used as the Flash when a path
+ *          is given, it is created erased if needed. Otherwise the Flash is
+ *          RAM which is shared with forked processes. Exits on failure.
+ *
+ * @param   path - Flash image file or NULL
+ * @param   pages - number of 8 KB pages in the NVS region
+ *
+ * @return  none
+ */
+extern void HOSTNV_open(const char *path, uint8_t pages);
+
+/**
+ * @fn      HOSTNV_flash
+ *
+ * @brief   Returns the stand-in Flash, HOSTNV_size() bytes
+ *
+ * @return  pointer to the first byte of the NVS region
+ */
+extern uint8_t *HOSTNV_flash(void);
+
+/**
+ * @fn      HOSTNV_size
+ *
+ * @brief   Returns the size of the NVS region
+ *
+ * @return  size in bytes
+ */
+extern uint32_t HOSTNV_size(void);
+
+/**
+ * @fn      HOSTNV_failAt
+ *
+ * @brief   Arms a power loss: the process exits with HOSTNV_POWERFAIL at the
+ *          given write or erase, counted from 0 since HOSTNV_open(). The
+ *          operation is not done, or done in part if torn is set: a write
+ *          programs the first half of its bytes, an erase erases the first
+ *          half of the page.
+ *
+ * @param   op - operation number, -1 to disarm
+ * @param   torn - true to do the failing operation in part
+ *
+ * @return  none
+ */
+extern void HOSTNV_failAt(int32_t op, bool torn);
+
+/**
+ * @fn      HOSTNV_readDelay
+ *
+ * @brief   Makes every NVS_read() take longer, so that concurrent reads
+ *          overlap more often
+ *
+ * @param   usecs - time spent in each NVS_read(), 0 for none
+ *
+ * @return  none
+ */
+extern void HOSTNV_readDelay(uint32_t usecs);
+
+/**
+ * @fn      HOSTNV_getCounts
+ *
+ * @brief   Reads the Flash operation counters
+ *
+ * @param   pCounts - pointer to caller's counter structure
+ *
+ * @return  none
+ */
+extern void HOSTNV_getCounts(HOSTNV_counts_t *pCounts);
+
+/**
+ * @fn      HOSTNV_clearCounts
+ *
+ * @brief   Clears the Flash operation counters, except the operation number
+ *
+ * @return  none
+ */
+extern void HOSTNV_clearCounts(void);
+
+/**
+ * @fn      HOSTNV_flashOp
+ *
+ * @brief   NVOCTP_FLASHHOOK of the driver, counts the operation and stops
+ *          the process if a power loss is armed for it
+ *
+ * @param   pg - Flash page number
+ * @param   ofs - offset in the page
+ * @param   len - number of bytes, a page for erases
+ *
+ * @return  none
+ */
+extern void HOSTNV_flashOp(uint8_t pg, uint16_t ofs, uint16_t len);
+
+/**
+ * @fn      HOSTNV_usecs
+ *
+ * @brief   Returns a monotonic time stamp
+ *
+ * @return  microseconds
+ */
+extern uint64_t HOSTNV_usecs(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOSTNV_H */
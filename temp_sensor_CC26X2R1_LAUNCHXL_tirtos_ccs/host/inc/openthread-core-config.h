@@ -0,0 +1 @@
+/* Host stand-in, settings.c needs no OpenThread core configuration */
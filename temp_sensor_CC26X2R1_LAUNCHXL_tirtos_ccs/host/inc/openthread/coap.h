@@ -0,0 +1,102 @@
+/* Host stand-in for the OpenThread CoAP API, see hostcoap.c. The header is
+ * kept in its wire format, as OpenThread does. */
+#ifndef OPENTHREAD_COAP_H_
+#define OPENTHREAD_COAP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <openthread/error.h>
+#include <openthread/instance.h>
+#include <openthread/ip6.h>
+#include <openthread/message.h>
+
+#define OT_DEFAULT_COAP_PORT        5683
+#define OT_COAP_MAX_TOKEN_LENGTH    8
+#define OT_COAP_HEADER_MAX_LENGTH   128
+
+typedef enum
+{
+    OT_COAP_TYPE_CONFIRMABLE     = 0x00,
+    OT_COAP_TYPE_NON_CONFIRMABLE = 0x10,
+    OT_COAP_TYPE_ACKNOWLEDGMENT  = 0x20,
+    OT_COAP_TYPE_RESET           = 0x30,
+} otCoapType;
+
+#define OT_COAP_CODE(c, d) ((((c) & 0x7) << 5) | ((d) & 0x1f))
+
+typedef enum
+{
+    OT_COAP_CODE_EMPTY              = OT_COAP_CODE(0, 0),
+    OT_COAP_CODE_GET                = OT_COAP_CODE(0, 1),
+    OT_COAP_CODE_POST               = OT_COAP_CODE(0, 2),
+    OT_COAP_CODE_PUT                = OT_COAP_CODE(0, 3),
+    OT_COAP_CODE_DELETE             = OT_COAP_CODE(0, 4),
+    OT_COAP_CODE_CHANGED            = OT_COAP_CODE(2, 4),
+    OT_COAP_CODE_CONTENT            = OT_COAP_CODE(2, 5),
+    OT_COAP_CODE_BAD_REQUEST        = OT_COAP_CODE(4, 0),
+    OT_COAP_CODE_NOT_FOUND          = OT_COAP_CODE(4, 4),
+    OT_COAP_CODE_METHOD_NOT_ALLOWED = OT_COAP_CODE(4, 5),
+    OT_COAP_CODE_NOT_ACCEPTABLE     = OT_COAP_CODE(4, 6),
+} otCoapCode;
+
+typedef enum
+{
+    OT_COAP_OPTION_OBSERVE        = 6,
+    OT_COAP_OPTION_URI_PATH       = 11,
+    OT_COAP_OPTION_CONTENT_FORMAT = 12,
+    OT_COAP_OPTION_MAX_AGE        = 14,
+    OT_COAP_OPTION_URI_QUERY      = 15,
+    OT_COAP_OPTION_ACCEPT         = 17,
+} otCoapOptionType;
+
+typedef struct
+{
+    uint16_t       mNumber;
+    uint16_t       mLength;
+    const uint8_t *mValue;
+} otCoapOption;
+
+typedef struct
+{
+    uint8_t      mBytes[OT_COAP_HEADER_MAX_LENGTH];
+    uint8_t      mHeaderLength;
+    uint16_t     mOptionLast;
+    uint16_t     mFirstOptionOffset;
+    uint16_t     mNextOptionOffset;
+    otCoapOption mOption;
+} otCoapHeader;
+
+typedef void (*otCoapResponseHandler)(void *aContext, otCoapHeader *aHeader,
+                                      otMessage *aMessage,
+                                      const otMessageInfo *aMessageInfo,
+                                      otError aResult);
+
+void otCoapHeaderInit(otCoapHeader *aHeader, otCoapType aType,
+                      otCoapCode aCode);
+void otCoapHeaderSetToken(otCoapHeader *aHeader, const uint8_t *aToken,
+                          uint8_t aTokenLength);
+void otCoapHeaderGenerateToken(otCoapHeader *aHeader, uint8_t aTokenLength);
+otError otCoapHeaderAppendOption(otCoapHeader *aHeader,
+                                 const otCoapOption *aOption);
+otError otCoapHeaderAppendUriPathOptions(otCoapHeader *aHeader,
+                                         const char *aUriPath);
+void otCoapHeaderSetPayloadMarker(otCoapHeader *aHeader);
+void otCoapHeaderSetMessageId(otCoapHeader *aHeader, uint16_t aMessageId);
+otCoapType otCoapHeaderGetType(const otCoapHeader *aHeader);
+otCoapCode otCoapHeaderGetCode(const otCoapHeader *aHeader);
+uint16_t otCoapHeaderGetMessageId(const otCoapHeader *aHeader);
+uint8_t otCoapHeaderGetTokenLength(const otCoapHeader *aHeader);
+const uint8_t *otCoapHeaderGetToken(const otCoapHeader *aHeader);
+const otCoapOption *otCoapHeaderGetFirstOption(otCoapHeader *aHeader);
+const otCoapOption *otCoapHeaderGetNextOption(otCoapHeader *aHeader);
+
+otMessage *otCoapNewMessage(otInstance *aInstance,
+                            const otCoapHeader *aHeader);
+otError otCoapSendRequest(otInstance *aInstance, otMessage *aMessage,
+                          const otMessageInfo *aMessageInfo,
+                          otCoapResponseHandler aHandler, void *aContext);
+otError otCoapSendResponse(otInstance *aInstance, otMessage *aMessage,
+                           const otMessageInfo *aMessageInfo);
+
+#endif
@@ -0,0 +1,20 @@
+/* Host stand-in for the OpenThread error codes */
+#ifndef OPENTHREAD_ERROR_H_
+#define OPENTHREAD_ERROR_H_
+
+typedef enum
+{
+    OT_ERROR_NONE             = 0,
+    OT_ERROR_FAILED           = 1,
+    OT_ERROR_NO_BUFS          = 3,
+    OT_ERROR_PARSE            = 6,
+    OT_ERROR_INVALID_ARGS     = 7,
+    OT_ERROR_ABORT            = 11,
+    OT_ERROR_NOT_IMPLEMENTED  = 12,
+    OT_ERROR_INVALID_STATE    = 13,
+    OT_ERROR_NOT_FOUND        = 23,
+    OT_ERROR_ALREADY          = 24,
+    OT_ERROR_RESPONSE_TIMEOUT = 28,
+} otError;
+
+#endif
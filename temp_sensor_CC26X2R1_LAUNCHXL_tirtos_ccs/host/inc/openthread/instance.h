@@ -0,0 +1,7 @@
+/* Host stand-in for the OpenThread instance type */
+#ifndef OPENTHREAD_INSTANCE_H_
+#define OPENTHREAD_INSTANCE_H_
+
+typedef struct otInstance otInstance;
+
+#endif
@@ -0,0 +1,30 @@
+/* Host stand-in for the OpenThread IPv6 types used with CoAP */
+#ifndef OPENTHREAD_IP6_H_
+#define OPENTHREAD_IP6_H_
+
+#include <stdint.h>
+
+#define OT_NETIF_INTERFACE_ID_THREAD 1
+
+typedef struct
+{
+    union
+    {
+        uint8_t  m8[16];
+        uint16_t m16[8];
+        uint32_t m32[4];
+    } mFields;
+} otIp6Address;
+
+typedef struct
+{
+    otIp6Address mSockAddr;
+    otIp6Address mPeerAddr;
+    uint16_t     mSockPort;
+    uint16_t     mPeerPort;
+    const void  *mLinkInfo;
+    uint8_t      mHopLimit;
+    int8_t       mInterfaceId;
+} otMessageInfo;
+
+#endif
@@ -0,0 +1,16 @@
+/* Host stand-in for the OpenThread message API, see hostcoap.c */
+#ifndef OPENTHREAD_MESSAGE_H_
+#define OPENTHREAD_MESSAGE_H_
+
+#include <stdint.h>
+
+#include <openthread/error.h>
+
+typedef struct otMessage otMessage;
+
+otError otMessageAppend(otMessage *aMessage, const void *aBuf,
+                        uint16_t aLength);
+uint16_t otMessageGetLength(otMessage *aMessage);
+void otMessageFree(otMessage *aMessage);
+
+#endif
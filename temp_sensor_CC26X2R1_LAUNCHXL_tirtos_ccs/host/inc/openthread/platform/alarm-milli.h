@@ -0,0 +1,9 @@
+/* Host stand-in for the millisecond alarm, see hostcoap.c */
+#ifndef OPENTHREAD_PLATFORM_ALARM_MILLI_H_
+#define OPENTHREAD_PLATFORM_ALARM_MILLI_H_
+
+#include <stdint.h>
+
+uint32_t otPlatAlarmMilliGetNow(void);
+
+#endif
@@ -0,0 +1,23 @@
+/* Host stand-in for the OpenThread settings platform API */
+#ifndef OPENTHREAD_PLATFORM_SETTINGS_H_
+#define OPENTHREAD_PLATFORM_SETTINGS_H_
+
+#include <stdint.h>
+
+#include <openthread/error.h>
+#include <openthread/instance.h>
+
+void otPlatSettingsInit(otInstance *aInstance);
+otError otPlatSettingsBeginChange(otInstance *aInstance);
+otError otPlatSettingsCommitChange(otInstance *aInstance);
+otError otPlatSettingsAbandonChange(otInstance *aInstance);
+otError otPlatSettingsGet(otInstance *aInstance, uint16_t aKey, int aIndex,
+                          uint8_t *aValue, uint16_t *aValueLength);
+otError otPlatSettingsSet(otInstance *aInstance, uint16_t aKey,
+                          const uint8_t *aValue, uint16_t aValueLength);
+otError otPlatSettingsAdd(otInstance *aInstance, uint16_t aKey,
+                          const uint8_t *aValue, uint16_t aValueLength);
+otError otPlatSettingsDelete(otInstance *aInstance, uint16_t aKey, int aIndex);
+void otPlatSettingsWipe(otInstance *aInstance);
+
+#endif
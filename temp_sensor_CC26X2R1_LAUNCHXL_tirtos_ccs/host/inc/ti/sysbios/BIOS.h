@@ -0,0 +1,10 @@
+/* Host stand-in for the BIOS constants used by the NV drivers */
+#ifndef ti_sysbios_BIOS__include
+#define ti_sysbios_BIOS__include
+
+#include <xdc/std.h>
+
+#define BIOS_WAIT_FOREVER (~(UInt32)0)
+#define BIOS_NO_WAIT      ((UInt32)0)
+
+#endif
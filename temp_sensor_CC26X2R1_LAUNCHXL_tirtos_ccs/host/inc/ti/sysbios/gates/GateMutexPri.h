@@ -0,0 +1,20 @@
+/* Host stand-in for GateMutexPri, a recursive mutex, see hostnv.c */
+#ifndef ti_sysbios_gates_GateMutexPri__include
+#define ti_sysbios_gates_GateMutexPri__include
+
+#include <xdc/std.h>
+
+typedef struct
+{
+    int dummy;
+} GateMutexPri_Params;
+
+typedef struct GateMutexPri_Object *GateMutexPri_Handle;
+
+extern void GateMutexPri_Params_init(GateMutexPri_Params *params);
+extern GateMutexPri_Handle GateMutexPri_create(
+    const GateMutexPri_Params *params, Error_Block *eb);
+extern IArg GateMutexPri_enter(GateMutexPri_Handle handle);
+extern void GateMutexPri_leave(GateMutexPri_Handle handle, IArg key);
+
+#endif
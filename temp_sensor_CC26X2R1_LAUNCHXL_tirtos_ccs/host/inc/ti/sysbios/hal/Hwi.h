@@ -0,0 +1,22 @@
+/* Host stand-in for the Hwi gate, one recursive mutex shared by all modules */
+#ifndef ti_sysbios_hal_Hwi__include
+#define ti_sysbios_hal_Hwi__include
+
+#include <pthread.h>
+#include <xdc/std.h>
+
+extern pthread_mutex_t HOSTNV_hwiMutex;
+
+static inline UInt Hwi_disable(void)
+{
+    pthread_mutex_lock(&HOSTNV_hwiMutex);
+    return (0);
+}
+
+static inline void Hwi_restore(UInt key)
+{
+    (void)key;
+    pthread_mutex_unlock(&HOSTNV_hwiMutex);
+}
+
+#endif
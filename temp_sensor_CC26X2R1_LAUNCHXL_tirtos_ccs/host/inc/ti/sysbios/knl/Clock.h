@@ -0,0 +1,9 @@
+/* Host stand-in for Clock_getTicks(), 10 us ticks, see hostnv.c */
+#ifndef ti_sysbios_knl_Clock__include
+#define ti_sysbios_knl_Clock__include
+
+#include <xdc/std.h>
+
+extern UInt32 Clock_getTicks(void);
+
+#endif
@@ -0,0 +1,75 @@
+/* Host stand-in for counting and binary Semaphores */
+#ifndef ti_sysbios_knl_Semaphore__include
+#define ti_sysbios_knl_Semaphore__include
+
+#include <pthread.h>
+#include <xdc/std.h>
+#include <ti/sysbios/BIOS.h>
+
+typedef enum
+{
+    Semaphore_Mode_COUNTING,
+    Semaphore_Mode_BINARY
+} Semaphore_Mode;
+
+typedef struct
+{
+    Semaphore_Mode mode;
+} Semaphore_Params;
+
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    Semaphore_Mode mode;
+    unsigned int count;
+} Semaphore_Struct;
+
+typedef Semaphore_Struct *Semaphore_Handle;
+
+#define Semaphore_handle(pStruct) (pStruct)
+
+static inline void Semaphore_Params_init(Semaphore_Params *params)
+{
+    params->mode = Semaphore_Mode_COUNTING;
+}
+
+static inline void Semaphore_construct(Semaphore_Struct *obj, int count,
+                                       const Semaphore_Params *params)
+{
+    pthread_mutex_init(&obj->mutex, NULL);
+    pthread_cond_init(&obj->cond, NULL);
+    obj->mode = (params != NULL) ? params->mode : Semaphore_Mode_COUNTING;
+    obj->count = count;
+}
+
+static inline void Semaphore_post(Semaphore_Handle handle)
+{
+    pthread_mutex_lock(&handle->mutex);
+    if ((handle->mode == Semaphore_Mode_COUNTING) || (handle->count == 0))
+    {
+        handle->count++;
+    }
+    pthread_cond_signal(&handle->cond);
+    pthread_mutex_unlock(&handle->mutex);
+}
+
+static inline Bool Semaphore_pend(Semaphore_Handle handle, UInt32 timeout)
+{
+    Bool taken = FALSE;
+
+    pthread_mutex_lock(&handle->mutex);
+    while ((handle->count == 0) && (timeout == BIOS_WAIT_FOREVER))
+    {
+        pthread_cond_wait(&handle->cond, &handle->mutex);
+    }
+    if (handle->count > 0)
+    {
+        handle->count--;
+        taken = TRUE;
+    }
+    pthread_mutex_unlock(&handle->mutex);
+    return (taken);
+}
+
+#endif
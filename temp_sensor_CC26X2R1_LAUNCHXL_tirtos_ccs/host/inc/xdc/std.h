@@ -0,0 +1,20 @@
+/* Host stand-in for the XDC types used by the NV drivers, see hostnv.c */
+#ifndef xdc_std__include
+#define xdc_std__include
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef intptr_t IArg;
+typedef int Int;
+typedef unsigned int UInt;
+typedef uint32_t UInt32;
+typedef bool Bool;
+typedef struct Error_Block Error_Block;
+
+#ifndef TRUE
+#define TRUE  1
+#define FALSE 0
+#endif
+
+#endif
@@ -0,0 +1,1195 @@
+/******************************************************************************
+
+ @file nvbench.c
+
+ @brief Host benchmark and power loss harness of the OpenThread settings on NVOCTP
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+//*****************************************************************************
+// Overview
+//*****************************************************************************
+/*
+Replays a workload of otPlatSettings calls through settings.c, nvqueue.c and
+nvoctp.c on the stand-in Flash of hostnv.c, and reports the operations per
+second, the Flash bytes written, the erases and the latency of every kind of
+call.
+
+The workload is a trace file (see traces/README.md for the format) or a
+synthetic one with the key usage of an OpenThread device: frequent network
+info updates, parent and child info changes, occasional dataset updates and
+change sets, and a reboot now and then.
+
+Every boot runs in a forked process, so that the driver starts from its reset
+state on the Flash left by the previous boot. A model of the settings is kept
+in memory shared with the parent. Every Get is checked against it, and after
+every boot the settings read back must match it.
+
+With -p, a power loss is injected at every Flash write and erase of the
+workload in turn (or every Nth with -k): the workload is run again from the
+same Flash image and stops at that operation, the next boot must find the
+settings before or after the call in flight, then finishes the workload.
+Commits and Add are atomic, a Set or a Delete of all settings of a key may
+also leave a part of the old settings next to the new ones, as in settings.c.
+With -t the failing operation is torn instead of skipped.
+*/
+
+//*****************************************************************************
+// Includes
+//*****************************************************************************
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <openthread/platform/settings.h>
+
+#include "task_config.h"
+#include "nvqueue.h"
+#include "hostnv.h"
+
+//*****************************************************************************
+// Constants and Definitions
+//*****************************************************************************
+
+#define BENCH_KEYS      16      // Keys 0..15 are modelled
+#define BENCH_VALUES    64      // Settings per key
+#define BENCH_VALLEN    255     // Bytes per setting
+
+#define BENCH_PAGES     4       // REGIONSIZE of CC26X2R1_LAUNCHXL.c
+#define BENCH_OPS       10000   // Synthetic workload length
+
+// OpenThread settings keys of the synthetic workload
+#define KEY_ACTIVE      1
+#define KEY_PENDING     2
+#define KEY_NETINFO     3
+#define KEY_PARENT      4
+#define KEY_CHILD       5
+#define KEY_SLAAC       7
+#define KEY_DAD         8
+
+#define BENCH_CHILDREN  10      // Default child table size
+
+enum
+{
+    OP_INIT,
+    OP_GET,
+    OP_SET,
+    OP_ADD,
+    OP_DELETE,
+    OP_BEGIN,
+    OP_COMMIT,
+    OP_ABANDON,
+    OP_WIPE,
+    OP_REBOOT,
+    OP_KINDS
+};
+
+static const char *const opNames[OP_KINDS] =
+{
+    "init", "get", "set", "add", "delete", "begin", "commit", "abandon",
+    "wipe", "reboot"
+};
+
+//*****************************************************************************
+// Typedefs
+//*****************************************************************************
+
+// One otPlatSettings call of the workload
+typedef struct
+{
+    uint8_t kind;
+    uint8_t key;
+    int8_t index;       // get and delete, -1 deletes all settings
+    uint8_t len;        // set and add
+    uint32_t val;       // offset of the value in the value pool
+} bench_op_t;
+
+// Settings of a key, in no particular order
+typedef struct
+{
+    uint8_t n;
+    uint8_t len[BENCH_VALUES];
+    uint8_t val[BENCH_VALUES][BENCH_VALLEN];
+} bench_key_t;
+
+typedef struct
+{
+    bench_key_t key[BENCH_KEYS];
+} bench_state_t;
+
+typedef struct
+{
+    uint32_t count;
+    uint64_t totalNs;
+    uint64_t maxNs;
+    uint32_t maxOp;
+} bench_stat_t;
+
+// Shared by all boots of a run
+typedef struct
+{
+    bench_state_t cur;      // Committed settings, before the call in flight
+    bench_state_t stage;    // Settings seen inside a change set
+    bool inChange;
+    bool loaded;            // cur was read from the Flash of the first boot
+    int32_t inFlight;       // Call that was not finished, -1 for none
+    uint8_t delLen;         // Setting removed by the delete in flight
+    uint8_t delVal[BENCH_VALLEN];
+    uint32_t next;          // Next call to do
+    int32_t failAt;         // Flash operation to stop at, -1 for none
+    int32_t injected;       // Flash operation of the power loss of the run
+    bool torn;              // The failing operation is torn
+    uint32_t flashOps;      // Flash operations of the finished boots
+    uint32_t boots;
+    bench_stat_t stat[OP_KINDS];
+    HOSTNV_counts_t counts;
+    NVQUEUE_stats_t queue;
+} bench_shared_t;
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static bench_shared_t *sh;
+static bench_op_t *ops;
+static uint32_t numOps;
+static uint8_t *pool;
+static uint32_t poolLen;
+static uint32_t poolSize;
+static uint32_t randState;
+static uint8_t maxChildren = BENCH_CHILDREN;
+static bool useQueue;
+
+//*****************************************************************************
+// Workloads
+//*****************************************************************************
+
+static uint32_t benchRand(void)
+{
+    // xorshift32, the same workload on every host
+    randState ^= randState << 13;
+    randState ^= randState >> 17;
+    randState ^= randState << 5;
+    return (randState);
+}
+
+static bench_op_t *benchAdd(uint8_t kind, uint8_t key, int index)
+{
+    bench_op_t *pOp;
+
+    if ((numOps % 1024) == 0)
+    {
+        ops = realloc(ops, (numOps + 1024) * sizeof(*ops));
+        if (ops == NULL)
+        {
+            perror("nvbench");
+            exit(2);
+        }
+    }
+    pOp = &ops[numOps++];
+    memset(pOp, 0, sizeof(*pOp));
+    pOp->kind = kind;
+    pOp->key = key;
+    pOp->index = (int8_t)index;
+    return (pOp);
+}
+
+static uint8_t *benchValue(bench_op_t *pOp, uint8_t len)
+{
+    if ((poolLen + len) > poolSize)
+    {
+        poolSize = (poolSize + len) * 2;
+        pool = realloc(pool, poolSize);
+        if (pool == NULL)
+        {
+            perror("nvbench");
+            exit(2);
+        }
+    }
+    pOp->len = len;
+    pOp->val = poolLen;
+    poolLen += len;
+    return (pool + pOp->val);
+}
+
+static void benchRandomValue(bench_op_t *pOp, uint8_t len)
+{
+    uint8_t *pVal = benchValue(pOp, len);
+
+    while (len--)
+    {
+        *pVal++ = (uint8_t)benchRand();
+    }
+}
+
+/**
+ * @brief Builds the synthetic workload, with the keys OpenThread uses most.
+ *        The sizes are those of the OpenThread settings structures.
+ *
+ * @param count number of calls
+ */
+static void benchSynthetic(uint32_t count)
+{
+    static const uint8_t getKeys[] =
+    {
+        KEY_NETINFO, KEY_NETINFO, KEY_ACTIVE, KEY_PARENT, KEY_CHILD,
+        KEY_PENDING, KEY_SLAAC
+    };
+    uint8_t children = 0;
+    uint8_t staged = 0;
+    uint8_t changes = 0;
+    bool inChange = false;
+
+    while (numOps < count)
+    {
+        uint32_t r = benchRand() % 100;
+        uint8_t key = getKeys[benchRand() % sizeof(getKeys)];
+        uint8_t *pChildren = inChange ? &staged : &children;
+
+        if (inChange && (changes-- == 0))
+        {
+            benchAdd(((benchRand() % 8) == 0) ? OP_ABANDON : OP_COMMIT, 0,
+                     0);
+            if (ops[numOps - 1].kind == OP_COMMIT)
+            {
+                children = staged;
+            }
+            inChange = false;
+        }
+        else if (r < 35)
+        {
+            benchAdd(OP_GET, key, benchRand() % 2);
+        }
+        else if (r < 60)
+        {
+            // MLE and MAC frame counter updates
+            benchRandomValue(benchAdd(OP_SET, KEY_NETINFO, 0), 38);
+        }
+        else if (r < 65)
+        {
+            benchRandomValue(benchAdd(OP_SET, KEY_PARENT, 0), 10);
+        }
+        else if ((r < 73) && (*pChildren < maxChildren))
+        {
+            benchRandomValue(benchAdd(OP_ADD, KEY_CHILD, 0), 18);
+            (*pChildren)++;
+        }
+        else if ((r < 80) && (*pChildren > 0))
+        {
+            benchAdd(OP_DELETE, KEY_CHILD, benchRand() % *pChildren);
+            (*pChildren)--;
+        }
+        else if (r < 83)
+        {
+            benchRandomValue(benchAdd(OP_SET, KEY_ACTIVE, 0),
+                             90 + benchRand() % 40);
+        }
+        else if (r < 85)
+        {
+            if (benchRand() % 2)
+            {
+                benchRandomValue(benchAdd(OP_SET, KEY_PENDING, 0),
+                                 100 + benchRand() % 40);
+            }
+            else
+            {
+                benchAdd(OP_DELETE, KEY_PENDING, -1);
+            }
+        }
+        else if (r < 88)
+        {
+            benchRandomValue(benchAdd(OP_SET, (benchRand() % 2) ?
+                                      KEY_SLAAC : KEY_DAD, 0), 32);
+        }
+        else if ((r < 98) && !inChange)
+        {
+            benchAdd(OP_BEGIN, 0, 0);
+            inChange = true;
+            staged = children;
+            changes = 2 + benchRand() % 4;
+        }
+        else if ((r == 98) && (*pChildren > 0))
+        {
+            benchAdd(OP_DELETE, KEY_CHILD, -1);
+            *pChildren = 0;
+        }
+        else if ((r == 99) && !inChange)
+        {
+            benchAdd(((benchRand() % 16) == 0) ? OP_WIPE : OP_REBOOT, 0, 0);
+            if (ops[numOps - 1].kind == OP_WIPE)
+            {
+                children = 0;
+            }
+        }
+    }
+    if (inChange)
+    {
+        benchAdd(OP_COMMIT, 0, 0);
+    }
+}
+
+static int benchHex(int c)
+{
+    return (isdigit(c) ? (c - '0') : (tolower(c) - 'a' + 10));
+}
+
+/**
+ * @brief Loads a workload trace, see traces/README.md
+ *
+ * @param path trace file
+ */
+static void benchTrace(const char *path)
+{
+    FILE *pFile = fopen(path, "r");
+    char line[2 * BENCH_VALLEN + 64];
+    uint32_t lineNo = 0;
+
+    if (pFile == NULL)
+    {
+        perror(path);
+        exit(2);
+    }
+    while (fgets(line, sizeof(line), pFile) != NULL)
+    {
+        char word[16];
+        char arg[2 * BENCH_VALLEN + 2];
+        int key = 0;
+        int kind;
+        int n;
+
+        lineNo++;
+        arg[0] = '\0';
+        n = sscanf(line, "%15s %d %511s", word, &key, arg);
+        if ((n < 1) || (word[0] == '#'))
+        {
+            continue;
+        }
+        for (kind = OP_GET; kind < OP_KINDS; kind++)
+        {
+            if (!strcmp(word, opNames[kind]))
+            {
+                break;
+            }
+        }
+        if ((kind == OP_KINDS) || (key < 0) || (key >= BENCH_KEYS) ||
+            ((kind <= OP_DELETE) && (n < 3)))
+        {
+            fprintf(stderr, "%s:%u: bad call\n", path, lineNo);
+            exit(2);
+        }
+
+        if ((kind == OP_SET) || (kind == OP_ADD))
+        {
+            bench_op_t *pOp = benchAdd(kind, key, 0);
+            size_t len = strlen(arg);
+
+            if (arg[0] == '*')
+            {
+                // '*' and a length: that many pseudo random bytes
+                len = strtoul(arg + 1, NULL, 10);
+                if ((len == 0) || (len > BENCH_VALLEN))
+                {
+                    fprintf(stderr, "%s:%u: bad length\n", path, lineNo);
+                    exit(2);
+                }
+                benchRandomValue(pOp, len);
+            }
+            else
+            {
+                uint8_t *pVal;
+                size_t i;
+
+                if ((len == 0) || (len % 2) ||
+                    (strspn(arg, "0123456789abcdefABCDEF") != len))
+                {
+                    fprintf(stderr, "%s:%u: bad value\n", path, lineNo);
+                    exit(2);
+                }
+                pVal = benchValue(pOp, len / 2);
+                for (i = 0; i < len; i += 2)
+                {
+                    pVal[i / 2] = (benchHex(arg[i]) << 4) |
+                                  benchHex(arg[i + 1]);
+                }
+            }
+        }
+        else
+        {
+            int index = atoi(arg);
+
+            if ((index < -1) || (index >= BENCH_VALUES))
+            {
+                fprintf(stderr, "%s:%u: bad index\n", path, lineNo);
+                exit(2);
+            }
+            benchAdd(kind, key, index);
+        }
+    }
+    fclose(pFile);
+}
+
+/**
+ * @brief Saves the workload as a trace
+ *
+ * @param path trace file
+ */
+static void benchSave(const char *path)
+{
+    FILE *pFile = fopen(path, "w");
+    uint32_t i;
+
+    if (pFile == NULL)
+    {
+        perror(path);
+        exit(2);
+    }
+    for (i = 0; i < numOps; i++)
+    {
+        const bench_op_t *pOp = &ops[i];
+        uint8_t j;
+
+        fprintf(pFile, "%s", opNames[pOp->kind]);
+        if ((pOp->kind == OP_SET) || (pOp->kind == OP_ADD))
+        {
+            fprintf(pFile, " %u ", pOp->key);
+            for (j = 0; j < pOp->len; j++)
+            {
+                fprintf(pFile, "%02x", pool[pOp->val + j]);
+            }
+        }
+        else if ((pOp->kind == OP_GET) || (pOp->kind == OP_DELETE))
+        {
+            fprintf(pFile, " %u %d", pOp->key, pOp->index);
+        }
+        fprintf(pFile, "\n");
+    }
+    if (fclose(pFile))
+    {
+        perror(path);
+        exit(2);
+    }
+}
+
+//*****************************************************************************
+// Model
+//*****************************************************************************
+
+static uint64_t benchNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+static void benchFail(const char *what, uint32_t op)
+{
+    printf("FAIL: %s, call %u", what, op);
+    if (sh->injected >= 0)
+    {
+        printf(", power loss at Flash operation %d", sh->injected);
+    }
+    printf("\n");
+    exit(1);
+}
+
+static int benchFind(const bench_key_t *pKey, const uint8_t *pVal,
+                     uint8_t len, const bool *pUsed)
+{
+    int i;
+
+    for (i = 0; i < pKey->n; i++)
+    {
+        if (((pUsed == NULL) || !pUsed[i]) && (pKey->len[i] == len) &&
+            !memcmp(pKey->val[i], pVal, len))
+        {
+            return (i);
+        }
+    }
+    return (-1);
+}
+
+static void benchRemove(bench_key_t *pKey, int i)
+{
+    pKey->n--;
+    pKey->len[i] = pKey->len[pKey->n];
+    memcpy(pKey->val[i], pKey->val[pKey->n], BENCH_VALLEN);
+}
+
+/**
+ * @brief Checks that every setting of a is in b or c, each one used once.
+ *        With c NULL, a and b must hold the same settings.
+ */
+static bool benchSubset(const bench_key_t *pA, const bench_key_t *pB,
+                        const bench_key_t *pC)
+{
+    bool usedB[BENCH_VALUES] = { false };
+    bool usedC[BENCH_VALUES] = { false };
+    int i;
+
+    if ((pC == NULL) && (pA->n != pB->n))
+    {
+        return (false);
+    }
+    for (i = 0; i < pA->n; i++)
+    {
+        int j = benchFind(pB, pA->val[i], pA->len[i], usedB);
+
+        if (j >= 0)
+        {
+            usedB[j] = true;
+        }
+        else if ((pC != NULL) &&
+                 ((j = benchFind(pC, pA->val[i], pA->len[i], usedC)) >= 0))
+        {
+            usedC[j] = true;
+        }
+        else
+        {
+            return (false);
+        }
+    }
+    return (true);
+}
+
+// Applies a finished call to the model
+static void benchApply(bench_state_t *pState, const bench_op_t *pOp)
+{
+    bench_key_t *pKey = &pState->key[pOp->key];
+    int i;
+
+    switch (pOp->kind)
+    {
+        case OP_SET:
+            pKey->n = 0;
+            // fall through
+        case OP_ADD:
+            pKey->len[pKey->n] = pOp->len;
+            memcpy(pKey->val[pKey->n], pool + pOp->val, pOp->len);
+            pKey->n++;
+            break;
+        case OP_DELETE:
+            if (pOp->index < 0)
+            {
+                pKey->n = 0;
+            }
+            else if ((i = benchFind(pKey, sh->delVal, sh->delLen,
+                                    NULL)) >= 0)
+            {
+                benchRemove(pKey, i);
+            }
+            break;
+        case OP_WIPE:
+            memset(pState, 0, sizeof(*pState));
+            break;
+        default:
+            break;
+    }
+}
+
+// Reads all settings of a key back
+static void benchRead(bench_key_t *pKey, uint8_t key)
+{
+    uint16_t len;
+
+    for (pKey->n = 0; pKey->n <= BENCH_VALUES; pKey->n++)
+    {
+        uint8_t buf[BENCH_VALLEN + 1];
+
+        len = sizeof(buf);
+        if (otPlatSettingsGet(NULL, key, pKey->n, buf, &len) !=
+            OT_ERROR_NONE)
+        {
+            break;
+        }
+        if ((pKey->n == BENCH_VALUES) || (len > BENCH_VALLEN))
+        {
+            benchFail("more settings than written", sh->next);
+        }
+        pKey->len[pKey->n] = len;
+        memcpy(pKey->val[pKey->n], buf, len);
+    }
+}
+
+/**
+ * @brief Checks the settings after a boot against the model. A call that
+ *        was in flight may be lost or done, a commit as a whole.
+ */
+static void benchCheckBoot(void)
+{
+    static bench_state_t after;
+    const bench_op_t *pOp = (sh->inFlight >= 0) ? &ops[sh->inFlight] : NULL;
+    bool partial = (pOp != NULL) &&
+                   (((pOp->kind == OP_SET) && (sh->cur.key[pOp->key].n > 0)) ||
+                    ((pOp->kind == OP_DELETE) && (pOp->index < 0)) ||
+                    (pOp->kind == OP_WIPE));
+    bool isBefore = true;
+    bool isAfter = true;
+    uint8_t key;
+
+    after = (pOp == NULL) ? sh->cur :
+            (pOp->kind == OP_COMMIT) ? sh->stage : sh->cur;
+    if (pOp != NULL)
+    {
+        benchApply(&after, pOp);
+    }
+
+    for (key = 0; key < BENCH_KEYS; key++)
+    {
+        bench_key_t got;
+        bool before;
+        bool done;
+
+        benchRead(&got, key);
+        before = benchSubset(&got, &sh->cur.key[key], NULL);
+        done = benchSubset(&got, &after.key[key], NULL);
+        if (!before && !done &&
+            !(partial && benchSubset(&got, &sh->cur.key[key],
+                                     &after.key[key])))
+        {
+            printf("key %u: %u settings, expected %u or %u\n", key, got.n,
+                   sh->cur.key[key].n, after.key[key].n);
+            benchFail("settings lost after boot",
+                      (pOp != NULL) ? (uint32_t)sh->inFlight : sh->next);
+        }
+        isBefore = isBefore && before;
+        isAfter = isAfter && done;
+        sh->cur.key[key] = got;
+    }
+    if ((pOp != NULL) && (pOp->kind == OP_COMMIT) && !isBefore && !isAfter)
+    {
+        benchFail("commit applied in part", sh->inFlight);
+    }
+    sh->inFlight = -1;
+    sh->inChange = false;
+}
+
+static void benchTime(uint8_t kind, uint64_t t0)
+{
+    uint64_t ns = benchNs() - t0;
+    bench_stat_t *pStat = &sh->stat[kind];
+
+    pStat->count++;
+    pStat->totalNs += ns;
+    if (ns > pStat->maxNs)
+    {
+        pStat->maxNs = ns;
+        pStat->maxOp = sh->next;
+    }
+}
+
+/**
+ * @brief Does one call of the workload, timed, and checks its result
+ *
+ * @param pOp call
+ */
+static void benchDo(const bench_op_t *pOp)
+{
+    bench_state_t *pState = sh->inChange ? &sh->stage : &sh->cur;
+    bench_key_t *pKey = &pState->key[pOp->key];
+    uint8_t buf[BENCH_VALLEN + 1];
+    uint16_t len = sizeof(buf);
+    otError expect = OT_ERROR_NONE;
+    otError error = OT_ERROR_NONE;
+    uint64_t t0;
+
+    if ((pOp->kind == OP_DELETE) && (pOp->index >= 0))
+    {
+        // The setting at an index is only known by reading it, untimed.
+        // Deleting all settings of a key succeeds if there are none.
+        sh->delLen = 0;
+        if (!otPlatSettingsGet(NULL, pOp->key, pOp->index, buf, &len))
+        {
+            sh->delLen = len;
+            memcpy(sh->delVal, buf, len);
+        }
+        else
+        {
+            expect = OT_ERROR_NOT_FOUND;
+        }
+    }
+    else if ((pOp->kind == OP_ADD) && (pKey->n == BENCH_VALUES))
+    {
+        benchFail("too many settings for the key", sh->next);
+    }
+
+    // The model is updated once the call is done, the Flash may not be
+    if (!sh->inChange || (pOp->kind == OP_COMMIT))
+    {
+        sh->inFlight = sh->next;
+    }
+    t0 = benchNs();
+    switch (pOp->kind)
+    {
+        case OP_GET:
+            error = otPlatSettingsGet(NULL, pOp->key, pOp->index, buf, &len);
+            break;
+        case OP_SET:
+            error = otPlatSettingsSet(NULL, pOp->key, pool + pOp->val,
+                                      pOp->len);
+            break;
+        case OP_ADD:
+            error = otPlatSettingsAdd(NULL, pOp->key, pool + pOp->val,
+                                      pOp->len);
+            break;
+        case OP_DELETE:
+            error = otPlatSettingsDelete(NULL, pOp->key, pOp->index);
+            break;
+        case OP_BEGIN:
+            error = otPlatSettingsBeginChange(NULL);
+            expect = sh->inChange ? OT_ERROR_ALREADY : OT_ERROR_NONE;
+            break;
+        case OP_COMMIT:
+            error = otPlatSettingsCommitChange(NULL);
+            break;
+        case OP_ABANDON:
+            error = otPlatSettingsAbandonChange(NULL);
+            break;
+        case OP_WIPE:
+            otPlatSettingsWipe(NULL);
+            break;
+    }
+    benchTime(pOp->kind, t0);
+
+    if (pOp->kind == OP_GET)
+    {
+        if (pOp->index < pKey->n)
+        {
+            if ((error != OT_ERROR_NONE) ||
+                (benchFind(pKey, buf, len, NULL) < 0))
+            {
+                benchFail("get returned a wrong value", sh->next);
+            }
+        }
+        else if (error != OT_ERROR_NOT_FOUND)
+        {
+            benchFail("get found a setting that was not written", sh->next);
+        }
+        return;
+    }
+    if (error != expect)
+    {
+        printf("error %d, expected %d\n", error, expect);
+        benchFail(opNames[pOp->kind], sh->next);
+    }
+    sh->inFlight = -1;
+    if (error != OT_ERROR_NONE)
+    {
+        return;
+    }
+
+    switch (pOp->kind)
+    {
+        case OP_BEGIN:
+            sh->stage = sh->cur;
+            sh->inChange = true;
+            break;
+        case OP_COMMIT:
+            if (sh->inChange)
+            {
+                sh->cur = sh->stage;
+            }
+            sh->inChange = false;
+            break;
+        case OP_ABANDON:
+            sh->inChange = false;
+            break;
+        case OP_WIPE:
+            benchApply(&sh->cur, pOp);
+            sh->inChange = false;
+            break;
+        default:
+            benchApply(pState, pOp);
+            break;
+    }
+}
+
+//*****************************************************************************
+// Boots
+//*****************************************************************************
+
+/**
+ * @brief One boot, in a forked process: mounts the settings, checks them and
+ *        runs the workload up to the next reboot
+ */
+static void benchBoot(void)
+{
+    HOSTNV_counts_t counts;
+    uint64_t t0;
+    int i;
+
+    if (sh->failAt >= (int32_t)sh->flashOps)
+    {
+        HOSTNV_failAt(sh->failAt - sh->flashOps, sh->torn);
+    }
+    HOSTNV_clearCounts();
+    if (useQueue)
+    {
+        NVQUEUE_taskCreate();
+    }
+
+    t0 = benchNs();
+    otPlatSettingsInit(NULL);
+    benchTime(OP_INIT, t0);
+
+    if (!sh->loaded)
+    {
+        // The Flash may hold settings from before the workload
+        for (i = 0; i < BENCH_KEYS; i++)
+        {
+            benchRead(&sh->cur.key[i], i);
+        }
+        sh->loaded = true;
+    }
+    benchCheckBoot();
+
+    while (sh->next < numOps)
+    {
+        const bench_op_t *pOp = &ops[sh->next];
+
+        if (pOp->kind == OP_REBOOT)
+        {
+            sh->stat[OP_REBOOT].count++;
+            sh->next++;
+            break;
+        }
+        benchDo(pOp);
+        sh->next++;
+    }
+
+    if (useQueue)
+    {
+        NVQUEUE_stats_t queue;
+
+        if (NVQUEUE_flush())
+        {
+            benchFail("queued write failed", sh->next);
+        }
+        NVQUEUE_getStats(&queue);
+        sh->queue.ops += queue.ops;
+        sh->queue.flushOps += queue.flushOps;
+        sh->queue.fullWaits += queue.fullWaits;
+        if (queue.maxDepth > sh->queue.maxDepth)
+        {
+            sh->queue.maxDepth = queue.maxDepth;
+            sh->queue.maxBytes = queue.maxBytes;
+        }
+        if (queue.maxLatency > sh->queue.maxLatency)
+        {
+            sh->queue.maxLatency = queue.maxLatency;
+        }
+    }
+    HOSTNV_getCounts(&counts);
+    sh->flashOps += counts.ops;
+    sh->counts.writes += counts.writes;
+    sh->counts.erases += counts.erases;
+    sh->counts.bytes += counts.bytes;
+    for (i = 0; i < HOSTNV_MAXPAGES; i++)
+    {
+        sh->counts.pageErases[i] += counts.pageErases[i];
+    }
+    exit(0);
+}
+
+/**
+ * @brief Runs the workload from the Flash as it is, boot after boot, and a
+ *        last boot that only checks the settings
+ *
+ * @return true if a power loss stopped a boot
+ */
+static bool benchRun(void)
+{
+    bool powerFail = false;
+    bool last = false;
+
+    sh->next = 0;
+    sh->flashOps = 0;
+    sh->inFlight = -1;
+    sh->inChange = false;
+    sh->loaded = false;
+
+    while (!last)
+    {
+        pid_t pid;
+        int status;
+
+        last = (sh->next >= numOps);
+        fflush(stdout);
+        pid = fork();
+        if (pid == 0)
+        {
+            benchBoot();
+        }
+        if ((pid < 0) || (waitpid(pid, &status, 0) != pid))
+        {
+            perror("nvbench");
+            exit(2);
+        }
+        sh->boots++;
+        if (WIFEXITED(status) && (WEXITSTATUS(status) == HOSTNV_POWERFAIL))
+        {
+            // The boot after the power loss finds the call in flight
+            sh->failAt = -1;
+            powerFail = true;
+            last = false;
+        }
+        else if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+        {
+            if (WIFSIGNALED(status))
+            {
+                printf("FAIL: signal %d\n", WTERMSIG(status));
+            }
+            exit(1);
+        }
+    }
+    return (powerFail);
+}
+
+static void benchReport(uint64_t wallNs)
+{
+    uint64_t totalNs = 0;
+    uint32_t calls = 0;
+    uint32_t maxErases = 0;
+    int worst = OP_GET;
+    int i;
+
+    printf("%-8s %8s %10s %10s %8s\n", "call", "count", "mean us", "max us",
+           "at call");
+    for (i = 0; i < OP_KINDS; i++)
+    {
+        bench_stat_t *pStat = &sh->stat[i];
+
+        if (pStat->count == 0)
+        {
+            continue;
+        }
+        if (i == OP_REBOOT)
+        {
+            printf("%-8s %8u\n", opNames[i], pStat->count);
+            continue;
+        }
+        printf("%-8s %8u %10.2f %10.2f %8u\n", opNames[i], pStat->count,
+               pStat->totalNs / 1000.0 / pStat->count, pStat->maxNs / 1000.0,
+               pStat->maxOp);
+        if (i != OP_INIT)
+        {
+            calls += pStat->count;
+            totalNs += pStat->totalNs;
+            if (pStat->maxNs > sh->stat[worst].maxNs)
+            {
+                worst = i;
+            }
+        }
+    }
+    for (i = 0; i < HOSTNV_MAXPAGES; i++)
+    {
+        if (sh->counts.pageErases[i] > maxErases)
+        {
+            maxErases = sh->counts.pageErases[i];
+        }
+    }
+
+    printf("calls/s  %.0f (%u calls in %.3f ms, %.3f ms with boots)\n",
+           (totalNs > 0) ? calls * 1e9 / totalNs : 0.0, calls, totalNs / 1e6,
+           wallNs / 1e6);
+    printf("worst    %s %.2f us at call %u\n", opNames[worst],
+           sh->stat[worst].maxNs / 1000.0, sh->stat[worst].maxOp);
+    printf("flash    %llu bytes in %u writes, %u erases, %u of one page, "
+           "%u boots\n", (unsigned long long)sh->counts.bytes,
+           sh->counts.writes, sh->counts.erases, maxErases, sh->boots);
+    if (useQueue)
+    {
+        printf("queue    %u by the NV task, %u by callers, max depth %u "
+               "(%u bytes), %u full waits, max latency %u us\n",
+               sh->queue.ops, sh->queue.flushOps, sh->queue.maxDepth,
+               sh->queue.maxBytes, sh->queue.fullWaits,
+               sh->queue.maxLatency * 10);
+    }
+}
+
+static void benchUsage(void)
+{
+    fprintf(stderr,
+            "usage: nvbench [options] [trace]\n"
+            "  -n pages   NV pages (default %d)\n"
+            "  -f file    Flash image file, created erased if missing\n"
+            "  -o file    save the Flash image at the end\n"
+            "  -c count   synthetic workload calls (default %d)\n"
+            "  -s seed    synthetic workload seed (default 1)\n"
+            "  -m count   synthetic workload children (default %d, max %d)\n"
+            "  -w file    save the workload as a trace\n"
+            "  -q         go through the write-behind queue and NV task\n"
+            "  -p         power loss at every Flash write and erase\n"
+            "  -k step    with -p, power loss at every step-th operation\n"
+            "  -t         with -p, tear the failing operation\n",
+            BENCH_PAGES, BENCH_OPS, BENCH_CHILDREN, BENCH_VALUES);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    const char *image = NULL;
+    const char *out = NULL;
+    const char *save = NULL;
+    uint32_t count = BENCH_OPS;
+    uint32_t step = 1;
+    uint8_t pages = BENCH_PAGES;
+    bool powerFail = false;
+    bool torn = false;
+    uint64_t t0;
+    int opt;
+
+    randState = 1;
+    while ((opt = getopt(argc, argv, "n:f:o:c:s:m:w:qpk:t")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': pages = atoi(optarg); break;
+            case 'f': image = optarg; break;
+            case 'o': out = optarg; break;
+            case 'c': count = strtoul(optarg, NULL, 0); break;
+            case 's': randState = strtoul(optarg, NULL, 0) | 1; break;
+            case 'm': maxChildren = atoi(optarg); break;
+            case 'w': save = optarg; break;
+            case 'q': useQueue = true; break;
+            case 'p': powerFail = true; break;
+            case 'k': step = strtoul(optarg, NULL, 0); break;
+            case 't': torn = true; break;
+            default: benchUsage();
+        }
+    }
+    if ((optind < argc - 1) || (step == 0) || (powerFail && useQueue) ||
+        (maxChildren > BENCH_VALUES))
+    {
+        benchUsage();
+    }
+
+    if (optind < argc)
+    {
+        benchTrace(argv[optind]);
+        printf("workload %s, %u calls\n", argv[optind], numOps);
+    }
+    else
+    {
+        benchSynthetic(count);
+        printf("workload synthetic, %u calls\n", numOps);
+    }
+    if (save != NULL)
+    {
+        benchSave(save);
+    }
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    sh = mmap(NULL, sizeof(*sh), PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (sh == MAP_FAILED)
+    {
+        perror("nvbench");
+        return (2);
+    }
+    memset(sh, 0, sizeof(*sh));
+    sh->failAt = -1;
+    sh->injected = -1;
+    HOSTNV_open(image, pages);
+    printf("%u pages%s\n", pages, useQueue ? ", write-behind queue" : "");
+
+    if (powerFail)
+    {
+        uint8_t *pImage = malloc(HOSTNV_size());
+        uint32_t total;
+        uint32_t k;
+        uint32_t fails = 0;
+        uint32_t runs = 0;
+
+        // A run without power loss counts the Flash operations
+        memcpy(pImage, HOSTNV_flash(), HOSTNV_size());
+        benchRun();
+        total = sh->flashOps;
+        printf("power loss at %u of %u Flash operations%s\n",
+               (total + step - 1) / step, total, torn ? ", torn" : "");
+
+        for (k = 0; k < total; k += step)
+        {
+            memcpy(HOSTNV_flash(), pImage, HOSTNV_size());
+            sh->failAt = k;
+            sh->injected = k;
+            sh->torn = torn;
+            fails += benchRun();
+            runs++;
+        }
+        printf("%u power losses recovered, %u boots\n", fails, sh->boots);
+        free(pImage);
+        if (fails != runs)
+        {
+            // The workload did not do the same Flash operations again
+            printf("FAIL: %u runs without a power loss\n", runs - fails);
+            return (1);
+        }
+    }
+    else
+    {
+        t0 = benchNs();
+        benchRun();
+        benchReport(benchNs() - t0);
+    }
+
+    if (out != NULL)
+    {
+        FILE *pFile = fopen(out, "wb");
+
+        if ((pFile == NULL) ||
+            (fwrite(HOSTNV_flash(), 1, HOSTNV_size(), pFile) !=
+             HOSTNV_size()) || fclose(pFile))
+        {
+            perror(out);
+            return (2);
+        }
+    }
+    return (0);
+}
@@ -0,0 +1,406 @@
+/******************************************************************************
+
+ @file nvdump.c
+
+ @brief Offline analyser of NVOCTP Flash dumps
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+//*****************************************************************************
+// Overview
+//*****************************************************************************
+/*
+Decodes a dump of the NVOCTP pages of a device and reports how the ring is
+used. The driver source is compiled into this tool, so the page and item
+layouts are the ones of nvoctp.c, for the same configuration macros.
+
+The page headers are decoded from the dump as read. The dump is then copied
+to the RAM Flash of hostnv.c (the file is never written) and mounted with the
+driver's initNV(), which is timed, as are readItem() lookups of every live
+item. A mount that recovers from an interrupted compaction or retires a
+duplicate writes to Flash; these writes are reported. NVOCTP_getUsage() then
+gives the live and dead bytes, the corrupted areas (bad CRC or no valid item
+header), the writes left before the next compaction, and every item, from
+which the per page and per sysid/itemid totals are made. With -v every item
+is listed with its location and header bits.
+*/
+
+//*****************************************************************************
+// Includes
+//*****************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hostnv.h"
+
+// The driver itself, for its layout definitions and ring state. Its page
+// numbers are Flash pages, NVOCTP_nvBegPage is the first page of the dump.
+#include "nvoctp.c"
+
+//*****************************************************************************
+// Constants and Definitions
+//*****************************************************************************
+
+#define DUMP_LOOKUPS    10000   // Default number of timed lookups
+#define DUMP_IDS        64      // sysid/itemid pairs reported
+#define DUMP_ITEMS      2048    // Live items looked up
+
+//*****************************************************************************
+// Typedefs
+//*****************************************************************************
+
+// Usage of one sysid/itemid pair, all its sub IDs
+typedef struct
+{
+    uint8_t sysid;
+    uint16_t itemid;
+    uint16_t items;
+    uint32_t liveBytes;
+    uint32_t deadBytes;
+} dump_id_t;
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static dump_id_t idUse[DUMP_IDS];
+static uint8_t numIds;
+static bool moreIds;
+static uint32_t posLive[NVOCTP_MAXPAGES];
+static uint32_t posDead[NVOCTP_MAXPAGES];
+static NVINTF_itemID_t liveIds[DUMP_ITEMS];
+static uint16_t liveLens[DUMP_ITEMS];
+static uint16_t numLive;
+static uint8_t itemBuf[FLASH_PAGE_SIZE];
+
+//*****************************************************************************
+// Functions
+//*****************************************************************************
+
+static void dumpUsage(void)
+{
+    fprintf(stderr,
+            "usage: nvdump [options] image\n"
+            "  -l count   timed lookups (default %d, 0 for none)\n"
+            "  -v         list every item\n",
+            DUMP_LOOKUPS);
+    exit(2);
+}
+
+static const char *dumpPageState(uint8_t state)
+{
+    switch (state)
+    {
+        case NVOCTP_PGCLEAR:  return ("clear");
+        case NVOCTP_PGERASED: return ("erased");
+        case NVOCTP_PGACTIVE: return ("active");
+        case NVOCTP_PGXFER:   return ("xfer");
+        default:              return ("unknown");
+    }
+}
+
+static void dumpPages(uint8_t pages)
+{
+    const uint8_t *pFlash = HOSTNV_flash();
+    uint8_t pg;
+
+    printf("page  state    cycle  version  signature\n");
+    for (pg = 0; pg < pages; pg++)
+    {
+        const uint8_t *pHdr = pFlash + (uint32_t)pg * FLASH_PAGE_SIZE;
+
+        printf("%4u  %-7s  %5u     0x%02x       0x%02x%s\n", pg,
+               dumpPageState(pHdr[NVOCTP_PGHDRPST]), pHdr[NVOCTP_PGHDRCYC],
+               pHdr[NVOCTP_PGHDRVER], pHdr[NVOCTP_PGHDRSIG],
+               ((pHdr[NVOCTP_PGHDRPST] != NVOCTP_PGCLEAR) &&
+                ((pHdr[NVOCTP_PGHDRVER] != NVOCTP_VERSION) ||
+                 (pHdr[NVOCTP_PGHDRSIG] != NVOCTP_SIGNATURE))) ?
+               "  not formatted by this driver" : "");
+    }
+}
+
+static void dumpItem(uint8_t pos, NVINTF_itemID_t id, uint16_t len,
+                     bool live)
+{
+    uint8_t i;
+
+    for (i = 0; i < numIds; i++)
+    {
+        if ((idUse[i].sysid == id.systemID) && (idUse[i].itemid == id.itemID))
+        {
+            break;
+        }
+    }
+    if (i == numIds)
+    {
+        if (numIds == DUMP_IDS)
+        {
+            moreIds = true;
+            i = DUMP_IDS;
+        }
+        else
+        {
+            idUse[i].sysid = id.systemID;
+            idUse[i].itemid = id.itemID;
+            numIds++;
+        }
+    }
+
+    if (live)
+    {
+        posLive[pos] += len;
+        if (i < DUMP_IDS)
+        {
+            idUse[i].items++;
+            idUse[i].liveBytes += len;
+        }
+        if (numLive < DUMP_ITEMS)
+        {
+            liveIds[numLive] = id;
+            liveLens[numLive] = len - NVOCTP_ITEMHDRLEN;
+            numLive++;
+        }
+    }
+    else
+    {
+        posDead[pos] += len;
+        if (i < DUMP_IDS)
+        {
+            idUse[i].deadBytes += len;
+        }
+    }
+}
+
+static void dumpList(void)
+{
+    uint8_t pg = NVOCTP_tailPg;
+    uint8_t i;
+
+    printf("page  offset  sysid  itemid  subid    len  state\n");
+    for (i = 0; i < NVOCTP_PGUSED(); i++, pg = NVOCTP_NEXTPG(pg))
+    {
+        uint16_t ofs = NVOCTP_PGEND(pg);
+        NVOCTP_itemHdr_t iHdr;
+
+        // Newest first, as the driver reads them
+        while (NVOCTP_prevItem(pg, &ofs, FALSE, &iHdr))
+        {
+            const char *pState = "deleted";
+
+            if ((iHdr.stats & NVOCTP_ACTIVEIDBIT) &&
+                !(iHdr.stats & NVOCTP_VALIDIDBIT))
+            {
+                uint8_t fPg = NVOCTP_activePg;
+
+                pState = ((NVOCTP_findItem(&fPg, NVOCTP_pgOff, iHdr.cmpid,
+                                           NVOCTP_FINDSTRICT) == iHdr.hofs) &&
+                          (fPg == pg)) ? "live" : "old copy";
+            }
+            printf("%4u  0x%04x  %5u  %6u  %5u  %5u  %s\n",
+                   pg - NVOCTP_nvBegPage, iHdr.hofs,
+                   iHdr.sysid, iHdr.itemid, iHdr.subid, iHdr.len, pState);
+        }
+    }
+}
+
+static void dumpReport(const NVOCTP_usage_t *pUse)
+{
+    uint32_t used = pUse->liveBytes + pUse->deadBytes + pUse->badBytes;
+    uint8_t pg = NVOCTP_tailPg;
+    uint8_t i;
+
+    printf("ring     %u of %u pages, tail page %u, active page %u at 0x%04x\n",
+           pUse->pages, NVOCTP_nvPages, NVOCTP_tailPg - NVOCTP_nvBegPage,
+           NVOCTP_activePg - NVOCTP_nvBegPage, NVOCTP_pgOff);
+    printf("live     %6u bytes in %u items\n", pUse->liveBytes,
+           pUse->liveItems);
+    printf("dead     %6u bytes in %u items\n", pUse->deadBytes,
+           pUse->deadItems);
+    printf("corrupt  %6u bytes in %u areas\n", pUse->badBytes,
+           pUse->badAreas);
+    printf("fragmentation %.1f%% of the used bytes are not live\n",
+           (used != 0) ? 100.0 * (used - pUse->liveBytes) / used : 0.0);
+    printf("next compaction after %u bytes, about %u writes of %u bytes\n",
+           pUse->freeBytes, pUse->writesLeft,
+           (pUse->liveItems != 0) ? pUse->liveBytes / pUse->liveItems : 0);
+
+    printf("page  ring    live    dead    free   dead %%\n");
+    for (i = 0; i < pUse->pages; i++, pg = NVOCTP_NEXTPG(pg))
+    {
+        uint32_t pgUsed = posLive[i] + posDead[i];
+
+        printf("%4u  %4u  %6u  %6u  %6u  %6.1f\n", pg - NVOCTP_nvBegPage, i,
+               posLive[i],
+               posDead[i], FLASH_PAGE_SIZE - NVOCTP_PGEND(pg),
+               (pgUsed != 0) ? 100.0 * posDead[i] / pgUsed : 0.0);
+    }
+
+    printf("sysid  itemid  items    live    dead\n");
+    for (i = 0; i < numIds; i++)
+    {
+        printf("%5u  %6u  %5u  %6u  %6u\n", idUse[i].sysid, idUse[i].itemid,
+               idUse[i].items, idUse[i].liveBytes, idUse[i].deadBytes);
+    }
+    if (moreIds)
+    {
+        printf("(more than %u sysid/itemid pairs, the rest not shown)\n",
+               DUMP_IDS);
+    }
+}
+
+static void dumpLookups(NVINTF_nvFuncts_t *pFps, uint32_t count)
+{
+    uint64_t maxUs = 0;
+    uint64_t t0;
+    uint32_t errors = 0;
+    uint32_t i;
+
+    t0 = HOSTNV_usecs();
+    for (i = 0; i < count; i++)
+    {
+        uint16_t n = i % numLive;
+        uint64_t t1 = HOSTNV_usecs();
+
+        if (pFps->readItem(liveIds[n], 0, liveLens[n], itemBuf) !=
+            NVINTF_SUCCESS)
+        {
+            errors++;
+        }
+        t1 = HOSTNV_usecs() - t1;
+        if (t1 > maxUs)
+        {
+            maxUs = t1;
+        }
+    }
+    printf("lookups  %u of %u live items, %.2f us each, %lu us worst, "
+           "%u failed\n", count, numLive,
+           (double)(HOSTNV_usecs() - t0) / count, (unsigned long)maxUs,
+           errors);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t lookups = DUMP_LOOKUPS;
+    bool list = false;
+    NVINTF_nvFuncts_t fps;
+    NVOCTP_usage_t use;
+    HOSTNV_counts_t counts;
+    uint64_t t0;
+    uint8_t status;
+    uint8_t pages;
+    FILE *pFile;
+    long size;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "l:v")) != -1)
+    {
+        switch (opt)
+        {
+            case 'l': lookups = strtoul(optarg, NULL, 0); break;
+            case 'v': list = true; break;
+            default: dumpUsage();
+        }
+    }
+    if (optind != argc - 1)
+    {
+        dumpUsage();
+    }
+
+    pFile = fopen(argv[optind], "rb");
+    if ((pFile == NULL) || fseek(pFile, 0, SEEK_END) ||
+        ((size = ftell(pFile)) < 0) || fseek(pFile, 0, SEEK_SET))
+    {
+        perror(argv[optind]);
+        return (2);
+    }
+    if ((size % FLASH_PAGE_SIZE) || (size < 2 * FLASH_PAGE_SIZE) ||
+        (size > HOSTNV_MAXPAGES * FLASH_PAGE_SIZE))
+    {
+        fprintf(stderr, "%s: not 2 to %u pages of %u bytes\n", argv[optind],
+                HOSTNV_MAXPAGES, FLASH_PAGE_SIZE);
+        return (2);
+    }
+    pages = size / FLASH_PAGE_SIZE;
+    HOSTNV_open(NULL, pages);
+    if (fread(HOSTNV_flash(), 1, size, pFile) != (size_t)size)
+    {
+        perror(argv[optind]);
+        return (2);
+    }
+    fclose(pFile);
+
+    printf("%s, %u pages\n", argv[optind], pages);
+    dumpPages(pages);
+
+    NVOCTP_loadApiPtrsExt(&fps);
+    HOSTNV_clearCounts();
+    t0 = HOSTNV_usecs();
+    status = fps.initNV(NULL);
+    t0 = HOSTNV_usecs() - t0;
+    HOSTNV_getCounts(&counts);
+    printf("mount    %lu us, %u writes, %u erases", (unsigned long)t0,
+           counts.writes, counts.erases);
+#if NVOCTP_RAMINDEX
+    printf(", RAM index %s", NVOCTP_idxValid ? "in use" : "full");
+#endif
+    printf("\n");
+    if (status != NVINTF_SUCCESS)
+    {
+        printf("mount failed, status %u\n", status);
+        return (1);
+    }
+
+    NVOCTP_getUsage(&use, dumpItem);
+    dumpReport(&use);
+    if (list)
+    {
+        dumpList();
+    }
+    if ((lookups != 0) && (numLive != 0))
+    {
+        dumpLookups(&fps, lookups);
+    }
+
+    return (0);
+}
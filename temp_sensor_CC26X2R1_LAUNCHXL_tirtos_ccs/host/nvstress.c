@@ -0,0 +1,435 @@
+/******************************************************************************
+
+ @file nvstress.c
+
+ @brief Concurrent reader and writer stress test of the NVOCTP driver
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+//*****************************************************************************
+// Overview
+//*****************************************************************************
+/*
+Runs threads against one NVOCTP instance on the RAM Flash of hostnv.c:
+
+- two writers rewrite the items of sysid 5 with new versions and lengths,
+- a deleter creates the items of sysid 6 and deletes them all with a
+  doNext() delete search,
+- an iterator reads every item of sysid 5 with a doNext() read search, and
+  runs two find searches interleaved step by step, each with its own proxy,
+- readers look items of sysid 5 up with getItemLen() and readItem().
+
+Every item read is checked: its content must be that of one version, and
+the version must not be older than one already seen or fully written. The
+driver is built with NVOCTP_MAPPED=0, so that its reads go through
+NVS_read(), which the stand-in slows down and watches: readers must overlap
+each other, and no write or erase may happen while a read is in progress.
+*/
+
+//*****************************************************************************
+// Includes
+//*****************************************************************************
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "nvoctp.h"
+#include "hostnv.h"
+
+//*****************************************************************************
+// Constants and Definitions
+//*****************************************************************************
+
+#define STRESS_PAGES    4       // REGIONSIZE of CC26X2R1_LAUNCHXL.c
+#define STRESS_SECS     2       // Default run time
+#define STRESS_READERS  4       // Default number of reader threads
+#define STRESS_MAXTHR   32
+#define STRESS_DELAY    20      // Microseconds spent in each NVS_read()
+
+#define STRESS_KEPT     12      // Items of sysid 5, always present
+#define STRESS_TEMP     8       // Items of sysid 6, created and deleted
+#define STRESS_MAXLEN   64
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static NVINTF_nvFuncts_t nv;
+static volatile bool stop;
+
+// Newest version of each kept item that was completely written
+static volatile uint32_t written[STRESS_KEPT];
+
+static uint32_t numReads;
+static uint32_t numWrites;
+static uint32_t numDeletes;
+static uint32_t numSearches;
+
+//*****************************************************************************
+// Functions
+//*****************************************************************************
+
+static void stressFail(const char *what, unsigned item, unsigned value)
+{
+    printf("FAIL: %s, item %u, %u\n", what, item, value);
+    exit(1);
+}
+
+static uint16_t stressLen(unsigned item, uint32_t ver)
+{
+    return (8 + ((item * 7 + ver) % (STRESS_MAXLEN - 8)));
+}
+
+// Version, item number and length, then a pattern of the version
+static void stressFill(uint8_t *pBuf, unsigned item, uint32_t ver)
+{
+    uint16_t len = stressLen(item, ver);
+    uint16_t i;
+
+    memcpy(pBuf, &ver, sizeof(ver));
+    pBuf[4] = item;
+    pBuf[5] = len;
+    for (i = 6; i < len; i++)
+    {
+        pBuf[i] = (uint8_t)(ver * 31 + i + item);
+    }
+}
+
+// Checks len bytes read of an item, which may be the start of the item if it
+// was rewritten since its length was read, returns the version
+static uint32_t stressCheck(const uint8_t *pBuf, unsigned item, uint16_t len)
+{
+    uint8_t expect[STRESS_MAXLEN];
+    uint32_t ver;
+
+    memcpy(&ver, pBuf, sizeof(ver));
+    stressFill(expect, item, ver);
+    if ((len < 6) || (len > stressLen(item, ver)) ||
+        memcmp(pBuf, expect, len))
+    {
+        stressFail("item read mixes versions", item, ver);
+    }
+
+    return (ver);
+}
+
+static void *stressWriter(void *arg)
+{
+    unsigned first = (unsigned)(uintptr_t)arg;
+    uint8_t buf[STRESS_MAXLEN];
+    uint32_t ver = 1;
+    unsigned i;
+
+    while (!stop)
+    {
+        for (i = first; i < STRESS_KEPT; i += 2)
+        {
+            NVINTF_itemID_t id = { 5, 1, i };
+
+            stressFill(buf, i, ver);
+            if (nv.writeItem(id, stressLen(i, ver), buf) != NVINTF_SUCCESS)
+            {
+                stressFail("write failed", i, ver);
+            }
+            written[i] = ver;
+        }
+        ver++;
+        __atomic_add_fetch(&numWrites, 1, __ATOMIC_RELAXED);
+    }
+
+    return (NULL);
+}
+
+static void *stressDeleter(void *arg)
+{
+    uint8_t buf[STRESS_MAXLEN];
+    uint32_t ver = 1;
+    unsigned deleted;
+    unsigned i;
+    IArg key;
+
+    (void)arg;
+    while (!stop)
+    {
+        NVINTF_nvProxy_t proxy = { 0 };
+
+        for (i = 0; i < STRESS_TEMP; i++)
+        {
+            NVINTF_itemID_t id = { 6, 2, i };
+
+            stressFill(buf, i, ver);
+            if (nv.writeItem(id, stressLen(i, ver), buf) != NVINTF_SUCCESS)
+            {
+                stressFail("write failed", i, ver);
+            }
+        }
+
+        proxy.sysid = 6;
+        proxy.itemid = 2;
+        proxy.flag = NVINTF_DOSTART | NVINTF_DOITMID | NVINTF_DODELETE;
+        key = nv.lockNV();
+        for (deleted = 0; nv.doNext(&proxy) == NVINTF_SUCCESS; deleted++)
+        {
+        }
+        nv.unlockNV(key);
+        if (deleted != STRESS_TEMP)
+        {
+            stressFail("delete search missed items", deleted, ver);
+        }
+        for (i = 0; i < STRESS_TEMP; i++)
+        {
+            NVINTF_itemID_t id = { 6, 2, i };
+
+            if (nv.getItemLen(id) != 0)
+            {
+                stressFail("item not deleted", i, ver);
+            }
+        }
+        ver++;
+        __atomic_add_fetch(&numDeletes, 1, __ATOMIC_RELAXED);
+    }
+
+    return (NULL);
+}
+
+static void *stressIterator(void *arg)
+{
+    uint8_t buf[STRESS_MAXLEN];
+    uint8_t status;
+    unsigned found;
+    IArg key;
+
+    (void)arg;
+    while (!stop)
+    {
+        NVINTF_nvProxy_t read = { 0 };
+        NVINTF_nvProxy_t bySys = { 0 };
+        NVINTF_nvProxy_t byItem = { 0 };
+        unsigned numSys = 0;
+        unsigned numItem = 0;
+        bool doneSys = false;
+        bool doneItem = false;
+
+        read.sysid = 5;
+        read.itemid = 1;
+        read.buffer = buf;
+        read.len = sizeof(buf);
+        read.flag = NVINTF_DOSTART | NVINTF_DOITMID | NVINTF_DOREAD;
+        key = nv.lockNV();
+        for (found = 0; (status = nv.doNext(&read)) == NVINTF_SUCCESS;
+             found++)
+        {
+            (void)stressCheck(buf, read.subid, read.len);
+            read.len = sizeof(buf);
+        }
+        nv.unlockNV(key);
+        if ((status != NVINTF_NOTFOUND) || (found != STRESS_KEPT))
+        {
+            stressFail("read search", found, status);
+        }
+
+        // Two searches in turn, each keeps its state in its own proxy
+        bySys.sysid = 5;
+        bySys.flag = NVINTF_DOSTART | NVINTF_DOSYSID | NVINTF_DOFIND;
+        byItem.sysid = 5;
+        byItem.itemid = 1;
+        byItem.flag = NVINTF_DOSTART | NVINTF_DOITMID | NVINTF_DOFIND;
+        key = nv.lockNV();
+        while (!doneSys || !doneItem)
+        {
+            if (!doneSys)
+            {
+                doneSys = (nv.doNext(&bySys) != NVINTF_SUCCESS);
+                numSys += !doneSys;
+            }
+            if (!doneItem)
+            {
+                doneItem = (nv.doNext(&byItem) != NVINTF_SUCCESS);
+                numItem += !doneItem;
+            }
+        }
+        nv.unlockNV(key);
+        if ((numSys != STRESS_KEPT) || (numItem != STRESS_KEPT))
+        {
+            stressFail("interleaved searches", numSys, numItem);
+        }
+        __atomic_add_fetch(&numSearches, 1, __ATOMIC_RELAXED);
+    }
+
+    return (NULL);
+}
+
+static void *stressReader(void *arg)
+{
+    uint32_t seen[STRESS_KEPT] = { 0 };
+    unsigned seed = (unsigned)(uintptr_t)arg;
+    uint8_t buf[STRESS_MAXLEN];
+
+    while (!stop)
+    {
+        unsigned i = rand_r(&seed) % STRESS_KEPT;
+        NVINTF_itemID_t id = { 5, 1, i };
+        uint32_t floor = written[i];
+        uint32_t len = nv.getItemLen(id);
+        uint32_t ver;
+        uint8_t status;
+
+        if ((len == 0) || (len > sizeof(buf)))
+        {
+            stressFail("bad item length", i, len);
+        }
+        status = nv.readItem(id, 0, len, buf);
+        if ((status == NVINTF_BADLENGTH) || (status == NVINTF_BADOFFSET))
+        {
+            // Rewritten shorter since its length was read
+            continue;
+        }
+        if (status != NVINTF_SUCCESS)
+        {
+            stressFail("read failed", i, status);
+        }
+        ver = stressCheck(buf, i, len);
+        if ((ver < seen[i]) || (ver < floor))
+        {
+            stressFail("older version read", i, ver);
+        }
+        seen[i] = ver;
+        __atomic_add_fetch(&numReads, 1, __ATOMIC_RELAXED);
+    }
+
+    return (NULL);
+}
+
+static void stressUsage(void)
+{
+    fprintf(stderr,
+            "usage: nvstress [options]\n"
+            "  -d secs    run time (default %d)\n"
+            "  -r count   reader threads (default %d)\n",
+            STRESS_SECS, STRESS_READERS);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned secs = STRESS_SECS;
+    unsigned readers = STRESS_READERS;
+    pthread_t threads[STRESS_MAXTHR];
+    uint8_t buf[STRESS_MAXLEN];
+    HOSTNV_counts_t counts;
+    unsigned n = 0;
+    unsigned i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:r:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'd': secs = strtoul(optarg, NULL, 0); break;
+            case 'r': readers = strtoul(optarg, NULL, 0); break;
+            default: stressUsage();
+        }
+    }
+    if ((optind != argc) || (readers > STRESS_MAXTHR - 4))
+    {
+        stressUsage();
+    }
+
+    HOSTNV_open(NULL, STRESS_PAGES);
+    NVOCTP_loadApiPtrsExt(&nv);
+    if (nv.initNV(NULL) != NVINTF_SUCCESS)
+    {
+        stressFail("init failed", 0, 0);
+    }
+    for (i = 0; i < STRESS_KEPT; i++)
+    {
+        NVINTF_itemID_t id = { 5, 1, i };
+
+        stressFill(buf, i, 0);
+        if (nv.writeItem(id, stressLen(i, 0), buf) != NVINTF_SUCCESS)
+        {
+            stressFail("write failed", i, 0);
+        }
+    }
+
+    HOSTNV_readDelay(STRESS_DELAY);
+    HOSTNV_clearCounts();
+    pthread_create(&threads[n++], NULL, stressWriter, (void *)0);
+    pthread_create(&threads[n++], NULL, stressWriter, (void *)1);
+    pthread_create(&threads[n++], NULL, stressDeleter, NULL);
+    pthread_create(&threads[n++], NULL, stressIterator, NULL);
+    for (i = 0; i < readers; i++)
+    {
+        pthread_create(&threads[n++], NULL, stressReader,
+                       (void *)(uintptr_t)(i + 1));
+    }
+    sleep(secs);
+    stop = true;
+    for (i = 0; i < n; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    HOSTNV_getCounts(&counts);
+    printf("%u readers, %u s: %u reads, %u write rounds, %u delete rounds, "
+           "%u search rounds\n", readers, secs, numReads, numWrites,
+           numDeletes, numSearches);
+    printf("Flash: %u reads, at most %u at once, %u writes, %u erases, "
+           "%u done during a read\n", counts.reads, counts.maxReaders,
+           counts.writes, counts.erases, counts.opsInRead);
+    if (counts.opsInRead != 0)
+    {
+        printf("FAIL: Flash written while being read\n");
+        return (1);
+    }
+    if ((readers > 1) && (counts.maxReaders < 2))
+    {
+        printf("FAIL: readers never overlapped\n");
+        return (1);
+    }
+
+    return (0);
+}
@@ -0,0 +1,476 @@
+/******************************************************************************
+
+ @file observetest.c
+
+ @brief Loopback test of the CoAP Observe support
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+//*****************************************************************************
+// Overview
+//*****************************************************************************
+/*
+Runs coap_observe.c against the loopback CoAP stand-in of hostcoap.c, with
+the test as the clients. Requests are built as a client sends them, and
+every notification is parsed from its bytes as the client receives it. It
+checks
+
+  - registration, the full list, re-registration and deregistration,
+  - the options of the responses and notifications, in ascending order,
+  - that one change fans out to every observer, encoded once per format,
+  - the Observe sequence numbers, also across their 24 bit wrap,
+  - that every COAP_OBSERVE_CON_EVERY-th notification and the first one
+    after COAP_OBSERVE_CON_INTERVAL are confirmable, one at a time,
+  - that a reset or a lost confirmable notification removes the observer,
+  - that a lack of message buffers leaks none, and
+  - that every stack call is made with the stack lock held.
+*/
+
+//*****************************************************************************
+// Includes
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openthread/coap.h>
+#include <openthread/platform/alarm-milli.h>
+
+#include "otsupport/otrtosapi.h"
+#include "coap_observe.h"
+#include "hostcoap.h"
+
+//*****************************************************************************
+// Constants and Definitions
+//*****************************************************************************
+
+#define OBS_MAX_AGE     920     // Max-Age of the test resource
+#define OBS_TEXT        0       // text/plain
+#define OBS_CBOR        60      // application/cbor
+#define OBS_ABSENT      (-1)    // option not in the header
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static CoapObserve_t obs;
+static unsigned encodes;
+static uint32_t sentSoFar;
+
+static const uint8_t textRep[] = "72";
+static const uint8_t cborRep[] = { 0xA1, 0x01, 0x18, 0x48 };
+
+//*****************************************************************************
+// Functions
+//*****************************************************************************
+
+static void obsCheck(int ok, const char *what)
+{
+    if (!ok)
+    {
+        printf("FAIL: %s\n", what);
+        exit(1);
+    }
+}
+
+// Representation of the test resource
+static uint16_t obsEncode(uint16_t format, uint8_t *buf, uint16_t size)
+{
+    encodes++;
+    if ((format == OBS_CBOR) && (size >= sizeof(cborRep)))
+    {
+        memcpy(buf, cborRep, sizeof(cborRep));
+        return (sizeof(cborRep));
+    }
+    if ((format == OBS_TEXT) && (size >= sizeof(textRep) - 1))
+    {
+        memcpy(buf, textRep, sizeof(textRep) - 1);
+        return (sizeof(textRep) - 1);
+    }
+    return (0);
+}
+
+// Value of an unsigned option, OBS_ABSENT if the header does not have it.
+// Also checks that the options are in ascending order.
+static long obsOption(otCoapHeader *header, uint16_t number)
+{
+    const otCoapOption *option;
+    long value = OBS_ABSENT;
+    uint16_t last = 0;
+    uint16_t i;
+
+    for (option = otCoapHeaderGetFirstOption(header); option != NULL;
+         option = otCoapHeaderGetNextOption(header))
+    {
+        obsCheck(option->mNumber >= last, "options out of order");
+        last = option->mNumber;
+        if (option->mNumber == number)
+        {
+            obsCheck(option->mLength <= 3, "option longer than 3 bytes");
+            obsCheck((option->mLength == 0) || (option->mValue[0] != 0),
+                     "option value not in its shortest encoding");
+            for (value = 0, i = 0; i < option->mLength; i++)
+            {
+                value = (value << 8) | option->mValue[i];
+            }
+        }
+    }
+
+    return (value);
+}
+
+static void obsClientInfo(uint8_t client, otMessageInfo *info)
+{
+    memset(info, 0, sizeof(*info));
+    info->mPeerAddr.mFields.m8[0] = 0xFD;
+    info->mPeerAddr.mFields.m8[15] = client;
+    info->mPeerPort = OT_DEFAULT_COAP_PORT + client;
+}
+
+// GET of the resource from a client, with the Observe option unless
+// observe is OBS_ABSENT. Returns true if the client is registered.
+static bool obsGet(uint8_t client, uint8_t token, long observe,
+                   uint16_t format, otCoapHeader *response)
+{
+    otCoapHeader request;
+    otMessageInfo info;
+    uint8_t tok[2] = { client, token };
+    uint8_t value = (uint8_t)observe;
+    otCoapOption option = { OT_COAP_OPTION_OBSERVE, 0, &value };
+    bool registered;
+
+    otCoapHeaderInit(&request, OT_COAP_TYPE_CONFIRMABLE, OT_COAP_CODE_GET);
+    otCoapHeaderSetToken(&request, tok, sizeof(tok));
+    if (observe != OBS_ABSENT)
+    {
+        option.mLength = (observe != 0) ? 1 : 0;
+        obsCheck(otCoapHeaderAppendOption(&request, &option) == OT_ERROR_NONE,
+                 "request option");
+    }
+    obsClientInfo(client, &info);
+
+    otCoapHeaderInit(response, OT_COAP_TYPE_ACKNOWLEDGMENT,
+                     OT_COAP_CODE_CONTENT);
+    otCoapHeaderSetToken(response, tok, sizeof(tok));
+
+    OtRtosApi_lock();
+    registered = CoapObserve_request(&obs, &request, &info, response, format,
+                                     otPlatAlarmMilliGetNow());
+    OtRtosApi_unlock();
+
+    return (registered);
+}
+
+// Sends a notification at a time, returns the number of notifications
+static uint8_t obsNotify(uint32_t now)
+{
+    HOSTCOAP_counts_t counts;
+    uint8_t sent;
+
+    HOSTCOAP_getCounts(&counts);
+    sentSoFar = counts.sent;
+
+    HOSTCOAP_setTime(now);
+    OtRtosApi_lock();
+    sent = CoapObserve_notify(&obs, obsEncode, now);
+    OtRtosApi_unlock();
+
+    return (sent);
+}
+
+// The i-th notification of the last obsNotify(), parsed by its client
+static const HOSTCOAP_sent_t *obsReceive(uint8_t i, otCoapHeader *header,
+                                         const uint8_t **payload,
+                                         uint16_t *len)
+{
+    const HOSTCOAP_sent_t *sent = HOSTCOAP_sent(sentSoFar + i);
+
+    obsCheck(sent != NULL, "notification not sent");
+    obsCheck(HOSTCOAP_parse(sent, header, payload, len) == OT_ERROR_NONE,
+             "notification does not parse");
+    return (sent);
+}
+
+static void obsRegistration(void)
+{
+    otCoapHeader rsp;
+    uint8_t i;
+
+    // a plain GET and a deregistration of an unknown client do not register
+    obsCheck(!obsGet(1, 1, OBS_ABSENT, OBS_TEXT, &rsp), "plain GET observes");
+    obsCheck((obsOption(&rsp, OT_COAP_OPTION_OBSERVE) == OBS_ABSENT) &&
+             (obsOption(&rsp, OT_COAP_OPTION_CONTENT_FORMAT) == OBS_TEXT) &&
+             (obsOption(&rsp, OT_COAP_OPTION_MAX_AGE) == OBS_ABSENT),
+             "options of a plain GET response");
+    obsCheck(!obsGet(1, 1, 1, OBS_TEXT, &rsp) &&
+             (CoapObserve_count(&obs) == 0), "deregistration of a stranger");
+
+    // clients 1 to the table size register, client 2 in CBOR
+    for (i = 1; i <= COAP_OBSERVE_MAX_OBSERVERS; i++)
+    {
+        uint16_t format = (i == 2) ? OBS_CBOR : OBS_TEXT;
+
+        obsCheck(obsGet(i, 1, 0, format, &rsp), "registration");
+        obsCheck((obsOption(&rsp, OT_COAP_OPTION_OBSERVE) == 0) &&
+                 (obsOption(&rsp, OT_COAP_OPTION_CONTENT_FORMAT) == format) &&
+                 (obsOption(&rsp, OT_COAP_OPTION_MAX_AGE) == OBS_MAX_AGE),
+                 "options of a registration response");
+    }
+
+    // a full list answers as to a plain GET
+    obsCheck(!obsGet(COAP_OBSERVE_MAX_OBSERVERS + 1, 1, 0, OBS_TEXT, &rsp) &&
+             (obsOption(&rsp, OT_COAP_OPTION_OBSERVE) == OBS_ABSENT) &&
+             (CoapObserve_count(&obs) == COAP_OBSERVE_MAX_OBSERVERS),
+             "registration beyond the table");
+
+    // registering again updates the token, it does not take another slot
+    obsCheck(obsGet(2, 9, 0, OBS_CBOR, &rsp) &&
+             (CoapObserve_count(&obs) == COAP_OBSERVE_MAX_OBSERVERS),
+             "second registration of a client");
+}
+
+static void obsFanOut(void)
+{
+    otCoapHeader hdr;
+    const uint8_t *payload;
+    uint16_t len;
+    uint8_t i;
+
+    encodes = 0;
+    obsCheck(obsNotify(1000) == COAP_OBSERVE_MAX_OBSERVERS,
+             "one change does not reach every observer");
+    obsCheck(encodes == 3, "representation not encoded once per format run");
+
+    for (i = 0; i < COAP_OBSERVE_MAX_OBSERVERS; i++)
+    {
+        const HOSTCOAP_sent_t *sent = obsReceive(i, &hdr, &payload, &len);
+        uint8_t client = i + 1;
+        bool cbor = (client == 2);
+        otMessageInfo info;
+
+        obsClientInfo(client, &info);
+        obsCheck((memcmp(&sent->info.mPeerAddr, &info.mPeerAddr,
+                         sizeof(info.mPeerAddr)) == 0) &&
+                 (sent->info.mPeerPort == info.mPeerPort),
+                 "notification to the wrong client");
+        obsCheck((otCoapHeaderGetTokenLength(&hdr) == 2) &&
+                 (otCoapHeaderGetToken(&hdr)[0] == client) &&
+                 (otCoapHeaderGetToken(&hdr)[1] == (cbor ? 9 : 1)),
+                 "notification token");
+        obsCheck((otCoapHeaderGetCode(&hdr) == OT_COAP_CODE_CONTENT) &&
+                 (otCoapHeaderGetType(&hdr) ==
+                  OT_COAP_TYPE_NON_CONFIRMABLE) && (sent->handler == NULL),
+                 "first notification is not a NON 2.05");
+        obsCheck((obsOption(&hdr, OT_COAP_OPTION_OBSERVE) == 1) &&
+                 (obsOption(&hdr, OT_COAP_OPTION_CONTENT_FORMAT) ==
+                  (cbor ? OBS_CBOR : OBS_TEXT)) &&
+                 (obsOption(&hdr, OT_COAP_OPTION_MAX_AGE) == OBS_MAX_AGE),
+                 "options of a notification");
+        obsCheck(cbor ? ((len == sizeof(cborRep)) &&
+                         (memcmp(payload, cborRep, len) == 0)) :
+                        ((len == sizeof(textRep) - 1) &&
+                         (memcmp(payload, textRep, len) == 0)),
+                 "notification payload");
+    }
+
+    // deregistration needs the token of the observation
+    obsCheck(!obsGet(3, 7, 1, OBS_TEXT, &hdr) &&
+             (CoapObserve_count(&obs) == COAP_OBSERVE_MAX_OBSERVERS),
+             "deregistration with another token");
+    obsCheck(!obsGet(3, 1, 1, OBS_TEXT, &hdr) &&
+             (CoapObserve_count(&obs) == COAP_OBSERVE_MAX_OBSERVERS - 1),
+             "deregistration");
+}
+
+static void obsConfirmable(void)
+{
+    HOSTCOAP_sent_t pending[COAP_OBSERVE_MAX_OBSERVERS];
+    otCoapHeader hdr;
+    const uint8_t *payload;
+    uint16_t len;
+    unsigned cons = 0;
+    uint32_t k;
+    uint8_t i;
+    uint8_t n;
+
+    // notifications 2 to 16: every observer gets the 8th and 16th as CON
+    for (k = 2; k <= 16; k++)
+    {
+        n = obsNotify(1000 + k);
+        obsCheck(n == COAP_OBSERVE_MAX_OBSERVERS - 1, "notification lost");
+        for (i = 0; i < n; i++)
+        {
+            const HOSTCOAP_sent_t *sent = obsReceive(i, &hdr, &payload, &len);
+            bool con = (otCoapHeaderGetType(&hdr) == OT_COAP_TYPE_CONFIRMABLE);
+
+            obsCheck(obsOption(&hdr, OT_COAP_OPTION_OBSERVE) == (long)k,
+                     "sequence number");
+            obsCheck(con == ((k % COAP_OBSERVE_CON_EVERY) == 0),
+                     "CON notification out of turn");
+            obsCheck(con == (sent->handler != NULL), "CON without handler");
+            if (con)
+            {
+                // acknowledged, the CoAP layer ends the exchange early
+                cons++;
+                HOSTCOAP_setTime(1000 + k + 2000);
+                sent->handler(sent->context, NULL, NULL, NULL,
+                              OT_ERROR_RESPONSE_TIMEOUT);
+            }
+        }
+    }
+    obsCheck((cons == 2 * n) && (CoapObserve_count(&obs) == n),
+             "acknowledged observers removed");
+
+    // a CON is pending until its exchange ends, the next ones go out NON
+    for (k = 17; k <= 24; k++)
+    {
+        obsNotify(1000 + k);
+    }
+    for (i = 0; i < n; i++)
+    {
+        pending[i] = *obsReceive(i, &hdr, &payload, &len);
+        obsCheck(pending[i].handler != NULL, "24th notification is not CON");
+    }
+    for (k = 25; k <= 40; k++)
+    {
+        obsNotify(1000 + k);
+        for (i = 0; i < n; i++)
+        {
+            obsReceive(i, &hdr, &payload, &len);
+            obsCheck(otCoapHeaderGetType(&hdr) ==
+                     OT_COAP_TYPE_NON_CONFIRMABLE,
+                     "second CON while one is pending");
+        }
+    }
+
+    // the exchange of the first observer is lost, the others are reset
+    HOSTCOAP_setTime(1024 + COAP_OBSERVE_LOST_TIME);
+    for (i = 0; i < n; i++)
+    {
+        pending[i].handler(pending[i].context, NULL, NULL, NULL,
+                           (i == 0) ? OT_ERROR_RESPONSE_TIMEOUT :
+                                      OT_ERROR_ABORT);
+    }
+    obsCheck(CoapObserve_count(&obs) == 0, "unanswered observers kept");
+}
+
+static void obsInterval(void)
+{
+    otCoapHeader hdr;
+    const uint8_t *payload;
+    uint16_t len;
+
+    // a rarely notified observer is checked after the CON interval
+    HOSTCOAP_setTime(0);
+    obsCheck(obsGet(7, 1, 0, OBS_TEXT, &hdr), "registration after removal");
+    obsCheck(obsNotify(COAP_OBSERVE_CON_INTERVAL - 1) == 1, "notify");
+    obsReceive(0, &hdr, &payload, &len);
+    obsCheck(otCoapHeaderGetType(&hdr) == OT_COAP_TYPE_NON_CONFIRMABLE,
+             "CON before the interval");
+    obsCheck(obsNotify(COAP_OBSERVE_CON_INTERVAL) == 1, "notify");
+    obsReceive(0, &hdr, &payload, &len);
+    obsCheck(otCoapHeaderGetType(&hdr) == OT_COAP_TYPE_CONFIRMABLE,
+             "no CON after the interval");
+}
+
+static void obsSequenceWrap(void)
+{
+    otCoapHeader hdr;
+    const uint8_t *payload;
+    uint16_t len;
+
+    obs.seq = 0xFFFFFE;
+    obsNotify(COAP_OBSERVE_CON_INTERVAL + 1);
+    obsReceive(0, &hdr, &payload, &len);
+    obsCheck(obsOption(&hdr, OT_COAP_OPTION_OBSERVE) == 0xFFFFFF,
+             "sequence number before the wrap");
+    obsNotify(COAP_OBSERVE_CON_INTERVAL + 2);
+    obsReceive(0, &hdr, &payload, &len);
+    obsCheck(obsOption(&hdr, OT_COAP_OPTION_OBSERVE) == 0,
+             "sequence number does not wrap at 24 bits");
+}
+
+static void obsBuffers(void)
+{
+    HOSTCOAP_counts_t counts;
+    otCoapHeader hdr;
+    uint8_t i;
+
+    HOSTCOAP_reset();
+    CoapObserve_init(&obs, (otInstance *)&obs, OBS_MAX_AGE);
+    for (i = 1; i <= COAP_OBSERVE_MAX_OBSERVERS; i++)
+    {
+        obsGet(i, 1, 0, OBS_TEXT, &hdr);
+    }
+
+    HOSTCOAP_allocLimit(1);
+    obsCheck(obsNotify(100) == 1, "notifications without buffers");
+    HOSTCOAP_getCounts(&counts);
+    obsCheck(counts.inUse == 0, "message buffers leaked");
+    obsCheck(CoapObserve_count(&obs) == COAP_OBSERVE_MAX_OBSERVERS,
+             "observers removed for a lack of buffers");
+}
+
+int main(void)
+{
+    HOSTCOAP_counts_t counts;
+
+    HOSTCOAP_reset();
+    CoapObserve_init(&obs, (otInstance *)&obs, OBS_MAX_AGE);
+
+    obsRegistration();
+    obsFanOut();
+    obsConfirmable();
+    obsInterval();
+    obsSequenceWrap();
+
+    HOSTCOAP_getCounts(&counts);
+    obsCheck((counts.unlocked == 0) && (counts.inUse == 0),
+             "stack called without the lock, or buffers leaked");
+    printf("Observe: %u notifications to %d observers, %u lock round-trips\n",
+           counts.sent, COAP_OBSERVE_MAX_OBSERVERS, counts.locks);
+
+    obsBuffers();
+
+    return (0);
+}
@@ -0,0 +1,299 @@
+/******************************************************************************
+
+ @file policytest.c
+
+ @brief Temperature trace replay of the reporting policy
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+//*****************************************************************************
+// Overview
+//*****************************************************************************
+/*
+Replays a temperature trace through report_policy.c the way tempsensor.c
+drives it: every sample is evaluated, a report is sent when the policy says
+so or when the sample ring is full, otherwise the reporting timer is armed
+for the time the policy returns and a report is sent when it expires. It
+counts the reports and checks that
+
+  - a sample that moved from the last reported temperature by the deadband
+    plus the hysteresis is reported within the minimum interval, and
+  - reports are no more than the heartbeat interval apart.
+
+A trace has one sample per line, the time in milliseconds and the
+temperature in degrees F. Blank lines and lines starting with # are ignored.
+*/
+
+//*****************************************************************************
+// Includes
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "report_policy.h"
+
+//*****************************************************************************
+// Constants and Definitions
+//*****************************************************************************
+
+// Defaults of tempsensor.c
+#define POLICY_DEADBAND     1
+#define POLICY_DEADBAND_PCT 0
+#define POLICY_HYSTERESIS   1
+#define POLICY_MIN_INTERVAL 30000
+#define POLICY_MAX_INTERVAL 900000
+#define POLICY_RING         8
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static ReportPolicy_config_t config = {
+    POLICY_DEADBAND,
+    POLICY_DEADBAND_PCT,
+    POLICY_HYSTERESIS,
+    POLICY_MIN_INTERVAL,
+    POLICY_MAX_INTERVAL,
+};
+static ReportPolicy_t policy;
+
+static unsigned ring = POLICY_RING; // Sample ring size, 0 for no ring
+static unsigned pending;            // Samples not reported yet
+static int32_t lastValue;           // Last sampled temperature
+static uint32_t timerAt;            // Reporting timer expiry
+
+static unsigned reports;
+static int32_t refValue;            // Last reported temperature
+static uint32_t refTime;            // Time of the last report
+static int changed;                 // A significant change waits
+static uint32_t changeAt;           // Time of that change
+static uint32_t maxDelay;           // Longest wait of a significant change
+static uint32_t maxGap;             // Longest time between two reports
+
+//*****************************************************************************
+// Functions
+//*****************************************************************************
+
+static void policyUsage(void)
+{
+    fprintf(stderr,
+            "usage: policytest [options] trace\n"
+            "  -d degrees  deadband (default %d, 0 if unused)\n"
+            "  -p percent  relative deadband (default %d, 0 if unused)\n"
+            "  -y degrees  hysteresis (default %d)\n"
+            "  -m ms       minimum interval (default %d)\n"
+            "  -x ms       heartbeat interval (default %d)\n"
+            "  -b samples  sample ring size (default %d, 0 for no ring)\n"
+            "  -o ms       offset added to the trace times\n"
+            "  -e reports  fail with more reports than this\n",
+            POLICY_DEADBAND, POLICY_DEADBAND_PCT, POLICY_HYSTERESIS,
+            POLICY_MIN_INTERVAL, POLICY_MAX_INTERVAL, POLICY_RING);
+    exit(2);
+}
+
+// True if a value moved from the last report by more than the policy can
+// hold back, whatever the direction of the last change
+static int policySignificant(int32_t value)
+{
+    int32_t diff = abs(value - refValue) - config.hysteresis;
+
+    if (diff <= 0)
+    {
+        return (0);
+    }
+    if ((config.absDeadband == 0) && (config.relDeadband == 0))
+    {
+        return (1);
+    }
+
+    return (((config.absDeadband != 0) && (diff >= config.absDeadband)) ||
+            ((config.relDeadband != 0) &&
+             ((int64_t)diff * 100 >=
+              (int64_t)abs(refValue) * config.relDeadband)));
+}
+
+// tempSensorReport(): restarts the timer and reports the pending samples
+static void policyReport(uint32_t now)
+{
+    timerAt = now + config.maxInterval;
+    if (pending == 0)
+    {
+        return;
+    }
+
+    if ((reports != 0) && (now - refTime > maxGap))
+    {
+        maxGap = now - refTime;
+    }
+    if (changed && (now - changeAt > maxDelay))
+    {
+        maxDelay = now - changeAt;
+    }
+
+    pending = 0;
+    reports++;
+    refValue = lastValue;
+    refTime = now;
+    changed = 0;
+    ReportPolicy_reported(&policy, lastValue, now);
+}
+
+// tempSensorSample(), after the timer has run up to the sample time
+static void policySample(int32_t value, uint32_t now)
+{
+    uint32_t due;
+
+    while ((reports != 0) && ((int32_t)(now - timerAt) >= 0))
+    {
+        policyReport(timerAt);
+    }
+
+    lastValue = value;
+    if ((ring == 0) || (pending < ring))
+    {
+        pending++;
+    }
+    if ((reports != 0) && !changed && policySignificant(value))
+    {
+        changed = 1;
+        changeAt = now;
+    }
+
+    due = ReportPolicy_sample(&policy, value, now);
+    if ((due == 0) || (pending == ring))
+    {
+        policyReport(now);
+    }
+    else
+    {
+        timerAt = now + due;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long maxReports = 0;
+    uint32_t offset = 0;
+    uint32_t first = 0;
+    uint32_t last = 0;
+    unsigned samples = 0;
+    char line[128];
+    FILE *trace;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:p:y:m:x:b:o:e:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'd': config.absDeadband = atoi(optarg); break;
+            case 'p': config.relDeadband = atoi(optarg); break;
+            case 'y': config.hysteresis = atoi(optarg); break;
+            case 'm': config.minInterval = strtoul(optarg, NULL, 0); break;
+            case 'x': config.maxInterval = strtoul(optarg, NULL, 0); break;
+            case 'b': ring = strtoul(optarg, NULL, 0); break;
+            case 'o': offset = strtoul(optarg, NULL, 0); break;
+            case 'e': maxReports = strtoul(optarg, NULL, 0); break;
+            default: policyUsage();
+        }
+    }
+    if ((optind + 1 != argc) || (config.minInterval > config.maxInterval))
+    {
+        policyUsage();
+    }
+
+    trace = fopen(argv[optind], "r");
+    if (trace == NULL)
+    {
+        perror(argv[optind]);
+        return (1);
+    }
+
+    ReportPolicy_init(&policy, &config);
+    while (fgets(line, sizeof(line), trace) != NULL)
+    {
+        unsigned long time;
+        int value;
+
+        if ((line[0] == '#') || (line[0] == '\n'))
+        {
+            continue;
+        }
+        if (sscanf(line, "%lu %d", &time, &value) != 2)
+        {
+            printf("FAIL: %s: bad line: %s", argv[optind], line);
+            return (1);
+        }
+        last = (uint32_t)time + offset;
+        if (samples++ == 0)
+        {
+            first = last;
+        }
+        policySample(value, last);
+    }
+    fclose(trace);
+
+    printf("%s: %u samples over %.1f h, %u reports (%.1f per hour)\n",
+           argv[optind], samples, (last - first) / 3.6e6, reports,
+           reports * 3.6e6 / ((last != first) ? (last - first) : 1));
+    printf("  longest change delay %.1f s, longest gap %.1f s\n",
+           maxDelay / 1e3, maxGap / 1e3);
+
+    if (maxDelay > config.minInterval)
+    {
+        printf("FAIL: a change waited longer than the minimum interval\n");
+        return (1);
+    }
+    if (maxGap > config.maxInterval)
+    {
+        printf("FAIL: reports further apart than the heartbeat interval\n");
+        return (1);
+    }
+    if ((maxReports != 0) && (reports > maxReports))
+    {
+        printf("FAIL: more than %lu reports\n", maxReports);
+        return (1);
+    }
+
+    return (0);
+}
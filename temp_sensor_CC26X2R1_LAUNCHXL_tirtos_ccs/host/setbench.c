@@ -0,0 +1,222 @@
+/******************************************************************************
+
+ @file setbench.c
+
+ @brief Settings enumeration microbenchmark
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+//*****************************************************************************
+// Overview
+//*****************************************************************************
+/*
+Times how OpenThread enumerates a key with many settings: Get of index 0, 1,
+2 and so on until OT_ERROR_NOT_FOUND, then Delete by random index until the
+key is empty. Every value read is checked, each setting must be seen once
+per pass.
+
+The Makefile builds it twice, setbench with the index cache of settings.c
+and setbench-nocache with SETTINGS_CACHE_SIZE=0, where every Get restarts
+the NV search and a pass costs O(N^2) header reads.
+*/
+
+//*****************************************************************************
+// Includes
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <openthread/platform/settings.h>
+
+#include "hostnv.h"
+
+//*****************************************************************************
+// Constants and Definitions
+//*****************************************************************************
+
+#define SET_PAGES       4       // REGIONSIZE of CC26X2R1_LAUNCHXL.c
+#define SET_KEY         5       // Child info, the key with most settings
+#define SET_SETTINGS    64      // Default number of settings of the key
+#define SET_PASSES      200     // Default number of timed enumerations
+#define SET_VALLEN      16      // Too large for the value cache to hold
+
+//*****************************************************************************
+// Functions
+//*****************************************************************************
+
+static void setUsage(void)
+{
+    fprintf(stderr,
+            "usage: setbench [options]\n"
+            "  -n count   settings of the key (default %d, max 255)\n"
+            "  -r count   timed enumerations (default %d)\n",
+            SET_SETTINGS, SET_PASSES);
+    exit(2);
+}
+
+static void setFail(const char *what, unsigned index)
+{
+    printf("FAIL: %s, index %u\n", what, index);
+    exit(1);
+}
+
+// Reads every setting of the key once, returns the time taken
+static uint64_t setEnumerate(unsigned count)
+{
+    bool seen[256] = { false };
+    uint8_t buf[SET_VALLEN];
+    uint64_t t0 = HOSTNV_usecs();
+    unsigned i;
+
+    for (i = 0; ; i++)
+    {
+        uint16_t len = sizeof(buf);
+        otError error = otPlatSettingsGet(NULL, SET_KEY, i, buf, &len);
+
+        if (error == OT_ERROR_NOT_FOUND)
+        {
+            break;
+        }
+        if ((error != OT_ERROR_NONE) || (len != SET_VALLEN) ||
+            (i >= count) || seen[buf[0]] || (buf[0] >= count) ||
+            (buf[SET_VALLEN - 1] != (uint8_t)~buf[0]))
+        {
+            setFail("wrong setting read", i);
+        }
+        seen[buf[0]] = true;
+    }
+    t0 = HOSTNV_usecs() - t0;
+    if (i != count)
+    {
+        setFail("settings missing", i);
+    }
+
+    return (t0);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned count = SET_SETTINGS;
+    unsigned passes = SET_PASSES;
+    uint8_t val[SET_VALLEN];
+    uint64_t us = 0;
+    uint64_t maxUs = 0;
+    uint16_t len;
+    unsigned i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:r:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': count = strtoul(optarg, NULL, 0); break;
+            case 'r': passes = strtoul(optarg, NULL, 0); break;
+            default: setUsage();
+        }
+    }
+    if ((optind != argc) || (count == 0) || (count > 255) || (passes == 0))
+    {
+        setUsage();
+    }
+
+    HOSTNV_open(NULL, SET_PAGES);
+    otPlatSettingsInit(NULL);
+
+    // Setting i holds i in its first byte and ~i in its last one
+    for (i = 0; i < count; i++)
+    {
+        memset(val, i, sizeof(val));
+        val[SET_VALLEN - 1] = ~i;
+        if (otPlatSettingsAdd(NULL, SET_KEY, val, sizeof(val)) !=
+            OT_ERROR_NONE)
+        {
+            setFail("add failed", i);
+        }
+    }
+    // Other keys in NV, one of them read between the passes
+    for (i = 0; i < 8; i++)
+    {
+        memset(val, 0x80 + i, sizeof(val));
+        otPlatSettingsSet(NULL, SET_KEY + 1 + i, val, sizeof(val));
+    }
+
+    for (i = 0; i < passes; i++)
+    {
+        uint64_t t = setEnumerate(count);
+
+        us += t;
+        if (t > maxUs)
+        {
+            maxUs = t;
+        }
+        len = sizeof(val);
+        otPlatSettingsGet(NULL, SET_KEY + 1, 0, val, &len);
+    }
+    printf("enumerate %u settings: %.2f us per pass, %.3f us per Get, "
+           "%lu us worst pass\n", count, (double)us / passes,
+           (double)us / passes / (count + 1), (unsigned long)maxUs);
+
+    // Delete in random order until the key is empty
+    srand(1);
+    us = HOSTNV_usecs();
+    for (i = count; i > 0; i--)
+    {
+        if (otPlatSettingsDelete(NULL, SET_KEY, rand() % i) != OT_ERROR_NONE)
+        {
+            setFail("delete failed", i);
+        }
+    }
+    us = HOSTNV_usecs() - us;
+    len = sizeof(val);
+    if (otPlatSettingsGet(NULL, SET_KEY, 0, val, &len) != OT_ERROR_NOT_FOUND)
+    {
+        setFail("settings left after deleting all", 0);
+    }
+    printf("delete %u settings by random index: %.2f us per Delete\n", count,
+           (double)us / count);
+
+    return (0);
+}
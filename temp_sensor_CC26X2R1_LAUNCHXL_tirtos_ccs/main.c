@@ -98,6 +98,12 @@ int main(void)
 
     TempSensor_taskCreate();
 
+    NVQUEUE_taskCreate();
+
+#ifndef Board_EXCLUDE_NVS_EXTERNAL_FLASH
+    NVLOG_taskCreate();
+#endif
+
     OtStack_taskCreate();
 
     /* Start sys/bios, this will never return */
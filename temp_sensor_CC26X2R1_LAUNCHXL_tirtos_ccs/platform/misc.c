@@ -51,12 +51,16 @@
 #include <ti/devices/DeviceFamily.h>
 #include DeviceFamily_constructPath(driverlib/sys_ctrl.h)
 
+#include "nv/nvqueue.h"
+
 /**
  * Function documented in platform/misc.h
  */
 void otPlatReset(otInstance *aInstance)
 {
     (void)aInstance;
+    /* Queued NV operations are lost on reset */
+    NVQUEUE_flush();
     SysCtrlSystemReset();
 }
 
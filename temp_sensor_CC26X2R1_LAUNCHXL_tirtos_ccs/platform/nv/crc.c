@@ -12,6 +12,8 @@
  *  - XorOut        = 0x00
  *  - ReflectOut    = False
  *  - Algorithm     = table-driven
+ *
+ * Extended with slice-by-4 and slice-by-8 tables, see CRC_SLICE in crc.h.
  */
 #include "crc.h"     /* include the header file generated with pycrc */
 #include <stdlib.h>
@@ -42,11 +44,169 @@ static const crc_t crc_table[256] = {
 };
 
 
+#if CRC_SLICE > 1
+/**
+ * Static tables used for the slice-by-N implementation.
+ *
+ * crc_slice_table[k][i] is the crc of byte i followed by k + 1 zero bytes,
+ * that is crc_table applied k + 2 times.
+ */
+static const crc_t crc_slice_table[CRC_SLICE - 1][256] = {
+    {
+        0x00, 0xd3, 0x31, 0xe2, 0x62, 0xb1, 0x53, 0x80, 0xc4, 0x17, 0xf5, 0x26, 0xa6, 0x75, 0x97, 0x44,
+        0x1f, 0xcc, 0x2e, 0xfd, 0x7d, 0xae, 0x4c, 0x9f, 0xdb, 0x08, 0xea, 0x39, 0xb9, 0x6a, 0x88, 0x5b,
+        0x3e, 0xed, 0x0f, 0xdc, 0x5c, 0x8f, 0x6d, 0xbe, 0xfa, 0x29, 0xcb, 0x18, 0x98, 0x4b, 0xa9, 0x7a,
+        0x21, 0xf2, 0x10, 0xc3, 0x43, 0x90, 0x72, 0xa1, 0xe5, 0x36, 0xd4, 0x07, 0x87, 0x54, 0xb6, 0x65,
+        0x7c, 0xaf, 0x4d, 0x9e, 0x1e, 0xcd, 0x2f, 0xfc, 0xb8, 0x6b, 0x89, 0x5a, 0xda, 0x09, 0xeb, 0x38,
+        0x63, 0xb0, 0x52, 0x81, 0x01, 0xd2, 0x30, 0xe3, 0xa7, 0x74, 0x96, 0x45, 0xc5, 0x16, 0xf4, 0x27,
+        0x42, 0x91, 0x73, 0xa0, 0x20, 0xf3, 0x11, 0xc2, 0x86, 0x55, 0xb7, 0x64, 0xe4, 0x37, 0xd5, 0x06,
+        0x5d, 0x8e, 0x6c, 0xbf, 0x3f, 0xec, 0x0e, 0xdd, 0x99, 0x4a, 0xa8, 0x7b, 0xfb, 0x28, 0xca, 0x19,
+        0xf8, 0x2b, 0xc9, 0x1a, 0x9a, 0x49, 0xab, 0x78, 0x3c, 0xef, 0x0d, 0xde, 0x5e, 0x8d, 0x6f, 0xbc,
+        0xe7, 0x34, 0xd6, 0x05, 0x85, 0x56, 0xb4, 0x67, 0x23, 0xf0, 0x12, 0xc1, 0x41, 0x92, 0x70, 0xa3,
+        0xc6, 0x15, 0xf7, 0x24, 0xa4, 0x77, 0x95, 0x46, 0x02, 0xd1, 0x33, 0xe0, 0x60, 0xb3, 0x51, 0x82,
+        0xd9, 0x0a, 0xe8, 0x3b, 0xbb, 0x68, 0x8a, 0x59, 0x1d, 0xce, 0x2c, 0xff, 0x7f, 0xac, 0x4e, 0x9d,
+        0x84, 0x57, 0xb5, 0x66, 0xe6, 0x35, 0xd7, 0x04, 0x40, 0x93, 0x71, 0xa2, 0x22, 0xf1, 0x13, 0xc0,
+        0x9b, 0x48, 0xaa, 0x79, 0xf9, 0x2a, 0xc8, 0x1b, 0x5f, 0x8c, 0x6e, 0xbd, 0x3d, 0xee, 0x0c, 0xdf,
+        0xba, 0x69, 0x8b, 0x58, 0xd8, 0x0b, 0xe9, 0x3a, 0x7e, 0xad, 0x4f, 0x9c, 0x1c, 0xcf, 0x2d, 0xfe,
+        0xa5, 0x76, 0x94, 0x47, 0xc7, 0x14, 0xf6, 0x25, 0x61, 0xb2, 0x50, 0x83, 0x03, 0xd0, 0x32, 0xe1
+    },
+    {
+        0x00, 0x67, 0xce, 0xa9, 0x0b, 0x6c, 0xc5, 0xa2, 0x16, 0x71, 0xd8, 0xbf, 0x1d, 0x7a, 0xd3, 0xb4,
+        0x2c, 0x4b, 0xe2, 0x85, 0x27, 0x40, 0xe9, 0x8e, 0x3a, 0x5d, 0xf4, 0x93, 0x31, 0x56, 0xff, 0x98,
+        0x58, 0x3f, 0x96, 0xf1, 0x53, 0x34, 0x9d, 0xfa, 0x4e, 0x29, 0x80, 0xe7, 0x45, 0x22, 0x8b, 0xec,
+        0x74, 0x13, 0xba, 0xdd, 0x7f, 0x18, 0xb1, 0xd6, 0x62, 0x05, 0xac, 0xcb, 0x69, 0x0e, 0xa7, 0xc0,
+        0xb0, 0xd7, 0x7e, 0x19, 0xbb, 0xdc, 0x75, 0x12, 0xa6, 0xc1, 0x68, 0x0f, 0xad, 0xca, 0x63, 0x04,
+        0x9c, 0xfb, 0x52, 0x35, 0x97, 0xf0, 0x59, 0x3e, 0x8a, 0xed, 0x44, 0x23, 0x81, 0xe6, 0x4f, 0x28,
+        0xe8, 0x8f, 0x26, 0x41, 0xe3, 0x84, 0x2d, 0x4a, 0xfe, 0x99, 0x30, 0x57, 0xf5, 0x92, 0x3b, 0x5c,
+        0xc4, 0xa3, 0x0a, 0x6d, 0xcf, 0xa8, 0x01, 0x66, 0xd2, 0xb5, 0x1c, 0x7b, 0xd9, 0xbe, 0x17, 0x70,
+        0xf7, 0x90, 0x39, 0x5e, 0xfc, 0x9b, 0x32, 0x55, 0xe1, 0x86, 0x2f, 0x48, 0xea, 0x8d, 0x24, 0x43,
+        0xdb, 0xbc, 0x15, 0x72, 0xd0, 0xb7, 0x1e, 0x79, 0xcd, 0xaa, 0x03, 0x64, 0xc6, 0xa1, 0x08, 0x6f,
+        0xaf, 0xc8, 0x61, 0x06, 0xa4, 0xc3, 0x6a, 0x0d, 0xb9, 0xde, 0x77, 0x10, 0xb2, 0xd5, 0x7c, 0x1b,
+        0x83, 0xe4, 0x4d, 0x2a, 0x88, 0xef, 0x46, 0x21, 0x95, 0xf2, 0x5b, 0x3c, 0x9e, 0xf9, 0x50, 0x37,
+        0x47, 0x20, 0x89, 0xee, 0x4c, 0x2b, 0x82, 0xe5, 0x51, 0x36, 0x9f, 0xf8, 0x5a, 0x3d, 0x94, 0xf3,
+        0x6b, 0x0c, 0xa5, 0xc2, 0x60, 0x07, 0xae, 0xc9, 0x7d, 0x1a, 0xb3, 0xd4, 0x76, 0x11, 0xb8, 0xdf,
+        0x1f, 0x78, 0xd1, 0xb6, 0x14, 0x73, 0xda, 0xbd, 0x09, 0x6e, 0xc7, 0xa0, 0x02, 0x65, 0xcc, 0xab,
+        0x33, 0x54, 0xfd, 0x9a, 0x38, 0x5f, 0xf6, 0x91, 0x25, 0x42, 0xeb, 0x8c, 0x2e, 0x49, 0xe0, 0x87
+    },
+    {
+        0x00, 0x79, 0xf2, 0x8b, 0x73, 0x0a, 0x81, 0xf8, 0xe6, 0x9f, 0x14, 0x6d, 0x95, 0xec, 0x67, 0x1e,
+        0x5b, 0x22, 0xa9, 0xd0, 0x28, 0x51, 0xda, 0xa3, 0xbd, 0xc4, 0x4f, 0x36, 0xce, 0xb7, 0x3c, 0x45,
+        0xb6, 0xcf, 0x44, 0x3d, 0xc5, 0xbc, 0x37, 0x4e, 0x50, 0x29, 0xa2, 0xdb, 0x23, 0x5a, 0xd1, 0xa8,
+        0xed, 0x94, 0x1f, 0x66, 0x9e, 0xe7, 0x6c, 0x15, 0x0b, 0x72, 0xf9, 0x80, 0x78, 0x01, 0x8a, 0xf3,
+        0xfb, 0x82, 0x09, 0x70, 0x88, 0xf1, 0x7a, 0x03, 0x1d, 0x64, 0xef, 0x96, 0x6e, 0x17, 0x9c, 0xe5,
+        0xa0, 0xd9, 0x52, 0x2b, 0xd3, 0xaa, 0x21, 0x58, 0x46, 0x3f, 0xb4, 0xcd, 0x35, 0x4c, 0xc7, 0xbe,
+        0x4d, 0x34, 0xbf, 0xc6, 0x3e, 0x47, 0xcc, 0xb5, 0xab, 0xd2, 0x59, 0x20, 0xd8, 0xa1, 0x2a, 0x53,
+        0x16, 0x6f, 0xe4, 0x9d, 0x65, 0x1c, 0x97, 0xee, 0xf0, 0x89, 0x02, 0x7b, 0x83, 0xfa, 0x71, 0x08,
+        0x61, 0x18, 0x93, 0xea, 0x12, 0x6b, 0xe0, 0x99, 0x87, 0xfe, 0x75, 0x0c, 0xf4, 0x8d, 0x06, 0x7f,
+        0x3a, 0x43, 0xc8, 0xb1, 0x49, 0x30, 0xbb, 0xc2, 0xdc, 0xa5, 0x2e, 0x57, 0xaf, 0xd6, 0x5d, 0x24,
+        0xd7, 0xae, 0x25, 0x5c, 0xa4, 0xdd, 0x56, 0x2f, 0x31, 0x48, 0xc3, 0xba, 0x42, 0x3b, 0xb0, 0xc9,
+        0x8c, 0xf5, 0x7e, 0x07, 0xff, 0x86, 0x0d, 0x74, 0x6a, 0x13, 0x98, 0xe1, 0x19, 0x60, 0xeb, 0x92,
+        0x9a, 0xe3, 0x68, 0x11, 0xe9, 0x90, 0x1b, 0x62, 0x7c, 0x05, 0x8e, 0xf7, 0x0f, 0x76, 0xfd, 0x84,
+        0xc1, 0xb8, 0x33, 0x4a, 0xb2, 0xcb, 0x40, 0x39, 0x27, 0x5e, 0xd5, 0xac, 0x54, 0x2d, 0xa6, 0xdf,
+        0x2c, 0x55, 0xde, 0xa7, 0x5f, 0x26, 0xad, 0xd4, 0xca, 0xb3, 0x38, 0x41, 0xb9, 0xc0, 0x4b, 0x32,
+        0x77, 0x0e, 0x85, 0xfc, 0x04, 0x7d, 0xf6, 0x8f, 0x91, 0xe8, 0x63, 0x1a, 0xe2, 0x9b, 0x10, 0x69
+    },
+#if CRC_SLICE == 8
+    {
+        0x00, 0xc2, 0x13, 0xd1, 0x26, 0xe4, 0x35, 0xf7, 0x4c, 0x8e, 0x5f, 0x9d, 0x6a, 0xa8, 0x79, 0xbb,
+        0x98, 0x5a, 0x8b, 0x49, 0xbe, 0x7c, 0xad, 0x6f, 0xd4, 0x16, 0xc7, 0x05, 0xf2, 0x30, 0xe1, 0x23,
+        0xa7, 0x65, 0xb4, 0x76, 0x81, 0x43, 0x92, 0x50, 0xeb, 0x29, 0xf8, 0x3a, 0xcd, 0x0f, 0xde, 0x1c,
+        0x3f, 0xfd, 0x2c, 0xee, 0x19, 0xdb, 0x0a, 0xc8, 0x73, 0xb1, 0x60, 0xa2, 0x55, 0x97, 0x46, 0x84,
+        0xd9, 0x1b, 0xca, 0x08, 0xff, 0x3d, 0xec, 0x2e, 0x95, 0x57, 0x86, 0x44, 0xb3, 0x71, 0xa0, 0x62,
+        0x41, 0x83, 0x52, 0x90, 0x67, 0xa5, 0x74, 0xb6, 0x0d, 0xcf, 0x1e, 0xdc, 0x2b, 0xe9, 0x38, 0xfa,
+        0x7e, 0xbc, 0x6d, 0xaf, 0x58, 0x9a, 0x4b, 0x89, 0x32, 0xf0, 0x21, 0xe3, 0x14, 0xd6, 0x07, 0xc5,
+        0xe6, 0x24, 0xf5, 0x37, 0xc0, 0x02, 0xd3, 0x11, 0xaa, 0x68, 0xb9, 0x7b, 0x8c, 0x4e, 0x9f, 0x5d,
+        0x25, 0xe7, 0x36, 0xf4, 0x03, 0xc1, 0x10, 0xd2, 0x69, 0xab, 0x7a, 0xb8, 0x4f, 0x8d, 0x5c, 0x9e,
+        0xbd, 0x7f, 0xae, 0x6c, 0x9b, 0x59, 0x88, 0x4a, 0xf1, 0x33, 0xe2, 0x20, 0xd7, 0x15, 0xc4, 0x06,
+        0x82, 0x40, 0x91, 0x53, 0xa4, 0x66, 0xb7, 0x75, 0xce, 0x0c, 0xdd, 0x1f, 0xe8, 0x2a, 0xfb, 0x39,
+        0x1a, 0xd8, 0x09, 0xcb, 0x3c, 0xfe, 0x2f, 0xed, 0x56, 0x94, 0x45, 0x87, 0x70, 0xb2, 0x63, 0xa1,
+        0xfc, 0x3e, 0xef, 0x2d, 0xda, 0x18, 0xc9, 0x0b, 0xb0, 0x72, 0xa3, 0x61, 0x96, 0x54, 0x85, 0x47,
+        0x64, 0xa6, 0x77, 0xb5, 0x42, 0x80, 0x51, 0x93, 0x28, 0xea, 0x3b, 0xf9, 0x0e, 0xcc, 0x1d, 0xdf,
+        0x5b, 0x99, 0x48, 0x8a, 0x7d, 0xbf, 0x6e, 0xac, 0x17, 0xd5, 0x04, 0xc6, 0x31, 0xf3, 0x22, 0xe0,
+        0xc3, 0x01, 0xd0, 0x12, 0xe5, 0x27, 0xf6, 0x34, 0x8f, 0x4d, 0x9c, 0x5e, 0xa9, 0x6b, 0xba, 0x78
+    },
+    {
+        0x00, 0x4a, 0x94, 0xde, 0xbf, 0xf5, 0x2b, 0x61, 0xe9, 0xa3, 0x7d, 0x37, 0x56, 0x1c, 0xc2, 0x88,
+        0x45, 0x0f, 0xd1, 0x9b, 0xfa, 0xb0, 0x6e, 0x24, 0xac, 0xe6, 0x38, 0x72, 0x13, 0x59, 0x87, 0xcd,
+        0x8a, 0xc0, 0x1e, 0x54, 0x35, 0x7f, 0xa1, 0xeb, 0x63, 0x29, 0xf7, 0xbd, 0xdc, 0x96, 0x48, 0x02,
+        0xcf, 0x85, 0x5b, 0x11, 0x70, 0x3a, 0xe4, 0xae, 0x26, 0x6c, 0xb2, 0xf8, 0x99, 0xd3, 0x0d, 0x47,
+        0x83, 0xc9, 0x17, 0x5d, 0x3c, 0x76, 0xa8, 0xe2, 0x6a, 0x20, 0xfe, 0xb4, 0xd5, 0x9f, 0x41, 0x0b,
+        0xc6, 0x8c, 0x52, 0x18, 0x79, 0x33, 0xed, 0xa7, 0x2f, 0x65, 0xbb, 0xf1, 0x90, 0xda, 0x04, 0x4e,
+        0x09, 0x43, 0x9d, 0xd7, 0xb6, 0xfc, 0x22, 0x68, 0xe0, 0xaa, 0x74, 0x3e, 0x5f, 0x15, 0xcb, 0x81,
+        0x4c, 0x06, 0xd8, 0x92, 0xf3, 0xb9, 0x67, 0x2d, 0xa5, 0xef, 0x31, 0x7b, 0x1a, 0x50, 0x8e, 0xc4,
+        0x91, 0xdb, 0x05, 0x4f, 0x2e, 0x64, 0xba, 0xf0, 0x78, 0x32, 0xec, 0xa6, 0xc7, 0x8d, 0x53, 0x19,
+        0xd4, 0x9e, 0x40, 0x0a, 0x6b, 0x21, 0xff, 0xb5, 0x3d, 0x77, 0xa9, 0xe3, 0x82, 0xc8, 0x16, 0x5c,
+        0x1b, 0x51, 0x8f, 0xc5, 0xa4, 0xee, 0x30, 0x7a, 0xf2, 0xb8, 0x66, 0x2c, 0x4d, 0x07, 0xd9, 0x93,
+        0x5e, 0x14, 0xca, 0x80, 0xe1, 0xab, 0x75, 0x3f, 0xb7, 0xfd, 0x23, 0x69, 0x08, 0x42, 0x9c, 0xd6,
+        0x12, 0x58, 0x86, 0xcc, 0xad, 0xe7, 0x39, 0x73, 0xfb, 0xb1, 0x6f, 0x25, 0x44, 0x0e, 0xd0, 0x9a,
+        0x57, 0x1d, 0xc3, 0x89, 0xe8, 0xa2, 0x7c, 0x36, 0xbe, 0xf4, 0x2a, 0x60, 0x01, 0x4b, 0x95, 0xdf,
+        0x98, 0xd2, 0x0c, 0x46, 0x27, 0x6d, 0xb3, 0xf9, 0x71, 0x3b, 0xe5, 0xaf, 0xce, 0x84, 0x5a, 0x10,
+        0xdd, 0x97, 0x49, 0x03, 0x62, 0x28, 0xf6, 0xbc, 0x34, 0x7e, 0xa0, 0xea, 0x8b, 0xc1, 0x1f, 0x55
+    },
+    {
+        0x00, 0xb5, 0xfd, 0x48, 0x6d, 0xd8, 0x90, 0x25, 0xda, 0x6f, 0x27, 0x92, 0xb7, 0x02, 0x4a, 0xff,
+        0x23, 0x96, 0xde, 0x6b, 0x4e, 0xfb, 0xb3, 0x06, 0xf9, 0x4c, 0x04, 0xb1, 0x94, 0x21, 0x69, 0xdc,
+        0x46, 0xf3, 0xbb, 0x0e, 0x2b, 0x9e, 0xd6, 0x63, 0x9c, 0x29, 0x61, 0xd4, 0xf1, 0x44, 0x0c, 0xb9,
+        0x65, 0xd0, 0x98, 0x2d, 0x08, 0xbd, 0xf5, 0x40, 0xbf, 0x0a, 0x42, 0xf7, 0xd2, 0x67, 0x2f, 0x9a,
+        0x8c, 0x39, 0x71, 0xc4, 0xe1, 0x54, 0x1c, 0xa9, 0x56, 0xe3, 0xab, 0x1e, 0x3b, 0x8e, 0xc6, 0x73,
+        0xaf, 0x1a, 0x52, 0xe7, 0xc2, 0x77, 0x3f, 0x8a, 0x75, 0xc0, 0x88, 0x3d, 0x18, 0xad, 0xe5, 0x50,
+        0xca, 0x7f, 0x37, 0x82, 0xa7, 0x12, 0x5a, 0xef, 0x10, 0xa5, 0xed, 0x58, 0x7d, 0xc8, 0x80, 0x35,
+        0xe9, 0x5c, 0x14, 0xa1, 0x84, 0x31, 0x79, 0xcc, 0x33, 0x86, 0xce, 0x7b, 0x5e, 0xeb, 0xa3, 0x16,
+        0x8f, 0x3a, 0x72, 0xc7, 0xe2, 0x57, 0x1f, 0xaa, 0x55, 0xe0, 0xa8, 0x1d, 0x38, 0x8d, 0xc5, 0x70,
+        0xac, 0x19, 0x51, 0xe4, 0xc1, 0x74, 0x3c, 0x89, 0x76, 0xc3, 0x8b, 0x3e, 0x1b, 0xae, 0xe6, 0x53,
+        0xc9, 0x7c, 0x34, 0x81, 0xa4, 0x11, 0x59, 0xec, 0x13, 0xa6, 0xee, 0x5b, 0x7e, 0xcb, 0x83, 0x36,
+        0xea, 0x5f, 0x17, 0xa2, 0x87, 0x32, 0x7a, 0xcf, 0x30, 0x85, 0xcd, 0x78, 0x5d, 0xe8, 0xa0, 0x15,
+        0x03, 0xb6, 0xfe, 0x4b, 0x6e, 0xdb, 0x93, 0x26, 0xd9, 0x6c, 0x24, 0x91, 0xb4, 0x01, 0x49, 0xfc,
+        0x20, 0x95, 0xdd, 0x68, 0x4d, 0xf8, 0xb0, 0x05, 0xfa, 0x4f, 0x07, 0xb2, 0x97, 0x22, 0x6a, 0xdf,
+        0x45, 0xf0, 0xb8, 0x0d, 0x28, 0x9d, 0xd5, 0x60, 0x9f, 0x2a, 0x62, 0xd7, 0xf2, 0x47, 0x0f, 0xba,
+        0x66, 0xd3, 0x9b, 0x2e, 0x0b, 0xbe, 0xf6, 0x43, 0xbc, 0x09, 0x41, 0xf4, 0xd1, 0x64, 0x2c, 0x99
+    },
+    {
+        0x00, 0x89, 0x85, 0x0c, 0x9d, 0x14, 0x18, 0x91, 0xad, 0x24, 0x28, 0xa1, 0x30, 0xb9, 0xb5, 0x3c,
+        0xcd, 0x44, 0x48, 0xc1, 0x50, 0xd9, 0xd5, 0x5c, 0x60, 0xe9, 0xe5, 0x6c, 0xfd, 0x74, 0x78, 0xf1,
+        0x0d, 0x84, 0x88, 0x01, 0x90, 0x19, 0x15, 0x9c, 0xa0, 0x29, 0x25, 0xac, 0x3d, 0xb4, 0xb8, 0x31,
+        0xc0, 0x49, 0x45, 0xcc, 0x5d, 0xd4, 0xd8, 0x51, 0x6d, 0xe4, 0xe8, 0x61, 0xf0, 0x79, 0x75, 0xfc,
+        0x1a, 0x93, 0x9f, 0x16, 0x87, 0x0e, 0x02, 0x8b, 0xb7, 0x3e, 0x32, 0xbb, 0x2a, 0xa3, 0xaf, 0x26,
+        0xd7, 0x5e, 0x52, 0xdb, 0x4a, 0xc3, 0xcf, 0x46, 0x7a, 0xf3, 0xff, 0x76, 0xe7, 0x6e, 0x62, 0xeb,
+        0x17, 0x9e, 0x92, 0x1b, 0x8a, 0x03, 0x0f, 0x86, 0xba, 0x33, 0x3f, 0xb6, 0x27, 0xae, 0xa2, 0x2b,
+        0xda, 0x53, 0x5f, 0xd6, 0x47, 0xce, 0xc2, 0x4b, 0x77, 0xfe, 0xf2, 0x7b, 0xea, 0x63, 0x6f, 0xe6,
+        0x34, 0xbd, 0xb1, 0x38, 0xa9, 0x20, 0x2c, 0xa5, 0x99, 0x10, 0x1c, 0x95, 0x04, 0x8d, 0x81, 0x08,
+        0xf9, 0x70, 0x7c, 0xf5, 0x64, 0xed, 0xe1, 0x68, 0x54, 0xdd, 0xd1, 0x58, 0xc9, 0x40, 0x4c, 0xc5,
+        0x39, 0xb0, 0xbc, 0x35, 0xa4, 0x2d, 0x21, 0xa8, 0x94, 0x1d, 0x11, 0x98, 0x09, 0x80, 0x8c, 0x05,
+        0xf4, 0x7d, 0x71, 0xf8, 0x69, 0xe0, 0xec, 0x65, 0x59, 0xd0, 0xdc, 0x55, 0xc4, 0x4d, 0x41, 0xc8,
+        0x2e, 0xa7, 0xab, 0x22, 0xb3, 0x3a, 0x36, 0xbf, 0x83, 0x0a, 0x06, 0x8f, 0x1e, 0x97, 0x9b, 0x12,
+        0xe3, 0x6a, 0x66, 0xef, 0x7e, 0xf7, 0xfb, 0x72, 0x4e, 0xc7, 0xcb, 0x42, 0xd3, 0x5a, 0x56, 0xdf,
+        0x23, 0xaa, 0xa6, 0x2f, 0xbe, 0x37, 0x3b, 0xb2, 0x8e, 0x07, 0x0b, 0x82, 0x13, 0x9a, 0x96, 0x1f,
+        0xee, 0x67, 0x6b, 0xe2, 0x73, 0xfa, 0xf6, 0x7f, 0x43, 0xca, 0xc6, 0x4f, 0xde, 0x57, 0x5b, 0xd2
+    }
+#endif
+};
+#endif
+
+
 crc_t crc_update(crc_t crc, const void *data, size_t data_len)
 {
     const unsigned char *d = (const unsigned char *)data;
     unsigned int tbl_idx;
 
+#if CRC_SLICE == 8
+    while (data_len >= 8) {
+        crc = crc_slice_table[6][crc ^ d[0]] ^ crc_slice_table[5][d[1]] ^
+              crc_slice_table[4][d[2]] ^ crc_slice_table[3][d[3]] ^
+              crc_slice_table[2][d[4]] ^ crc_slice_table[1][d[5]] ^
+              crc_slice_table[0][d[6]] ^ crc_table[d[7]];
+        d += 8;
+        data_len -= 8;
+    }
+#endif
+#if CRC_SLICE >= 4
+    while (data_len >= 4) {
+        crc = crc_slice_table[2][crc ^ d[0]] ^ crc_slice_table[1][d[1]] ^
+              crc_slice_table[0][d[2]] ^ crc_table[d[3]];
+        d += 4;
+        data_len -= 4;
+    }
+#endif
     while (data_len--) {
         tbl_idx = crc ^ *d;
         crc = crc_table[tbl_idx] & 0xff;
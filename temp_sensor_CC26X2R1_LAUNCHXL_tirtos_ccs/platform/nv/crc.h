@@ -57,6 +57,21 @@ extern "C" {
 #define CRC_ALGO_TABLE_DRIVEN 1
 
 
+/**
+ * Number of bytes processed per table lookup round.
+ *
+ * 1 uses the 256 byte table only. 4 and 8 (slice-by-N) add 3 or 7 more
+ * tables of 256 bytes each, and process 4 or 8 bytes per round.
+ */
+#ifndef CRC_SLICE
+#define CRC_SLICE 4
+#endif
+
+#if (CRC_SLICE != 1) && (CRC_SLICE != 4) && (CRC_SLICE != 8)
+#error "CRC_SLICE must be 1, 4 or 8"
+#endif
+
+
 /**
  * The type of the CRC values.
  *
@@ -139,6 +139,23 @@ typedef struct nvintf_itemid_t
     uint16_t subID;
 } NVINTF_itemID_t;
 
+// doNext() search state, set up by the driver and the write-behind queue when
+// a search is started
+typedef struct nvintf_nvsearch_t
+{
+    uint32_t cid;       // Compressed ID of the searched items
+    int16_t ofs;        // Offset in the page to continue the search from
+    uint8_t pg;         // Page to continue the search from
+    uint8_t search;     // Search type
+    uint8_t op;         // Operation on the found items
+    uint16_t bufLen;    // Size of the user's buffer
+    uint16_t qEnd;      // Queue position at the start, owned by NVQUEUE
+    uint16_t qPos;      // Queue position of the last queued item returned
+    uint16_t qItemid;   // Searched itemID, kept while queued items are found
+    uint8_t qSysid;     // Searched sysID, kept while queued items are found
+    uint8_t qPart;      // Queued items or driver items being found
+} NVINTF_nvSearch_t;
+
 // Proxy NV item used by doNext()
 typedef struct nvintf_nvproxy_t
 {
@@ -148,6 +165,7 @@ typedef struct nvintf_nvproxy_t
     void * buffer;      // Buffer to which API writes item contents, if specified in FLAG
     uint16_t len;       // User inputs size of buffer here, API returns item size here
     uint8_t flag;       // User sets flags for search by system/item, and operation: read/delete
+    NVINTF_nvSearch_t state; // Search state, owned by the driver
 } NVINTF_nvProxy_t;
 
 //! Function pointer definition for the NVINTF_initNV() function
@@ -187,6 +205,23 @@ typedef void (*NVINTF_unlockNV)(IArg);
 //! Function pointer definition for the NVINTF_doNext() function
 typedef uint8_t (*NVINTF_doNext)(NVINTF_nvProxy_t *nvProxy);
 
+//! Function pointer definition for the NVINTF_appendItem() function
+typedef uint8_t (*NVINTF_appendItem)(NVINTF_itemID_t id,
+                                     uint16_t length,
+                                     void *buffer );
+
+//! Function pointer definition for the NVINTF_readStream() function
+typedef uint8_t (*NVINTF_readStream)(NVINTF_itemID_t id,
+                                     uint32_t offset,
+                                     uint16_t length,
+                                     void *buffer );
+
+//! Function pointer definition for the NVINTF_getStreamLen() function
+typedef uint32_t (*NVINTF_getStreamLen)(NVINTF_itemID_t id);
+
+//! Function pointer definition for the NVINTF_deleteStream() function
+typedef uint8_t (*NVINTF_deleteStream)(NVINTF_itemID_t id);
+
 //! Structure of NV API function pointers
 typedef struct nvintf_nvfuncts_t
 {
@@ -210,6 +245,14 @@ typedef struct nvintf_nvfuncts_t
     NVINTF_lockNV lockNV;
     //! Unlock item function
     NVINTF_unlockNV unlockNV;
+    //! Append to streamed item function
+    NVINTF_appendItem appendItem;
+    //! Read streamed item function
+    NVINTF_readStream readStream;
+    //! Get streamed item length function
+    NVINTF_getStreamLen getStreamLen;
+    //! Delete streamed item function
+    NVINTF_deleteStream deleteStream;
 } NVINTF_nvFuncts_t;
 
 //*****************************************************************************
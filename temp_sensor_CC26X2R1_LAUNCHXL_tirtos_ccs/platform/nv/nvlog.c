@@ -0,0 +1,798 @@
+/******************************************************************************
+
+ @file nvlog.c
+
+ @brief Log-structured append store on the external SPI Flash
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+//*****************************************************************************
+// Design Overview
+//*****************************************************************************
+/*
+The internal Flash pages are kept for NVOCTP and the OpenThread settings. Bulk
+data such as sample history, event logs and OTA images goes to this log on the
+external SPI Flash region, which has room for many sectors of records.
+
+Sectors are used in order around the region. A sector starts with a header
+holding its sequence number, which goes up by one from sector to sector, so the
+sector with sequence number seq is always at index seq % count. A record is a
+3 byte header (length, then CRC8 of length and data) followed by the data.
+Records do not cross sectors, the rest of a sector without room for the next
+record is left erased.
+
+Appended records are copied into page sized RAM buffers. Full buffers are
+handed to the NV log task, which programs them in order, one page program per
+buffer, so a stream of small appends costs one program per page. The task also
+keeps the sector after the one being written erased. The erase is done when no
+buffer is ready to be programmed, so an append only waits when every buffer is
+full. Erasing ahead drops the oldest sector once the log has wrapped.
+
+Reads use a cursor and only see programmed records, NVLOG_flush() programs the
+buffered ones. The oldest sector is dropped before it is erased and a read
+checks that its sector was not dropped while reading, so reads need no lock.
+
+At mount, the sector headers are read to find the newest sector, whose records
+are walked to find the end of the log. The sector after it is erased again, as
+it may have been erased partly at power loss. A record that was being
+programmed at power loss fails its CRC check and is skipped by reads. The log
+is mounted by the NV log task, appends return NVINTF_NOTREADY until then.
+
+Configuration:
+NVLOG_NVS_INDEX - The index of the NVS_Config structure which describes the
+external Flash region. Default is Board_NVSEXTERNAL.
+NVLOG_PAGESIZE - Size of a page program, the size of a RAM buffer. Default is
+256.
+NVLOG_BUFS - Number of RAM buffers. Default is 2. Appends do not wait as long as
+the buffers hold what is appended during a sector erase, typically 40 ms.
+NVLOG_MAXREC - Largest record length, see nvlog.h. Default is 1024.
+
+Dependencies:
+Requires NVS with an external Flash region, the log is left out when
+Board_EXCLUDE_NVS_EXTERNAL_FLASH is defined.
+Requires TI-RTOS GateMutexPri, Hwi and Semaphore to be enabled in
+configuration.
+*/
+
+//*****************************************************************************
+// Includes
+//*****************************************************************************
+
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/gates/GateMutexPri.h>
+#include <ti/drivers/NVS.h>
+
+#include "Board.h"
+#include "task_config.h"
+#include "crc.h"
+#include "nvlog.h"
+
+#ifndef Board_EXCLUDE_NVS_EXTERNAL_FLASH
+
+//*****************************************************************************
+// Constants and Definitions
+//*****************************************************************************
+
+// NVS region of the log
+#ifndef NVLOG_NVS_INDEX
+#define NVLOG_NVS_INDEX     Board_NVSEXTERNAL
+#endif
+
+// Size of a page program
+#ifndef NVLOG_PAGESIZE
+#define NVLOG_PAGESIZE      256
+#endif
+
+// Number of page buffers
+#ifndef NVLOG_BUFS
+#define NVLOG_BUFS          2
+#endif
+
+// Sector header, the sequence number is programmed before the signature
+#define NVLOG_SECTHDR       8
+#define NVLOG_SIGNATURE     0x474F4C4EUL
+
+// Record header, length then CRC8
+#define NVLOG_RECHDR        3
+
+// Record length of erased Flash
+#define NVLOG_NOREC         0xFFFF
+
+//*****************************************************************************
+// Macros
+//*****************************************************************************
+
+// Region offset of an offset in the sector with sequence number seq
+#define NVLOG_FLASHOFFSET(seq, ofs) \
+    ((((seq) % NVLOG_nSect) * NVLOG_sectSize) + (ofs))
+
+// Lock the appenders via TI-RTOS gatemutex
+#define NVLOG_LOCK()        GateMutexPri_enter(NVLOG_gMutexPri)
+
+// Unlock the appenders via TI-RTOS gatemutex
+#define NVLOG_UNLOCK(key)   GateMutexPri_leave(NVLOG_gMutexPri, (key))
+
+//*****************************************************************************
+// Typedefs
+//*****************************************************************************
+
+// Page buffer, data for one page program
+typedef struct
+{
+    uint32_t seq;           // Sequence number of the sector
+    uint16_t ofs;           // Offset of the data in the sector
+    uint16_t len;           // Number of data bytes
+    uint8_t data[NVLOG_PAGESIZE];
+}
+NVLOG_buf_t;
+
+//*****************************************************************************
+// Local Variables
+//*****************************************************************************
+
+// NVS handle and geometry of the log region
+static NVS_Handle NVLOG_nvsHandle;
+static uint32_t NVLOG_sectSize;
+static uint32_t NVLOG_nSect;
+
+// Set by the NV log task once the log is mounted
+static volatile bool NVLOG_ready = false;
+
+// Page buffers, NVLOG_full of them are programmed by the task, oldest first,
+// the one after them is being filled
+static NVLOG_buf_t NVLOG_bufs[NVLOG_BUFS];
+static uint8_t NVLOG_fill;
+static volatile uint8_t NVLOG_full;
+
+// Sector being written and offset of the next record, appenders only
+static uint32_t NVLOG_headSeq;
+static uint16_t NVLOG_headOfs;
+
+// Positions shared with the task, changed with interrupts disabled:
+// oldest sector, last erased sector and end of the programmed data
+static volatile uint32_t NVLOG_tailSeq;
+static volatile uint32_t NVLOG_erasedSeq;
+static volatile uint32_t NVLOG_progSeq;
+static volatile uint16_t NVLOG_progOfs;
+
+// TI-RTOS gateMutexPri for the appenders
+static GateMutexPri_Handle NVLOG_gMutexPri;
+
+// Posted when there is work for the task
+static Semaphore_Struct NVLOG_sem;
+
+// Posted by the task when a buffer is programmed
+static Semaphore_Struct NVLOG_bufSem;
+
+// NV log task call stack
+static char NVLOG_stack[TASK_CONFIG_NVLOG_TASK_STACK_SIZE];
+
+// Log statistics
+static NVLOG_stats_t NVLOG_stats;
+
+//*****************************************************************************
+// Local Functions
+//*****************************************************************************
+
+/******************************************************************************
+ * @fn      NVLOG_queue
+ *
+ * @brief   Local function to hand the buffer being filled to the task. The
+ *          caller holds the appender gate.
+ *
+ * @return  none
+ */
+static void NVLOG_queue(void)
+{
+    if(NVLOG_bufs[NVLOG_fill].len > 0)
+    {
+        UInt hwiKey = Hwi_disable();
+
+        NVLOG_full++;
+        Hwi_restore(hwiKey);
+
+        NVLOG_fill = (NVLOG_fill + 1) % NVLOG_BUFS;
+        Semaphore_post(Semaphore_handle(&NVLOG_sem));
+    }
+}
+
+/******************************************************************************
+ * @fn      NVLOG_put
+ *
+ * @brief   Local function to copy bytes to the head of the log, buffers are
+ *          handed to the task at page boundaries. The caller holds the
+ *          appender gate.
+ *
+ * @param   pData - pointer to the bytes
+ * @param   len   - number of bytes
+ *
+ * @return  none
+ */
+static void NVLOG_put(const uint8_t *pData, uint16_t len)
+{
+    while(len > 0)
+    {
+        NVLOG_buf_t *pBuf = &NVLOG_bufs[NVLOG_fill];
+        uint16_t room;
+
+        // Wait for the task to program the oldest buffer
+        if(NVLOG_full == NVLOG_BUFS)
+        {
+            NVLOG_stats.bufWaits++;
+            do
+            {
+                Semaphore_pend(Semaphore_handle(&NVLOG_bufSem),
+                               BIOS_WAIT_FOREVER);
+            } while(NVLOG_full == NVLOG_BUFS);
+        }
+
+        if(pBuf->len == 0)
+        {
+            pBuf->seq = NVLOG_headSeq;
+            pBuf->ofs = NVLOG_headOfs;
+        }
+
+        // Bytes up to the next page boundary
+        room = NVLOG_PAGESIZE - (NVLOG_headOfs % NVLOG_PAGESIZE);
+        room = (len < room) ? len : room;
+
+        memcpy(pBuf->data + pBuf->len, pData, room);
+        pBuf->len     += room;
+        NVLOG_headOfs += room;
+        pData         += room;
+        len           -= room;
+
+        if((NVLOG_headOfs % NVLOG_PAGESIZE) == 0)
+        {
+            NVLOG_queue();
+        }
+    }
+}
+
+/******************************************************************************
+ * @fn      NVLOG_open
+ *
+ * @brief   Local function to start the next sector, the task erases the one
+ *          after it. The caller holds the appender gate.
+ *
+ * @return  none
+ */
+static void NVLOG_open(void)
+{
+    uint8_t sHdr[NVLOG_SECTHDR];
+    uint32_t seq = NVLOG_headSeq + 1;
+    uint8_t i;
+
+    // Data of the old sector is programmed first
+    NVLOG_queue();
+
+    for(i = 0; i < 4; i++)
+    {
+        sHdr[i]     = (uint8_t)(seq >> (8 * i));
+        sHdr[i + 4] = (uint8_t)(NVLOG_SIGNATURE >> (8 * i));
+    }
+
+    NVLOG_headSeq = seq;
+    NVLOG_headOfs = 0;
+    NVLOG_put(sHdr, NVLOG_SECTHDR);
+
+    Semaphore_post(Semaphore_handle(&NVLOG_sem));
+}
+
+/******************************************************************************
+ * @fn      NVLOG_sectorSeq
+ *
+ * @brief   Local function to read the sequence number of a sector
+ *
+ * @param   sect - sector index
+ *
+ * @return  Sequence number, 0 if the sector has no valid header
+ */
+static uint32_t NVLOG_sectorSeq(uint32_t sect)
+{
+    uint8_t sHdr[NVLOG_SECTHDR];
+    uint32_t seq = 0;
+    uint32_t sig = 0;
+    uint8_t i;
+
+    NVS_read(NVLOG_nvsHandle, sect * NVLOG_sectSize, sHdr, NVLOG_SECTHDR);
+    for(i = 0; i < 4; i++)
+    {
+        seq |= (uint32_t)sHdr[i] << (8 * i);
+        sig |= (uint32_t)sHdr[i + 4] << (8 * i);
+    }
+
+    if((sig != NVLOG_SIGNATURE) || (seq == 0) || ((seq % NVLOG_nSect) != sect))
+    {
+        seq = 0;
+    }
+
+    return (seq);
+}
+
+/******************************************************************************
+ * @fn      NVLOG_mount
+ *
+ * @brief   Local function to find the oldest and the newest sector and the
+ *          end of the log
+ *
+ * @return  NVINTF_SUCCESS or specific failure code
+ */
+static uint8_t NVLOG_mount(void)
+{
+    NVS_Attrs attrs;
+    uint32_t sect;
+    uint32_t head = 0;
+    uint32_t tail;
+    uint16_t ofs = 0;
+
+    NVS_init();
+    NVLOG_nvsHandle = NVS_open(NVLOG_NVS_INDEX, NULL);
+    if(NVLOG_nvsHandle == NULL)
+    {
+        return (NVINTF_NOTREADY);
+    }
+    NVS_getAttrs(NVLOG_nvsHandle, &attrs);
+    NVLOG_sectSize = attrs.sectorSize;
+    NVLOG_nSect    = attrs.regionSize / attrs.sectorSize;
+    if((NVLOG_nSect < 3) ||
+       ((NVLOG_sectSize % NVLOG_PAGESIZE) != 0) ||
+       ((NVLOG_SECTHDR + NVLOG_RECHDR + NVLOG_MAXREC) > NVLOG_sectSize))
+    {
+        return (NVINTF_BADLENGTH);
+    }
+
+    // Newest sector
+    for(sect = 0; sect < NVLOG_nSect; sect++)
+    {
+        uint32_t seq = NVLOG_sectorSeq(sect);
+
+        head = (seq > head) ? seq : head;
+    }
+
+    // Oldest sector of the run of sectors before it
+    tail = (head > 0) ? head : 1;
+    while((tail > 1) && ((head - tail + 2) < NVLOG_nSect) &&
+          (NVLOG_sectorSeq((tail - 1) % NVLOG_nSect) == (tail - 1)))
+    {
+        tail--;
+    }
+
+    // End of the records in the newest sector
+    if(head > 0)
+    {
+        ofs = NVLOG_SECTHDR;
+        while((ofs + NVLOG_RECHDR) <= NVLOG_sectSize)
+        {
+            uint8_t rHdr[NVLOG_RECHDR];
+            uint16_t len;
+
+            NVS_read(NVLOG_nvsHandle, NVLOG_FLASHOFFSET(head, ofs), rHdr,
+                     NVLOG_RECHDR);
+            len = rHdr[0] | ((uint16_t)rHdr[1] << 8);
+            if(len == NVLOG_NOREC)
+            {
+                break;
+            }
+            // A length torn at power loss may not fit, the sector is closed
+            ofs = ((ofs + NVLOG_RECHDR + len) <= NVLOG_sectSize) ?
+                  (ofs + NVLOG_RECHDR + len) : NVLOG_sectSize;
+        }
+    }
+
+    NVLOG_headSeq   = head;
+    NVLOG_headOfs   = (head > 0) ? ofs : NVLOG_sectSize;
+    NVLOG_tailSeq   = tail;
+    NVLOG_erasedSeq = head;
+    NVLOG_progSeq   = head;
+    NVLOG_progOfs   = NVLOG_headOfs;
+
+    return (NVINTF_SUCCESS);
+}
+
+/******************************************************************************
+ * @fn      NVLOG_doOne
+ *
+ * @brief   Local function to program the oldest buffer or, when its sector is
+ *          not erased yet or no buffer is full, to erase the next sector
+ *
+ * @return  false if there was nothing to do
+ */
+static bool NVLOG_doOne(void)
+{
+    NVLOG_buf_t *pBuf = NULL;
+    uint32_t eraseSeq = 0;
+    UInt hwiKey = Hwi_disable();
+
+    if(NVLOG_full > 0)
+    {
+        pBuf = &NVLOG_bufs[(NVLOG_fill + NVLOG_BUFS - NVLOG_full) % NVLOG_BUFS];
+    }
+    if(NVLOG_erasedSeq <= NVLOG_headSeq)
+    {
+        eraseSeq = NVLOG_erasedSeq + 1;
+    }
+    Hwi_restore(hwiKey);
+
+    if((pBuf != NULL) && (pBuf->seq <= NVLOG_erasedSeq))
+    {
+        NVS_write(NVLOG_nvsHandle, NVLOG_FLASHOFFSET(pBuf->seq, pBuf->ofs),
+                  pBuf->data, pBuf->len, NVS_WRITE_POST_VERIFY);
+
+        hwiKey = Hwi_disable();
+        NVLOG_progSeq = pBuf->seq;
+        NVLOG_progOfs = pBuf->ofs + pBuf->len;
+        pBuf->len = 0;
+        NVLOG_full--;
+        NVLOG_stats.pages++;
+        Hwi_restore(hwiKey);
+
+        Semaphore_post(Semaphore_handle(&NVLOG_bufSem));
+    }
+    else if(eraseSeq != 0)
+    {
+        // Records of the sector are dropped before they are erased
+        hwiKey = Hwi_disable();
+        if((NVLOG_tailSeq + NVLOG_nSect) <= eraseSeq)
+        {
+            NVLOG_tailSeq = eraseSeq + 1 - NVLOG_nSect;
+        }
+        if(pBuf != NULL)
+        {
+            NVLOG_stats.eraseWaits++;
+        }
+        Hwi_restore(hwiKey);
+
+        NVS_erase(NVLOG_nvsHandle, NVLOG_FLASHOFFSET(eraseSeq, 0),
+                  NVLOG_sectSize);
+
+        hwiKey = Hwi_disable();
+        NVLOG_erasedSeq = eraseSeq;
+        NVLOG_stats.erases++;
+        Hwi_restore(hwiKey);
+    }
+    else
+    {
+        return (false);
+    }
+
+    return (true);
+}
+
+/******************************************************************************
+ * @fn      NVLOG_task
+ *
+ * @brief   NV log task, mounts the log, then programs buffers and erases
+ *          sectors ahead
+ *
+ * @param   arg0 - unused
+ *
+ * @return  none
+ */
+static void *NVLOG_task(void *arg0)
+{
+    (void)arg0;
+
+    if(NVLOG_mount() != NVINTF_SUCCESS)
+    {
+        return (NULL);
+    }
+    NVLOG_ready = true;
+
+    while(1)
+    {
+        while(NVLOG_doOne())
+        {
+            // Until every buffer is programmed and the next sector erased
+        }
+
+        Semaphore_pend(Semaphore_handle(&NVLOG_sem), BIOS_WAIT_FOREVER);
+    }
+}
+
+//*****************************************************************************
+// Global Functions
+//*****************************************************************************
+
+/******************************************************************************
+ * @fn      NVLOG_append
+ *
+ * @brief   Global function to append a record to the log
+ *
+ * @param   pBuf - pointer to the record data
+ * @param   len  - record length, 1 to NVLOG_MAXREC bytes
+ *
+ * @return  NVINTF_SUCCESS or specific failure code
+ */
+uint8_t NVLOG_append(const void *pBuf, uint16_t len)
+{
+    uint8_t rHdr[NVLOG_RECHDR];
+    crc_t crc;
+    IArg key;
+
+    if((pBuf == NULL) || (len == 0))
+    {
+        return (NVINTF_BADPARAM);
+    }
+    if(len > NVLOG_MAXREC)
+    {
+        return (NVINTF_BADLENGTH);
+    }
+    if(!NVLOG_ready)
+    {
+        return (NVINTF_NOTREADY);
+    }
+
+    rHdr[0] = (uint8_t)len;
+    rHdr[1] = (uint8_t)(len >> 8);
+    crc = crc_update(crc_init(), rHdr, 2);
+    crc = crc_update(crc, pBuf, len);
+    rHdr[2] = crc_finalize(crc);
+
+    key = NVLOG_LOCK();
+
+    if((NVLOG_headOfs + NVLOG_RECHDR + len) > NVLOG_sectSize)
+    {
+        NVLOG_open();
+    }
+    NVLOG_put(rHdr, NVLOG_RECHDR);
+    NVLOG_put((const uint8_t *)pBuf, len);
+
+    NVLOG_stats.appends++;
+    NVLOG_stats.bytes += len;
+
+    NVLOG_UNLOCK(key);
+
+    return (NVINTF_SUCCESS);
+}
+
+/******************************************************************************
+ * @fn      NVLOG_flush
+ *
+ * @brief   Global function to program all appended records before returning
+ *
+ * @return  none
+ */
+void NVLOG_flush(void)
+{
+    if(NVLOG_ready)
+    {
+        IArg key = NVLOG_LOCK();
+
+        NVLOG_queue();
+        while(NVLOG_full > 0)
+        {
+            Semaphore_pend(Semaphore_handle(&NVLOG_bufSem), BIOS_WAIT_FOREVER);
+        }
+
+        NVLOG_UNLOCK(key);
+    }
+}
+
+/******************************************************************************
+ * @fn      NVLOG_first
+ *
+ * @brief   Global function to set a cursor to the oldest record
+ *
+ * @param   pCur - pointer to caller's cursor
+ *
+ * @return  none
+ */
+void NVLOG_first(NVLOG_cursor_t *pCur)
+{
+    pCur->seq = NVLOG_tailSeq;
+    pCur->ofs = NVLOG_SECTHDR;
+}
+
+/******************************************************************************
+ * @fn      NVLOG_next
+ *
+ * @brief   Global function to read the record at a cursor and move the cursor
+ *          to the next record
+ *
+ * @param   pCur - pointer to caller's cursor
+ * @param   pBuf - pointer to caller's read data buffer
+ * @param   pLen - buffer length in, record length out
+ *
+ * @return  NVINTF_SUCCESS or specific failure code
+ */
+uint8_t NVLOG_next(NVLOG_cursor_t *pCur, void *pBuf, uint16_t *pLen)
+{
+    if((pCur == NULL) || (pBuf == NULL) || (pLen == NULL))
+    {
+        return (NVINTF_BADPARAM);
+    }
+    if(!NVLOG_ready)
+    {
+        return (NVINTF_NOTREADY);
+    }
+
+    while(1)
+    {
+        uint8_t rHdr[NVLOG_RECHDR];
+        uint32_t progSeq;
+        uint16_t progOfs;
+        uint16_t len;
+        crc_t crc;
+        UInt hwiKey = Hwi_disable();
+
+        if(pCur->seq < NVLOG_tailSeq)
+        {
+            pCur->seq = NVLOG_tailSeq;
+            pCur->ofs = NVLOG_SECTHDR;
+        }
+        progSeq = NVLOG_progSeq;
+        progOfs = NVLOG_progOfs;
+        Hwi_restore(hwiKey);
+
+        // End of the programmed records
+        if((pCur->seq > progSeq) ||
+           ((pCur->seq == progSeq) && ((pCur->ofs + NVLOG_RECHDR) > progOfs)))
+        {
+            return (NVINTF_NOTFOUND);
+        }
+
+        len = NVLOG_NOREC;
+        if((pCur->ofs + NVLOG_RECHDR) <= NVLOG_sectSize)
+        {
+            NVS_read(NVLOG_nvsHandle, NVLOG_FLASHOFFSET(pCur->seq, pCur->ofs),
+                     rHdr, NVLOG_RECHDR);
+            len = rHdr[0] | ((uint16_t)rHdr[1] << 8);
+        }
+        if((len == NVLOG_NOREC) ||
+           ((pCur->ofs + NVLOG_RECHDR + len) > NVLOG_sectSize))
+        {
+            // End of the sector
+            pCur->seq++;
+            pCur->ofs = NVLOG_SECTHDR;
+            continue;
+        }
+        if((pCur->seq == progSeq) &&
+           ((pCur->ofs + NVLOG_RECHDR + len) > progOfs))
+        {
+            return (NVINTF_NOTFOUND);
+        }
+        if(len > *pLen)
+        {
+            *pLen = len;
+            return (NVINTF_BADLENGTH);
+        }
+
+        NVS_read(NVLOG_nvsHandle,
+                 NVLOG_FLASHOFFSET(pCur->seq, pCur->ofs + NVLOG_RECHDR), pBuf,
+                 len);
+        if(pCur->seq < NVLOG_tailSeq)
+        {
+            // The sector was dropped while reading
+            continue;
+        }
+        pCur->ofs += NVLOG_RECHDR + len;
+
+        crc = crc_update(crc_init(), rHdr, 2);
+        crc = crc_update(crc, pBuf, len);
+        if(crc_finalize(crc) == rHdr[2])
+        {
+            *pLen = len;
+            return (NVINTF_SUCCESS);
+        }
+
+        hwiKey = Hwi_disable();
+        NVLOG_stats.crcErrors++;
+        Hwi_restore(hwiKey);
+    }
+}
+
+/******************************************************************************
+ * @fn      NVLOG_getStats
+ *
+ * @brief   Global function to read the log statistics
+ *
+ * @param   pStats - pointer to caller's statistics structure
+ *
+ * @return  none
+ */
+void NVLOG_getStats(NVLOG_stats_t *pStats)
+{
+    UInt hwiKey = Hwi_disable();
+
+    *pStats = NVLOG_stats;
+    pStats->headSeq = NVLOG_headSeq;
+    pStats->tailSeq = NVLOG_tailSeq;
+
+    Hwi_restore(hwiKey);
+}
+
+/******************************************************************************
+ * @fn      NVLOG_taskCreate
+ *
+ * @brief   Global function to create the NV log task, called before
+ *          BIOS_start()
+ *
+ * @return  none
+ */
+void NVLOG_taskCreate(void)
+{
+    pthread_t           thread;
+    pthread_attr_t      pAttrs;
+    struct sched_param  priParam;
+    GateMutexPri_Params gateParams;
+    Semaphore_Params    semParams;
+    int                 retc;
+
+    // Create a priority gate mutex for the appenders
+    GateMutexPri_Params_init(&gateParams);
+    NVLOG_gMutexPri = GateMutexPri_create(&gateParams, NULL);
+
+    Semaphore_Params_init(&semParams);
+    semParams.mode = Semaphore_Mode_BINARY;
+    Semaphore_construct(&NVLOG_sem, 0, &semParams);
+    Semaphore_construct(&NVLOG_bufSem, 0, &semParams);
+
+    retc = pthread_attr_init(&pAttrs);
+    assert(retc == 0);
+
+    retc = pthread_attr_setdetachstate(&pAttrs, PTHREAD_CREATE_DETACHED);
+    assert(retc == 0);
+
+    priParam.sched_priority = TASK_CONFIG_NVLOG_TASK_PRIORITY;
+    retc = pthread_attr_setschedparam(&pAttrs, &priParam);
+    assert(retc == 0);
+
+    retc = pthread_attr_setstack(&pAttrs, (void *)NVLOG_stack,
+                                 TASK_CONFIG_NVLOG_TASK_STACK_SIZE);
+    assert(retc == 0);
+
+    retc = pthread_create(&thread, &pAttrs, NVLOG_task, NULL);
+    assert(retc == 0);
+
+    retc = pthread_attr_destroy(&pAttrs);
+    assert(retc == 0);
+
+    (void) retc;
+}
+
+#endif /* Board_EXCLUDE_NVS_EXTERNAL_FLASH */
@@ -0,0 +1,165 @@
+/******************************************************************************
+
+ @file nvlog.h
+
+ @brief Log-structured append store on the external SPI Flash
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+#ifndef NVLOG_H
+#define NVLOG_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#include "nvintf.h"
+
+//*****************************************************************************
+// Constants and Definitions
+//*****************************************************************************
+
+// Largest record, a record must fit into a sector with the sector header
+#ifndef NVLOG_MAXREC
+#define NVLOG_MAXREC        1024
+#endif
+
+//*****************************************************************************
+// Typedefs
+//*****************************************************************************
+
+// Read position in the log, set up by NVLOG_first()
+typedef struct
+{
+    uint32_t seq;         // Sequence number of the sector
+    uint16_t ofs;         // Offset of the next record in the sector
+}
+NVLOG_cursor_t;
+
+// Log statistics
+typedef struct
+{
+    uint32_t appends;     // Number of records appended
+    uint32_t bytes;       // Number of record data bytes appended
+    uint32_t pages;       // Number of page programs done by the NV log task
+    uint16_t erases;      // Number of sector erases done by the NV log task
+    uint16_t bufWaits;    // Number of times an append waited for a buffer
+    uint16_t eraseWaits;  // Number of times a page program waited for an erase
+    uint16_t crcErrors;   // Number of records skipped by reads, bad CRC
+    uint32_t headSeq;     // Sequence number of the sector being written
+    uint32_t tailSeq;     // Sequence number of the oldest sector
+}
+NVLOG_stats_t;
+
+//*****************************************************************************
+// Functions
+//*****************************************************************************
+
+/**
+ * @fn      NVLOG_append
+ *
+ * @brief   Global function to append a record to the log. The record is
+ *          copied to a page buffer and programmed by the NV log task, the call
+ *          only waits when every page buffer is full. When the log is full,
+ *          the oldest sector of records is dropped.
+ *
+ * @param   pBuf - pointer to the record data
+ * @param   len  - record length, 1 to NVLOG_MAXREC bytes
+ *
+ * @return  NVINTF_SUCCESS or specific failure code
+ */
+extern uint8_t NVLOG_append(const void *pBuf, uint16_t len);
+
+/**
+ * @fn      NVLOG_flush
+ *
+ * @brief   Global function to program all appended records before returning.
+ *          Reads only see programmed records.
+ *
+ * @return  none
+ */
+extern void NVLOG_flush(void);
+
+/**
+ * @fn      NVLOG_first
+ *
+ * @brief   Global function to set a cursor to the oldest record
+ *
+ * @param   pCur - pointer to caller's cursor
+ *
+ * @return  none
+ */
+extern void NVLOG_first(NVLOG_cursor_t *pCur);
+
+/**
+ * @fn      NVLOG_next
+ *
+ * @brief   Global function to read the record at a cursor and move the cursor
+ *          to the next record. Records with a bad CRC are skipped, a cursor
+ *          behind the oldest record moves to the oldest record.
+ *
+ * @param   pCur - pointer to caller's cursor
+ * @param   pBuf - pointer to caller's read data buffer
+ * @param   pLen - buffer length in, record length out
+ *
+ * @return  NVINTF_SUCCESS, NVINTF_NOTFOUND at the end of the log,
+ *          NVINTF_BADLENGTH if the buffer is too small or another code
+ */
+extern uint8_t NVLOG_next(NVLOG_cursor_t *pCur, void *pBuf, uint16_t *pLen);
+
+/**
+ * @fn      NVLOG_getStats
+ *
+ * @brief   Global function to read the log statistics
+ *
+ * @param   pStats - pointer to caller's statistics structure
+ *
+ * @return  none
+ */
+extern void NVLOG_getStats(NVLOG_stats_t *pStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NVLOG_H */
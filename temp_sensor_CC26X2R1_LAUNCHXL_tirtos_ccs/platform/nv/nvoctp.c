@@ -48,13 +48,28 @@
 // Design Overview
 //*****************************************************************************
 /*
-This driver implements a non-volatile (NV) memory system that utilizes 2 pages
-(consecutive) of on-chip Flash memory. After initialization, one page is ACTIVE
-and the other page is available for "compaction" when the ACTIVE page does not
-have enough empty space for data write operation. Compaction can occur 'just in
-time' during a data write operation or 'on demand' by application request. The
-compaction process is designed to survive a power cycle before it completes. It
-will resume where it was interrupted and complete the process.
+This driver implements a non-volatile (NV) memory system that utilizes a ring
+of 2 or more pages (consecutive) of on-chip Flash memory, as many as the NVS
+region provides up to NVOCTP_MAXPAGES. Items are always written to the newest
+ACTIVE page (the 'head' of the ring). When it is full the next page of the ring
+becomes the head, until only one erased page is left. From then on room is made
+by "compaction" of the oldest page (the 'tail'): its current items are copied
+to the head and the tail page is erased. Since pages are used in ring order,
+erase cycles are spread evenly over the ring, and a compaction only copies the
+items that are still current on one page. With a 2 page ring this is the same
+as compacting the one ACTIVE page to the other page. Compaction can occur 'just
+in time' during a data write operation or 'on demand' by application request.
+The compaction process is designed to survive a power cycle before it
+completes. It will resume where it was interrupted and complete the process.
+
+Incremental Compaction: To keep the time the driver is locked short, the tail
+page is reclaimed a few items at a time (NVOCTP_COMPACTSTEP) once only the page
+reserved for compaction is left. Each item write or create that finds the ring
+in this state does one step, as does compactNV() with a non-zero minimum. The
+longest step moves NVOCTP_COMPACTSTEP items and erases the tail page. Items are
+marked inactive on the tail page as they are moved, so item updates and deletes
+between steps are not undone. Compaction of the whole page is still done when
+an item does not fit before the incremental transfer is complete.
 
 This driver makes the following assumptions and uses them to optimize the code
 and data storage design: (1) Flash memory is addressable at individual, 1-byte
@@ -81,16 +96,78 @@ item, and is the same for all items as well as the page header. The CRC8 value
 allows the driver to confirm the integrity of the items during compaction and
 optionally when an item read operation is requested. The length of the data
 block is used to jump from one item to the next. If this field is corrupted,
-the driver is forced to search for items by signature and possibly compute
-multiple CRC's to confirm it has found a valid item. Note that any corruption
-event forces a compaction to recover.
-
-Usage Note: Each item operation results in a traversal of the page starting at
+or an item write was interrupted by a power cycle, the driver is forced to
+search for items by signature and possibly compute multiple CRC's to confirm it
+has found a valid item. The corrupted data is left behind when its page is
+compacted.
+
+Write Verification: Every Flash write is read back once and compared with the
+source buffer a word at a time. The data of an item larger than
+NVOCTP_SMALLITEM is written first and its CRC is computed during the readback,
+then the header is written. Compaction trusts the headers below the newest
+item of the tail page the way a search does, and checks the CRC of a moved
+item on the bytes as they are copied. A moved item is then read once plus the
+readback, and items left behind are not read at all. When a copy turns out to
+be corrupt it is marked inactive and the tail page is searched again from that
+item with every CRC checked.
+
+Usage Note: Each item operation results in a traversal of the ring starting at
 the most recently written item. This makes 'finding' items by 'trying' item IDs
 in order extremely inefficient. The doNext() API call allows the user to find,
-read, or delete items in one page traversal. However, this call requires the
+read, or delete items in one ring traversal. However, this call requires the
 user to lock access to NV until the operation is complete so it should be used
 carefully and sparingly.
+
+RAM Index: To avoid the ring traversal, the driver keeps a small hash table in
+RAM which maps the compressed ID of every active item to its page and header
+offset. It is built once at initialization, kept current on item write, delete
+and page compaction, and is used by findItem() instead of reading item headers.
+Should the table fill up, the driver falls back to ring traversal until the
+next compaction rebuilds it. Older duplicates of an item, which can be left
+behind when power is lost during an item update, are marked inactive while the
+table is built.
+
+Mount Checkpoint: Items are only added to the active page, the older pages of
+the ring only see items being marked inactive. So when a page becomes the
+active page, its first item is a checkpoint which lists the location of every
+active item of the RAM index. At initialization only the active page is
+traversed, the checkpoint at its bottom provides the rest of the index. An
+entry is kept when its header still holds the active item, without a CRC check.
+When the checkpoint is missing or bad, the whole ring is traversed instead.
+
+Deferred Inactive Marks: When an item is updated, its old copy is not marked
+inactive right away. The location of the old copy is kept in a small RAM list
+(NVOCTP_RETIRE) and ring traversals skip it, which saves a Flash write per
+update. The marks are written in batches: when the list is full, when the NV
+task is idle (NVOCTP_retireIdle()) and before a checkpoint is written, since
+initialization only sees the older pages through the checkpoint. Old copies on
+the page being compacted are not marked at all, they are erased with it. Item
+headers carry no sequence number for this, the position in the ring already
+tells which copy is newer: initialization keeps the newest copy of an item and
+marks the others inactive, so a power loss only postpones the marks. Marks
+are only deferred while every item fits in the RAM index, which is what
+initialization needs to find the old copies. A delete marks every copy of the
+item, they can't come back after a reset.
+
+Streamed Items: Records larger than an item, or that grow a little at a time,
+are stored as a stream of chunk items which share the system and item ID of
+the stream. The sub ID is the chunk number and every chunk but the last holds
+NVOCTP_CHUNKLEN bytes, so a stream offset maps to one chunk and each chunk has
+its own CRC. appendItem() fills up the last chunk by rewriting it, then adds new
+chunks, so a small append costs one chunk write instead of a rewrite of the
+whole record. Chunks are added in order and deleteStream() deletes them last
+chunk first, so after a power loss a stream is always a run of chunks from
+chunk 0. The number of chunks is found with a binary search of the chunk IDs.
+
+Locking: Item reads, length lookups and doNext() find/read steps only take a
+shared lock, so that tasks can look up items at the same time. Writes, creates,
+deletes, compactions and lockNV() take the exclusive lock: the gate mutex is
+entered, which holds off new readers, then the driver waits for the readers
+inside to leave. A task holding the exclusive lock may call the read API, but a
+task must not call the write API while it is inside a read. The doNext() search
+state is kept in the caller's proxy, so searches of several tasks do not
+interfere. Readers are counted, not gate owners, so a writer waiting for them
+gives them no priority inheritance, see NVOCTP_lockRd() for the bound.
 */
 //*****************************************************************************
 // Use / Configuration
@@ -116,15 +193,43 @@ nvFps.compactNV(NULL);
 status = nvFps.readItem(id, 0, len, buf);
 
 Configuration:
-NVOCTP_STATS - Places a protected item with driver stats
+NVOCTP_STATS - Places a protected item with driver stats: item and compaction
+counts, Flash bytes written, erases of each page and latency histograms of the
+API calls, which include the time spent waiting for the driver lock. The stats
+are kept in RAM and saved on every compaction and every NVOCTP_DIAGWRITES item
+writes (default 256). NVOCTP_getDiags() returns the current values.
 NVOCTP_CRCONREAD (on:1 off:0) - item crc is checked on read. Disabling this may
 increase driver speed but safety is reduced.
 NVOCTP_NVS_INDEX - The index of the NVS_Config structure which describes the
 flash sector that NVOCTP should use. Default is 0.
+NVOCTP_MAXPAGES - Maximum number of Flash pages in the NV ring, additional pages
+of the NVS region are not used. Default is 8.
+NVOCTP_RAMINDEX - Number of RAM index slots, must be a power of 2. Up to 3/4 of
+the slots are used, 8 bytes of RAM each. Default is 64, 0 disables the index.
+NVOCTP_COMPACTSTEP - Number of items moved by one incremental compaction step.
+Default is 8, 0 disables incremental compaction.
+NVOCTP_MAPPED (on:1 off:0) - headers, CRCs and item data are read in place when
+the NVS region is memory mapped (internal Flash), instead of being copied by
+NVS_read(). Regions that are not addressable (SPI Flash) are always copied.
+Default is 1.
+NVOCTP_CHUNKLEN - Number of data bytes in a chunk of a streamed item. A stream
+holds up to 1024 chunks. A RAM buffer of this size is used by appendItem().
+Default is 256, 0 disables streamed items.
+NVOCTP_CHECKPOINT (on:1 off:0) - a mount checkpoint of the RAM index is written
+on every new active page, which saves the ring traversal at initialization.
+Each checkpoint uses 6 bytes per indexed item. Requires the RAM index. Default
+is 1.
+NVOCTP_RETIRE - Number of old item copies whose inactive mark is deferred, 8
+bytes of RAM each. Default is 16, 0 marks the old copy on every update.
+Requires the RAM index.
+NVOCTP_FLASHHOOK(pg, ofs, len) - Called before every Flash write and page
+erase (ofs 0, len of a page). Empty by default. The host build of the driver
+(host/hostnv.h) uses it to count Flash operations and to simulate a power loss
+at any of them.
 
 Dependencies:
 Requires NVS for NV access.
-Requires TI-RTOS GateMutexPri to be enabled in configuration.
+Requires TI-RTOS GateMutexPri and Semaphore to be enabled in configuration.
 Requires API's in a crc.h to implement CRC functionality.
 */
 
@@ -133,7 +238,13 @@ Requires API's in a crc.h to implement CRC functionality.
 //*****************************************************************************
 
 #include <string.h>
+#include <ti/sysbios/BIOS.h>
 #include <ti/sysbios/gates/GateMutexPri.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#if defined (NVOCTP_STATS)
+#include <ti/sysbios/knl/Clock.h>
+#endif
 
 #include "nvoctp.h"
 #include "crc.h"
@@ -170,9 +281,89 @@ Requires API's in a crc.h to implement CRC functionality.
 // in RAM before write, instead of header/data written separately
 #define NVOCTP_SMALLITEM    12
 
+// Number of RAM index slots (power of 2), 0 disables the RAM index
+#ifndef NVOCTP_RAMINDEX
+#define NVOCTP_RAMINDEX     64
+#endif
+
+// Number of items moved per incremental compaction step, 0 disables it
+#ifndef NVOCTP_COMPACTSTEP
+#define NVOCTP_COMPACTSTEP  8
+#endif
+
+// Item count for a page transfer without limit
+#define NVOCTP_XFERALL      0xFFFF
+
+// Data bytes per chunk of a streamed item, 0 disables streamed items
+#ifndef NVOCTP_CHUNKLEN
+#define NVOCTP_CHUNKLEN     256
+#endif
+
+// Read the NV region in place when it is memory mapped
+#ifndef NVOCTP_MAPPED
+#define NVOCTP_MAPPED       1
+#endif
+
+// Write a mount checkpoint of the RAM index on every new active page
+#ifndef NVOCTP_CHECKPOINT
+#define NVOCTP_CHECKPOINT   1
+#endif
+
+// Old item copies whose inactive mark is deferred, 0 marks them right away
+#ifndef NVOCTP_RETIRE
+#define NVOCTP_RETIRE       16
+#endif
+
+#if NVOCTP_CHUNKLEN > NVOCTP_MAXLEN
+#error "NVOCTP_CHUNKLEN is larger than an item"
+#endif
+
+#if NVOCTP_RAMINDEX
+// Unused RAM index slot (bit31 of a compressed ID is always zero)
+#define NVOCTP_IDXEMPTY     0xFFFFFFFF
+// Highest number of used RAM index slots, keeps probe sequences short
+#define NVOCTP_IDXLIMIT     ((NVOCTP_RAMINDEX * 3) / 4)
+#else
+// The mount checkpoint is a copy of the RAM index
+#undef NVOCTP_CHECKPOINT
+#define NVOCTP_CHECKPOINT   0
+// Mount retires old copies while building the RAM index
+#undef NVOCTP_RETIRE
+#define NVOCTP_RETIRE       0
+#endif
+
+#if NVOCTP_CHECKPOINT
+// Checkpoint entry: compressed ID, followed by the item header offset with
+// the ring page in bits 13-15 (for 0x2000 page size)
+#define NVOCTP_CKPTENTLEN   6
+// Number of checkpoint entries per Flash read/write
+#define NVOCTP_CKPTBLK      (NVOCTP_XFERBLKMAX / NVOCTP_CKPTENTLEN)
+#if NVOCTP_MAXPAGES > 8
+#error "NVOCTP_CHECKPOINT supports up to 8 pages"
+#endif
+#endif
+
+#if NVOCTP_RETIRE
+// Compressed ID that selects the deferred marks of all items
+#define NVOCTP_RETALL       0xFFFFFFFF
+// Page being compacted, its old copies are erased instead of marked
+#define NVOCTP_RETKEEP()    ((NVOCTP_xferOff != 0) ? NVOCTP_tailPg : \
+                                                     NVOCTP_NULLPAGE)
+#endif
+
 #if defined (NVOCTP_STATS)
 // NV item ID for driver diagnostics
 static const NVINTF_itemID_t diagId = NVOCTP_NVID_DIAG;
+
+// Number of item writes between saves of the diagnostic data
+#ifndef NVOCTP_DIAGWRITES
+#define NVOCTP_DIAGWRITES   256
+#endif
+#endif
+
+#if NVOCTP_CHECKPOINT
+// NV item ID of the mount checkpoint
+static const NVINTF_itemID_t ckptId = NVOCTP_NVID_CKPT;
 #endif
 
 // CRC options
@@ -185,6 +376,11 @@ static const NVINTF_itemID_t diagId = NVOCTP_NVID_DIAG;
 #define NVOCTP_FINDITMID    3   // Find the first item with spec'd sysid and item id
 #define NVOCTP_FINDSTRICT   4   // Find the exact match
 
+// doNext operations on the found items
+#define NVOCTP_OPFIND       0   // Return the item's ID and length
+#define NVOCTP_OPREAD       1   // Also read the item into the user's buffer
+#define NVOCTP_OPDELETE     2   // Mark the item inactive
+
 //*****************************************************************************
 // Macros
 //*****************************************************************************
@@ -193,23 +389,86 @@ static const NVINTF_itemID_t diagId = NVOCTP_NVID_DIAG;
 #define NVOCTP_FLASHOFFSET(base, pg, ofs) ((uint32_t)\
         (((pg) << 13) + (ofs) - (uint32_t)(base)))
 
+// Makes a pointer to a memory mapped NV Flash location (for 0x2000 page size)
+#define NVOCTP_MAPADDR(pg, ofs) ((const uint8_t *)(uintptr_t)\
+        (((uint32_t)(pg) << 13) + (ofs)))
+
+// Flash operation hook, called before writes/erases
+#ifndef NVOCTP_FLASHHOOK
+#define NVOCTP_FLASHHOOK(pg, ofs, len)
+#endif
+
 // Optional user provided function is called before writes/erases
 // Intention is to check for sufficient voltage for operation
 #define NVOCTP_FLASHACCESS(err) {if (NVOCTP_voltCheckFptr)\
     { if (!NVOCTP_voltCheckFptr()) { err = NVINTF_LOWPOWER;}}}
 
-// Lock driver access via TI-RTOS gatemutex
-#define NVOCTP_LOCK() IArg key = GateMutexPri_enter(NVOCTP_gMutexPri);
+#if defined (NVOCTP_STATS)
+// Start timing an operation for its latency histogram
+#define NVOCTP_TSTART(op) uint32_t tStart = Clock_getTicks(); \
+    uint8_t tOp = (op);
+
+// Count the operation in its latency histogram
+#define NVOCTP_TSTOP() NVOCTP_histAdd(tOp, tStart);
+#else
+#define NVOCTP_TSTART(op)
+#define NVOCTP_TSTOP()
+#endif
+
+// Lock exclusive driver access via TI-RTOS gatemutex
+#define NVOCTP_LOCK(op) NVOCTP_TSTART(op) IArg key = NVOCTP_lockNvApi();
 
-// Unlock driver access via TI-RTOS gatemutex and return error code
-#define NVOCTP_UNLOCK(err) { \
-    GateMutexPri_leave(NVOCTP_gMutexPri, key); return (err); }
+// Unlock exclusive driver access and return error code
+#define NVOCTP_UNLOCK(err) { NVOCTP_TSTOP() \
+    NVOCTP_unlockNvApi(key); return (err); }
+
+// Lock shared driver access, for API functions that only read
+#define NVOCTP_LOCKRD(op) NVOCTP_TSTART(op) NVOCTP_lockRd();
+
+// Unlock shared driver access and return error code
+#define NVOCTP_UNLOCKRD(err) { NVOCTP_TSTOP() \
+    NVOCTP_unlockRd(); return (err); }
 
 // Generate a compressed NV ID (NOTE: bit31 must be zero)
 #define NVOCTP_CMPRID(s,i,b) ((uint32_t)((((((s) & NVOCTP_MAXSYSID) << 12)   | \
                                             ((i) & NVOCTP_MAXITEMID)) << 12) | \
                                             ((b) & NVOCTP_MAXSUBID)))
 
+// Neighbouring pages in the NV ring
+#define NVOCTP_NEXTPG(pg) (((pg) == NVOCTP_nvEndPage) ? NVOCTP_nvBegPage : \
+                                                        ((pg) + 1))
+#define NVOCTP_PREVPG(pg) (((pg) == NVOCTP_nvBegPage) ? NVOCTP_nvEndPage : \
+                                                        ((pg) - 1))
+
+// Position of a page in the NV ring, 0 for the oldest (tail) page
+#define NVOCTP_PGPOS(pg) ((uint8_t)(((pg) + NVOCTP_nvPages - NVOCTP_tailPg) % \
+                                    NVOCTP_nvPages))
+
+// Number of pages in use, from tail page up to the active page
+#define NVOCTP_PGUSED() (NVOCTP_PGPOS(NVOCTP_activePg) + 1)
+
+// Incremental compaction of the tail page is due: a transfer is in progress,
+// or only the page reserved for compaction is left
+#define NVOCTP_RECLAIM() ((NVOCTP_xferOff != 0) || \
+                          ((NVOCTP_tailPg != NVOCTP_activePg) && \
+                           ((NVOCTP_nvPages - NVOCTP_PGUSED()) <= 1)))
+
+// Offset to next available location on a page of the NV ring
+#define NVOCTP_PGEND(pg) (((pg) == NVOCTP_activePg) ? NVOCTP_pgOff : \
+                          NVOCTP_pgEnd[(pg) - NVOCTP_nvBegPage])
+
+#if NVOCTP_RAMINDEX
+// Home slot of a compressed NV ID in the RAM index (multiplicative hash)
+#define NVOCTP_IDXHASH(c) ((uint16_t)((((c) * 0x9E3779B1) >> 16) & \
+                                      (NVOCTP_RAMINDEX - 1)))
+
+// Next slot of a RAM index probe sequence
+#define NVOCTP_IDXNEXT(i) (((i) + 1) & (NVOCTP_RAMINDEX - 1))
+
+// Item location in NV ring order, newer items have higher values
+#define NVOCTP_IDXPOS(pg, ofs) ((((uint32_t)NVOCTP_PGPOS(pg)) << 16) | (ofs))
+#endif
+
 // NVOCTP Unit Test Assert Macro/Function
 #ifdef NVDEBUG
 extern void Main_printf(char * message);
@@ -257,7 +516,7 @@ static void NVOCTP_assert(bool cond, char *message, bool fatal)
 typedef struct
 {
     uint8_t state;      // PGCLEAR, PGERASED, PGACTIVE, PGXFER
-    uint8_t cycle;      // Rolling page compaction count (0x00, 0xFF not used)
+    uint8_t cycle;      // Rolling page sequence count (0x00, 0xFF not used)
     uint8_t version;    // Version of NV page format
     uint8_t signature;  // Signature for formatted NV page
 } NVOCTP_pageHdr_t;
@@ -287,6 +546,13 @@ typedef struct
 #define NVOCTP_MINCYCLE  0x01  // Minimum cycle count (after rollover)
 #define NVOCTP_MAXCYCLE  0xFE  // Maximum cycle count (before rollover)
 
+// Number of cycle counts in use, cycle counts from b to a and preceding c
+#define NVOCTP_NUMCYCLES (NVOCTP_MAXCYCLE - NVOCTP_MINCYCLE + 1)
+#define NVOCTP_CYCDIFF(a, b) ((uint8_t)(((a) + NVOCTP_NUMCYCLES - (b)) % \
+                                        NVOCTP_NUMCYCLES))
+#define NVOCTP_PREVCYCLE(c) (((c) > NVOCTP_MINCYCLE) ? ((c) - 1) : \
+                                                       NVOCTP_MAXCYCLE)
+
 
 //*****************************************************************************
 // Item Header Definitions
@@ -304,6 +570,7 @@ typedef struct
     uint8_t  stats; // Status 'marks'
     uint16_t hofs;  // Header offset
     uint16_t len;   // Data length
+    uint8_t  pg;    // Page of the item
 } NVOCTP_itemHdr_t;
 
 // Length (bytes) of compressed header
@@ -359,6 +626,26 @@ typedef struct
     uint8_t          *pBuf; // Ptr to data buffer
 } NVOCTP_itemWrp_t;
 
+#if NVOCTP_RAMINDEX
+// RAM index entry
+typedef struct
+{
+    uint32_t cmpid; // Compressed ID, NVOCTP_IDXEMPTY if slot is unused
+    uint16_t hofs;  // Header offset of the item
+    uint8_t  pg;    // Page of the item
+} NVOCTP_idxEnt_t;
+#endif
+
+#if NVOCTP_RETIRE
+// Old copy of an item that is still marked active in Flash
+typedef struct
+{
+    uint32_t cmpid; // Compressed ID of the item
+    uint16_t hofs;  // Header offset of the old copy
+    uint8_t  pg;    // Page of the old copy
+} NVOCTP_retEnt_t;
+#endif
+
 //*****************************************************************************
 // Local variables
 //*****************************************************************************
@@ -377,19 +664,49 @@ static NVS_Attrs NVOCTP_nvsAttrs;
 static uint8_t NVOCTP_nvBegPage;
 static uint8_t NVOCTP_nvEndPage;
 
+// Number of Flash pages in the NV ring
+static uint8_t NVOCTP_nvPages;
+
+#if NVOCTP_MAPPED
+// Flag to indicate that the NV region can be read in place
+static bool NVOCTP_mapped;
+#endif
+
 #ifndef NVDEBUG
-// Active page
+// Active page, newest page of the ring
 static uint8_t NVOCTP_activePg;
 
 // Active page offset to next available location to write an item
 static uint16_t NVOCTP_pgOff;
+
+// Oldest page of the ring, next one to be compacted
+static uint8_t NVOCTP_tailPg;
 #else
 uint8_t NVOCTP_activePg;
 uint16_t NVOCTP_pgOff;
+uint8_t NVOCTP_tailPg;
 #endif
 
-// Active page compaction cycle count. Used to select the 'newest' active page
-// at device reset, in the very unlikely scenario that both pages are active.
+// Offset to next available location of the other pages in use, indexed by
+// page number from the first page of the ring
+static uint16_t NVOCTP_pgEnd[NVOCTP_MAXPAGES];
+
+// Tail page offset to next item to be moved, 0 when no transfer is in progress
+static uint16_t NVOCTP_xferOff;
+
+#if NVOCTP_COMPACTSTEP
+// Bytes left when the current compactNV() reclaim cycle started, and number
+// of tail pages it still has to transfer, 0 when no cycle is in progress
+static uint32_t NVOCTP_cycleLeft;
+static uint8_t NVOCTP_cyclePages;
+#endif
+
+// Flag to indicate that the header of the next item to be moved can be
+// trusted, cleared for the newest item and after a corrupt item was copied
+static bool NVOCTP_xferTrust;
+
+// Active page sequence count. Used to find the order of the pages in use at
+// device reset, the newest page is the active page.
 static uint8_t NVOCTP_pgCycle;
 
 // Flag to indicate that a fatal error occurred while writing to or erasing the
@@ -405,15 +722,57 @@ static uint8_t NVOCTP_failW;
 // TI-RTOS gateMutexPri for the NV driver API functions
 static GateMutexPri_Handle NVOCTP_gMutexPri;
 
+// Number of readers inside the driver, changed with interrupts disabled
+static volatile uint8_t NVOCTP_readers;
+
+// Flag to indicate that a writer waits for the readers to leave
+static volatile bool NVOCTP_writerWait;
+
+// Posted by the last reader to leave when a writer waits
+static Semaphore_Struct NVOCTP_rdSem;
+
 // Small NV Item Buffer, for item construction
 static uint8_t NVOCTP_itemBuffer[NVOCTP_SMALLITEM];
 
 // Function Pointer to an optional user provided voltage check function
 static bool (*NVOCTP_voltCheckFptr)(void);
 
-// Diagnostic counter for bad CRCs
+#if NVOCTP_CHUNKLEN
+// Last chunk of a streamed item, for appends that fill it up
+static uint8_t NVOCTP_chunkBuf[NVOCTP_CHUNKLEN];
+#endif
+
 #ifdef NVOCTP_STATS
-static uint16_t NVOCTP_badCRCCount = 0;
+// Driver diagnostic data, saved to the diagnostic item now and then
+static NVOCTP_diag_t NVOCTP_diags;
+
+// Number of item writes since the diagnostic data was saved
+static uint16_t NVOCTP_diagWrites = 0;
+
+// Diagnostic counters of items moved and left behind by the page transfer
+static uint16_t NVOCTP_xferActive;
+static uint16_t NVOCTP_xferDeleted;
+#endif
+
+#if NVOCTP_RAMINDEX
+// RAM index of the active items in the NV ring, open addressing
+static NVOCTP_idxEnt_t NVOCTP_idxTbl[NVOCTP_RAMINDEX];
+
+// Number of used RAM index slots
+static uint16_t NVOCTP_idxCount;
+
+// Flag to indicate that the RAM index holds every active item. When cleared
+// (table full or flash failure) findItem() falls back to a page traversal
+// until the next compaction rebuilds the index.
+static bool NVOCTP_idxValid;
+#endif
+
+#if NVOCTP_RETIRE
+// Old item copies waiting for their inactive mark, oldest first
+static NVOCTP_retEnt_t NVOCTP_retTbl[NVOCTP_RETIRE];
+
+// Number of used entries of NVOCTP_retTbl
+static uint8_t NVOCTP_retCount;
 #endif
 
 //*****************************************************************************
@@ -429,6 +788,14 @@ static IArg NVOCTP_lockNvApi(void);
 
 static void NVOCTP_unlockNvApi(IArg);
 
+static void NVOCTP_lockRd(void);
+
+static void NVOCTP_unlockRd(void);
+
+#if defined (NVOCTP_STATS)
+static void NVOCTP_histAdd(uint8_t op, uint32_t start);
+#endif
+
 // NV API data item functions
 static uint8_t NVOCTP_createItemApi(NVINTF_itemID_t id,
                                     uint32_t len,
@@ -449,6 +816,25 @@ static uint8_t NVOCTP_writeItemApi(NVINTF_itemID_t id,
 
 static uint8_t NVOCTP_doNextApi(NVINTF_nvProxy_t * prx);
 
+#if NVOCTP_CHUNKLEN
+// NV API streamed item functions
+static uint8_t NVOCTP_appendItemApi(NVINTF_itemID_t id,
+                                    uint16_t len,
+                                    void *buf);
+
+static uint8_t NVOCTP_readStreamApi(NVINTF_itemID_t id,
+                                    uint32_t ofs,
+                                    uint16_t len,
+                                    void *buf);
+
+static uint32_t NVOCTP_getStreamLenApi(NVINTF_itemID_t id);
+
+static uint8_t NVOCTP_deleteStreamApi(NVINTF_itemID_t id);
+
+static uint16_t NVOCTP_chunkCount(NVINTF_itemID_t id,
+                                  uint16_t *pLast);
+#endif
+
 // NV driver utility functions
 static uint8_t NVOCTP_readByte(uint8_t pg,
                                uint16_t ofs);
@@ -462,21 +848,42 @@ static uint8_t NVOCTP_checkItem(NVINTF_itemID_t *id,
                                 NVOCTP_itemHdr_t *iHdr,
                                 uint8_t flag);
 
-static int16_t NVOCTP_compactPage(uint8_t srcPg);
+static int16_t NVOCTP_compactPage(uint8_t pg);
 
-static void NVOCTP_copyItem(uint8_t xPg,
-                            uint16_t sOfs,
-                            uint16_t dOfs,
-                            uint16_t len);
+static uint32_t NVOCTP_ringLeft(void);
+
+static bool NVOCTP_xferPage(uint8_t srcPg,
+                            uint16_t maxItems);
+
+#if NVOCTP_COMPACTSTEP
+static void NVOCTP_compactStep(void);
+#endif
 
-static int16_t NVOCTP_findItem(uint8_t pg,
+static uint8_t NVOCTP_copyItem(uint8_t srcPg,
+                               uint8_t dstPg,
+                               uint16_t sOfs,
+                               uint16_t dOfs,
+                               NVOCTP_itemHdr_t *pHdr);
+
+static int16_t NVOCTP_findItem(uint8_t *pPg,
                                uint16_t ofs,
                                uint32_t cid,
                                uint8_t flag);
 
+static bool NVOCTP_prevItem(uint8_t pg,
+                            uint16_t *pOfs,
+                            bool trust,
+                            NVOCTP_itemHdr_t *pHdr);
+
+static void NVOCTP_nestedItem(uint8_t pg,
+                              uint16_t *pOfs,
+                              NVOCTP_itemHdr_t *pHdr);
+
 static uint16_t NVOCTP_findOffset(uint8_t pg,
                                   uint16_t ofs);
 
+static bool NVOCTP_makeRoom(uint16_t iLen);
+
 static uint8_t NVOCTP_newItem(NVOCTP_itemHdr_t *iHdr,
                               uint8_t *pBuf);
 
@@ -485,6 +892,11 @@ static inline void NVOCTP_read(uint8_t pg,
                                uint8_t *pBuf,
                                uint16_t len);
 
+static inline const uint8_t *NVOCTP_readPtr(uint8_t pg,
+                                            uint16_t off,
+                                            uint8_t *pBuf,
+                                            uint16_t len);
+
 static uint8_t NVOCTP_readItem(NVOCTP_itemHdr_t *iHdr,
                               uint16_t ofs,
                               uint16_t len,
@@ -494,14 +906,23 @@ static void NVOCTP_readHeader(uint8_t pg,
                               uint16_t ofs,
                               NVOCTP_itemHdr_t *iHdr);
 
-static void NVOCTP_setItemInactive(uint16_t hOfs);
+static void NVOCTP_setItemInactive(uint8_t pg,
+                                   uint16_t hOfs);
 
 static void NVOCTP_setPageActive(uint8_t pg);
 
+static void NVOCTP_openPage(uint8_t pg);
+
+static bool NVOCTP_isErased(uint8_t pg);
+
 static void NVOCTP_writeItem(NVOCTP_itemHdr_t *iHdr,
                              uint8_t dstPg,
                              uint8_t *pBuf);
 
+static void NVOCTP_packHeader(NVOCTP_itemHdr_t *pHdr,
+                              uint8_t crc,
+                              uint8_t *cHdr);
+
 static uint8_t NVOCTP_doNVCRC(uint8_t pg,
                              uint16_t ofs,
                              uint16_t len,
@@ -511,17 +932,80 @@ static uint8_t NVOCTP_doRAMCRC(uint8_t *input,
                              uint16_t len,
                              uint8_t crc);
 
-static uint8_t NVOCTP_verifyCRC(uint16_t iOfs,
+static uint8_t NVOCTP_verifyCRC(uint8_t pg,
+                             uint16_t iOfs,
                              uint16_t len,
                              uint8_t crc);
 
+static uint8_t NVOCTP_checkCRC(uint16_t len,
+                               uint8_t crc,
+                               uint8_t newCRC);
+
+static bool NVOCTP_sameItem(NVOCTP_itemHdr_t *iHdr,
+                            uint8_t *pBuf,
+                            uint16_t len);
+
 static uint8_t NVOCTP_write(uint8_t dstPg,
                             uint16_t off,
                             uint8_t *pBuf,
                             uint16_t len);
 
+static uint8_t NVOCTP_writeCRC(uint8_t dstPg,
+                               uint16_t off,
+                               uint8_t *pBuf,
+                               uint16_t len,
+                               uint8_t *pCrc);
+
+static bool NVOCTP_verify(uint8_t pg,
+                          uint16_t off,
+                          uint8_t *pBuf,
+                          uint16_t len,
+                          uint8_t *pCrc);
+
 static uint8_t NVOCTP_erase(uint8_t dstPg);
 
+#if NVOCTP_RAMINDEX
+static void NVOCTP_buildIndex(void);
+
+static void NVOCTP_idxReset(void);
+
+static int16_t NVOCTP_idxFind(uint32_t cid);
+
+static bool NVOCTP_idxPut(uint32_t cid,
+                          uint8_t pg,
+                          uint16_t hofs);
+
+static void NVOCTP_idxDelete(uint8_t pg,
+                             uint16_t hofs);
+
+static int16_t NVOCTP_idxFindItem(uint8_t *pPg,
+                                  uint16_t ofs,
+                                  uint32_t cid,
+                                  uint8_t flag);
+#else
+static void NVOCTP_dropDuplicate(void);
+#endif
+
+#if NVOCTP_CHECKPOINT
+static void NVOCTP_writeCheckpoint(void);
+
+static bool NVOCTP_loadCheckpoint(void);
+#endif
+
+#if NVOCTP_RETIRE
+static void NVOCTP_retAdd(uint32_t cid,
+                          uint8_t pg,
+                          uint16_t hofs);
+
+static void NVOCTP_retMark(uint32_t cid,
+                           uint8_t keepPg);
+
+static void NVOCTP_retDrop(uint8_t pg);
+
+static bool NVOCTP_retFind(uint8_t pg,
+                           uint16_t hofs);
+#endif
+
 //*****************************************************************************
 // API Functions - NV driver
 //*****************************************************************************
@@ -549,6 +1033,17 @@ void NVOCTP_loadApiPtrs(NVINTF_nvFuncts_t *pfn)
     pfn->lockNV      = NULL;
     pfn->unlockNV    = NULL;
     pfn->doNext      = NULL;
+#if NVOCTP_CHUNKLEN
+    pfn->appendItem   = &NVOCTP_appendItemApi;
+    pfn->readStream   = &NVOCTP_readStreamApi;
+    pfn->getStreamLen = &NVOCTP_getStreamLenApi;
+    pfn->deleteStream = &NVOCTP_deleteStreamApi;
+#else
+    pfn->appendItem   = NULL;
+    pfn->readStream   = NULL;
+    pfn->getStreamLen = NULL;
+    pfn->deleteStream = NULL;
+#endif
 }
 
 /**
@@ -576,6 +1071,10 @@ void NVOCTP_loadApiPtrsMin(NVINTF_nvFuncts_t *pfn)
     pfn->lockNV      = NULL;
     pfn->unlockNV    = NULL;
     pfn->doNext      = NULL;
+    pfn->appendItem   = NULL;
+    pfn->readStream   = NULL;
+    pfn->getStreamLen = NULL;
+    pfn->deleteStream = NULL;
 }
 
 /**
@@ -602,6 +1101,17 @@ void NVOCTP_loadApiPtrsExt(NVINTF_nvFuncts_t *pfn)
     pfn->lockNV      = &NVOCTP_lockNvApi;
     pfn->unlockNV    = &NVOCTP_unlockNvApi;
     pfn->doNext      = &NVOCTP_doNextApi;
+#if NVOCTP_CHUNKLEN
+    pfn->appendItem   = &NVOCTP_appendItemApi;
+    pfn->readStream   = &NVOCTP_readStreamApi;
+    pfn->getStreamLen = &NVOCTP_getStreamLenApi;
+    pfn->deleteStream = &NVOCTP_deleteStreamApi;
+#else
+    pfn->appendItem   = NULL;
+    pfn->readStream   = NULL;
+    pfn->getStreamLen = NULL;
+    pfn->deleteStream = NULL;
+#endif
 }
 
 /**
@@ -623,6 +1133,169 @@ extern void NVOCTP_setCheckVoltage(void *funcPtr)
     NVOCTP_voltCheckFptr = (bool (*)()) funcPtr;
 }
 
+#if defined (NVOCTP_STATS)
+/**
+ * @fn      NVOCTP_getDiags
+ *
+ * @brief   Global function to read the current driver diagnostic data
+ *
+ * @param   pDiag - pointer to caller's diagnostic data structure
+ *
+ * @return  none
+ */
+void NVOCTP_getDiags(NVOCTP_diag_t *pDiag)
+{
+    // Readers count latencies too, so take exclusive access
+    IArg key = NVOCTP_lockNvApi();
+
+    memcpy(pDiag, &NVOCTP_diags, sizeof(NVOCTP_diag_t));
+    NVOCTP_unlockNvApi(key);
+}
+#endif
+
+/**
+ * @fn      NVOCTP_retireIdle
+ *
+ * @brief   Global function to write the deferred inactive marks of old item
+ *          copies in one batch, once half of the list is used
+ *
+ * @return  none
+ */
+void NVOCTP_retireIdle(void)
+{
+#if NVOCTP_RETIRE
+    IArg key;
+
+    if((NVOCTP_failF != NVINTF_SUCCESS) ||
+       (NVOCTP_retCount < ((NVOCTP_RETIRE + 1) / 2)))
+    {
+        // Not initialized, or too few for a batch
+        return;
+    }
+
+    key = NVOCTP_lockNvApi();
+    NVOCTP_failW = NVINTF_SUCCESS;
+    NVOCTP_retMark(NVOCTP_RETALL, NVOCTP_RETKEEP());
+    NVOCTP_unlockNvApi(key);
+#endif
+}
+
+/**
+ * @fn      NVOCTP_getUsage
+ *
+ * @brief   Global function to walk the NV ring and report how its bytes are
+ *          used
+ *
+ * @param   pUse    - pointer to caller's usage structure
+ * @param   pfnItem - called for every item, NULL if not needed
+ *
+ * @return  none
+ */
+void NVOCTP_getUsage(NVOCTP_usage_t *pUse, NVOCTP_usageCB_t pfnItem)
+{
+    IArg key;
+    uint8_t i;
+    uint8_t pg;
+    uint8_t freePages;
+
+    memset(pUse, 0, sizeof(NVOCTP_usage_t));
+    if(NVOCTP_failF != NVINTF_SUCCESS)
+    {
+        return;
+    }
+
+    key = NVOCTP_lockNvApi();
+
+    // Newest page first, items are live if findItem() returns them
+    pg = NVOCTP_activePg;
+    for(i = NVOCTP_PGUSED(); i > 0; i--, pg = NVOCTP_PREVPG(pg))
+    {
+        uint16_t ofs = NVOCTP_PGEND(pg);
+        uint16_t end = ofs;
+        NVOCTP_itemHdr_t iHdr;
+
+        while(NVOCTP_prevItem(pg, &ofs, FALSE, &iHdr))
+        {
+            uint16_t size = NVOCTP_ITEMHDRLEN + iHdr.len;
+            bool live = FALSE;
+
+            if(end != (iHdr.hofs + NVOCTP_ITEMHDRLEN))
+            {
+                // Corrupted area between this item and the one above
+                pUse->badBytes += end - (iHdr.hofs + NVOCTP_ITEMHDRLEN);
+                pUse->badAreas++;
+            }
+            end = ofs;
+
+            if((iHdr.stats & NVOCTP_ACTIVEIDBIT) &&
+              !(iHdr.stats & NVOCTP_VALIDIDBIT))
+            {
+                uint8_t fPg = NVOCTP_activePg;
+
+                live = (NVOCTP_findItem(&fPg, NVOCTP_pgOff, iHdr.cmpid,
+                                        NVOCTP_FINDSTRICT) == iHdr.hofs) &&
+                       (fPg == pg);
+            }
+            if(live)
+            {
+                pUse->liveBytes += size;
+                pUse->liveItems++;
+            }
+            else
+            {
+                pUse->deadBytes += size;
+                pUse->deadItems++;
+            }
+
+            if(pfnItem != NULL)
+            {
+                NVINTF_itemID_t id;
+
+                id.systemID = iHdr.sysid;
+                id.itemID   = iHdr.itemid;
+                id.subID    = iHdr.subid;
+                pfnItem(NVOCTP_PGPOS(pg), id, size, live);
+            }
+        }
+        if(end > NVOCTP_PGDATAOFS)
+        {
+            // Nothing valid at the bottom of the page
+            pUse->badBytes += end - NVOCTP_PGDATAOFS;
+            pUse->badAreas++;
+        }
+    }
+
+    // Same room as compactNvApi() works with, up to the next compaction
+    pUse->pages = NVOCTP_PGUSED();
+    freePages = NVOCTP_nvPages - pUse->pages;
+    pUse->freeBytes = FLASH_PAGE_SIZE - NVOCTP_pgOff;
+#if NVOCTP_COMPACTSTEP
+    if(NVOCTP_RECLAIM())
+    {
+        // Every write does a compaction step
+        pUse->freeBytes = 0;
+    }
+    else if(freePages > 2)
+    {
+        // Opening the last free page but one starts the compaction steps
+        pUse->freeBytes += (uint32_t)(freePages - 2) * NVOCTP_PGDATALEN;
+    }
+#else
+    if(freePages > 1)
+    {
+        // One page is kept free for compaction
+        pUse->freeBytes += (uint32_t)(freePages - 1) * NVOCTP_PGDATALEN;
+    }
+#endif
+    if(pUse->liveItems != 0)
+    {
+        pUse->writesLeft = pUse->freeBytes /
+                           (pUse->liveBytes / pUse->liveItems);
+    }
+
+    NVOCTP_unlockNvApi(key);
+}
+
 /******************************************************************************
  * @fn      NVOCTP_initNvApi
  *
@@ -641,15 +1314,25 @@ static uint8_t NVOCTP_initNvApi(void *param)
     {
         uint8_t pg;
         uint8_t xferPg;
+        uint8_t xferCycle = 0;
         GateMutexPri_Params gateParams;
+        Semaphore_Params semParams;
 
         // Only one init per device reset
         NVOCTP_failF = NVOCTP_failW = NVINTF_SUCCESS;
+#if NVOCTP_RETIRE
+        NVOCTP_retCount = 0;
+#endif
 
         // Create a priority gate mutex for the NV driver
         GateMutexPri_Params_init(&gateParams);
         NVOCTP_gMutexPri = GateMutexPri_create(&gateParams, NULL);
 
+        // Writers wait on this semaphore for the readers to leave
+        Semaphore_Params_init(&semParams);
+        semParams.mode = Semaphore_Mode_BINARY;
+        Semaphore_construct(&NVOCTP_rdSem, 0, &semParams);
+
         xferPg = NVOCTP_NULLPAGE;
         NVOCTP_activePg = NVOCTP_NULLPAGE;
 
@@ -662,7 +1345,21 @@ static uint8_t NVOCTP_initNvApi(void *param)
         // Get page number from hardware attributes
         NVOCTP_nvBegPage = ((size_t)(NVOCTP_nvsAttrs.regionBase)/
                 NVOCTP_nvsAttrs.sectorSize);
-        NVOCTP_nvEndPage = NVOCTP_nvBegPage + 1;
+        // All pages of the region make up the NV ring, up to the maximum
+        NVOCTP_nvPages = ((NVOCTP_nvsAttrs.regionSize /
+                NVOCTP_nvsAttrs.sectorSize) < NVOCTP_MAXPAGES) ?
+                (NVOCTP_nvsAttrs.regionSize / NVOCTP_nvsAttrs.sectorSize) :
+                NVOCTP_MAXPAGES;
+        NVOCTP_nvEndPage = NVOCTP_nvBegPage + NVOCTP_nvPages - 1;
+#if NVOCTP_MAPPED
+        // Internal Flash is memory mapped, SPI Flash is not
+#ifdef NVS_REGION_NOT_ADDRESSABLE
+        NVOCTP_mapped = (NVOCTP_nvsAttrs.regionBase !=
+                         NVS_REGION_NOT_ADDRESSABLE);
+#else
+        NVOCTP_mapped = TRUE;
+#endif
+#endif
 
         // Confirm sector size is expected value
         if (FLASH_PAGE_SIZE != NVOCTP_nvsAttrs.sectorSize)
@@ -681,7 +1378,16 @@ static uint8_t NVOCTP_initNvApi(void *param)
             return NVOCTP_failF;
         }
 
-        // Look for active page and clean up the other if necessary
+        // Compaction needs a page to compact to
+        if (NVOCTP_nvPages < 2)
+        {
+            NVOCTP_failF = NVINTF_FAILURE;
+            NVOCTP_ASSERT(FALSE,"NVS REGION TOO SMALL")
+            NVOCTP_EXCEPTION(pg, NVINTF_FAILURE);
+            return NVOCTP_failF;
+        }
+
+        // Look for newest active page and clean up invalid pages
         for(pg = NVOCTP_nvBegPage; pg <= NVOCTP_nvEndPage; pg++)
         {
             NVOCTP_pageHdr_t pHdr;
@@ -700,44 +1406,24 @@ static uint8_t NVOCTP_initNvApi(void *param)
                     NVOCTP_ASSERT(FALSE, "Version mismatch.")
                     NVOCTP_EXCEPTION(pg, NVINTF_BADVERSION);
                 }
-                if(NVOCTP_activePg == NVOCTP_NULLPAGE)
+                if((NVOCTP_activePg == NVOCTP_NULLPAGE) ||
+                   ((NVOCTP_CYCDIFF(pHdr.cycle, NVOCTP_pgCycle) > 0) &&
+                    (NVOCTP_CYCDIFF(pHdr.cycle, NVOCTP_pgCycle) <
+                     (NVOCTP_NUMCYCLES / 2))))
                 {
-                    // First active page found
+                    // Newest active page found so far
                     NVOCTP_activePg = pg;
                     NVOCTP_pgCycle  = pHdr.cycle;
                 }
-                else
-                {
-                    // Both pages are in the active state, pick one...
-                    if(((NVOCTP_pgCycle > pHdr.cycle) &&
-                       ((NVOCTP_pgCycle != NVOCTP_MAXCYCLE) &&
-                        (pHdr.cycle != NVOCTP_MINCYCLE))) ||
-                       ((NVOCTP_pgCycle < pHdr.cycle) &&
-                       ((NVOCTP_pgCycle == NVOCTP_MINCYCLE) &&
-                        (pHdr.cycle == NVOCTP_MAXCYCLE))))
-                    {
-                        // First page found is newer, erase the second
-                        NVOCTP_failW = NVOCTP_erase(pg);
-                    }
-                    else
-                    {
-                        // Second page found is newer, erase the first
-                        NVOCTP_failW    = NVOCTP_erase(NVOCTP_activePg);
-                        NVOCTP_activePg = pg;
-                        NVOCTP_pgCycle  = pHdr.cycle;
-                    }
-                }
             }
-            else if(pHdr.state == NVOCTP_PGXFER)
+            else if((pHdr.state == NVOCTP_PGXFER) &&
+                    (xferPg == NVOCTP_NULLPAGE))
             {
                 xferPg = pg;
-                if(NVOCTP_pgCycle == 0)
-                {
-                    // Restore interrupted compaction cycle count
-                    NVOCTP_pgCycle = pHdr.cycle;
-                }
+                xferCycle = pHdr.cycle;
             }
-            else if(pHdr.state != NVOCTP_PGERASED)
+            else if((pHdr.state != NVOCTP_PGCLEAR) &&
+                    (pHdr.state != NVOCTP_PGERASED))
             {
                 // Ensure that interrupted compaction page erase gets finished
                 NVOCTP_failW = NVOCTP_erase(pg);
@@ -746,52 +1432,108 @@ static uint8_t NVOCTP_initNvApi(void *param)
 
         if(NVOCTP_activePg == NVOCTP_NULLPAGE)
         {
-            if(xferPg == NVOCTP_NULLPAGE)
+            // No active page, unless interrupted while compacting the only one
+            NVOCTP_activePg = xferPg;
+            NVOCTP_pgCycle  = xferCycle;
+        }
+        NVOCTP_tailPg = NVOCTP_activePg;
+
+        if(NVOCTP_activePg != NVOCTP_NULLPAGE)
+        {
+            uint8_t cycle = NVOCTP_pgCycle;
+
+            // Older pages in use precede the active page in the ring, each
+            // with the previous sequence count
+            for(pg = NVOCTP_PREVPG(NVOCTP_activePg); pg != NVOCTP_activePg;
+                pg = NVOCTP_PREVPG(pg))
             {
-                // Both pages are erased. Initial state, select an active page
-                NVOCTP_setPageActive(NVOCTP_nvBegPage);
-                NVOCTP_pgOff = NVOCTP_PGDATAOFS;
+                NVOCTP_pageHdr_t pHdr;
+
+                NVOCTP_read(pg,NVOCTP_PGHDROFS, (uint8_t *)&pHdr,
+                            NVOCTP_PGHDRLEN);
+                cycle = NVOCTP_PREVCYCLE(cycle);
+                if((pHdr.state != NVOCTP_PGACTIVE) || (pHdr.cycle != cycle) ||
+                   (pHdr.signature != NVOCTP_SIGNATURE))
+                {
+                    break;
+                }
+                NVOCTP_tailPg = pg;
             }
-            else
+
+            if((xferPg != NVOCTP_NULLPAGE) &&
+               (xferPg == NVOCTP_PREVPG(NVOCTP_tailPg)))
+            {
+                // Page being compacted is still the oldest page in use
+                NVOCTP_tailPg = xferPg;
+            }
+
+            for(pg = NVOCTP_nvBegPage; pg <= NVOCTP_nvEndPage; pg++)
+            {
+                uint8_t state = NVOCTP_readByte(pg, NVOCTP_PGHDRPST);
+
+                if(NVOCTP_PGPOS(pg) < NVOCTP_PGUSED())
+                {
+                    // Find the offset for next NV item write
+                    NVOCTP_pgEnd[pg - NVOCTP_nvBegPage] =
+                            NVOCTP_findOffset(pg, FLASH_PAGE_SIZE);
+                }
+                else if((state != NVOCTP_PGCLEAR) &&
+                        (state != NVOCTP_PGERASED))
+                {
+                    // Not in use, compaction completed except for this erase
+                    NVOCTP_failW = NVOCTP_erase(pg);
+                }
+            }
+            NVOCTP_pgOff = NVOCTP_pgEnd[NVOCTP_activePg - NVOCTP_nvBegPage];
+
+            if(NVOCTP_tailPg == xferPg)
             {
                 // Compacting interrupted in previous power cycle - do it now
                 NVOCTP_ALERT(FALSE, "NVOCTP Init., recovering from compaction"
                         " interruption.")
-                NVOCTP_activePg = xferPg;
-                NVOCTP_pgOff    = NVOCTP_findOffset(xferPg, FLASH_PAGE_SIZE);
                 (void)NVOCTP_compactPage(xferPg);
             }
         }
         else
         {
-            if(xferPg != NVOCTP_NULLPAGE)
-            {
-                // Compacting completed except for last step to erase xferPage
-                NVOCTP_failW = NVOCTP_erase(xferPg);
-            }
-            // Find the active page offset for next NV item write
-            NVOCTP_pgOff = NVOCTP_findOffset(NVOCTP_activePg, FLASH_PAGE_SIZE);
+            // All pages are erased. Initial state, select an active page
+            NVOCTP_openPage(NVOCTP_nvBegPage);
+            NVOCTP_tailPg = NVOCTP_activePg;
         }
 
-#if defined (NVOCTP_STATS)
+#if NVOCTP_RAMINDEX
+#if NVOCTP_CHECKPOINT
+        // Index the active page, its checkpoint covers the older pages
+        if(!NVOCTP_loadCheckpoint())
+#endif
         {
-            uint8_t err;
-            NVOCTP_diag_t diags;
+            // One ring traversal to index all active items
+            NVOCTP_buildIndex();
+        }
+#else
+        // Retire the old copy of an update interrupted by a reset
+        NVOCTP_dropDuplicate();
+#endif
+
+#if defined (NVOCTP_STATS)
+        {
+            uint8_t err;
 
             // Look for a copy of diagnostic info
-            err = NVOCTP_readItemApi(diagId, 0, sizeof(diags), &diags);
-            if(err == NVINTF_NOTFOUND)
+            err = NVOCTP_readItemApi(diagId, 0, sizeof(NVOCTP_diags),
+                                     &NVOCTP_diags);
+            if(err != NVINTF_SUCCESS)
             {
-                // Assume this is the first time,
-                memset(&diags, 0, sizeof(diags));
+                // Assume this is the first time, or the layout changed
+                memset(&NVOCTP_diags, 0, sizeof(NVOCTP_diags));
                 // Space available for everything else
-                diags.available = FLASH_PAGE_SIZE - (NVOCTP_pgOff +
-                        NVOCTP_ITEMHDRLEN + sizeof(diags));
+                NVOCTP_diags.available = FLASH_PAGE_SIZE - (NVOCTP_pgOff +
+                        NVOCTP_ITEMHDRLEN + sizeof(NVOCTP_diags));
             }
             // Remember this reset
-            diags.resets += 1;
+            NVOCTP_diags.resets += 1;
             // Create/Update the diagnostic NV item
-            NVOCTP_writeItemApi(diagId, sizeof(diags), &diags);
+            NVOCTP_writeItemApi(diagId, sizeof(NVOCTP_diags), &NVOCTP_diags);
         }
 #endif
     }
@@ -801,44 +1543,104 @@ static uint8_t NVOCTP_initNvApi(void *param)
 /******************************************************************************
  * @fn      NVOCTP_compactNvApi
  *
- * @brief   API function to force NV active page compaction
+ * @brief   API function to force NV compaction. The oldest page is compacted
+ *          when less than minAvail bytes are left in the ring, minAvail 0
+ *          compacts all pages in use. With incremental compaction enabled,
+ *          a call with minAvail > 0 only does one compaction step, the
+ *          caller repeats the call while NVINTF_SUCCESS is returned. A reclaim
+ *          cycle that transfers every page in use without freeing any bytes
+ *          ends with NVINTF_FAILURE, so the caller never loops on a ring
+ *          whose items are all current.
  *
- * @param   minAvail - threshold size of available bytes on Flash page to do
+ * @param   minAvail - threshold size of available bytes in the NV ring to do
  *                     compaction: 0 = always, >0 = minimum remaining bytes
  *
- * @return  NVINTF_SUCCESS or specific failure code
+ * @return  NVINTF_SUCCESS or specific failure code, NVINTF_BADPARAM when no
+ *          compaction is needed or minAvail is more than an empty ring holds,
+ *          NVINTF_FAILURE when compaction can not free any more bytes
  */
 static uint8_t NVOCTP_compactNvApi(uint16_t minAvail)
 {
     uint8_t err;
 
-    // Prevent RTOS thread contention
-    NVOCTP_LOCK();
+    // Prevent RTOS thread contention, compactions time themselves
+    IArg key = NVOCTP_lockNvApi();
     NVOCTP_ALERT(FALSE, "API Compaction Request.")
     err = NVOCTP_failF;
     // Check for a fatal error
     if(err == NVINTF_SUCCESS)
     {
-        int16_t left;
-
-        // Number of bytes left on active page
-        left = FLASH_PAGE_SIZE - NVOCTP_pgOff;
+        uint32_t left = NVOCTP_ringLeft();
 
         // Time to do a compaction?
-        if((left < minAvail) || (minAvail == 0))
+        if(minAvail == 0)
         {
-            // Transfer all items to non-ACTIVE page
+            // Transfer items of all pages in use to a fresh active page
             (void)NVOCTP_compactPage(NVOCTP_activePg);
             // 'failW' indicates compaction status
             err = NVOCTP_failW;
         }
+        else if(minAvail > (uint32_t)(NVOCTP_nvPages - 1) * NVOCTP_PGDATALEN)
+        {
+            // More than the ring holds with only the compaction page spare
+            err = NVINTF_BADPARAM;
+        }
+#if NVOCTP_COMPACTSTEP
+        else if((left < minAvail) || (NVOCTP_xferOff != 0))
+        {
+            if(NVOCTP_cyclePages == 0)
+            {
+                // Start a reclaim cycle over the pages in use
+                NVOCTP_cycleLeft = left;
+                NVOCTP_cyclePages = NVOCTP_PGUSED();
+            }
+
+            // Move a few items of the oldest page to the active page
+            NVOCTP_failW = NVINTF_SUCCESS;
+            NVOCTP_compactStep();
+            // 'failW' indicates compaction status
+            err = NVOCTP_failW;
+
+            if((err == NVINTF_SUCCESS) && (NVOCTP_xferOff == 0))
+            {
+                // A tail page was erased, start over if that freed bytes
+                if(NVOCTP_ringLeft() > NVOCTP_cycleLeft)
+                {
+                    NVOCTP_cyclePages = 0;
+                }
+                else if(--NVOCTP_cyclePages == 0)
+                {
+                    // Every page was transferred and nothing was freed
+                    err = NVINTF_FAILURE;
+                }
+            }
+        }
+#else
+        else if(left < minAvail)
+        {
+            // Transfer items of the oldest page to the active page
+            (void)NVOCTP_compactPage(NVOCTP_tailPg);
+            // 'failW' indicates compaction status
+            err = NVOCTP_failW;
+        }
+#endif
         else
         {
             // Indicate "bad" minAvail value
             err = NVINTF_BADPARAM;
         }
+
+#if NVOCTP_COMPACTSTEP
+        if(err != NVINTF_SUCCESS)
+        {
+            // Next stepped request starts a new reclaim cycle
+            NVOCTP_cyclePages = 0;
+        }
+#endif
     }
-    NVOCTP_UNLOCK(err);
+    NVOCTP_unlockNvApi(key);
+
+    return (err);
 }
 
 //*****************************************************************************
@@ -871,13 +1673,23 @@ static uint8_t NVOCTP_createItemApi(NVINTF_itemID_t id,
     }
 
     // Prevent RTOS thread contention
-    NVOCTP_LOCK();
+    NVOCTP_LOCK(NVOCTP_HISTWRITE);
+
+    // Reset erase/write fail indicator for current transaction
+    NVOCTP_failW = NVINTF_SUCCESS;
 
     err = NVOCTP_checkItem(&id, len, &iHdr, NVOCTP_FINDSTRICT);
     if(err == NVINTF_NOTFOUND)
     {
         // Create the new item
         err = NVOCTP_newItem(&iHdr, pBuf);
+#if NVOCTP_COMPACTSTEP
+        if((err == NVINTF_SUCCESS) && NVOCTP_RECLAIM())
+        {
+            // Reclaim the tail page a few items at a time
+            NVOCTP_compactStep();
+        }
+#endif
     }
     else
     {
@@ -915,21 +1727,43 @@ static uint8_t NVOCTP_deleteItemApi(NVINTF_itemID_t id)
         return (NVINTF_BADSYSID);
     }
 #endif
+#if NVOCTP_CHECKPOINT
+    if(!memcmp(&id, &ckptId, sizeof(NVINTF_itemID_t)))
+    {
+        // Protect NV driver item(s)
+        return (NVINTF_BADSYSID);
+    }
+#endif
 
     // Prevent RTOS thread contention
-    NVOCTP_LOCK();
+    NVOCTP_LOCK(NVOCTP_HISTDELETE);
+
+    // Reset erase/write fail indicator for current transaction
+    NVOCTP_failW = NVINTF_SUCCESS;
 
     err = NVOCTP_checkItem(&id, 0, &iHdr, NVOCTP_FINDSTRICT);
     if(err == NVINTF_SUCCESS)
     {
         int16_t hOfs;
 
+        uint8_t pg = NVOCTP_activePg;
+
+#if NVOCTP_RETIRE
+        // Old copies first, or they come back after a reset
+        NVOCTP_retMark(iHdr.cmpid, NVOCTP_NULLPAGE);
+#endif
         // Mark this item as inactive
-        NVOCTP_setItemInactive(iHdr.hofs);
+        NVOCTP_setItemInactive(iHdr.pg, iHdr.hofs);
 
-        // Verify that item has been removed
-        hOfs = NVOCTP_findItem(NVOCTP_activePg, NVOCTP_pgOff,
-                               iHdr.cmpid, NVOCTP_FINDSTRICT);
+        // Verify that item has been removed, older copies left behind by a
+        // reset go too
+        while(((hOfs = NVOCTP_findItem(&pg, NVOCTP_pgOff, iHdr.cmpid,
+                                       NVOCTP_FINDSTRICT)) > 0) &&
+              (NVOCTP_failW == NVINTF_SUCCESS))
+        {
+            NVOCTP_setItemInactive(pg, (uint16_t)hOfs);
+            pg = NVOCTP_activePg;
+        }
 
         // If item did get deleted, report 'failW' status
         err = (hOfs <= 0) ? NVOCTP_failW : NVINTF_FAILURE;
@@ -954,15 +1788,15 @@ static uint32_t NVOCTP_getItemLenApi(NVINTF_itemID_t id)
     uint32_t len;
     NVOCTP_itemHdr_t iHdr;
 
-    // Prevent RTOS thread contention
-    NVOCTP_LOCK();
+    // Lookups may run in parallel, writes are held off
+    NVOCTP_LOCKRD(NVOCTP_HISTREAD);
 
     err = NVOCTP_checkItem(&id, 0, &iHdr, NVOCTP_FINDSTRICT);
 
     // If there was any error, report zero length
     len = (err != NVINTF_SUCCESS) ? 0 : iHdr.len;
 
-    NVOCTP_UNLOCK(len);
+    NVOCTP_UNLOCKRD(len);
 }
 
 /******************************************************************************
@@ -991,8 +1825,8 @@ static uint8_t NVOCTP_readItemApi(NVINTF_itemID_t id,
         return NVINTF_BADPARAM;
     }
 
-    // Prevent RTOS thread contention
-    NVOCTP_LOCK();
+    // Lookups may run in parallel, writes are held off
+    NVOCTP_LOCKRD(NVOCTP_HISTREAD);
 
     err = NVOCTP_checkItem(&id, len, &iHdr, NVOCTP_FINDSTRICT);
 
@@ -1002,18 +1836,18 @@ static uint8_t NVOCTP_readItemApi(NVINTF_itemID_t id,
         err = NVOCTP_readItem(&iHdr, ofs, len, pBuf);
     }
 
-    NVOCTP_UNLOCK(err);
+    NVOCTP_UNLOCKRD(err);
 }
 
 /******************************************************************************
  * @fn      NVOCTP_writeItemApi
  *
  * @brief   API function to write data to item, creates item if needed.
- *          Note that when writing to an existing item, data is not
- *          checked for redundancy. Data passed to this function will be
- *          written to NV. NOTE: It is not recommended to write items with
- *          SYSID 0 as this is reserved for the driver. NVOCTP will not
- *          delete items with this SYSID.
+ *          When the existing item already holds the same length and data
+ *          (NVOCTP_sameItem()), nothing is written to NV and the write is
+ *          counted in diags.skipped. NOTE: It is not recommended to write
+ *          items with SYSID 0 as this is reserved for the driver. NVOCTP
+ *          will not delete items with this SYSID.
  *
  * @param   id   - NV item type identifier
  * @param   len - data buffer length to write into NV block  (0 is illegal)
@@ -1026,6 +1860,7 @@ static uint8_t NVOCTP_writeItemApi(NVINTF_itemID_t id,
                                    void *pBuf)
 {
     uint8_t err;
+    uint8_t oPg;
     uint16_t oOfs;
     NVOCTP_itemHdr_t iHdr;
 
@@ -1036,17 +1871,31 @@ static uint8_t NVOCTP_writeItemApi(NVINTF_itemID_t id,
     }
 
     // Prevent RTOS thread contention
-    NVOCTP_LOCK();
+    NVOCTP_LOCK(NVOCTP_HISTWRITE);
+
+    // Reset erase/write fail indicator for current transaction
+    NVOCTP_failW = NVINTF_SUCCESS;
 
+    oPg  = NVOCTP_NULLPAGE;
     oOfs = 0;
     err  = NVOCTP_checkItem(&id, len, &iHdr, NVOCTP_FINDSTRICT);
 
+    if((err == NVINTF_SUCCESS) && NVOCTP_sameItem(&iHdr, pBuf, len))
+    {
+        // Item already holds this data, leave Flash untouched
+#ifdef NVOCTP_STATS
+        NVOCTP_diags.skipped++;
+#endif
+        NVOCTP_UNLOCK(NVINTF_SUCCESS);
+    }
+
     if(err == NVINTF_SUCCESS)
     {
         // Found old version of item
         // Our new item may have different length
         iHdr.len = len;
-        // Offset of old item
+        // Location of old item
+        oPg  = iHdr.pg;
         oOfs = iHdr.hofs;
         // Trigger item creation
         err = NVINTF_NOTFOUND;
@@ -1055,21 +1904,292 @@ static uint8_t NVOCTP_writeItemApi(NVINTF_itemID_t id,
     // Check voltage if possible
     NVOCTP_FLASHACCESS(err)
 
+    if((err == NVINTF_NOTFOUND) && (oOfs != 0) &&
+       ((NVOCTP_pgOff + NVOCTP_ITEMHDRLEN + len) > FLASH_PAGE_SIZE))
+    {
+        int16_t hOfs;
+
+        // Compaction may move the old item, so do it here and find it again
+        (void)NVOCTP_makeRoom(NVOCTP_ITEMHDRLEN + len);
+        oPg  = NVOCTP_activePg;
+        hOfs = NVOCTP_findItem(&oPg, NVOCTP_pgOff,
+                               iHdr.cmpid, NVOCTP_FINDSTRICT);
+        oOfs = (hOfs > 0) ? hOfs : 0;
+    }
+
     if (err == NVINTF_NOTFOUND)
     {
         // Create a new item
         err = NVOCTP_newItem(&iHdr, pBuf);
-        if(oOfs != 0)
+        if((oOfs != 0) && (err == NVINTF_SUCCESS))
         {
+#if NVOCTP_RETIRE
+            // New copy is found first, the old one is marked later
+            NVOCTP_retAdd(iHdr.cmpid, oPg, oOfs);
+#else
             // Mark old item as inactive
-            NVOCTP_setItemInactive(oOfs);
+            NVOCTP_setItemInactive(oPg, oOfs);
+#endif
             err = NVOCTP_failW;
         }
+#if NVOCTP_COMPACTSTEP
+        if((err == NVINTF_SUCCESS) && NVOCTP_RECLAIM())
+        {
+            // Reclaim the tail page a few items at a time
+            NVOCTP_compactStep();
+        }
+#endif
     }
 
+#ifdef NVOCTP_STATS
+    if((err == NVINTF_SUCCESS) && (++NVOCTP_diagWrites >= NVOCTP_DIAGWRITES))
+    {
+        // Save the diagnostic data now and then
+        NVOCTP_diagWrites = 0;
+        (void)NVOCTP_writeItemApi(diagId, sizeof(NVOCTP_diags),
+                                  &NVOCTP_diags);
+    }
+#endif
+
     NVOCTP_UNLOCK(err);
 }
 
+#if NVOCTP_CHUNKLEN
+//*****************************************************************************
+// API Functions - Streamed Items
+//*****************************************************************************
+
+/******************************************************************************
+ * @fn      NVOCTP_appendItemApi
+ *
+ * @brief   API function to append data to a streamed item, the stream is
+ *          created if needed. The last chunk is filled up first, then new
+ *          chunks are added. After a power loss, a prefix of the data may
+ *          have been appended.
+ *
+ * @param   id   - NV item type identifier of the stream, subID must be 0
+ * @param   len  - length of the data to append (0 is illegal)
+ * @param   pBuf - pointer to caller's data buffer (NULL is illegal)
+ *
+ * @return  NVINTF_SUCCESS or specific failure code
+ */
+static uint8_t NVOCTP_appendItemApi(NVINTF_itemID_t id,
+                                    uint16_t len,
+                                    void *pBuf)
+{
+    uint8_t err = NVINTF_SUCCESS;
+    uint8_t *pData = (uint8_t *)pBuf;
+    uint16_t last;
+    uint16_t n;
+    IArg key;
+
+    // Parameter Sanity Check
+    if (pBuf == NULL || len == 0)
+    {
+        return NVINTF_BADPARAM;
+    }
+    if (id.subID != 0)
+    {
+        return NVINTF_BADSUBID;
+    }
+
+    // Chunk writes are timed by writeItem
+    key = NVOCTP_lockNvApi();
+
+    n = NVOCTP_chunkCount(id, &last);
+    while ((len > 0) && (err == NVINTF_SUCCESS))
+    {
+        uint16_t cLen;
+
+        if ((n > 0) && (last < NVOCTP_CHUNKLEN))
+        {
+            NVOCTP_itemHdr_t iHdr;
+
+            // Fill up the last chunk, it is rewritten with the data behind
+            id.subID = n - 1;
+            cLen = (len < (NVOCTP_CHUNKLEN - last)) ?
+                   len : (NVOCTP_CHUNKLEN - last);
+            err = NVOCTP_checkItem(&id, 0, &iHdr, NVOCTP_FINDSTRICT);
+            if (err == NVINTF_SUCCESS)
+            {
+                err = NVOCTP_readItem(&iHdr, 0, last, NVOCTP_chunkBuf);
+            }
+            if (err == NVINTF_SUCCESS)
+            {
+                memcpy(NVOCTP_chunkBuf + last, pData, cLen);
+                err = NVOCTP_writeItemApi(id, last + cLen, NVOCTP_chunkBuf);
+            }
+        }
+        else if (n > NVOCTP_MAXSUBID)
+        {
+            // Stream is full
+            err = NVINTF_BADLENGTH;
+            break;
+        }
+        else
+        {
+            // Add a chunk, straight from the caller's buffer
+            id.subID = n++;
+            cLen = (len < NVOCTP_CHUNKLEN) ? len : NVOCTP_CHUNKLEN;
+            err  = NVOCTP_writeItemApi(id, cLen, pData);
+            last = 0;
+        }
+        last  += cLen;
+        pData += cLen;
+        len   -= cLen;
+    }
+
+    NVOCTP_unlockNvApi(key);
+
+    return (err);
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_readStreamApi
+ *
+ * @brief   API function to read data from a streamed item. Each chunk is
+ *          read as an item, so with NVOCTP_CRCONREAD its CRC is checked.
+ *
+ * @param   id   - NV item type identifier of the stream, subID must be 0
+ * @param   ofs  - offset into the stream data
+ * @param   len  - length of data to return (0 is illegal)
+ * @param   pBuf - pointer to caller's read data buffer (NULL is illegal)
+ *
+ * @return  NVINTF_SUCCESS or specific failure code
+ */
+static uint8_t NVOCTP_readStreamApi(NVINTF_itemID_t id,
+                                    uint32_t ofs,
+                                    uint16_t len,
+                                    void *pBuf)
+{
+    uint8_t err = NVINTF_SUCCESS;
+    uint8_t *pData = (uint8_t *)pBuf;
+
+    // Parameter Sanity Check
+    if (pBuf == NULL || len == 0)
+    {
+        return NVINTF_BADPARAM;
+    }
+    if (id.subID != 0)
+    {
+        return NVINTF_BADSUBID;
+    }
+    if ((ofs / NVOCTP_CHUNKLEN) > NVOCTP_MAXSUBID)
+    {
+        return NVINTF_BADOFFSET;
+    }
+
+    // Lookups may run in parallel, writes are held off
+    NVOCTP_LOCKRD(NVOCTP_HISTREAD);
+
+    while ((len > 0) && (err == NVINTF_SUCCESS))
+    {
+        NVOCTP_itemHdr_t iHdr;
+        uint16_t cOfs = ofs % NVOCTP_CHUNKLEN;
+        uint16_t cLen = NVOCTP_CHUNKLEN - cOfs;
+
+        cLen = (len < cLen) ? len : cLen;
+        id.subID = ofs / NVOCTP_CHUNKLEN;
+        err = NVOCTP_checkItem(&id, 0, &iHdr, NVOCTP_FINDSTRICT);
+        if (err == NVINTF_SUCCESS)
+        {
+            if ((cOfs + cLen) <= iHdr.len)
+            {
+                err = NVOCTP_readItem(&iHdr, cOfs, cLen, pData);
+            }
+            else
+            {
+                // Read past the end of the last chunk
+                err = ((pData == pBuf) && (cOfs >= iHdr.len)) ?
+                      NVINTF_BADOFFSET : NVINTF_BADLENGTH;
+            }
+        }
+        else if ((err == NVINTF_NOTFOUND) && (id.subID > 0))
+        {
+            // Read past the last chunk
+            err = (pData == pBuf) ? NVINTF_BADOFFSET : NVINTF_BADLENGTH;
+        }
+        ofs   += cLen;
+        pData += cLen;
+        len   -= cLen;
+    }
+
+    NVOCTP_UNLOCKRD(err);
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_getStreamLenApi
+ *
+ * @brief   API function to return the length of a streamed item
+ *
+ * @param   id - NV item type identifier of the stream, subID must be 0
+ *
+ * @return  Stream length or 0 if the stream is not found
+ */
+static uint32_t NVOCTP_getStreamLenApi(NVINTF_itemID_t id)
+{
+    uint32_t len = 0;
+    uint16_t last;
+    uint16_t n;
+
+    if (id.subID != 0)
+    {
+        return (0);
+    }
+
+    // Lookups may run in parallel, writes are held off
+    NVOCTP_LOCKRD(NVOCTP_HISTREAD);
+
+    n = NVOCTP_chunkCount(id, &last);
+    if (n > 0)
+    {
+        len = ((uint32_t)(n - 1) * NVOCTP_CHUNKLEN) + last;
+    }
+
+    NVOCTP_UNLOCKRD(len);
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_deleteStreamApi
+ *
+ * @brief   API function to delete a streamed item, last chunk first
+ *
+ * @param   id - NV item type identifier of the stream, subID must be 0
+ *
+ * @return  NVINTF_SUCCESS or specific failure code
+ */
+static uint8_t NVOCTP_deleteStreamApi(NVINTF_itemID_t id)
+{
+    uint8_t err = NVINTF_NOTFOUND;
+    uint16_t last;
+    uint16_t n;
+    IArg key;
+
+    if (id.subID != 0)
+    {
+        return NVINTF_BADSUBID;
+    }
+
+    // Chunk deletes are timed by deleteItem
+    key = NVOCTP_lockNvApi();
+
+    n = NVOCTP_chunkCount(id, &last);
+    while (n > 0)
+    {
+        id.subID = --n;
+        err = NVOCTP_deleteItemApi(id);
+        if (err != NVINTF_SUCCESS)
+        {
+            break;
+        }
+    }
+
+    NVOCTP_unlockNvApi(key);
+
+    return (err);
+}
+#endif
+
 //*****************************************************************************
 // Extended API Functions
 //*****************************************************************************
@@ -1077,13 +2197,31 @@ static uint8_t NVOCTP_writeItemApi(NVINTF_itemID_t id,
 /**
  * @fn      NVOCTP_lockNvApi
  *
- * @brief   Global function to lock the NV semaphore
+ * @brief   Global function to lock exclusive access to NV. New readers are
+ *          held off by the gate mutex, the readers inside are waited for.
  *
- * @return  bool indicating success or failure
+ * @return  Key value needed to unlock NV
  */
 static IArg NVOCTP_lockNvApi(void)
 {
-    return GateMutexPri_enter(NVOCTP_gMutexPri);
+    IArg key = GateMutexPri_enter(NVOCTP_gMutexPri);
+    UInt hwiKey;
+    bool busy;
+
+    do
+    {
+        hwiKey = Hwi_disable();
+        busy = (NVOCTP_readers != 0);
+        NVOCTP_writerWait = busy;
+        Hwi_restore(hwiKey);
+        if(busy)
+        {
+            // Posted by the last reader to leave
+            Semaphore_pend(Semaphore_handle(&NVOCTP_rdSem), BIOS_WAIT_FOREVER);
+        }
+    } while(busy);
+
+    return (key);
 }
 
 /**
@@ -1101,6 +2239,96 @@ static void NVOCTP_unlockNvApi(IArg key)
     GateMutexPri_leave(NVOCTP_gMutexPri,key);
 }
 
+/**
+ * @fn      NVOCTP_lockRd
+ *
+ * @brief   Local function to lock shared access to NV. Only the gate mutex is
+ *          entered to count the reader, so readers do not wait for each other.
+ *          A task holding exclusive access re-enters the gate mutex.
+ *
+ *          A writer waiting for the readers does not raise their priority,
+ *          and readers are not boosted either: Task_setPri() must not be
+ *          called while the gate mutex is held, which is the case for reads
+ *          under lockNV(). A reader does not block inside, it holds the shared
+ *          lock for one header search and one copy and CRC check of at most
+ *          the item length. A writer waits for the reads in progress, plus
+ *          the run time of any task whose priority is between a preempted
+ *          reader's and the writer's. In this application the OpenThread
+ *          stack task reads NV and, with the NV task, writes it at the same
+ *          priority, and the temperature sensor task, which only takes the
+ *          exclusive lock for the diagnostics, has the next priority up
+ *          (task_config.h). No task runs between a reader and a waiting
+ *          writer, so a writer waits for one read at most. A task of lower
+ *          priority than a writer should read under lockNV(), which gives
+ *          priority inheritance.
+ *
+ * @return  none
+ */
+static void NVOCTP_lockRd(void)
+{
+    IArg key = GateMutexPri_enter(NVOCTP_gMutexPri);
+    UInt hwiKey = Hwi_disable();
+
+    NVOCTP_readers++;
+    Hwi_restore(hwiKey);
+    GateMutexPri_leave(NVOCTP_gMutexPri, key);
+}
+
+/**
+ * @fn      NVOCTP_unlockRd
+ *
+ * @brief   Local function to unlock shared access to NV, a waiting writer is
+ *          released by the last reader to leave
+ *
+ * @return  none
+ */
+static void NVOCTP_unlockRd(void)
+{
+    UInt hwiKey = Hwi_disable();
+
+    if((--NVOCTP_readers == 0) && NVOCTP_writerWait)
+    {
+        NVOCTP_writerWait = FALSE;
+        Semaphore_post(Semaphore_handle(&NVOCTP_rdSem));
+    }
+    Hwi_restore(hwiKey);
+}
+
+#if defined (NVOCTP_STATS)
+/**
+ * @fn      NVOCTP_histAdd
+ *
+ * @brief   Local function to count an operation in its latency histogram,
+ *          called with the driver locked. Counts stop at 0xFFFF.
+ *
+ * @param   op    - Operation, NVOCTP_HISTREAD etc.
+ * @param   start - Clock ticks at the start of the operation
+ *
+ * @return  none
+ */
+static void NVOCTP_histAdd(uint8_t op, uint32_t start)
+{
+    uint32_t ticks = Clock_getTicks() - start;
+    uint8_t bin = 0;
+    UInt hwiKey;
+
+    // Log2 bins, see NVOCTP_HISTBINS
+    while((ticks != 0) && (bin < (NVOCTP_HISTBINS - 1)))
+    {
+        ticks >>= 1;
+        bin++;
+    }
+
+    // Readers may get here at the same time
+    hwiKey = Hwi_disable();
+    if(NVOCTP_diags.hist[op][bin] != 0xFFFF)
+    {
+        NVOCTP_diags.hist[op][bin]++;
+    }
+    Hwi_restore(hwiKey);
+}
+#endif
+
 /******************************************************************************
  * @fn      NVOCTP_doNextApi
  *
@@ -1108,8 +2336,9 @@ static void NVOCTP_unlockNvApi(IArg key)
  * function provides a faster way of finding, reading, or deleting multiple
  * NV items. However, the user must first lock access to NV with lockNV() to
  * ensure consistent results. The user must take care to minimize the time NV
- * is locked if NV access is shared. User must also remember to unlock NV when
- * done with unlockNV().
+ * is locked if NV access is shared. The search state is kept in the proxy, so
+ * several searches can be in progress at the same time. User must also
+ * remember to unlock NV when done with unlockNV().
  *
  * Usage Details:
  * doNext is controlled through the nvProxy item pointed to by prx
@@ -1139,6 +2368,9 @@ static void NVOCTP_unlockNvApi(IArg key)
  * Notes:
  * -User changes to the proxy struct will have no effect until a new search is
  * started by setting NVINTF_DOSTART
+ * -The proxy's state member belongs to the driver and must not be changed
+ * during a search
+ * -Find and read steps only take shared access to NV, delete steps exclusive
  * -On read operations, the user will supply a buffer and length into the proxy
  * -Items with system id NVINTF_SYSID_NVDRVR cannot be deleted with this API,
  * deleteItemApi must be used one an individual item basis
@@ -1150,14 +2382,11 @@ static void NVOCTP_unlockNvApi(IArg key)
 
 static uint8_t NVOCTP_doNextApi(NVINTF_nvProxy_t * prx)
 {
-    static enum {doFind, doRead, doDelete} op = doFind;
     NVOCTP_itemHdr_t hdr;
-    static uint32_t cid;
-    static uint8_t search;
-    static int16_t fOfs    = FLASH_PAGE_SIZE;
-    static uint16_t bufLen = 0;
+    NVINTF_nvSearch_t *pS;
+    IArg key               = 0;
     uint8_t status         = NVINTF_SUCCESS;
-    int16_t iOfs           = NVOCTP_pgOff;
+    int16_t iOfs;
 
     // Sanitize inputs
     if (NULL == prx)
@@ -1169,80 +2398,103 @@ static uint8_t NVOCTP_doNextApi(NVINTF_nvProxy_t * prx)
         return NVINTF_BADPARAM;
     }
 
-    // Locks NV
-    NVOCTP_LOCK();
+    NVOCTP_TSTART(NVOCTP_HISTDONEXT)
+    pS = &prx->state;
 
-    // New search if start flag set
+    // New search if start flag set, the caller owns the proxy
     if (prx->flag & NVINTF_DOSTART)
     {
-        // Remove start flag
-        prx->flag &= ~NVINTF_DOSTART;
-        // Start at latest item
-        fOfs = NVOCTP_pgOff;
         // Read in buffer len
-        bufLen = prx->len;
+        pS->bufLen = prx->len;
         // Make cid
-        cid = NVOCTP_CMPRID(prx->sysid,prx->itemid,prx->subid);
+        pS->cid = NVOCTP_CMPRID(prx->sysid,prx->itemid,prx->subid);
 
         // Decode flag
         if (prx->flag & NVINTF_DOSYSID)
         {
-            search = NVOCTP_FINDSYSID;
+            pS->search = NVOCTP_FINDSYSID;
         }
         else if (prx->flag & NVINTF_DOITMID)
         {
-            search = NVOCTP_FINDITMID;
+            pS->search = NVOCTP_FINDITMID;
         }
-        else if (prx->flag & NVINTF_DOANYID)
+        else
         {
-            search = NVOCTP_FINDANY;
+            pS->search = NVOCTP_FINDANY;
         }
         if (prx->flag & NVINTF_DOFIND)
         {
-            op = doFind;
+            pS->op = NVOCTP_OPFIND;
         }
         else if (prx->flag & NVINTF_DOREAD)
         {
-            op = doRead;
+            pS->op = NVOCTP_OPREAD;
         }
         else if (prx->flag & NVINTF_DODELETE)
         {
-            op = doDelete;
+            pS->op = NVOCTP_OPDELETE;
+        }
+        else
+        {
+            pS->op = NVOCTP_OPFIND;
         }
     }
 
-    // Look for item
-    iOfs = NVOCTP_findItem(NVOCTP_activePg, fOfs, cid, search);
-
-    if (iOfs > 0 && iOfs < FLASH_PAGE_SIZE)
+    // Locks NV, only deletes need exclusive access
+    if (pS->op == NVOCTP_OPDELETE)
     {
-        // Found an item, gets its header
-        NVOCTP_readHeader(NVOCTP_activePg, (uint16_t)iOfs, &hdr);
-        // store its attributes
+        key = NVOCTP_lockNvApi();
+    }
+    else
+    {
+        NVOCTP_lockRd();
+    }
+
+    if (prx->flag & NVINTF_DOSTART)
+    {
+        // Remove start flag
+        prx->flag &= ~NVINTF_DOSTART;
+        // Start at latest item
+        pS->pg  = NVOCTP_activePg;
+        pS->ofs = NVOCTP_pgOff;
+    }
+
+    // Look for item
+    iOfs = NVOCTP_findItem(&pS->pg, pS->ofs, pS->cid, pS->search);
+
+    if (iOfs > 0 && iOfs < FLASH_PAGE_SIZE)
+    {
+        // Found an item, gets its header
+        NVOCTP_readHeader(pS->pg, (uint16_t)iOfs, &hdr);
+        // store its attributes
         prx->sysid  = hdr.sysid;
         prx->itemid = hdr.itemid;
         prx->subid  = hdr.subid;
         prx->len    = hdr.len;
         // start from this item on next findItem()
-        fOfs = iOfs - hdr.len;
+        pS->ofs = iOfs - hdr.len;
 
         // Do operation based on flag
-        switch (op)
+        switch (pS->op)
         {
-        case doFind:
+        case NVOCTP_OPFIND:
             // nothing, we already stored its info
             break;
-        case doRead:
+        case NVOCTP_OPREAD:
             // read item into user supplied buffer
-            if (prx->buffer != NULL && hdr.len <= bufLen)
+            if (prx->buffer != NULL && hdr.len <= pS->bufLen)
             {
                 status = NVOCTP_readItem(&hdr, 0, hdr.len, prx->buffer);
             }
             break;
-        case doDelete:
+        case NVOCTP_OPDELETE:
             if (prx->sysid != NVINTF_SYSID_NVDRVR)
             {
-                NVOCTP_setItemInactive(iOfs);
+#if NVOCTP_RETIRE
+                // Old copies first, or they come back after a reset
+                NVOCTP_retMark(hdr.cmpid, NVOCTP_NULLPAGE);
+#endif
+                NVOCTP_setItemInactive(pS->pg, iOfs);
             }
             break;
         default:
@@ -1257,13 +2509,71 @@ static uint8_t NVOCTP_doNextApi(NVINTF_nvProxy_t * prx)
     }
 
     // Unlocks NV
-    NVOCTP_UNLOCK(status);
+    NVOCTP_TSTOP()
+    if (pS->op == NVOCTP_OPDELETE)
+    {
+        NVOCTP_unlockNvApi(key);
+    }
+    else
+    {
+        NVOCTP_unlockRd();
+    }
+
+    return (status);
 }
 
 //*****************************************************************************
 // Local NV Driver Utility Functions
 //*****************************************************************************
 
+#if NVOCTP_CHUNKLEN
+/******************************************************************************
+ * @fn      NVOCTP_chunkCount
+ *
+ * @brief   Local function to find the number of chunks of a streamed item.
+ *          Chunks 0 to n-1 exist, so the first missing chunk is found with a
+ *          binary search.
+ *
+ * @param   id    - NV item type identifier of the stream
+ * @param   pLast - returns the data length of the last chunk
+ *
+ * @return  Number of chunks, 0 if the stream is not found
+ */
+static uint16_t NVOCTP_chunkCount(NVINTF_itemID_t id,
+                                  uint16_t *pLast)
+{
+    NVOCTP_itemHdr_t iHdr;
+    uint16_t lo = 0;
+    uint16_t hi = NVOCTP_MAXSUBID + 1;
+
+    *pLast = 0;
+    while (lo < hi)
+    {
+        id.subID = (lo + hi) / 2;
+        if (NVOCTP_checkItem(&id, 0, &iHdr, NVOCTP_FINDSTRICT) ==
+            NVINTF_SUCCESS)
+        {
+            lo = id.subID + 1;
+            *pLast = iHdr.len;
+        }
+        else
+        {
+            hi = id.subID;
+        }
+    }
+
+    if ((lo > 0) && (id.subID != (lo - 1)))
+    {
+        // Last probe was past the end, get the length of the last chunk
+        id.subID = lo - 1;
+        (void)NVOCTP_checkItem(&id, 0, &iHdr, NVOCTP_FINDSTRICT);
+        *pLast = iHdr.len;
+    }
+
+    return (lo);
+}
+#endif
+
 /******************************************************************************
  * @fn      NVOCTP_checkItem
  *
@@ -1282,6 +2592,7 @@ static uint8_t NVOCTP_checkItem(NVINTF_itemID_t *id,
                                 uint8_t flag)
 {
     int16_t ofs;
+    uint8_t pg;
     uint32_t cid;
 
     if(len > NVOCTP_MAXLEN)
@@ -1316,15 +2627,15 @@ static uint8_t NVOCTP_checkItem(NVINTF_itemID_t *id,
         return (NVINTF_NOTREADY);
     }
 
-    // Reset erase/write fail indicator for current transaction
-    NVOCTP_failW = NVINTF_SUCCESS;
-    cid          = NVOCTP_CMPRID(id->systemID, id->itemID, id->subID);
-    ofs          = NVOCTP_findItem(NVOCTP_activePg, NVOCTP_pgOff, cid, flag);
+    cid = NVOCTP_CMPRID(id->systemID, id->itemID, id->subID);
+    pg  = NVOCTP_activePg;
+    ofs = NVOCTP_findItem(&pg, NVOCTP_pgOff, cid, flag);
 
     if(ofs <= 0)
     {
         // Item does not exist yet
         pHdr->len    = len;
+        pHdr->pg     = NVOCTP_NULLPAGE;
         pHdr->hofs   = 0;
         pHdr->cmpid  = cid;
         pHdr->subid  = id->subID;
@@ -1335,9 +2646,9 @@ static uint8_t NVOCTP_checkItem(NVINTF_itemID_t *id,
     }
 
     // Read and decompress item header
-    NVOCTP_readHeader(NVOCTP_activePg, (uint16_t)ofs, pHdr);
+    NVOCTP_readHeader(pg, (uint16_t)ofs, pHdr);
 
-    return (NVOCTP_failW);
+    return (NVINTF_SUCCESS);
 }
 /******************************************************************************
  * @fn      NVOCTP_newItem
@@ -1357,8 +2668,8 @@ static uint8_t NVOCTP_newItem(NVOCTP_itemHdr_t *iHdr,
     iLen = NVOCTP_ITEMHDRLEN + iHdr->len;
     if((NVOCTP_pgOff + iLen) > FLASH_PAGE_SIZE)
     {
-        // Won't fit on the active page, compact and check again
-        if(NVOCTP_compactPage(NVOCTP_activePg) < iLen)
+        // Won't fit on the active page, move on or compact and check again
+        if(!NVOCTP_makeRoom(iLen))
         {
             // Failure means there's no place to put this item
             NVOCTP_ALERT(FALSE, "Out of NV.")
@@ -1392,10 +2703,45 @@ static inline void NVOCTP_read(uint8_t pg,
                                uint8_t *pBuf,
                                uint16_t len)
 {
+#if NVOCTP_MAPPED
+    if (NVOCTP_mapped)
+    {
+        memcpy(pBuf, NVOCTP_MAPADDR(pg, off), len);
+        return;
+    }
+#endif
     NVS_read(NVOCTP_nvsHandle, NVOCTP_FLASHOFFSET
              (NVOCTP_nvsAttrs.regionBase, pg, off), (uint8_t *)pBuf, len);
 }
 
+/******************************************************************************
+ * @fn      NVOCTP_readPtr
+ *
+ * @brief   Get read access to a block of flash
+ *
+ * @param   pg  - Flash page to read from
+ * @param   off - Offset in the page to read from
+ * @param   pBuf - Buffer for the copy if the flash is not memory mapped
+ * @param   len - Number of bytes to read
+ *
+ * @return  Pointer to the bytes in the mapped flash, or pBuf holding a copy
+ */
+static inline const uint8_t *NVOCTP_readPtr(uint8_t pg,
+                                            uint16_t off,
+                                            uint8_t *pBuf,
+                                            uint16_t len)
+{
+#if NVOCTP_MAPPED
+    if (NVOCTP_mapped)
+    {
+        return (NVOCTP_MAPADDR(pg, off));
+    }
+#endif
+    NVOCTP_read(pg, off, pBuf, len);
+
+    return (pBuf);
+}
+
 /******************************************************************************
  * @fn      NVOCTP_write
  *
@@ -1412,6 +2758,29 @@ static uint8_t NVOCTP_write(uint8_t dstPg,
                              uint16_t off,
                              uint8_t *pBuf,
                              uint16_t len)
+{
+    return (NVOCTP_writeCRC(dstPg, off, pBuf, len, NULL));
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_writeCRC
+ *
+ * @brief   Writes to a flash buffer from RAM, the readback that verifies the
+ *          write also computes the CRC of the written bytes
+ *
+ * @param   dstPg  - Flash page to write to
+ * @param   off - offset in destination page to write to
+ * @param   pBuf  - Pointer to caller's buffer to write & verify
+ * @param   len - number of bytes to write from pBuf
+ * @param   pCrc - Pointer to the CRC to continue, NULL if not needed
+ *
+ * @return  NVS_STATUS_SUCCESS or other NVS status code
+ */
+static uint8_t NVOCTP_writeCRC(uint8_t dstPg,
+                               uint16_t off,
+                               uint8_t *pBuf,
+                               uint16_t len,
+                               uint8_t *pCrc)
 {
     uint8_t err = NVINTF_SUCCESS;
     int_fast16_t nvsRes = 0;
@@ -1421,9 +2790,10 @@ static uint8_t NVOCTP_write(uint8_t dstPg,
 
     if (NVINTF_SUCCESS == err)
     {
+        NVOCTP_FLASHHOOK(dstPg, off, len)
         nvsRes = NVS_write(NVOCTP_nvsHandle, NVOCTP_FLASHOFFSET(
                            NVOCTP_nvsAttrs.regionBase, dstPg, off), pBuf, len,
-                           NVS_WRITE_POST_VERIFY);
+                           0);
     }
     else
     {
@@ -1434,6 +2804,19 @@ static uint8_t NVOCTP_write(uint8_t dstPg,
     {
         err = NVINTF_FAILURE;
     }
+    else if ((NVINTF_SUCCESS == err) &&
+             !NVOCTP_verify(dstPg, off, pBuf, len, pCrc))
+    {
+        // Flash does not hold what was written
+        err = NVINTF_FAILURE;
+    }
+#if defined (NVOCTP_STATS)
+    if (NVINTF_LOWPOWER != err)
+    {
+        // Counted after the readback, pBuf may be the diagnostic data itself
+        NVOCTP_diags.bytesWritten += len;
+    }
+#endif
 
     NVOCTP_ALERT(NVINTF_LOWPOWER != err, "Voltage check failed.")
     NVOCTP_ALERT(NVINTF_FAILURE != err, "NVS write failure.")
@@ -1441,6 +2824,68 @@ static uint8_t NVOCTP_write(uint8_t dstPg,
     return err;
 }
 
+/******************************************************************************
+ * @fn      NVOCTP_verify
+ *
+ * @brief   Reads back a written flash buffer and compares it to the RAM copy,
+ *          a word at a time, in one pass. The CRC of the bytes is optionally
+ *          computed along the way.
+ *
+ * @param   pg   - Flash page that was written
+ * @param   off  - offset in the page of the written bytes
+ * @param   pBuf - Pointer to the bytes that were written
+ * @param   len  - number of bytes to compare
+ * @param   pCrc - Pointer to the CRC to continue, NULL if not needed
+ *
+ * @return  TRUE if flash holds the same bytes
+ */
+static bool NVOCTP_verify(uint8_t pg,
+                          uint16_t off,
+                          uint8_t *pBuf,
+                          uint16_t len,
+                          uint8_t *pCrc)
+{
+    uint32_t tmp[NVOCTP_XFERBLKMAX / sizeof(uint32_t)];
+
+    while(len > 0)
+    {
+        uint16_t i;
+        uint16_t num = (len < NVOCTP_XFERBLKMAX) ? len : NVOCTP_XFERBLKMAX;
+        const uint8_t *pRead = NVOCTP_readPtr(pg, off, (uint8_t *)tmp, num);
+
+        // Whole words first, neither side has to be aligned
+        for(i = 0; (i + sizeof(uint32_t)) <= num; i += sizeof(uint32_t))
+        {
+            uint32_t nvWord, ramWord;
+
+            memcpy(&nvWord, pRead + i, sizeof(nvWord));
+            memcpy(&ramWord, pBuf + i, sizeof(ramWord));
+            if(nvWord != ramWord)
+            {
+                return (FALSE);
+            }
+        }
+        for(; i < num; i++)
+        {
+            if(pRead[i] != pBuf[i])
+            {
+                return (FALSE);
+            }
+        }
+        if(pCrc != NULL)
+        {
+            // Same bytes as were just compared
+            *pCrc = NVOCTP_doRAMCRC(pBuf, num, *pCrc);
+        }
+
+        off  += num;
+        pBuf += num;
+        len  -= num;
+    }
+
+    return (TRUE);
+}
+
 /******************************************************************************
  * @fn      NVOCTP_erase
  *
@@ -1460,9 +2905,13 @@ static uint8_t NVOCTP_erase(uint8_t dstPg)
 
     if (NVINTF_SUCCESS == err)
     {
+        NVOCTP_FLASHHOOK(dstPg, 0, FLASH_PAGE_SIZE)
         nvsRes = NVS_erase(NVOCTP_nvsHandle, NVOCTP_FLASHOFFSET(
                            NVOCTP_nvsAttrs.regionBase, dstPg, 0),
                            NVOCTP_nvsAttrs.sectorSize);
+#if defined (NVOCTP_STATS)
+        NVOCTP_diags.erases[dstPg - NVOCTP_nvBegPage] += 1;
+#endif
     }
     else
     {
@@ -1507,17 +2956,6 @@ static void NVOCTP_writeItem(NVOCTP_itemHdr_t *pHdr,
     {
         cmpIH_t cHdr;
         uint16_t hOfs, dLen;
-        uint8_t newCRC;
-
-        // Compressed item header information <-- Lower Addr    Higher Addr-->
-        // Byte: [0]      [1]      [2]      [3]      [4]      [5]      [6]
-        // Item: SSSSSSII IIIIIIII SSSSSSSS SSLLLLLL LLLLLLCC CCCCCCAV SSSSSSSS
-        // LSB of field:         ^           ^            ^        ^          ^
-        cHdr[0] = ((pHdr->sysid << 2) | ((pHdr->itemid >> 8) & 0x3));
-        cHdr[1] = (pHdr->itemid & 0xFF);
-        cHdr[2] = ((pHdr->subid >> 2) & 0xFF);
-        cHdr[3] = ((pHdr->subid & 0x3) << 6) | ((pHdr->len >> 6) & 0x3F);
-        cHdr[4] = ((pHdr->len & 0x3F) << 2);
 
         // Header is located after the item data
         dLen = pHdr->len;
@@ -1525,21 +2963,13 @@ static void NVOCTP_writeItem(NVOCTP_itemHdr_t *pHdr,
 
         if (iLen <= NVOCTP_SMALLITEM)
         {
+            // Compress the header, the CRC covers data and header
+            NVOCTP_packHeader(pHdr, NVOCTP_doRAMCRC(pBuf, dLen, 0), cHdr);
             // Construct item in one buffer
             memset(NVOCTP_itemBuffer, NVOCTP_ERASEDBYTE, NVOCTP_SMALLITEM);
             // Put data into buffer
             memcpy(NVOCTP_itemBuffer, (const void *)pBuf, dLen);
-            // Put most of header into buffer
-            memcpy(NVOCTP_itemBuffer + dLen, (const void *)cHdr,
-                   NVOCTP_HDRCRCINC);
-            // Calculate CRC
-            newCRC = NVOCTP_doRAMCRC(NVOCTP_itemBuffer, dLen +
-                                     NVOCTP_HDRCRCINC, 0);
-            // Insert CRC and last bytes
-            cHdr[4] |= ((newCRC >> 6) & 0x3);
-            // Note NVOCTP_VALIDIDBIT set implicitly zero
-            cHdr[5] = ((newCRC & 0x3F) << 2) | NVOCTP_ACTIVEIDBIT;
-            cHdr[6] = NVOCTP_SIGNATURE;
+            // Put header into buffer
             memcpy(NVOCTP_itemBuffer + dLen, (const void *)cHdr,
                    NVOCTP_ITEMHDRLEN);
             // NVS_write
@@ -1550,20 +2980,21 @@ static void NVOCTP_writeItem(NVOCTP_itemHdr_t *pHdr,
         }
         else
         {
+            uint8_t crc = 0;
+            uint8_t err;
+
             // Write header/item separately
-            // Calculate CRC on data portion
-            newCRC = NVOCTP_doRAMCRC(pBuf, dLen, 0);
-            // Finish CRC using header portion
-            newCRC = NVOCTP_doRAMCRC(cHdr, NVOCTP_HDRCRCINC, newCRC);
-            // Complete Header with CRC, bits, and sig
-            cHdr[4] |= ((newCRC >> 6) & 0x3);
-            // Note NVOCTP_VALIDIDBIT set implicitly zero
-            cHdr[5] = ((newCRC & 0x3F) << 2) | NVOCTP_ACTIVEIDBIT;
-            cHdr[6] = NVOCTP_SIGNATURE;
-            // Write data
-            NVOCTP_failW = NVOCTP_write(dstPg, NVOCTP_pgOff, pBuf, dLen);
-            // Write header
-            NVOCTP_failW = NVOCTP_write(dstPg, hOfs, cHdr, NVOCTP_ITEMHDRLEN);
+            // Write data, its readback computes the CRC
+            NVOCTP_failW = NVOCTP_writeCRC(dstPg, NVOCTP_pgOff, pBuf, dLen,
+                                           &crc);
+            // Compress the header, the CRC covers data and header
+            NVOCTP_packHeader(pHdr, crc, cHdr);
+            // Write header, even after a data failure so the item is found
+            err = NVOCTP_write(dstPg, hOfs, cHdr, NVOCTP_ITEMHDRLEN);
+            if (NVOCTP_failW == NVINTF_SUCCESS)
+            {
+                NVOCTP_failW = err;
+            }
             // Advance to next location
             NVOCTP_ASSERT(NVOCTP_pgOff < (NVOCTP_pgOff + iLen),
                           "Page offset overflow!")
@@ -1573,8 +3004,15 @@ static void NVOCTP_writeItem(NVOCTP_itemHdr_t *pHdr,
         NVOCTP_ALERT(!NVOCTP_failW, "Driver write failure. Item deleted.")
         if (NVOCTP_failW)
         {
-            NVOCTP_setItemInactive(hOfs);
+            NVOCTP_setItemInactive(dstPg, hOfs);
+        }
+#if NVOCTP_RAMINDEX
+        else if(NVOCTP_idxValid && !NVOCTP_idxPut(pHdr->cmpid, dstPg, hOfs))
+        {
+            // RAM index is full, fall back to page traversal
+            NVOCTP_idxValid = FALSE;
         }
+#endif
     }
     else
     {
@@ -1583,6 +3021,40 @@ static void NVOCTP_writeItem(NVOCTP_itemHdr_t *pHdr,
     }
 }
 
+/******************************************************************************
+ * @fn      NVOCTP_packHeader
+ *
+ * @brief   Compress an item header for writing, completing the item CRC
+ *
+ * @param   pHdr - Pointer to caller's item header buffer
+ * @param   crc  - CRC of the item data
+ * @param   cHdr - Pointer to the compressed header output
+ *
+ * @return  none
+ */
+static void NVOCTP_packHeader(NVOCTP_itemHdr_t *pHdr,
+                              uint8_t crc,
+                              uint8_t *cHdr)
+{
+    // Compressed item header information <-- Lower Addr    Higher Addr-->
+    // Byte: [0]      [1]      [2]      [3]      [4]      [5]      [6]
+    // Item: SSSSSSII IIIIIIII SSSSSSSS SSLLLLLL LLLLLLCC CCCCCCAV SSSSSSSS
+    // LSB of field:         ^           ^            ^        ^          ^
+    cHdr[0] = ((pHdr->sysid << 2) | ((pHdr->itemid >> 8) & 0x3));
+    cHdr[1] = (pHdr->itemid & 0xFF);
+    cHdr[2] = ((pHdr->subid >> 2) & 0xFF);
+    cHdr[3] = ((pHdr->subid & 0x3) << 6) | ((pHdr->len >> 6) & 0x3F);
+    cHdr[4] = ((pHdr->len & 0x3F) << 2);
+
+    // Finish CRC using header portion
+    crc = NVOCTP_doRAMCRC(cHdr, NVOCTP_HDRCRCINC, crc);
+    // Complete Header with CRC, bits, and sig
+    cHdr[4] |= ((crc >> 6) & 0x3);
+    // Note NVOCTP_VALIDIDBIT set implicitly zero
+    cHdr[5] = ((crc & 0x3F) << 2) | NVOCTP_ACTIVEIDBIT;
+    cHdr[6] = NVOCTP_SIGNATURE;
+}
+
 
 /******************************************************************************
  * @fn      NVOCTP_readHeader
@@ -1600,12 +3072,14 @@ static void NVOCTP_readHeader(uint8_t pg,
                               NVOCTP_itemHdr_t *pHdr)
 {
     uint8_t sigOfItemBehind;
-    cmpIH_t cHdr;
+    cmpIH_t hdrBuf;
+    const uint8_t *cHdr;
 
     // Get item header from Flash
-    NVOCTP_read(pg, ofs, (uint8_t *)cHdr, NVOCTP_ITEMHDRLEN);
+    cHdr = NVOCTP_readPtr(pg, ofs, (uint8_t *)hdrBuf, NVOCTP_ITEMHDRLEN);
 
-    // Offset to compressed header
+    // Location of compressed header
+    pHdr->pg   = pg;
     pHdr->hofs = ofs;
 
     // Compressed item header information <-- Lower Addr    Higher Addr-->
@@ -1634,8 +3108,8 @@ static void NVOCTP_readHeader(uint8_t pg,
         uint16_t nextItemSigOfs = ofs - (pHdr->len + 1);
         if (nextItemSigOfs < ofs)
         {
-            NVOCTP_read(pg, nextItemSigOfs, &sigOfItemBehind, NVOCTP_ONEBYTE);
-            if (sigOfItemBehind == NVOCTP_SIGNATURE)
+            if (*NVOCTP_readPtr(pg, nextItemSigOfs, &sigOfItemBehind,
+                                NVOCTP_ONEBYTE) == NVOCTP_SIGNATURE)
             {
                 (pHdr->stats) |= NVOCTP_FOLLOWBIT;
             }
@@ -1669,7 +3143,7 @@ static uint8_t NVOCTP_readItem(NVOCTP_itemHdr_t *iHdr,
     // Optional CRC integrity check
     if (NVOCTP_CRCONREAD)
     {
-        err = NVOCTP_verifyCRC(iOfs, iHdr->len, iHdr->crc8);
+        err = NVOCTP_verifyCRC(iHdr->pg, iOfs, iHdr->len, iHdr->crc8);
     }
     if(err == NVINTF_SUCCESS)
     {
@@ -1678,7 +3152,7 @@ static uint8_t NVOCTP_readItem(NVOCTP_itemHdr_t *iHdr,
         if((dOfs + len) <= iHdr->hofs)
         {
             // Copy NV data block to caller's buffer
-            NVOCTP_read(NVOCTP_activePg, dOfs, (uint8_t *)pBuf, len);
+            NVOCTP_read(iHdr->pg, dOfs, (uint8_t *)pBuf, len);
         }
         else
         {
@@ -1695,22 +3169,36 @@ static uint8_t NVOCTP_readItem(NVOCTP_itemHdr_t *iHdr,
  *
  * @brief   Mark an item as inactive
  *
- * @param   iOfs - Offset to item header (lowest address) in active page
+ * @param   pg   - NV page of the item
+ * @param   iOfs - Offset to item header (lowest address) in the page
  *
  * @return  none
  */
-static void NVOCTP_setItemInactive(uint16_t iOfs)
+static void NVOCTP_setItemInactive(uint8_t pg,
+                                   uint16_t iOfs)
 {
     uint8_t tmp;
 
     // Get byte with validity bit
-    tmp = NVOCTP_readByte(NVOCTP_activePg, iOfs + NVOCTP_HDRVLDOFS);
+    tmp = NVOCTP_readByte(pg, iOfs + NVOCTP_HDRVLDOFS);
 
     // Remove ACTIVE_IDS_MARK
     tmp &= ~NVOCTP_ACTIVEIDBIT;
 
     // Mark the item as inactive
-    NVOCTP_writeByte(NVOCTP_activePg, iOfs + NVOCTP_HDRVLDOFS, tmp);
+    NVOCTP_writeByte(pg, iOfs + NVOCTP_HDRVLDOFS, tmp);
+
+#if NVOCTP_RAMINDEX
+    if(NVOCTP_failW == NVINTF_SUCCESS)
+    {
+        NVOCTP_idxDelete(pg, iOfs);
+    }
+    else
+    {
+        // Item may still be active, stop trusting the RAM index
+        NVOCTP_idxValid = FALSE;
+    }
+#endif
 }
 
 /******************************************************************************
@@ -1792,105 +3280,116 @@ static uint16_t NVOCTP_findOffset(uint8_t pg,
 /******************************************************************************
  * @fn      NVOCTP_findItem
  *
- * @brief   Find a valid item from designated page and offset
+ * @brief   Find a valid item from designated page and offset. The search goes
+ *          from newer to older items, continuing on the previous pages of the
+ *          ring until the tail page has been searched.
  *
- * @param   pg  - Valid NV page
+ * @param   pPg - Valid NV page, updated to the page of the found item
  * @param   ofs - Offset in NV page from where to start search
  * @param   cid - Compressed NV item ID to search for
  * @param   flag - specifies type of search
  *
  * @return  When >0, offset to the item header for found item
  *          When <=0, -number of items searched when item not found
- *
+ *          (always 0 when the RAM index is used)
  */
-static int16_t NVOCTP_findItem(uint8_t pg,
+static int16_t NVOCTP_findItem(uint8_t *pPg,
                                uint16_t ofs,
                                uint32_t cid,
                                uint8_t flag)
 {
-    bool found = FALSE;
+    bool trust;
+    uint8_t pg;
     uint16_t items = 0;
+    uint32_t sysid = ((cid >> 24) & 0x3F);
+    uint32_t itemid = ((cid >> 12) & 0x3FF);
 
-    while(ofs >= (NVOCTP_PGHDRLEN + NVOCTP_ITEMHDRLEN))
+#if NVOCTP_RAMINDEX
+    if(NVOCTP_idxValid)
     {
-        NVOCTP_itemHdr_t iHdr;
+        // RAM index knows all active items, no need to read headers
+        return (NVOCTP_idxFindItem(pPg, ofs, cid, flag));
+    }
+#endif
 
-        // Align to start of item header
-        ofs -= NVOCTP_ITEMHDRLEN;
+    // Newest item on a page may be an interrupted write, check it fully
+    pg    = *pPg;
+    trust = (ofs != NVOCTP_PGEND(pg));
 
-        // Read and decompress item header
-        NVOCTP_readHeader(pg, ofs, &iHdr);
+    for(;;)
+    {
+        NVOCTP_itemHdr_t iHdr;
 
-        if((iHdr.stats & NVOCTP_ACTIVEIDBIT) &&
-          !(iHdr.stats & NVOCTP_VALIDIDBIT))
+        while(NVOCTP_prevItem(pg, &ofs, trust, &iHdr))
         {
-            uint32_t sysid = ((cid >> 24) & 0x3F);
-            uint32_t itemid = ((cid >> 12) & 0x3FF);
+            bool found = FALSE;
 
-            switch (flag)
+            // Next item down is trusted if this one has an item behind it
+            trust = TRUE;
+
+            if((iHdr.stats & NVOCTP_ACTIVEIDBIT) &&
+              !(iHdr.stats & NVOCTP_VALIDIDBIT))
             {
-            case NVOCTP_FINDANY:
-                found = TRUE;
-                break;
-            case NVOCTP_FINDSTRICT:
-                // Return first cid match
-                if (cid == iHdr.cmpid)
+                switch (flag)
                 {
+                case NVOCTP_FINDANY:
                     found = TRUE;
+                    break;
+                case NVOCTP_FINDSTRICT:
+                    // Return first cid match
+                    if (cid == iHdr.cmpid)
+                    {
+                        found = TRUE;
+                    }
+                    break;
+                case NVOCTP_FINDSYSID:
+                    // return first sysid match
+                    if (sysid == iHdr.sysid)
+                    {
+                        found = TRUE;
+                    }
+                    break;
+                case NVOCTP_FINDITMID:
+                    // return first sysid AND itemid match
+                    if (sysid == iHdr.sysid && itemid == iHdr.itemid)
+                    {
+                        found = TRUE;
+                    }
+                    break;
+                default:
+                    // Should not get here
+                    NVOCTP_EXCEPTION(pg, NVINTF_BADPARAM);
+                    NVOCTP_ASSERT(FALSE, "Unhandled case in findItem().")
+                    return -1;
                 }
-                break;
-            case NVOCTP_FINDSYSID:
-                // return first sysid match
-                if (sysid == iHdr.sysid)
+#if NVOCTP_RETIRE
+                if (found && NVOCTP_retFind(pg, iHdr.hofs))
                 {
-                    found = TRUE;
+                    // Old copy, its inactive mark is deferred
+                    found = FALSE;
                 }
-                break;
-            case NVOCTP_FINDITMID:
-                // return first sysid AND itemid match
-                if (sysid == iHdr.sysid && itemid == iHdr.itemid)
+#endif
+                // Item found - return page and offset of item header
+                if (found)
                 {
-                    found = TRUE;
+                    *pPg = pg;
+                    return (iHdr.hofs);
                 }
-                break;
-            default:
-                // Should not get here
-                NVOCTP_EXCEPTION(pg, NVINTF_BADPARAM);
-                NVOCTP_ASSERT(FALSE, "Unhandled case in findItem().")
-                return -1;
-            }
-            // Item found - return offset of item header
-            if (found)
-            {
-                return (ofs);
-            }
-        }
-        // Try to jump to next item
-        if(iHdr.stats & NVOCTP_FOLLOWBIT)
-        {
-            // Appears to be an item there, check bounds
-            if(iHdr.len < ofs)
-            {
-                // Adjust offset for next try
-                ofs -= iHdr.len;
-            }
-            else
-            {
-                // Length is corrupt, mark item invalid and compact
-                NVOCTP_ALERT(FALSE, "Item length corrupted. Deleting item.")
-                NVOCTP_setItemInactive(ofs);
-                NVOCTP_compactPage(NVOCTP_activePg);
             }
+            // Running count of items searched
+            items += 1;
         }
-        else
+
+        if(pg == NVOCTP_tailPg)
         {
-            // Something is corrupted, compact to fix
-            NVOCTP_ALERT(FALSE, "No item following current item, "
-                    "compaction needed.")
-            NVOCTP_compactPage(NVOCTP_activePg);
+            // Searched the oldest page in use
+            break;
         }
-        // Running count of items searched
-        items += 1;
+
+        // Continue with the newest item on the previous page
+        pg    = NVOCTP_PREVPG(pg);
+        ofs   = NVOCTP_PGEND(pg);
+        trust = FALSE;
     }
 
     // Item not found (negate number of items searched)
@@ -1899,252 +3398,636 @@ static int16_t NVOCTP_findItem(uint8_t pg,
 }
 
 /******************************************************************************
- * @fn      NVOCTP_compactPage
+ * @fn      NVOCTP_prevItem
  *
- * @brief   Compact specified page by copying active items to other page
- *
- *          Compaction occurs under three circumstances: (1) 'maintenance'
- *          activity which is triggered by a user call to compactNvApi(),
- *          (2) 'update' activity where an NV page is packed to make room
- *          for an item being written. The 'update' mode is performed by
- *          writing the item after the rest of the page has been compacted,
- *          and (3) when corruption is detected in the NV page. The compaction
- *          operation will move all active&valid items to the other page.
+ * @brief   Step back to the item stored below the specified offset. An item
+ *          is accepted on its header alone when the caller trusts the offset
+ *          and there is an item behind it, otherwise its CRC is checked. When
+ *          corruption is found, the page is searched for the next signature.
  *
- * @param   srcPg - Valid NV page to compact from
+ * @param   pg    - Valid NV page
+ * @param   pOfs  - Offset in NV page from where to step back, updated to the
+ *                  offset of the item data when an item is found
+ * @param   trust - TRUE if the offset is the start of a valid item
+ * @param   pHdr  - Pointer to caller's item header buffer
  *
- * @return  Number of available bytes on compacted page, -1 if error
+ * @return  TRUE if an item was found, FALSE at the bottom of the page
  */
-static int16_t NVOCTP_compactPage(uint8_t srcPg)
+static bool NVOCTP_prevItem(uint8_t pg,
+                            uint16_t *pOfs,
+                            bool trust,
+                            NVOCTP_itemHdr_t *pHdr)
 {
-    bool needScan = FALSE;
-    uint8_t dstPg;
-    uint16_t dstOff;
-    uint16_t endOff;
-    uint16_t srcOff;
-#if defined (NVOCTP_STATS)
-    uint32_t nvcid;
-    uint16_t aitems = 0;
-    uint16_t ditems = 0;
-#endif
-
-    // Reset Flash erase/write fail indicator
-    NVOCTP_failW = NVINTF_SUCCESS;
-
-    // Select the destination page
-    dstPg = (srcPg == NVOCTP_nvBegPage) ? NVOCTP_nvEndPage : NVOCTP_nvBegPage;
-
-    // Ensure that destination page is ready
-    NVOCTP_failW = NVOCTP_erase(dstPg);
-
-    // Mark the specified page to be in XFER state
-    NVOCTP_writeByte(srcPg, NVOCTP_PGHDROFS, (uint8_t)NVOCTP_PGXFER);
+    uint16_t ofs = *pOfs;
+    const uint16_t endOff = NVOCTP_PGHDRLEN + NVOCTP_ITEMHDRLEN - 1;
 
-    // Destination items start right after page header
-    dstOff = NVOCTP_PGDATAOFS;
-#if defined (NVOCTP_STATS)
-    // Create a compressed item ID for NV diagnostic
-    nvcid = NVOCTP_CMPRID(NVINTF_SYSID_NVDRVR, 1, 0);
-    // Reserved space for NV driver diagnostic item
-    dstOff += NVOCTP_ITEMHDRLEN + sizeof(NVOCTP_diag_t);
-#endif
-    // Stop looking when we get to this offset
-    endOff = NVOCTP_PGHDRLEN + NVOCTP_ITEMHDRLEN - 1;
+    while(ofs > endOff)
+    {
+        bool foundSig = FALSE;
+        uint16_t hOfs = ofs - NVOCTP_ITEMHDRLEN;
 
-    // Source items start with the last written item
-    srcOff = NVOCTP_pgOff;
+        // Read and decompress item header
+        NVOCTP_readHeader(pg, hOfs, pHdr);
 
-    NVOCTP_ALERT(FALSE, "Compaction triggered.")
-    while(srcOff > endOff && dstOff < FLASH_PAGE_SIZE)
-    {
-        if(NVOCTP_failW == NVINTF_SUCCESS)
+        if((pHdr->sig == NVOCTP_SIGNATURE) &&
+           (pHdr->len <= (hOfs - NVOCTP_PGHDRLEN)) &&
+           ((trust && (pHdr->stats & NVOCTP_FOLLOWBIT)) ||
+            (NVOCTP_verifyCRC(pg, hOfs - pHdr->len, pHdr->len,
+                              pHdr->crc8) == NVINTF_SUCCESS)))
         {
-            NVOCTP_itemHdr_t srcHdr;
-            uint16_t dataLen;
-            uint16_t itemSize;
-
-            // Align to start of item header
-            srcOff -= NVOCTP_ITEMHDRLEN;
-
-            // Read and decompress item header
-            NVOCTP_readHeader(srcPg, srcOff, &srcHdr);
-            dataLen  = srcHdr.len;
-            itemSize = NVOCTP_ITEMHDRLEN + dataLen;
-            
-            // Check if length is safe
-            if (srcOff < (dataLen + NVOCTP_PGHDRLEN) ||
-                    (NVOCTP_SIGNATURE != srcHdr.sig))
-            {
-                needScan = TRUE;
-            }
-            else
+            // Item data is located below its header
+            *pOfs = hOfs - pHdr->len;
+            if(!(pHdr->stats & NVOCTP_FOLLOWBIT) &&
+               (*pOfs != NVOCTP_PGHDRLEN))
             {
-                needScan = FALSE;
+                // Header may be a chance match in the data of an item
+                // whose own header was lost, prefer a real one below it
+                NVOCTP_nestedItem(pg, pOfs, pHdr);
             }
+            return (TRUE);
+        }
 
-            // Is item valid?
-            if(!(srcHdr.stats & NVOCTP_VALIDIDBIT) &&
-                    srcHdr.stats & NVOCTP_ACTIVEIDBIT &&
-                    !needScan)
-            {
-                uint16_t crcOff;
-                uint8_t crcStatus = NVINTF_FAILURE;
-
-                NVOCTP_ALERT(srcOff >= (dataLen + NVOCTP_PGHDRLEN),
-                             "Item header corrupted, data length too long.")
-                crcOff    = srcOff - dataLen;
-                crcStatus = NVOCTP_verifyCRC(crcOff,dataLen,srcHdr.crc8);
-
-                if (!crcStatus)
-                {
-                    // Copy valid/non-diag item to XFER page
-                    // Unless its the diagnostic item
-#if defined (NVOCTP_STATS)
-                    if (srcHdr.cmpid != nvcid)
-                    {
-#endif
-                        NVOCTP_copyItem(dstPg, crcOff, dstOff, itemSize);
-                        dstOff += itemSize;
-                        if (dstOff > FLASH_PAGE_SIZE)
-                        {
-                            // Somehow ran out of space on new page
-                            NVOCTP_ALERT(FALSE, "Offset overflow: dstOff")
-                            NVOCTP_failW = NVINTF_BADLENGTH;
-                        }
-#if defined (NVOCTP_STATS)
-                        aitems += 1;
-                    }
-#endif
-                }
-                else
-                {
-                    // Invalid CRC, corruption
-                    NVOCTP_ALERT(FALSE, "Item CRC incorrect!")
-                    needScan = TRUE;
-                    srcOff--;
-                }
-            }
-#ifdef NVOCTP_STATS
-            else
-            {
-                ditems++;
-            }
-#endif
-            // Move to next item if no issues
-            if (!needScan)
-            {
-                NVOCTP_ALERT(srcOff > dataLen, "Offset overflow: srcOff")
-                srcOff -= dataLen;
-            }
-            else
+        // Detected a problem, find next header (scan for signature)
+        NVOCTP_ALERT(FALSE, "Attempting to find signature...")
+        trust = FALSE;
+        // Rejected header may overlap the real one, only skip its sig
+        ofs -= 1;
+        while(!foundSig && ofs > endOff)
+        {
+            // read in NVOCTP_XFERBLKMAX bytes at a time for signature
+            uint16_t i, rdLen;
+            uint8_t readBuffer[NVOCTP_XFERBLKMAX];
+            const uint8_t *pRead;
+
+            // Check read bounds
+            rdLen = ((ofs - endOff) > NVOCTP_XFERBLKMAX) ?
+                    NVOCTP_XFERBLKMAX : ofs - endOff;
+            ofs  -= rdLen;
+            pRead = NVOCTP_readPtr(pg, ofs, readBuffer, rdLen);
+            for(i = rdLen; i > 0; i--)
             {
-                // Detected a problem, find next header (scan for signature)
-                bool foundSig = FALSE;
-                NVOCTP_ALERT(FALSE, "Attempting to find signature...")
-                while(!foundSig && srcOff > endOff)
+                if (NVOCTP_SIGNATURE == pRead[i - 1])
                 {
-                    // read in NVOCTP_XFERBLKMAX bytes at a time for signature
-                    uint16_t i, rdLen;
-                    uint8_t readBuffer[NVOCTP_XFERBLKMAX];
-
-                    // Check read bounds
-                    rdLen   = (srcOff - NVOCTP_XFERBLKMAX > endOff) ?
-                            NVOCTP_XFERBLKMAX : srcOff - endOff;
-                    srcOff -= rdLen;
-                    NVOCTP_read(srcPg, srcOff, readBuffer, rdLen);
-                    for(i = rdLen; i > 0; i--)
-                    {
-                        if (NVOCTP_SIGNATURE == readBuffer[i])
-                        {
-                            // Found possible header, resume normal operation
-                            NVOCTP_ALERT(FALSE, "Found possible signature.")
-                            foundSig = TRUE;
-                            // srcOff is address of [first byte of item]
-                            // after our [found sig]
-                            srcOff += (i + 1);
-                            break;
-                        }
-                    }
+                    // Found possible header, ofs is the first byte after it
+                    foundSig = TRUE;
+                    ofs += i;
+                    break;
                 }
-                // If we get here and foundSig is false, we never found another
-                // item in the page
-                NVOCTP_ALERT(foundSig, "Attempt to find signature failed.")
             }
         }
-        else
-        {
-            // Failure during item xfer makes next findItem() unreliable
-            NVOCTP_ASSERT(FALSE, "COMPACTION FAILURE")
-            return (-1);
-        }
-    }
-
-#if defined (NVOCTP_STATS)
-    NVOCTP_diag_t diags;
-    NVOCTP_itemHdr_t dHdr;
-    // Get the diagnostic info
-    NVOCTP_read(srcPg, NVOCTP_PGHDRLEN, (uint8_t *)&diags, sizeof(diags));
-    // One more erase/compaction is complete
-    diags.compacts += 1;
-    // Number of items copied
-    diags.active = aitems;
-    // Number of items left behind
-    diags.deleted = ditems;
-    // Number of bad CRCs found
-    diags.badCRC += NVOCTP_badCRCCount;
-    NVOCTP_badCRCCount = 0;
-    // Available space after this item update
-    diags.available = (FLASH_PAGE_SIZE - dstOff);
-    // Make Diag Header Object
-    dHdr.len     = sizeof(diags);
-    dHdr.hofs    = 0;
-    dHdr.cmpid   = nvcid;
-    dHdr.subid   = diagId.subID;
-    dHdr.itemid  = diagId.itemID;
-    dHdr.sysid   = diagId.systemID;
-    dHdr.sig     = NVOCTP_SIGNATURE;
-    NVOCTP_pgOff = NVOCTP_PGHDRLEN;
-    NVOCTP_writeItem(&dHdr, dstPg, (uint8_t *)&diags);
-#endif
-
-    // All items have been copied - activate the new page
-    NVOCTP_setPageActive(dstPg);
-
-    if(NVOCTP_failW != NVINTF_SUCCESS)
-    {
-        // Something bad happened when trying to compact the page
-        NVOCTP_ASSERT(FALSE, "COMPACTION FAILURE")
-        return (-1);
+        NVOCTP_ALERT(foundSig, "Attempt to find signature failed.")
     }
 
-    // Next item offset for activePg
-    NVOCTP_pgOff = dstOff;
-    // Erase the previous active page
-    NVOCTP_failW = NVOCTP_erase(srcPg);
-
-    // Tell caller how much room is left on the active page
-    return (FLASH_PAGE_SIZE - dstOff);
+    // No more items on this page
+    return (FALSE);
 }
 
 /******************************************************************************
- * @fn      NVOCTP_copyItem
+ * @fn      NVOCTP_nestedItem
  *
- * @brief   Copy an NV item from active page to specified destination page
+ * @brief   Search the data of an item that is not followed by another item
+ *          for the header of one that is. Items never overlap, so a power
+ *          loss between writing an item's data and its header can leave
+ *          a signature in the data that passes the CRC check by chance and
+ *          would hide every item it spans. The highest nested header that
+ *          passes the CRC check and is followed replaces the caller's.
  *
- * @param   dstPg - Destination page
- * @param   sOfs  - Source page offset of original data in active page
- * @param   dOfs  - Destination page offset to transferred copy of the item
- * @param   len   - Length of data to copy
+ * @param   pg   - Valid NV page
+ * @param   pOfs - Offset of the item data, updated if a nested item is found
+ * @param   pHdr - Pointer to the item header, updated likewise
  *
- * @return  none.
+ * @return  none
  */
-static void NVOCTP_copyItem(uint8_t dstPg,
-                            uint16_t sOfs,
-                            uint16_t dOfs,
-                            uint16_t len)
+static void NVOCTP_nestedItem(uint8_t pg,
+                              uint16_t *pOfs,
+                              NVOCTP_itemHdr_t *pHdr)
+{
+    uint16_t ofs;
+    uint8_t sig;
+    NVOCTP_itemHdr_t iHdr;
+
+    for(ofs = pHdr->hofs - 1; ofs >= *pOfs + NVOCTP_ITEMHDRLEN - 1; ofs--)
+    {
+        uint16_t hOfs = ofs - (NVOCTP_ITEMHDRLEN - 1);
+
+        if(*NVOCTP_readPtr(pg, ofs, &sig, NVOCTP_ONEBYTE) != NVOCTP_SIGNATURE)
+        {
+            continue;
+        }
+        NVOCTP_readHeader(pg, hOfs, &iHdr);
+        if((iHdr.len <= (hOfs - NVOCTP_PGHDRLEN)) &&
+           ((iHdr.stats & NVOCTP_FOLLOWBIT) ||
+            ((hOfs - iHdr.len) == NVOCTP_PGHDRLEN)) &&
+           (NVOCTP_verifyCRC(pg, hOfs - iHdr.len, iHdr.len,
+                             iHdr.crc8) == NVINTF_SUCCESS))
+        {
+            NVOCTP_ALERT(FALSE, "Item header found inside item data.")
+            *pHdr = iHdr;
+            *pOfs = hOfs - iHdr.len;
+            return;
+        }
+    }
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_compactPage
+ *
+ * @brief   Compact the ring up to and including the specified page
+ *
+ *          Compaction occurs under three circumstances: (1) 'maintenance'
+ *          activity which is triggered by a user call to compactNvApi(),
+ *          (2) 'update' activity where the ring is full and the tail page
+ *          is packed to make room for an item being written, and (3) when
+ *          a compaction was interrupted by a reset. Pages are compacted
+ *          oldest first, moving their active&valid items to the active page.
+ *          A transfer already started by incremental compaction is finished.
+ *
+ * @param   pg - Page in use, compaction stops after this page
+ *
+ * @return  Number of available bytes on active page, -1 if error
+ */
+static int16_t NVOCTP_compactPage(uint8_t pg)
+{
+    uint8_t srcPg;
+    uint8_t pages = NVOCTP_nvPages;
+    NVOCTP_TSTART(NVOCTP_HISTCOMPACT)
+
+    // Reset Flash erase/write fail indicator
+    NVOCTP_failW = NVINTF_SUCCESS;
+
+    NVOCTP_ALERT(FALSE, "Compaction triggered.")
+    do
+    {
+        srcPg = NVOCTP_tailPg;
+        if(srcPg == NVOCTP_activePg)
+        {
+            // Items on the active page move to a fresh page
+            NVOCTP_openPage(NVOCTP_NEXTPG(srcPg));
+        }
+        if(NVOCTP_failW == NVINTF_SUCCESS)
+        {
+            (void)NVOCTP_xferPage(srcPg, NVOCTP_XFERALL);
+        }
+        if(NVOCTP_failW != NVINTF_SUCCESS)
+        {
+            // Something bad happened when trying to compact the page
+            NVOCTP_ASSERT(FALSE, "COMPACTION FAILURE")
+#if NVOCTP_RAMINDEX
+            NVOCTP_idxValid = FALSE;
+#endif
+            NVOCTP_TSTOP()
+            return (-1);
+        }
+    } while((srcPg != pg) && --pages);
+
+#if NVOCTP_RAMINDEX
+    if(!NVOCTP_idxValid)
+    {
+        // Item locations changed without the index keeping track
+        NVOCTP_buildIndex();
+    }
+#endif
+
+    NVOCTP_TSTOP()
+
+    // Tell caller how much room is left on the active page
+    return (FLASH_PAGE_SIZE - NVOCTP_pgOff);
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_ringLeft
+ *
+ * @brief   Number of bytes left on the active page and the spare pages of
+ *          the ring, not counting the page kept for compaction
+ *
+ * @return  Number of bytes that can be written before compaction is needed
+ */
+static uint32_t NVOCTP_ringLeft(void)
+{
+    uint32_t left = FLASH_PAGE_SIZE - NVOCTP_pgOff;
+    uint8_t freePages = NVOCTP_nvPages - NVOCTP_PGUSED();
+
+    if(freePages > 1)
+    {
+        left += (uint32_t)(freePages - 1) * NVOCTP_PGDATALEN;
+    }
+
+    return (left);
+}
+
+#if NVOCTP_COMPACTSTEP
+/******************************************************************************
+ * @fn      NVOCTP_compactStep
+ *
+ * @brief   Do one step of incremental compaction, which moves a bounded
+ *          number of items from the tail page to the active page. The step
+ *          that reaches the bottom of the tail page also erases it.
+ *
+ * @return  none ('failW' will be set if the transfer fails)
+ */
+static void NVOCTP_compactStep(void)
+{
+    NVOCTP_TSTART(NVOCTP_HISTCOMPACT)
+
+    if(NVOCTP_tailPg == NVOCTP_activePg)
+    {
+        // Items on the active page move to a fresh page
+        NVOCTP_openPage(NVOCTP_NEXTPG(NVOCTP_activePg));
+    }
+
+    if((NVOCTP_failW == NVINTF_SUCCESS) &&
+       NVOCTP_xferPage(NVOCTP_tailPg, NVOCTP_COMPACTSTEP))
+    {
+#if NVOCTP_RAMINDEX
+        if(!NVOCTP_idxValid)
+        {
+            // Item locations changed without the index keeping track
+            NVOCTP_buildIndex();
+        }
+#endif
+    }
+
+    if(NVOCTP_failW != NVINTF_SUCCESS)
+    {
+        // Next compaction starts over, moved items are found as duplicates
+        NVOCTP_ASSERT(FALSE, "COMPACTION FAILURE")
+#if NVOCTP_RAMINDEX
+        NVOCTP_idxValid = FALSE;
+#endif
+    }
+
+    NVOCTP_TSTOP()
+}
+
+#endif
+
+/******************************************************************************
+ * @fn      NVOCTP_xferPage
+ *
+ * @brief   Copy the active&valid items of the tail page to the active page,
+ *          then erase it. Items are moved from newest to oldest; a copy is
+ *          left behind when a newer copy of the item exists. Moved items are
+ *          marked inactive on the tail page, so that an item update or
+ *          delete between two steps of a transfer only has to deal with the
+ *          newest copy.
+ *
+ * @param   srcPg    - Tail page of the ring
+ * @param   maxItems - Maximum number of items to look at in this call
+ *
+ * @return  TRUE when the tail page has been erased, FALSE if more items are
+ *          left to move ('failW' will be set if the transfer fails)
+ */
+static bool NVOCTP_xferPage(uint8_t srcPg,
+                            uint16_t maxItems)
+{
+    uint16_t srcOff;
+    NVOCTP_itemHdr_t srcHdr;
+#if NVOCTP_RAMINDEX
+    uint16_t i;
+#endif
+#if defined (NVOCTP_STATS)
+    uint32_t nvcid;
+
+    // Create a compressed item ID for NV diagnostic
+    nvcid = NVOCTP_CMPRID(NVINTF_SYSID_NVDRVR, 1, 0);
+#endif
+
+    if(NVOCTP_xferOff == 0)
+    {
+        // Mark the specified page to be in XFER state
+        NVOCTP_writeByte(srcPg, NVOCTP_PGHDROFS, (uint8_t)NVOCTP_PGXFER);
+
+        // Source items start with the last written item, it may be damaged
+        // by an interrupted write so check its CRC
+        NVOCTP_xferOff   = NVOCTP_PGEND(srcPg);
+        NVOCTP_xferTrust = FALSE;
+#if defined (NVOCTP_STATS)
+        NVOCTP_xferActive  = 0;
+        NVOCTP_xferDeleted = 0;
+#endif
+    }
+
+    srcOff = NVOCTP_xferOff;
+    while(NVOCTP_failW == NVINTF_SUCCESS)
+    {
+        bool move = FALSE;
+        uint16_t itemSize;
+        uint16_t itemEnd = srcOff;
+
+        if(maxItems-- == 0)
+        {
+            // Continue with the next step
+            return (FALSE);
+        }
+        // Moved items get their CRC checked as they are copied, so the
+        // header is enough when the item has one behind it
+        if(!NVOCTP_prevItem(srcPg, &srcOff, NVOCTP_xferTrust, &srcHdr))
+        {
+            // All items have been moved
+            break;
+        }
+        itemSize = NVOCTP_ITEMHDRLEN + srcHdr.len;
+
+        if((srcHdr.stats & NVOCTP_ACTIVEIDBIT) &&
+          !(srcHdr.stats & NVOCTP_VALIDIDBIT))
+        {
+            uint8_t pg = NVOCTP_activePg;
+
+            // Older copies were left behind by an interrupted item update
+            move = (NVOCTP_findItem(&pg, NVOCTP_pgOff, srcHdr.cmpid,
+                                    NVOCTP_FINDSTRICT) == srcHdr.hofs) &&
+                   (pg == srcPg);
+#if defined (NVOCTP_STATS)
+            // Diagnostic item is written again when the page is done
+            move = move && (srcHdr.cmpid != nvcid);
+#endif
+        }
+
+        if(move)
+        {
+            if((NVOCTP_pgOff + itemSize) > FLASH_PAGE_SIZE)
+            {
+                if(NVOCTP_NEXTPG(NVOCTP_activePg) == srcPg)
+                {
+                    // Somehow ran out of pages
+                    NVOCTP_ALERT(FALSE, "Offset overflow: pgOff")
+                    NVOCTP_failW = NVINTF_BADLENGTH;
+                    break;
+                }
+                // Active page is full, continue on the next one
+                NVOCTP_openPage(NVOCTP_NEXTPG(NVOCTP_activePg));
+            }
+
+            if(NVOCTP_copyItem(srcPg, NVOCTP_activePg, srcOff, NVOCTP_pgOff,
+                               &srcHdr) == NVINTF_CORRUPT)
+            {
+                // Copy is as bad as the source, look at this part of the page
+                // again with every CRC checked
+                NVOCTP_setItemInactive(NVOCTP_activePg,
+                                       NVOCTP_pgOff + srcHdr.len);
+                NVOCTP_pgOff    += itemSize;
+                NVOCTP_xferTrust = FALSE;
+                srcOff = itemEnd;
+                continue;
+            }
+#if NVOCTP_RAMINDEX
+            if (NVOCTP_idxValid && NVOCTP_failW == NVINTF_SUCCESS &&
+                !NVOCTP_idxPut(srcHdr.cmpid, NVOCTP_activePg,
+                               NVOCTP_pgOff + srcHdr.len))
+            {
+                // RAM index is full, fall back to page traversal
+                NVOCTP_idxValid = FALSE;
+            }
+#endif
+            NVOCTP_pgOff += itemSize;
+            if(NVOCTP_failW == NVINTF_SUCCESS)
+            {
+                // Only the moved copy is current now
+                NVOCTP_setItemInactive(srcPg, srcHdr.hofs);
+            }
+#if defined (NVOCTP_STATS)
+            NVOCTP_xferActive += 1;
+#endif
+        }
+#ifdef NVOCTP_STATS
+        else
+        {
+            NVOCTP_xferDeleted++;
+        }
+#endif
+        // Item is done, resume below it
+        NVOCTP_xferOff   = srcOff;
+        NVOCTP_xferTrust = TRUE;
+    }
+
+    if(NVOCTP_failW != NVINTF_SUCCESS)
+    {
+        // Failure during item xfer makes next findItem() unreliable
+        return (FALSE);
+    }
+
+#if defined (NVOCTP_STATS)
+    {
+        int16_t dOfs;
+        uint8_t dPg = NVOCTP_activePg;
+        NVOCTP_itemHdr_t dHdr;
+
+        // Previous copy of the diagnostic info
+        dOfs = NVOCTP_findItem(&dPg, NVOCTP_pgOff, nvcid, NVOCTP_FINDSTRICT);
+        // One more erase/compaction is complete
+        NVOCTP_diags.compacts += 1;
+        // Number of items copied
+        NVOCTP_diags.active = NVOCTP_xferActive;
+        // Number of items left behind
+        NVOCTP_diags.deleted = NVOCTP_xferDeleted;
+        // Make Diag Header Object
+        dHdr.len     = sizeof(NVOCTP_diags);
+        dHdr.hofs    = 0;
+        dHdr.cmpid   = nvcid;
+        dHdr.subid   = diagId.subID;
+        dHdr.itemid  = diagId.itemID;
+        dHdr.sysid   = diagId.systemID;
+        dHdr.sig     = NVOCTP_SIGNATURE;
+        if(((NVOCTP_pgOff + NVOCTP_ITEMHDRLEN + sizeof(NVOCTP_diags)) >
+            FLASH_PAGE_SIZE) && (NVOCTP_NEXTPG(NVOCTP_activePg) != srcPg))
+        {
+            // Active page is full, continue on the next one
+            NVOCTP_openPage(NVOCTP_NEXTPG(NVOCTP_activePg));
+        }
+        // Available space after this item update
+        NVOCTP_diags.available = FLASH_PAGE_SIZE - (NVOCTP_pgOff +
+                                 NVOCTP_ITEMHDRLEN + sizeof(NVOCTP_diags));
+        NVOCTP_writeItem(&dHdr, NVOCTP_activePg, (uint8_t *)&NVOCTP_diags);
+        if((NVOCTP_failW == NVINTF_SUCCESS) && (dOfs > 0) && (dPg != srcPg))
+        {
+            // Retire the previous diagnostic item
+            NVOCTP_setItemInactive(dPg, (uint16_t)dOfs);
+        }
+        // Diagnostic item is optional, don't fail the compaction over it
+        NVOCTP_failW = NVINTF_SUCCESS;
+    }
+#endif
+
+    // Erase the compacted page, the next page in use is the oldest now
+    NVOCTP_failW = NVOCTP_erase(srcPg);
+    if(NVOCTP_failW == NVINTF_SUCCESS)
+    {
+        NVOCTP_tailPg  = NVOCTP_NEXTPG(srcPg);
+        NVOCTP_xferOff = 0;
+#if NVOCTP_RETIRE
+        // Old copies on the page are gone
+        NVOCTP_retDrop(srcPg);
+#endif
+    }
+
+#if NVOCTP_RAMINDEX
+    for(i = 0; NVOCTP_idxValid && (i < NVOCTP_RAMINDEX); i++)
+    {
+        if((NVOCTP_idxTbl[i].cmpid != NVOCTP_IDXEMPTY) &&
+           (NVOCTP_idxTbl[i].pg == srcPg))
+        {
+            // Item was not moved, stop trusting the RAM index
+            NVOCTP_idxValid = FALSE;
+        }
+    }
+#endif
+
+    return (NVOCTP_failW == NVINTF_SUCCESS);
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_makeRoom
+ *
+ * @brief   Make room on the active page for an item of the specified size.
+ *          A full active page is closed and the next page of the ring is
+ *          opened; when there is no free page left, the oldest page in use
+ *          is compacted first.
+ *
+ * @param   iLen - Total length of the item (header and data)
+ *
+ * @return  TRUE if the item fits on the active page, FALSE otherwise
+ */
+static bool NVOCTP_makeRoom(uint16_t iLen)
+{
+    uint8_t passes = 0;
+    uint8_t used = NVOCTP_PGUSED();
+
+    while((NVOCTP_pgOff + iLen) > FLASH_PAGE_SIZE)
+    {
+        if((NVOCTP_nvPages - NVOCTP_PGUSED()) > 1)
+        {
+            // Keep one page free for compaction, use the others
+            NVOCTP_openPage(NVOCTP_NEXTPG(NVOCTP_activePg));
+        }
+        else if(passes++ < used)
+        {
+            // Ring is full, free up the oldest page
+            (void)NVOCTP_compactPage(NVOCTP_tailPg);
+        }
+        else
+        {
+            // Compacting every page did not make enough room
+            return (FALSE);
+        }
+
+        if(NVOCTP_failW != NVINTF_SUCCESS)
+        {
+            return (FALSE);
+        }
+    }
+
+    return (TRUE);
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_openPage
+ *
+ * @brief   Make the specified page the active page. The page is erased
+ *          first if it is not blank, and the end of the previous active page
+ *          is kept for ring traversal. A valid RAM index is recorded in a
+ *          mount checkpoint, the first item of the page.
+ *
+ * @param   pg - NV page to activate, must not be in use
+ *
+ * @return  none ('failW' will be set if the page can't be activated)
+ */
+static void NVOCTP_openPage(uint8_t pg)
+{
+    if(!NVOCTP_isErased(pg))
+    {
+        // Ensure that the page is ready
+        NVOCTP_failW = NVOCTP_erase(pg);
+    }
+
+    if(NVOCTP_failW == NVINTF_SUCCESS)
+    {
+        if(NVOCTP_activePg != NVOCTP_NULLPAGE)
+        {
+            // Previous active page is full
+            NVOCTP_pgEnd[NVOCTP_activePg - NVOCTP_nvBegPage] = NVOCTP_pgOff;
+        }
+        NVOCTP_setPageActive(pg);
+    }
+
+    if(NVOCTP_failW == NVINTF_SUCCESS)
+    {
+        // Items start right after page header
+        NVOCTP_pgOff = NVOCTP_PGDATAOFS;
+#if NVOCTP_CHECKPOINT
+#if NVOCTP_RETIRE
+        if(NVOCTP_idxValid)
+        {
+            // Initialization sees older pages only through the checkpoint,
+            // it can't find their old copies
+            NVOCTP_retMark(NVOCTP_RETALL, NVOCTP_RETKEEP());
+        }
+#endif
+        if(NVOCTP_idxValid)
+        {
+            // Older pages only lose items from now on, record the rest
+            NVOCTP_writeCheckpoint();
+        }
+#endif
+    }
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_isErased
+ *
+ * @brief   Check that every byte of the specified page is erased
+ *
+ * @param   pg - NV Flash page
+ *
+ * @return  TRUE if the page is blank
+ */
+static bool NVOCTP_isErased(uint8_t pg)
+{
+    uint16_t i, ofs;
+    uint8_t readBuffer[NVOCTP_XFERBLKMAX];
+    const uint8_t *pRead;
+
+    for(ofs = 0; ofs < FLASH_PAGE_SIZE; ofs += NVOCTP_XFERBLKMAX)
+    {
+        pRead = NVOCTP_readPtr(pg, ofs, readBuffer, NVOCTP_XFERBLKMAX);
+        for(i = 0; i < NVOCTP_XFERBLKMAX; i++)
+        {
+            if(pRead[i] != NVOCTP_ERASEDBYTE)
+            {
+                return (FALSE);
+            }
+        }
+    }
+
+    return (TRUE);
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_copyItem
+ *
+ * @brief   Copy an NV item from source page to specified destination page.
+ *          The item CRC is checked on the bytes as they are copied.
+ *
+ * @param   srcPg - Source page
+ * @param   dstPg - Destination page
+ * @param   sOfs  - Source page offset of original data
+ * @param   dOfs  - Destination page offset to transferred copy of the item
+ * @param   pHdr  - Header of the item to copy
+ *
+ * @return  NVINTF_SUCCESS, NVINTF_CORRUPT if the CRC does not match or the
+ *          write failure ('failW' will be set if the write fails)
+ */
+static uint8_t NVOCTP_copyItem(uint8_t srcPg,
+                               uint8_t dstPg,
+                               uint16_t sOfs,
+                               uint16_t dOfs,
+                               NVOCTP_itemHdr_t *pHdr)
 {
     uint16_t num;
     uint8_t tmp[NVOCTP_XFERBLKMAX];
+    uint8_t crc = 0;
+    uint16_t len = NVOCTP_ITEMHDRLEN + pHdr->len;
+    // CRC calculations stop at the length field of header
+    uint16_t crcLen = pHdr->len + NVOCTP_HDRCRCINC - 1;
 
     // Copy over the data: Flash to RAM, then RAM to Flash
     while(len > 0 && !NVOCTP_failW)
@@ -2153,7 +4036,14 @@ static void NVOCTP_copyItem(uint8_t dstPg,
         num = (len < NVOCTP_XFERBLKMAX) ? len : NVOCTP_XFERBLKMAX;
 
         // Get block of bytes from source page
-        NVOCTP_read(NVOCTP_activePg, sOfs, (uint8_t *)&tmp, num);
+        NVOCTP_read(srcPg, sOfs, (uint8_t *)&tmp, num);
+        if(crcLen > 0)
+        {
+            uint16_t n = (crcLen < num) ? crcLen : num;
+
+            crc     = NVOCTP_doRAMCRC(tmp, n, crc);
+            crcLen -= n;
+        }
 
         // Write block to destination page
         NVOCTP_failW = NVOCTP_write(dstPg, dOfs, (uint8_t *)&tmp, num);
@@ -2162,6 +4052,14 @@ static void NVOCTP_copyItem(uint8_t dstPg,
         sOfs += num;
         len  -= num;
     }
+
+    if(NVOCTP_failW != NVINTF_SUCCESS)
+    {
+        // Copy is incomplete, so is the CRC
+        return (NVOCTP_failW);
+    }
+
+    return (NVOCTP_checkCRC(pHdr->len, pHdr->crc8, crc));
 }
 
 /******************************************************************************
@@ -2178,9 +4076,8 @@ static uint8_t NVOCTP_readByte(uint8_t pg,
                                uint16_t ofs)
 {
     uint8_t byteVal;
-    NVOCTP_read(pg, ofs, &byteVal, NVOCTP_ONEBYTE);
 
-    return byteVal;
+    return (*NVOCTP_readPtr(pg, ofs, &byteVal, NVOCTP_ONEBYTE));
 }
 
 
@@ -2225,6 +4122,14 @@ static uint8_t NVOCTP_doNVCRC(uint8_t pg,
     uint8_t tmp[NVOCTP_XFERBLKMAX];
     crc_t newCRC = (crc_t)crc;
 
+#if NVOCTP_MAPPED
+    // Compute CRC in place
+    if (NVOCTP_mapped)
+    {
+        return (crc_update(newCRC, NVOCTP_MAPADDR(pg, ofs), len));
+    }
+#endif
+
     // Read flash and compute CRC in blocks
     while(len > 0)
     {
@@ -2263,31 +4168,756 @@ static uint8_t NVOCTP_doRAMCRC(uint8_t *input,
  *
  * @brief   Helper function to validate item crc from NV
  *
+ * @param   pg - Flash page of the item
  * @param   iOfs - offset to item data
  * @param   len - length of item data
  * @param   crc - crc to compare against
  *
  * @return  status byte
  */
-static uint8_t NVOCTP_verifyCRC(uint16_t iOfs,
+static uint8_t NVOCTP_verifyCRC(uint8_t pg, uint16_t iOfs,
                              uint16_t len, uint8_t crc)
 {
-    uint8_t newCRC;
-    uint16_t crcLen   = len + NVOCTP_HDRCRCINC - 1;
-    uint8_t finalByte = (len & 0x3F) << 2;
+    uint16_t crcLen = len + NVOCTP_HDRCRCINC - 1;
 
     // CRC calculations stop at the length field of header
-    // So the last byte must be done separately
-    newCRC = NVOCTP_doNVCRC(NVOCTP_activePg, iOfs, crcLen, 0);
-    newCRC = NVOCTP_doRAMCRC(&finalByte,sizeof(finalByte),newCRC);
+    return (NVOCTP_checkCRC(len, crc, NVOCTP_doNVCRC(pg, iOfs, crcLen, 0)));
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_checkCRC
+ *
+ * @brief   Helper function to complete an item crc and compare it
+ *
+ * @param   len - length of item data
+ * @param   crc - crc to compare against
+ * @param   newCRC - crc of the item data and header up to the length field
+ *
+ * @return  status byte
+ */
+static uint8_t NVOCTP_checkCRC(uint16_t len,
+                               uint8_t crc,
+                               uint8_t newCRC)
+{
+    uint8_t finalByte = (len & 0x3F) << 2;
+
+    // The last byte must be done separately
+    newCRC = NVOCTP_doRAMCRC(&finalByte,sizeof(finalByte),newCRC);
     NVOCTP_ALERT(newCRC == crc, "Invalid CRC detected.")
 #ifdef NVOCTP_STATS
     if (newCRC != crc)
     {
-        NVOCTP_badCRCCount++;
+        // Readers may get here at the same time
+        UInt hwiKey = Hwi_disable();
+        NVOCTP_diags.badCRC++;
+        Hwi_restore(hwiKey);
     }
 #endif
     return (newCRC == crc ? NVINTF_SUCCESS : NVINTF_CORRUPT);
 }
 
+/******************************************************************************
+ * @fn      NVOCTP_sameItem
+ *
+ * @brief   Check if an item in NV already holds the data of a write. Only
+ *          when the length and the CRC the new data would get both match, the
+ *          data is compared.
+ *
+ * @param   iHdr - pointer to the header of the item in NV
+ * @param   pBuf - pointer to the new data
+ * @param   len - length of the new data
+ *
+ * @return  TRUE if the item holds the same data
+ */
+static bool NVOCTP_sameItem(NVOCTP_itemHdr_t *iHdr,
+                            uint8_t *pBuf,
+                            uint16_t len)
+{
+    uint8_t newCRC;
+    uint8_t finalByte = (len & 0x3F) << 2;
+    uint8_t tmp[NVOCTP_XFERBLKMAX];
+    uint16_t ofs, num;
+
+    if(iHdr->len != len)
+    {
+        return (FALSE);
+    }
+
+    // CRC of the new data, with the same ID and length as the stored header
+    newCRC = NVOCTP_doRAMCRC(pBuf, len, 0);
+    newCRC = NVOCTP_doNVCRC(iHdr->pg, iHdr->hofs, NVOCTP_HDRCRCINC - 1, newCRC);
+    newCRC = NVOCTP_doRAMCRC(&finalByte, sizeof(finalByte), newCRC);
+    if(newCRC != iHdr->crc8)
+    {
+        return (FALSE);
+    }
+
+    // Compare the data in blocks
+    for(ofs = iHdr->hofs - len; len > 0; ofs += num, pBuf += num, len -= num)
+    {
+        num = (len < NVOCTP_XFERBLKMAX) ? len : NVOCTP_XFERBLKMAX;
+        if(memcmp(NVOCTP_readPtr(iHdr->pg, ofs, tmp, num), pBuf, num))
+        {
+            return (FALSE);
+        }
+    }
+
+    return (TRUE);
+}
+
+#if !NVOCTP_RAMINDEX
+/******************************************************************************
+ * @fn      NVOCTP_dropDuplicate
+ *
+ * @brief   Mark the older copy of the newest item inactive. An update writes
+ *          the new copy before marking the old one, so when power is lost in
+ *          between, the newest item in the ring is the only one that can
+ *          have an active older copy. Without the RAM index, which retires
+ *          duplicates while it is built, lookups would find both copies.
+ *
+ * @return  none
+ */
+static void NVOCTP_dropDuplicate(void)
+{
+    int16_t iOfs;
+    uint8_t pg = NVOCTP_activePg;
+    NVOCTP_itemHdr_t iHdr;
+
+    iOfs = NVOCTP_findItem(&pg, NVOCTP_pgOff, 0, NVOCTP_FINDANY);
+    if(iOfs > 0)
+    {
+        NVOCTP_readHeader(pg, (uint16_t)iOfs, &iHdr);
+        // Older copy is the next match below the newest item
+        iOfs = NVOCTP_findItem(&pg, (uint16_t)iOfs - iHdr.len, iHdr.cmpid,
+                               NVOCTP_FINDSTRICT);
+        if(iOfs > 0)
+        {
+            NVOCTP_ALERT(FALSE, "Duplicate item found. Item deleted.")
+            NVOCTP_setItemInactive(pg, (uint16_t)iOfs);
+        }
+    }
+}
+#endif
+
+#if NVOCTP_RAMINDEX
+/******************************************************************************
+ * @fn      NVOCTP_buildIndex
+ *
+ * @brief   Build the RAM index with one traversal of the NV ring. Older
+ *          duplicates of an item, left behind when power was lost between
+ *          writing a new item and marking the old one inactive, are marked
+ *          inactive now.
+ *
+ * @return  none
+ */
+static void NVOCTP_buildIndex(void)
+{
+    int16_t iOfs;
+    uint16_t ofs;
+    uint8_t pg;
+
+    NVOCTP_idxReset();
+    // Page traversal must not consult the index while it is being built
+    NVOCTP_idxValid = FALSE;
+
+    pg  = NVOCTP_activePg;
+    ofs = NVOCTP_pgOff;
+    while((iOfs = NVOCTP_findItem(&pg, ofs, 0, NVOCTP_FINDANY)) > 0)
+    {
+        NVOCTP_itemHdr_t iHdr;
+
+        NVOCTP_readHeader(pg, (uint16_t)iOfs, &iHdr);
+        if(NVOCTP_idxFind(iHdr.cmpid) >= 0)
+        {
+            // Newest copy is already indexed, retire this one
+            NVOCTP_ALERT(FALSE, "Duplicate item found. Item deleted.")
+            NVOCTP_setItemInactive(pg, (uint16_t)iOfs);
+        }
+        else if(!NVOCTP_idxPut(iHdr.cmpid, pg, (uint16_t)iOfs))
+        {
+            // Too many items, leave the index invalid
+            return;
+        }
+        ofs = (uint16_t)iOfs - iHdr.len;
+    }
+
+    NVOCTP_idxValid = TRUE;
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_idxReset
+ *
+ * @brief   Empty the RAM index
+ *
+ * @return  none
+ */
+static void NVOCTP_idxReset(void)
+{
+    uint16_t i;
+
+    for(i = 0; i < NVOCTP_RAMINDEX; i++)
+    {
+        NVOCTP_idxTbl[i].cmpid = NVOCTP_IDXEMPTY;
+    }
+    NVOCTP_idxCount = 0;
+    NVOCTP_idxValid = TRUE;
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_idxFind
+ *
+ * @brief   Find the RAM index slot of an item
+ *
+ * @param   cid - Compressed NV item ID to look for
+ *
+ * @return  Slot number when found, -1 otherwise
+ */
+static int16_t NVOCTP_idxFind(uint32_t cid)
+{
+    uint16_t i;
+
+    // Probe sequence ends at the first unused slot
+    for(i = NVOCTP_IDXHASH(cid); NVOCTP_idxTbl[i].cmpid != NVOCTP_IDXEMPTY;
+        i = NVOCTP_IDXNEXT(i))
+    {
+        if(NVOCTP_idxTbl[i].cmpid == cid)
+        {
+            return ((int16_t)i);
+        }
+    }
+
+    return (-1);
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_idxPut
+ *
+ * @brief   Add an item to the RAM index, or update its location if the
+ *          item is already indexed
+ *
+ * @param   cid  - Compressed NV item ID
+ * @param   pg   - NV page of the item
+ * @param   hofs - Offset to the item header
+ *
+ * @return  FALSE when the index is full, TRUE otherwise
+ */
+static bool NVOCTP_idxPut(uint32_t cid,
+                          uint8_t pg,
+                          uint16_t hofs)
+{
+    uint16_t i;
+
+    for(i = NVOCTP_IDXHASH(cid); NVOCTP_idxTbl[i].cmpid != NVOCTP_IDXEMPTY;
+        i = NVOCTP_IDXNEXT(i))
+    {
+        if(NVOCTP_idxTbl[i].cmpid == cid)
+        {
+            // Item has moved
+            NVOCTP_idxTbl[i].pg   = pg;
+            NVOCTP_idxTbl[i].hofs = hofs;
+            return (TRUE);
+        }
+    }
+
+    if(NVOCTP_idxCount >= NVOCTP_IDXLIMIT)
+    {
+        NVOCTP_ALERT(FALSE, "RAM index full.")
+        return (FALSE);
+    }
+
+    // New item goes into the unused slot ending the probe sequence
+    NVOCTP_idxTbl[i].cmpid = cid;
+    NVOCTP_idxTbl[i].pg    = pg;
+    NVOCTP_idxTbl[i].hofs  = hofs;
+    NVOCTP_idxCount++;
+
+    return (TRUE);
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_idxDelete
+ *
+ * @brief   Remove the item at the specified location from the RAM index.
+ *          Entries that follow in the probe sequence are moved back, so that
+ *          lookups never have to skip deleted slots.
+ *
+ * @param   pg   - NV page of the item
+ * @param   hofs - Offset to the item header
+ *
+ * @return  none
+ */
+static void NVOCTP_idxDelete(uint8_t pg,
+                             uint16_t hofs)
+{
+    uint16_t i, j, k;
+
+    // Items are only deleted by location, so search for it
+    for(i = 0; i < NVOCTP_RAMINDEX; i++)
+    {
+        if((NVOCTP_idxTbl[i].cmpid != NVOCTP_IDXEMPTY) &&
+           (NVOCTP_idxTbl[i].pg == pg) &&
+           (NVOCTP_idxTbl[i].hofs == hofs))
+        {
+            break;
+        }
+    }
+    if(i == NVOCTP_RAMINDEX)
+    {
+        // Item is not indexed
+        return;
+    }
+
+    NVOCTP_idxCount--;
+    for(j = i; ; i = j)
+    {
+        NVOCTP_idxTbl[i].cmpid = NVOCTP_IDXEMPTY;
+        do
+        {
+            j = NVOCTP_IDXNEXT(j);
+            if(NVOCTP_idxTbl[j].cmpid == NVOCTP_IDXEMPTY)
+            {
+                return;
+            }
+            k = NVOCTP_IDXHASH(NVOCTP_idxTbl[j].cmpid);
+        }
+        // Entry stays where it is if its home slot is cyclically in (i, j]
+        while((i <= j) ? ((i < k) && (k <= j)) : ((i < k) || (k <= j)));
+
+        // Entry at j can be reached from slot i, move it there
+        NVOCTP_idxTbl[i] = NVOCTP_idxTbl[j];
+    }
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_idxFindItem
+ *
+ * @brief   RAM index equivalent of a NVOCTP_findItem() ring traversal. The
+ *          item a traversal would find first is the matching item with the
+ *          highest ring position below the search position.
+ *
+ * @param   pPg  - Valid NV page, updated to the page of the found item
+ * @param   ofs  - Offset in NV page from where to start search
+ * @param   cid  - Compressed NV item ID to search for
+ * @param   flag - specifies type of search
+ *
+ * @return  When >0, offset to the item header for found item
+ *          When 0, item not found
+ *          When <0, bad search type
+ */
+static int16_t NVOCTP_idxFindItem(uint8_t *pPg,
+                                  uint16_t ofs,
+                                  uint32_t cid,
+                                  uint8_t flag)
+{
+    int16_t i;
+    uint8_t pg = NVOCTP_NULLPAGE;
+    uint16_t hOfs = 0;
+    uint32_t pos = NVOCTP_IDXPOS(*pPg, ofs);
+    uint32_t mask;
+
+    // Select the compressed ID bits that have to match
+    switch (flag)
+    {
+    case NVOCTP_FINDANY:
+        mask = 0;
+        break;
+    case NVOCTP_FINDSTRICT:
+        // Direct lookup
+        i = NVOCTP_idxFind(cid);
+        if((i >= 0) && (NVOCTP_IDXPOS(NVOCTP_idxTbl[i].pg,
+                        NVOCTP_idxTbl[i].hofs + NVOCTP_ITEMHDRLEN) <= pos))
+        {
+            *pPg = NVOCTP_idxTbl[i].pg;
+            hOfs = NVOCTP_idxTbl[i].hofs;
+        }
+        return ((int16_t)hOfs);
+    case NVOCTP_FINDSYSID:
+        mask = NVOCTP_CMPRID(NVOCTP_MAXSYSID, 0, 0);
+        break;
+    case NVOCTP_FINDITMID:
+        mask = NVOCTP_CMPRID(NVOCTP_MAXSYSID, NVOCTP_MAXITEMID, 0);
+        break;
+    default:
+        // Should not get here
+        NVOCTP_ASSERT(FALSE, "Unhandled case in idxFindItem().")
+        return (-1);
+    }
+
+    for(i = 0; i < NVOCTP_RAMINDEX; i++)
+    {
+        NVOCTP_idxEnt_t *pEnt = &NVOCTP_idxTbl[i];
+
+        if((pEnt->cmpid != NVOCTP_IDXEMPTY) &&
+           (((pEnt->cmpid ^ cid) & mask) == 0) &&
+           ((hOfs == 0) ||
+            (NVOCTP_IDXPOS(pEnt->pg, pEnt->hofs) > NVOCTP_IDXPOS(pg, hOfs))) &&
+           (NVOCTP_IDXPOS(pEnt->pg, pEnt->hofs + NVOCTP_ITEMHDRLEN) <= pos))
+        {
+            pg   = pEnt->pg;
+            hOfs = pEnt->hofs;
+        }
+    }
+
+    if(hOfs != 0)
+    {
+        *pPg = pg;
+    }
+
+    return ((int16_t)hOfs);
+}
+#endif
+
+#if NVOCTP_CHECKPOINT
+/******************************************************************************
+ * @fn      NVOCTP_writeCheckpoint
+ *
+ * @brief   Write the mount checkpoint, the location of every item in the RAM
+ *          index, as the first item of a new active page. The previous
+ *          checkpoint is retired.
+ *
+ * @return  none
+ */
+static void NVOCTP_writeCheckpoint(void)
+{
+    uint16_t i, ofs, hOfs, blk;
+    int16_t old;
+    uint8_t oldPg = NVOCTP_NULLPAGE;
+    uint16_t oldOfs = 0;
+    uint8_t crc = 0;
+    cmpIH_t cHdr;
+    NVOCTP_itemHdr_t cpHdr;
+    uint8_t buf[NVOCTP_CKPTBLK * NVOCTP_CKPTENTLEN];
+
+    cpHdr.cmpid  = NVOCTP_CMPRID(ckptId.systemID, ckptId.itemID,
+                                 ckptId.subID);
+    cpHdr.subid  = ckptId.subID;
+    cpHdr.itemid = ckptId.itemID;
+    cpHdr.sysid  = ckptId.systemID;
+
+    // Previous checkpoint does not go into this one
+    old = NVOCTP_idxFind(cpHdr.cmpid);
+    if(old >= 0)
+    {
+        oldPg  = NVOCTP_idxTbl[old].pg;
+        oldOfs = NVOCTP_idxTbl[old].hofs;
+    }
+    cpHdr.len = (NVOCTP_idxCount - ((old >= 0) ? 1 : 0)) * NVOCTP_CKPTENTLEN;
+
+    ofs  = NVOCTP_pgOff;
+    hOfs = ofs + cpHdr.len;
+    if((hOfs + NVOCTP_ITEMHDRLEN) > FLASH_PAGE_SIZE)
+    {
+        return;
+    }
+
+    // Write the entries in blocks, the CRC follows along
+    for(i = 0, blk = 0; (i < NVOCTP_RAMINDEX) && (ofs < hOfs); i++)
+    {
+        NVOCTP_idxEnt_t *pEnt = &NVOCTP_idxTbl[i];
+        uint16_t loc;
+
+        if((pEnt->cmpid == NVOCTP_IDXEMPTY) || ((int16_t)i == old))
+        {
+            continue;
+        }
+        loc = pEnt->hofs | ((pEnt->pg - NVOCTP_nvBegPage) << 13);
+        memcpy(buf + blk, &pEnt->cmpid, sizeof(pEnt->cmpid));
+        memcpy(buf + blk + sizeof(pEnt->cmpid), &loc, sizeof(loc));
+        blk += NVOCTP_CKPTENTLEN;
+
+        if((blk == sizeof(buf)) || ((ofs + blk) == hOfs))
+        {
+            NVOCTP_failW = NVOCTP_writeCRC(NVOCTP_activePg, ofs, buf, blk,
+                                           &crc);
+            if(NVOCTP_failW != NVINTF_SUCCESS)
+            {
+                break;
+            }
+            ofs += blk;
+            blk  = 0;
+        }
+    }
+
+    if(NVOCTP_failW == NVINTF_SUCCESS)
+    {
+        NVOCTP_packHeader(&cpHdr, crc, cHdr);
+        NVOCTP_failW = NVOCTP_write(NVOCTP_activePg, hOfs, cHdr,
+                                    NVOCTP_ITEMHDRLEN);
+    }
+    NVOCTP_pgOff = hOfs + NVOCTP_ITEMHDRLEN;
+
+    if(NVOCTP_failW == NVINTF_SUCCESS)
+    {
+        if(!NVOCTP_idxPut(cpHdr.cmpid, NVOCTP_activePg, hOfs))
+        {
+            // RAM index is full, fall back to page traversal
+            NVOCTP_idxValid = FALSE;
+        }
+        if(oldPg != NVOCTP_NULLPAGE)
+        {
+            NVOCTP_setItemInactive(oldPg, oldOfs);
+        }
+    }
+    else
+    {
+        NVOCTP_ALERT(FALSE, "Checkpoint write failure. Item deleted.")
+        NVOCTP_setItemInactive(NVOCTP_activePg, hOfs);
+    }
+
+    // Checkpoint is optional, don't fail opening the page over it
+    NVOCTP_failW = NVINTF_SUCCESS;
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_loadCheckpoint
+ *
+ * @brief   Build the RAM index from the active page and the mount checkpoint
+ *          at its bottom. Items of the active page are indexed like a ring
+ *          traversal would, then the checkpoint adds the items of the older
+ *          pages that are still active. Older duplicates are marked inactive.
+ *
+ * @return  TRUE if the RAM index is valid, FALSE when there is no usable
+ *          checkpoint and the ring has to be traversed
+ */
+static bool NVOCTP_loadCheckpoint(void)
+{
+    NVOCTP_itemHdr_t iHdr;
+    uint16_t i, ofs, blk;
+    uint16_t cOfs = 0;
+    uint32_t ckptCid;
+    bool trust = FALSE;
+    uint8_t pg = NVOCTP_activePg;
+    uint8_t buf[NVOCTP_CKPTBLK * NVOCTP_CKPTENTLEN];
+    const uint8_t *pRead;
+
+    ckptCid = NVOCTP_CMPRID(ckptId.systemID, ckptId.itemID, ckptId.subID);
+
+    NVOCTP_idxReset();
+    // Index is incomplete until the checkpoint has been merged
+    NVOCTP_idxValid = FALSE;
+
+    // Newest items first, older duplicates of an item are retired
+    ofs = NVOCTP_pgOff;
+    while(NVOCTP_prevItem(pg, &ofs, trust, &iHdr))
+    {
+        trust = TRUE;
+        if(!(iHdr.stats & NVOCTP_ACTIVEIDBIT) ||
+           (iHdr.stats & NVOCTP_VALIDIDBIT))
+        {
+            continue;
+        }
+        if(NVOCTP_idxFind(iHdr.cmpid) >= 0)
+        {
+            NVOCTP_ALERT(FALSE, "Duplicate item found. Item deleted.")
+            NVOCTP_setItemInactive(pg, iHdr.hofs);
+        }
+        else if(!NVOCTP_idxPut(iHdr.cmpid, pg, iHdr.hofs))
+        {
+            return (FALSE);
+        }
+        else if((ofs == NVOCTP_PGDATAOFS) && (iHdr.cmpid == ckptCid) &&
+                !(iHdr.len % NVOCTP_CKPTENTLEN) &&
+                (NVOCTP_verifyCRC(pg, ofs, iHdr.len, iHdr.crc8) ==
+                 NVINTF_SUCCESS))
+        {
+            // Checkpoint written when the page was opened
+            cOfs = iHdr.hofs;
+        }
+    }
+
+    if(cOfs == 0)
+    {
+        return (FALSE);
+    }
+
+    for(ofs = NVOCTP_PGDATAOFS; ofs < cOfs; ofs += blk)
+    {
+        blk   = ((uint16_t)(cOfs - ofs) > sizeof(buf)) ? sizeof(buf) :
+                (uint16_t)(cOfs - ofs);
+        pRead = NVOCTP_readPtr(pg, ofs, buf, blk);
+
+        for(i = 0; i < blk; i += NVOCTP_CKPTENTLEN)
+        {
+            uint32_t cid;
+            uint16_t hOfs;
+            uint8_t ePg;
+
+            memcpy(&cid, pRead + i, sizeof(cid));
+            memcpy(&hOfs, pRead + i + sizeof(cid), sizeof(hOfs));
+            ePg   = (uint8_t)(hOfs >> 13);
+            hOfs &= (FLASH_PAGE_SIZE - 1);
+            if(ePg >= NVOCTP_nvPages)
+            {
+                continue;
+            }
+            ePg += NVOCTP_nvBegPage;
+
+            // Item must still be active on an older page of the ring
+            if((NVOCTP_PGPOS(ePg) >= NVOCTP_PGPOS(NVOCTP_activePg)) ||
+               (hOfs < NVOCTP_PGDATAOFS) ||
+               ((hOfs + NVOCTP_ITEMHDRLEN) > NVOCTP_PGEND(ePg)))
+            {
+                continue;
+            }
+            NVOCTP_readHeader(ePg, hOfs, &iHdr);
+            if((iHdr.sig != NVOCTP_SIGNATURE) || (iHdr.cmpid != cid) ||
+               !(iHdr.stats & NVOCTP_ACTIVEIDBIT) ||
+               (iHdr.stats & NVOCTP_VALIDIDBIT))
+            {
+                continue;
+            }
+
+            if(NVOCTP_idxFind(cid) >= 0)
+            {
+                // Item was written again after the checkpoint
+                NVOCTP_ALERT(FALSE, "Duplicate item found. Item deleted.")
+                NVOCTP_setItemInactive(ePg, hOfs);
+            }
+            else if(!NVOCTP_idxPut(cid, ePg, hOfs))
+            {
+                return (FALSE);
+            }
+        }
+    }
+
+    NVOCTP_idxValid = TRUE;
+    return (TRUE);
+}
+#endif
+
+#if NVOCTP_RETIRE
+/******************************************************************************
+ * @fn      NVOCTP_retAdd
+ *
+ * @brief   Defer the inactive mark of an old item copy. When the list is
+ *          full its marks are written first.
+ *
+ * @param   cid  - Compressed ID of the item
+ * @param   pg   - NV page of the old copy
+ * @param   hofs - Header offset of the old copy
+ *
+ * @return  none ('failW' will be set if a mark can't be written)
+ */
+static void NVOCTP_retAdd(uint32_t cid,
+                          uint8_t pg,
+                          uint16_t hofs)
+{
+    if(!NVOCTP_idxValid)
+    {
+        // Initialization may not find this copy, don't wait
+        NVOCTP_setItemInactive(pg, hofs);
+        return;
+    }
+
+    if(NVOCTP_retCount == NVOCTP_RETIRE)
+    {
+        NVOCTP_retMark(NVOCTP_RETALL, NVOCTP_RETKEEP());
+    }
+
+    if(NVOCTP_retCount < NVOCTP_RETIRE)
+    {
+        NVOCTP_retTbl[NVOCTP_retCount].cmpid = cid;
+        NVOCTP_retTbl[NVOCTP_retCount].hofs  = hofs;
+        NVOCTP_retTbl[NVOCTP_retCount].pg    = pg;
+        NVOCTP_retCount++;
+    }
+    else
+    {
+        // List is stuck on a failed write, mark it now
+        NVOCTP_setItemInactive(pg, hofs);
+    }
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_retMark
+ *
+ * @brief   Write the deferred inactive marks of an item, or of all items.
+ *          Marks already written by an earlier pass are not written again.
+ *
+ * @param   cid    - Compressed ID of the item, NVOCTP_RETALL for all items
+ * @param   keepPg - NV page whose old copies are erased instead of marked,
+ *                   NVOCTP_NULLPAGE if none
+ *
+ * @return  none ('failW' will be set if a mark can't be written)
+ */
+static void NVOCTP_retMark(uint32_t cid,
+                           uint8_t keepPg)
+{
+    uint8_t i;
+    uint8_t n = 0;
+
+    for(i = 0; i < NVOCTP_retCount; i++)
+    {
+        NVOCTP_retEnt_t *pEnt = &NVOCTP_retTbl[i];
+
+        if((NVOCTP_failW == NVINTF_SUCCESS) && (pEnt->pg != keepPg) &&
+           ((cid == NVOCTP_RETALL) || (cid == pEnt->cmpid)))
+        {
+            if(NVOCTP_readByte(pEnt->pg, pEnt->hofs + NVOCTP_HDRVLDOFS) &
+               NVOCTP_ACTIVEIDBIT)
+            {
+                NVOCTP_setItemInactive(pEnt->pg, pEnt->hofs);
+            }
+            if(NVOCTP_failW == NVINTF_SUCCESS)
+            {
+                // Mark is in Flash, drop the entry
+                continue;
+            }
+        }
+        NVOCTP_retTbl[n++] = *pEnt;
+    }
+    NVOCTP_retCount = n;
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_retDrop
+ *
+ * @brief   Forget the deferred marks of an erased page
+ *
+ * @param   pg - NV page that has been erased
+ *
+ * @return  none
+ */
+static void NVOCTP_retDrop(uint8_t pg)
+{
+    uint8_t i;
+    uint8_t n = 0;
+
+    for(i = 0; i < NVOCTP_retCount; i++)
+    {
+        if(NVOCTP_retTbl[i].pg != pg)
+        {
+            NVOCTP_retTbl[n++] = NVOCTP_retTbl[i];
+        }
+    }
+    NVOCTP_retCount = n;
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_retFind
+ *
+ * @brief   Check if an item copy is old with its inactive mark deferred
+ *
+ * @param   pg   - NV page of the item copy
+ * @param   hofs - Header offset of the item copy
+ *
+ * @return  TRUE if the copy is old, FALSE otherwise
+ */
+static bool NVOCTP_retFind(uint8_t pg,
+                           uint16_t hofs)
+{
+    uint8_t i;
+
+    for(i = 0; i < NVOCTP_retCount; i++)
+    {
+        if((NVOCTP_retTbl[i].pg == pg) && (NVOCTP_retTbl[i].hofs == hofs))
+        {
+            return (TRUE);
+        }
+    }
+
+    return (FALSE);
+}
+#endif
+
 //*****************************************************************************
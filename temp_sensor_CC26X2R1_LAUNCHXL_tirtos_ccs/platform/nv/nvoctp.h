@@ -60,6 +60,25 @@ extern "C"
 
 // NV driver item ID definitions
 #define NVOCTP_NVID_DIAG {NVINTF_SYSID_NVDRVR, 1, 0}
+#define NVOCTP_NVID_CKPT {NVINTF_SYSID_NVDRVR, 2, 0}
+
+// Maximum number of Flash pages in the NV ring
+#ifndef NVOCTP_MAXPAGES
+#define NVOCTP_MAXPAGES     8
+#endif
+
+// Operations with a latency histogram in the diagnostic data
+#define NVOCTP_HISTREAD     0   // readItem() and getItemLen()
+#define NVOCTP_HISTWRITE    1   // writeItem() and createItem()
+#define NVOCTP_HISTDELETE   2   // deleteItem()
+#define NVOCTP_HISTDONEXT   3   // doNext()
+#define NVOCTP_HISTCOMPACT  4   // Page compaction or compaction step
+#define NVOCTP_HISTOPS      5
+
+// Number of latency histogram bins. Bin 0 counts operations done within the
+// Clock tick, bin n counts operations of 2^(n-1) up to 2^n ticks. The last bin
+// counts all longer operations.
+#define NVOCTP_HISTBINS     16
 
 //*****************************************************************************
 // Typedefs
@@ -74,9 +93,33 @@ typedef struct
     uint16_t active;    // Number of active items after last compaction
     uint16_t deleted;   // Number of items not transferred during compaction
     uint16_t badCRC;    // Number of bad CRCs encountered
+    uint16_t skipped;   // Number of writes skipped, data was unchanged
+    uint32_t bytesWritten;  // Number of bytes written to Flash
+    uint32_t erases[NVOCTP_MAXPAGES]; // Number of erases of each ring page
+    uint16_t hist[NVOCTP_HISTOPS][NVOCTP_HISTBINS]; // Latency histograms
 }
 NVOCTP_diag_t;
 
+// NV ring usage, item sizes include the item header
+typedef struct
+{
+    uint32_t liveBytes;  // Bytes of the current item copies
+    uint32_t deadBytes;  // Bytes of deleted items and older item copies
+    uint32_t badBytes;   // Bytes skipped over because of a bad CRC
+    uint32_t freeBytes;  // Bytes that can be written before a compaction
+    uint32_t writesLeft; // Item writes of average size before a compaction
+    uint16_t liveItems;  // Number of current item copies
+    uint16_t deadItems;  // Number of deleted items and older item copies
+    uint16_t badAreas;   // Number of corrupted areas skipped over
+    uint8_t  pages;      // Number of ring pages in use
+}
+NVOCTP_usage_t;
+
+// Called for every item found by NVOCTP_getUsage(), pos is the position of
+// the item's page in the ring (0 for the oldest page)
+typedef void (*NVOCTP_usageCB_t)(uint8_t pos, NVINTF_itemID_t id,
+                                 uint16_t len, bool live);
+
 //*****************************************************************************
 // Functions
 //*****************************************************************************
@@ -136,6 +179,48 @@ extern void NVOCTP_loadApiPtrsMin(NVINTF_nvFuncts_t *pfn);
  */
 extern void NVOCTP_setCheckVoltage(void *funcPtr);
 
+#ifdef NVOCTP_STATS
+/**
+ * @fn      NVOCTP_getDiags
+ *
+ * @brief   Global function to read the current driver diagnostic data, which
+ *          includes the counts since it was last saved to NV. Must not be
+ *          called before the driver is initialized.
+ *
+ * @param   pDiag - pointer to caller's diagnostic data structure
+ *
+ * @return  none
+ */
+extern void NVOCTP_getDiags(NVOCTP_diag_t *pDiag);
+#endif
+
+/**
+ * @fn      NVOCTP_retireIdle
+ *
+ * @brief   Global function to write the deferred inactive marks of old item
+ *          copies. Meant to be called when the system is idle, it does
+ *          nothing until half of the NVOCTP_RETIRE list is in use.
+ *
+ * @return  none
+ */
+extern void NVOCTP_retireIdle(void);
+
+/**
+ * @fn      NVOCTP_getUsage
+ *
+ * @brief   Global function to walk the NV ring and report how its bytes are
+ *          used. Every item CRC is checked, so this takes about as long as
+ *          a ring traversal. Must not be called before the driver is
+ *          initialized.
+ *
+ * @param   pUse    - pointer to caller's usage structure
+ * @param   pfnItem - called for every item, NULL if not needed. It must not
+ *                    call the NV driver.
+ *
+ * @return  none
+ */
+extern void NVOCTP_getUsage(NVOCTP_usage_t *pUse, NVOCTP_usageCB_t pfnItem);
+
 // Exception function can be defined to handle NV corruption issues
 // If none provided, NV module attempts to proceed ignoring problem
 #if !defined (NVOCTP_EXCEPTION)
@@ -0,0 +1,1125 @@
+/******************************************************************************
+
+ @file nvqueue.c
+
+ @brief Write-behind queue for the NVOCTP driver, serviced by the NV task
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+//*****************************************************************************
+// Design Overview
+//*****************************************************************************
+/*
+A Flash page erase or program takes milliseconds and a full compaction many
+times that, so a thread calling the NV driver directly stalls for as long.
+This module puts a write-behind queue in front of the NVOCTP driver: item
+writes, deletes and full compactions are copied to a RAM queue and the call
+returns, the Flash work is done by the low priority NV task.
+
+Queued operations are done one at a time in queue order, they are never
+merged or reordered. The NV contents after a power loss are those of a prefix
+of the queued operations, so ordering based schemes such as the settings
+change set journal are not affected. Operations still queued at power loss are
+lost, NVQUEUE_flush() must be called before a software reset.
+
+Reads see pending operations: readItem() and getItemLen() look up the newest
+queued write or delete of the item before asking the driver. A doNext() find
+search merges the queue the same way, without waiting for Flash: it returns
+the items whose newest queued operation is a write first, newest first as the
+driver would after writing them, then the driver's items that have no queued
+operation. Items written or deleted by the queue are skipped in NV. Searches
+that read or delete items do the queued operations when they start and are
+left to the driver.
+
+lockNV() is the driver's gate, it does no queued operation. The queue only
+grows while a thread holds it, so a find search under lockNV() sees a stable
+queue; the lock holder's own writes, deletes and compactions are queued like
+any other. Only when the holder fills the queue does it do the oldest
+operations itself, and a find search still in its queued items may then
+return an item a second time from NV. createItem(), writes of items too large
+for the queue and incremental compaction steps are not queued; queued
+operations are done first where order matters. Streamed item appends and
+deletes are not queued either, stream reads do the queued operations first
+when one of them is on a chunk of the stream.
+
+Two gates are used. The driver gate (lockNV) is held by whoever does a queued
+operation, from taking it off the queue until it is done. The queue gate only
+guards the queue contents for a few copies, so queuing an operation does not
+wait for Flash. Threads that need both take the driver gate first. A thread
+that finds the queue full does the oldest operations itself until its own fits.
+
+Errors of queued operations are counted in the statistics, and the first one
+is kept until NVQUEUE_flush() returns it after the queue is empty. API calls
+always do their own operation and only return its status, a failure of another
+caller's queued write is never reported to them. A delete of an item that is
+already gone is not an error. Callers that need the status of a write, such as
+the settings change set journal, flush after it. Until NVQUEUE_taskCreate() is
+called, NVQUEUE_loadApiPtrs() returns the NVOCTP API unchanged.
+
+Configuration:
+NVQUEUE_SIZE - Size of the queue in bytes. Each operation uses a 16 byte header
+plus its data, rounded up to 4 bytes. Default is 1024.
+
+Dependencies:
+Requires NVOCTP for NV access.
+Requires TI-RTOS GateMutexPri, Semaphore and Clock to be enabled in
+configuration.
+*/
+
+//*****************************************************************************
+// Includes
+//*****************************************************************************
+
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/gates/GateMutexPri.h>
+
+#include "task_config.h"
+#include "nvoctp.h"
+#include "nvqueue.h"
+
+//*****************************************************************************
+// Constants and Definitions
+//*****************************************************************************
+
+// Size of the queue in bytes
+#ifndef NVQUEUE_SIZE
+#define NVQUEUE_SIZE        1024
+#endif
+
+// Queued operations
+#define NVQUEUE_OPWRITE     0
+#define NVQUEUE_OPDELETE    1
+#define NVQUEUE_OPCOMPACT   2
+
+// Parts of a doNext() find search
+#define NVQUEUE_FINDQUEUE   0   // items written by the queue
+#define NVQUEUE_FINDDRIVER  1   // items in NV without a queued operation
+
+//*****************************************************************************
+// Macros
+//*****************************************************************************
+
+// Queue bytes used by an operation with len data bytes, keeps entries aligned
+#define NVQUEUE_ENTLEN(len) (sizeof(NVQUEUE_entry_t) + (((len) + 3) & ~3))
+
+// Queue bytes used by a queued operation
+#define NVQUEUE_ENTSIZE(pEnt) NVQUEUE_ENTLEN(((pEnt)->op == NVQUEUE_OPWRITE) ? \
+                                             (pEnt)->len : 0)
+
+// Queued operation at a queue offset
+#define NVQUEUE_ENTRY(ofs)  ((NVQUEUE_entry_t *)((uint8_t *)NVQUEUE_buf + (ofs)))
+
+// Queue position of a queued operation, which does not change when older
+// operations are taken off the queue
+#define NVQUEUE_POS(pEnt)   ((uint16_t)(NVQUEUE_base + \
+                             ((uint8_t *)(pEnt) - (uint8_t *)NVQUEUE_buf)))
+
+// Lock the queue via TI-RTOS gatemutex
+#define NVQUEUE_LOCK()      GateMutexPri_enter(NVQUEUE_gMutexPri)
+
+// Unlock the queue via TI-RTOS gatemutex
+#define NVQUEUE_UNLOCK(key) GateMutexPri_leave(NVQUEUE_gMutexPri, (key))
+
+//*****************************************************************************
+// Typedefs
+//*****************************************************************************
+
+// Queued operation, the data of a write follows
+typedef struct
+{
+    uint32_t ticks;         // Clock ticks when the operation was queued
+    NVINTF_itemID_t id;     // Item written or deleted
+    uint16_t len;           // Data length of a write
+    uint8_t op;             // NVQUEUE_OPWRITE, _OPDELETE or _OPCOMPACT
+}
+NVQUEUE_entry_t;
+
+//*****************************************************************************
+// Local Variables
+//*****************************************************************************
+
+// NVOCTP driver API
+static NVINTF_nvFuncts_t NVQUEUE_nv;
+
+// Queued operations, oldest first
+static uint32_t NVQUEUE_buf[NVQUEUE_SIZE / sizeof(uint32_t)];
+
+// Number of queue bytes in use
+static uint16_t NVQUEUE_len = 0;
+
+// Flag to indicate that the NV task is created, no operation is queued before
+static bool NVQUEUE_started = false;
+
+// TI-RTOS gateMutexPri for the queue
+static GateMutexPri_Handle NVQUEUE_gMutexPri;
+
+// Posted when an operation is queued
+static Semaphore_Struct NVQUEUE_sem;
+
+// NV task call stack
+static char NVQUEUE_stack[TASK_CONFIG_NV_TASK_STACK_SIZE];
+
+// Queue statistics, depth and bytes are current
+static NVQUEUE_stats_t NVQUEUE_stats;
+
+// First error of a queued operation not reported to a caller yet
+static uint8_t NVQUEUE_error = NVINTF_SUCCESS;
+
+// Queue position of the oldest queued operation, see NVQUEUE_POS()
+static uint16_t NVQUEUE_base = 0;
+
+//*****************************************************************************
+// Local Functions
+//*****************************************************************************
+
+/******************************************************************************
+ * @fn      NVQUEUE_findLast
+ *
+ * @brief   Local function to find the newest queued write or delete of an
+ *          item. The caller holds the queue gate.
+ *
+ * @param   id - NV item type identifier
+ *
+ * @return  queued operation or NULL if none
+ */
+static NVQUEUE_entry_t *NVQUEUE_findLast(NVINTF_itemID_t id)
+{
+    NVQUEUE_entry_t *pFound = NULL;
+    uint16_t ofs = 0;
+
+    while(ofs < NVQUEUE_len)
+    {
+        NVQUEUE_entry_t *pEnt = NVQUEUE_ENTRY(ofs);
+
+        if((pEnt->op != NVQUEUE_OPCOMPACT) &&
+           (pEnt->id.systemID == id.systemID) &&
+           (pEnt->id.itemID == id.itemID) &&
+           (pEnt->id.subID == id.subID))
+        {
+            pFound = pEnt;
+        }
+        ofs += NVQUEUE_ENTSIZE(pEnt);
+    }
+
+    return (pFound);
+}
+
+/******************************************************************************
+ * @fn      NVQUEUE_streamQueued
+ *
+ * @brief   Local function to check for a queued write or delete of a chunk
+ *          of a streamed item
+ *
+ * @param   id - NV item type identifier of the stream
+ *
+ * @return  true if an operation on the stream is queued
+ */
+static bool NVQUEUE_streamQueued(NVINTF_itemID_t id)
+{
+    bool found = false;
+    uint16_t ofs = 0;
+    IArg key = NVQUEUE_LOCK();
+
+    while(!found && (ofs < NVQUEUE_len))
+    {
+        NVQUEUE_entry_t *pEnt = NVQUEUE_ENTRY(ofs);
+
+        found = ((pEnt->op != NVQUEUE_OPCOMPACT) &&
+                 (pEnt->id.systemID == id.systemID) &&
+                 (pEnt->id.itemID == id.itemID));
+        ofs += NVQUEUE_ENTSIZE(pEnt);
+    }
+    NVQUEUE_UNLOCK(key);
+
+    return (found);
+}
+
+/******************************************************************************
+ * @fn      NVQUEUE_offset
+ *
+ * @brief   Local function to convert a queue position to a queue offset. The
+ *          caller holds the queue gate.
+ *
+ * @param   pos - queue position, see NVQUEUE_POS()
+ *
+ * @return  queue offset, 0 if the operations before it are off the queue
+ */
+static uint16_t NVQUEUE_offset(uint16_t pos)
+{
+    uint16_t ofs = (uint16_t)(pos - NVQUEUE_base);
+
+    return ((ofs <= NVQUEUE_len) ? ofs : 0);
+}
+
+/******************************************************************************
+ * @fn      NVQUEUE_found
+ *
+ * @brief   Local function to check whether a queued operation writes an item
+ *          of a doNext() find search. The caller holds the queue gate.
+ *
+ * @param   pEnt - queued operation
+ * @param   prx  - proxy of the search
+ *
+ * @return  true if the operation is the newest one on a searched item and
+ *          writes it
+ */
+static bool NVQUEUE_found(NVQUEUE_entry_t *pEnt, NVINTF_nvProxy_t *prx)
+{
+    NVINTF_nvSearch_t *pS = &prx->state;
+
+    if(pEnt->op != NVQUEUE_OPWRITE)
+    {
+        return (false);
+    }
+    // Same filters as the driver
+    if(prx->flag & NVINTF_DOSYSID)
+    {
+        if(pEnt->id.systemID != pS->qSysid)
+        {
+            return (false);
+        }
+    }
+    else if(prx->flag & NVINTF_DOITMID)
+    {
+        if((pEnt->id.systemID != pS->qSysid) ||
+           (pEnt->id.itemID != pS->qItemid))
+        {
+            return (false);
+        }
+    }
+
+    return (NVQUEUE_findLast(pEnt->id) == pEnt);
+}
+
+/******************************************************************************
+ * @fn      NVQUEUE_takeError
+ *
+ * @brief   Local function to return the kept error of a queued operation,
+ *          which is reported by one flush only
+ *
+ * @return  NVINTF_SUCCESS or failure code of a queued operation
+ */
+static uint8_t NVQUEUE_takeError(void)
+{
+    uint8_t err;
+    IArg key = NVQUEUE_LOCK();
+
+    err = NVQUEUE_error;
+    NVQUEUE_error = NVINTF_SUCCESS;
+    NVQUEUE_UNLOCK(key);
+
+    return (err);
+}
+
+/******************************************************************************
+ * @fn      NVQUEUE_doOne
+ *
+ * @brief   Local function to do the oldest queued operation. The driver gate
+ *          is held until the operation is off the queue, so operations are
+ *          done one at a time and in order, by the NV task or by a caller.
+ *
+ * @param   byTask - true when called by the NV task
+ *
+ * @return  false if the queue is empty
+ */
+static bool NVQUEUE_doOne(bool byTask)
+{
+    NVQUEUE_entry_t *pEnt;
+    uint32_t latency;
+    uint16_t eLen;
+    uint8_t err;
+    IArg dKey = NVQUEUE_nv.lockNV();
+    IArg qKey = NVQUEUE_LOCK();
+
+    if(NVQUEUE_len == 0)
+    {
+        NVQUEUE_UNLOCK(qKey);
+        NVQUEUE_nv.unlockNV(dKey);
+        return (false);
+    }
+
+    // Operations are only appended while this one is done, it stays in place
+    pEnt = NVQUEUE_ENTRY(0);
+    NVQUEUE_UNLOCK(qKey);
+
+    switch(pEnt->op)
+    {
+        case NVQUEUE_OPWRITE:
+            err = NVQUEUE_nv.writeItem(pEnt->id, pEnt->len, pEnt + 1);
+            break;
+        case NVQUEUE_OPDELETE:
+            err = NVQUEUE_nv.deleteItem(pEnt->id);
+            break;
+        default:
+            err = NVQUEUE_nv.compactNV(0);
+            break;
+    }
+
+    qKey = NVQUEUE_LOCK();
+
+    // Take the operation off the queue
+    latency = Clock_getTicks() - pEnt->ticks;
+    eLen = NVQUEUE_ENTSIZE(pEnt);
+    NVQUEUE_len -= eLen;
+    NVQUEUE_base += eLen;
+    memmove(NVQUEUE_buf, (uint8_t *)NVQUEUE_buf + eLen, NVQUEUE_len);
+
+    NVQUEUE_stats.depth--;
+    NVQUEUE_stats.bytes = NVQUEUE_len;
+    NVQUEUE_stats.lastLatency = latency;
+    if(latency > NVQUEUE_stats.maxLatency)
+    {
+        NVQUEUE_stats.maxLatency = latency;
+    }
+    if(byTask)
+    {
+        NVQUEUE_stats.ops++;
+    }
+    else
+    {
+        NVQUEUE_stats.flushOps++;
+    }
+    if(err != NVINTF_SUCCESS)
+    {
+        NVQUEUE_stats.errors++;
+
+        // Keep the first error for the next flush, a repeated delete is not
+        if((NVQUEUE_error == NVINTF_SUCCESS) &&
+           !((pEnt->op == NVQUEUE_OPDELETE) && (err == NVINTF_NOTFOUND)))
+        {
+            NVQUEUE_error = err;
+        }
+    }
+
+    NVQUEUE_UNLOCK(qKey);
+    NVQUEUE_nv.unlockNV(dKey);
+
+    return (true);
+}
+
+/******************************************************************************
+ * @fn      NVQUEUE_drain
+ *
+ * @brief   Local function to do all queued operations before returning.
+ *          Inside a lockNV() section, operations queued by the lock holder
+ *          are done as well.
+ *
+ * @return  none
+ */
+static void NVQUEUE_drain(void)
+{
+    // Nothing is queued before the API is loaded
+    if(NVQUEUE_started && (NVQUEUE_nv.lockNV != NULL))
+    {
+        while(NVQUEUE_doOne(false))
+        {
+            // Until the queue is empty
+        }
+    }
+}
+
+/******************************************************************************
+ * @fn      NVQUEUE_put
+ *
+ * @brief   Local function to queue an operation. If the queue is full, the
+ *          oldest operations are done by the caller until the new one fits.
+ *
+ * @param   op   - NVQUEUE_OPWRITE, NVQUEUE_OPDELETE or NVQUEUE_OPCOMPACT
+ * @param   id   - NV item type identifier
+ * @param   len  - data length of a write
+ * @param   pBuf - data of a write
+ *
+ * @return  none
+ */
+static void NVQUEUE_put(uint8_t op,
+                        NVINTF_itemID_t id,
+                        uint16_t len,
+                        void *pBuf)
+{
+    NVQUEUE_entry_t *pEnt;
+    uint16_t eLen = NVQUEUE_ENTLEN((op == NVQUEUE_OPWRITE) ? len : 0);
+    IArg key = NVQUEUE_LOCK();
+
+    if((NVQUEUE_len + eLen) > NVQUEUE_SIZE)
+    {
+        NVQUEUE_stats.fullWaits++;
+        do
+        {
+            // The queue gate is not held while waiting for the driver gate
+            NVQUEUE_UNLOCK(key);
+            (void)NVQUEUE_doOne(false);
+            key = NVQUEUE_LOCK();
+        }
+        while((NVQUEUE_len + eLen) > NVQUEUE_SIZE);
+    }
+
+    pEnt = NVQUEUE_ENTRY(NVQUEUE_len);
+    pEnt->ticks = Clock_getTicks();
+    pEnt->id    = id;
+    pEnt->len   = len;
+    pEnt->op    = op;
+    if(op == NVQUEUE_OPWRITE)
+    {
+        memcpy(pEnt + 1, pBuf, len);
+    }
+    NVQUEUE_len += eLen;
+
+    NVQUEUE_stats.bytes = NVQUEUE_len;
+    if(NVQUEUE_len > NVQUEUE_stats.maxBytes)
+    {
+        NVQUEUE_stats.maxBytes = NVQUEUE_len;
+    }
+    if(++NVQUEUE_stats.depth > NVQUEUE_stats.maxDepth)
+    {
+        NVQUEUE_stats.maxDepth = NVQUEUE_stats.depth;
+    }
+
+    NVQUEUE_UNLOCK(key);
+
+    Semaphore_post(Semaphore_handle(&NVQUEUE_sem));
+}
+
+/******************************************************************************
+ * @fn      NVQUEUE_task
+ *
+ * @brief   NV task, does the queued operations
+ *
+ * @param   arg0 - unused
+ *
+ * @return  none
+ */
+static void *NVQUEUE_task(void *arg0)
+{
+    (void)arg0;
+
+    while(1)
+    {
+        Semaphore_pend(Semaphore_handle(&NVQUEUE_sem), BIOS_WAIT_FOREVER);
+
+        while(NVQUEUE_doOne(true))
+        {
+            // Until the queue is empty
+        }
+
+        // Flash is idle, catch up on old item copies
+        NVOCTP_retireIdle();
+    }
+}
+
+//*****************************************************************************
+// API Functions
+//*****************************************************************************
+
+/******************************************************************************
+ * @fn      NVQUEUE_compactNvApi
+ *
+ * @brief   API function to force NV compaction. A full compaction (minAvail
+ *          0) is queued, a compaction step is done by the driver right away.
+ *
+ * @param   minAvail - threshold size of available bytes in the NV ring to do
+ *                     compaction: 0 = always, >0 = minimum remaining bytes
+ *
+ * @return  NVINTF_SUCCESS or specific failure code
+ */
+static uint8_t NVQUEUE_compactNvApi(uint16_t minAvail)
+{
+    NVINTF_itemID_t id = {0};
+
+    if(minAvail != 0)
+    {
+        // The caller repeats steps while the driver reports success
+        return (NVQUEUE_nv.compactNV(minAvail));
+    }
+
+    NVQUEUE_put(NVQUEUE_OPCOMPACT, id, 0, NULL);
+
+    return (NVINTF_SUCCESS);
+}
+
+/******************************************************************************
+ * @fn      NVQUEUE_createItemApi
+ *
+ * @brief   API function to create a new NV item, queued operations are done
+ *          first.
+ *
+ * @param   id   - NV item type identifier
+ * @param   len  - length of NV data
+ * @param   pBuf - pointer to caller's initialization data buffer
+ *
+ * @return  NVINTF_SUCCESS or specific failure code
+ */
+static uint8_t NVQUEUE_createItemApi(NVINTF_itemID_t id,
+                                     uint32_t len,
+                                     void *pBuf)
+{
+    uint8_t err;
+    IArg key = NVQUEUE_nv.lockNV();
+
+    NVQUEUE_drain();
+    err = NVQUEUE_nv.createItem(id, len, pBuf);
+
+    NVQUEUE_nv.unlockNV(key);
+
+    return (err);
+}
+
+/******************************************************************************
+ * @fn      NVQUEUE_deleteItemApi
+ *
+ * @brief   API function to delete an NV item, the delete is queued unless
+ *          the caller is in a lockNV() section
+ *
+ * @param   id - NV item type identifier
+ *
+ * @return  NVINTF_SUCCESS or specific failure code
+ */
+static uint8_t NVQUEUE_deleteItemApi(NVINTF_itemID_t id)
+{
+    NVQUEUE_entry_t *pEnt;
+    uint8_t err = NVINTF_SUCCESS;
+    IArg dKey;
+    IArg qKey;
+
+    // No queued operation is done while the item is looked up and queued
+    dKey = NVQUEUE_nv.lockNV();
+
+    if(id.systemID == NVINTF_SYSID_NVDRVR)
+    {
+        // Driver items are protected by the driver
+        err = NVQUEUE_nv.deleteItem(id);
+    }
+    else
+    {
+        qKey = NVQUEUE_LOCK();
+        pEnt = NVQUEUE_findLast(id);
+        if(pEnt != NULL)
+        {
+            err = (pEnt->op == NVQUEUE_OPWRITE) ? NVINTF_SUCCESS :
+                                                  NVINTF_NOTFOUND;
+        }
+        NVQUEUE_UNLOCK(qKey);
+
+        if(pEnt == NULL)
+        {
+            // No queued operation, the item is as in NV
+            err = (NVQUEUE_nv.getItemLen(id) != 0) ? NVINTF_SUCCESS :
+                                                     NVINTF_NOTFOUND;
+        }
+        if(err == NVINTF_SUCCESS)
+        {
+            NVQUEUE_put(NVQUEUE_OPDELETE, id, 0, NULL);
+        }
+    }
+
+    NVQUEUE_nv.unlockNV(dKey);
+
+    return (err);
+}
+
+/******************************************************************************
+ * @fn      NVQUEUE_getItemLenApi
+ *
+ * @brief   API function to return the length of an NV data item
+ *
+ * @param   id - NV item type identifier
+ *
+ * @return  NV item length or 0 if item not found
+ */
+static uint32_t NVQUEUE_getItemLenApi(NVINTF_itemID_t id)
+{
+    NVQUEUE_entry_t *pEnt;
+    uint32_t len = 0;
+    IArg key = NVQUEUE_LOCK();
+
+    pEnt = NVQUEUE_findLast(id);
+    if((pEnt != NULL) && (pEnt->op == NVQUEUE_OPWRITE))
+    {
+        len = pEnt->len;
+    }
+    NVQUEUE_UNLOCK(key);
+
+    if(pEnt == NULL)
+    {
+        len = NVQUEUE_nv.getItemLen(id);
+    }
+
+    return (len);
+}
+
+/******************************************************************************
+ * @fn      NVQUEUE_readItemApi
+ *
+ * @brief   API function to read data from an NV item, from the queue if the
+ *          item has a queued write
+ *
+ * @param   id   - NV item type identifier
+ * @param   ofs  - offset into NV data
+ * @param   len  - length of NV data to return (0 is illegal)
+ * @param   pBuf - pointer to caller's read data buffer  (NULL is illegal)
+ *
+ * @return  NVINTF_SUCCESS or specific failure code
+ */
+static uint8_t NVQUEUE_readItemApi(NVINTF_itemID_t id,
+                                   uint16_t ofs,
+                                   uint16_t len,
+                                   void *pBuf)
+{
+    NVQUEUE_entry_t *pEnt;
+    uint8_t err = NVINTF_NOTFOUND;
+    IArg key;
+
+    // Parameter Sanity Check
+    if(pBuf == NULL || len == 0)
+    {
+        return (NVINTF_BADPARAM);
+    }
+
+    key  = NVQUEUE_LOCK();
+    pEnt = NVQUEUE_findLast(id);
+    if((pEnt != NULL) && (pEnt->op == NVQUEUE_OPWRITE))
+    {
+        if((uint32_t)ofs + len <= pEnt->len)
+        {
+            memcpy(pBuf, (uint8_t *)(pEnt + 1) + ofs, len);
+            err = NVINTF_SUCCESS;
+        }
+        else
+        {
+            // Bad length or offset
+            err = (len > pEnt->len) ? NVINTF_BADLENGTH : NVINTF_BADOFFSET;
+        }
+    }
+    NVQUEUE_UNLOCK(key);
+
+    if(pEnt == NULL)
+    {
+        err = NVQUEUE_nv.readItem(id, ofs, len, pBuf);
+    }
+
+    return (err);
+}
+
+/******************************************************************************
+ * @fn      NVQUEUE_writeItemApi
+ *
+ * @brief   API function to write data to item, creates item if needed. The
+ *          write is queued unless the item is too large for the queue.
+ *
+ * @param   id   - NV item type identifier
+ * @param   len  - data buffer length to write into NV block  (0 is illegal)
+ * @param   pBuf - pointer to caller's data buffer to write  (NULL is illegal)
+ *
+ * @return  NVINTF_SUCCESS or specific failure code
+ */
+static uint8_t NVQUEUE_writeItemApi(NVINTF_itemID_t id,
+                                    uint16_t len,
+                                    void *pBuf)
+{
+    uint8_t err;
+
+    // Parameter Sanity Check
+    if(pBuf == NULL || len == 0)
+    {
+        return (NVINTF_BADPARAM);
+    }
+
+    if(NVQUEUE_ENTLEN(len) > NVQUEUE_SIZE)
+    {
+        IArg key = NVQUEUE_nv.lockNV();
+
+        // Written now, after the queued operations
+        NVQUEUE_drain();
+        err = NVQUEUE_nv.writeItem(id, len, pBuf);
+
+        NVQUEUE_nv.unlockNV(key);
+
+        return (err);
+    }
+
+    NVQUEUE_put(NVQUEUE_OPWRITE, id, len, pBuf);
+
+    return (NVINTF_SUCCESS);
+}
+
+/******************************************************************************
+ * @fn      NVQUEUE_appendItemApi
+ *
+ * @brief   API function to append data to a streamed item, queued operations
+ *          are done first.
+ *
+ * @param   id   - NV item type identifier of the stream
+ * @param   len  - length of the data to append
+ * @param   pBuf - pointer to caller's data buffer
+ *
+ * @return  NVINTF_SUCCESS or specific failure code
+ */
+static uint8_t NVQUEUE_appendItemApi(NVINTF_itemID_t id,
+                                     uint16_t len,
+                                     void *pBuf)
+{
+    uint8_t err;
+    IArg key = NVQUEUE_nv.lockNV();
+
+    NVQUEUE_drain();
+    err = NVQUEUE_nv.appendItem(id, len, pBuf);
+
+    NVQUEUE_nv.unlockNV(key);
+
+    return (err);
+}
+
+/******************************************************************************
+ * @fn      NVQUEUE_readStreamApi
+ *
+ * @brief   API function to read data from a streamed item, queued operations
+ *          on the stream are done first
+ *
+ * @param   id   - NV item type identifier of the stream
+ * @param   ofs  - offset into the stream data
+ * @param   len  - length of data to return
+ * @param   pBuf - pointer to caller's read data buffer
+ *
+ * @return  NVINTF_SUCCESS or specific failure code
+ */
+static uint8_t NVQUEUE_readStreamApi(NVINTF_itemID_t id,
+                                     uint32_t ofs,
+                                     uint16_t len,
+                                     void *pBuf)
+{
+    if(NVQUEUE_streamQueued(id))
+    {
+        NVQUEUE_drain();
+    }
+
+    return (NVQUEUE_nv.readStream(id, ofs, len, pBuf));
+}
+
+/******************************************************************************
+ * @fn      NVQUEUE_getStreamLenApi
+ *
+ * @brief   API function to return the length of a streamed item, queued
+ *          operations on the stream are done first
+ *
+ * @param   id - NV item type identifier of the stream
+ *
+ * @return  Stream length or 0 if the stream is not found
+ */
+static uint32_t NVQUEUE_getStreamLenApi(NVINTF_itemID_t id)
+{
+    if(NVQUEUE_streamQueued(id))
+    {
+        NVQUEUE_drain();
+    }
+
+    return (NVQUEUE_nv.getStreamLen(id));
+}
+
+/******************************************************************************
+ * @fn      NVQUEUE_deleteStreamApi
+ *
+ * @brief   API function to delete a streamed item, queued operations are
+ *          done first.
+ *
+ * @param   id - NV item type identifier of the stream
+ *
+ * @return  NVINTF_SUCCESS or specific failure code
+ */
+static uint8_t NVQUEUE_deleteStreamApi(NVINTF_itemID_t id)
+{
+    uint8_t err;
+    IArg key = NVQUEUE_nv.lockNV();
+
+    NVQUEUE_drain();
+    err = NVQUEUE_nv.deleteStream(id);
+
+    NVQUEUE_nv.unlockNV(key);
+
+    return (err);
+}
+
+/******************************************************************************
+ * @fn      NVQUEUE_doNextApi
+ *
+ * @brief   API function to iterate over NV items. A find search returns the
+ *          items written by the queue, then the driver's items without a
+ *          queued operation, and does no queued operation. Read and delete
+ *          searches do the queued operations when they start.
+ *
+ * @param   prx - pointer to nvProxy item which contains user inputs
+ *
+ * @return  NVINTF_SUCCESS or specific failure code
+ */
+static uint8_t NVQUEUE_doNextApi(NVINTF_nvProxy_t *prx)
+{
+    NVINTF_nvSearch_t *pS;
+    NVINTF_itemID_t id;
+    NVQUEUE_entry_t *pEnt;
+    NVQUEUE_entry_t *pFound = NULL;
+    uint8_t status = NVINTF_SUCCESS;
+    uint16_t ofs = 0;
+    uint16_t end;
+    bool skip;
+    IArg dKey;
+    IArg qKey;
+
+    if((prx == NULL) || !(prx->flag & NVINTF_DOFIND))
+    {
+        if((prx != NULL) && (prx->flag & NVINTF_DOSTART))
+        {
+            NVQUEUE_drain();
+        }
+        return (NVQUEUE_nv.doNext(prx));
+    }
+
+    // No queued operation is done during a step
+    dKey = NVQUEUE_nv.lockNV();
+    qKey = NVQUEUE_LOCK();
+    pS = &prx->state;
+
+    if(prx->flag & NVINTF_DOSTART)
+    {
+        // The driver search starts when the queued items are done
+        prx->flag &= ~NVINTF_DOSTART;
+        pS->qSysid  = prx->sysid;
+        pS->qItemid = prx->itemid;
+        pS->qEnd    = (uint16_t)(NVQUEUE_base + NVQUEUE_len);
+        pS->qPos    = pS->qEnd;
+        pS->qPart   = NVQUEUE_FINDQUEUE;
+    }
+
+    if(pS->qPart == NVQUEUE_FINDQUEUE)
+    {
+        // Newest queued write before the last one returned
+        end = NVQUEUE_offset(pS->qPos);
+        while(ofs < end)
+        {
+            pEnt = NVQUEUE_ENTRY(ofs);
+            if(NVQUEUE_found(pEnt, prx))
+            {
+                pFound = pEnt;
+            }
+            ofs += NVQUEUE_ENTSIZE(pEnt);
+        }
+
+        if(pFound != NULL)
+        {
+            prx->sysid  = pFound->id.systemID;
+            prx->itemid = pFound->id.itemID;
+            prx->subid  = pFound->id.subID;
+            prx->len    = pFound->len;
+            pS->qPos    = NVQUEUE_POS(pFound);
+        }
+        else
+        {
+            prx->sysid  = pS->qSysid;
+            prx->itemid = pS->qItemid;
+            prx->subid  = 0;
+            prx->flag  |= NVINTF_DOSTART;
+            pS->qPart   = NVQUEUE_FINDDRIVER;
+        }
+    }
+    NVQUEUE_UNLOCK(qKey);
+
+    if(pS->qPart == NVQUEUE_FINDDRIVER)
+    {
+        do
+        {
+            skip   = false;
+            status = NVQUEUE_nv.doNext(prx);
+            if(status == NVINTF_SUCCESS)
+            {
+                id.systemID = prx->sysid;
+                id.itemID   = prx->itemid;
+                id.subID    = prx->subid;
+
+                // Written by the queue and returned already, or deleted. A
+                // write queued after the search started is returned here.
+                qKey = NVQUEUE_LOCK();
+                pEnt = NVQUEUE_findLast(id);
+                if(pEnt != NULL)
+                {
+                    skip = ((pEnt->op != NVQUEUE_OPWRITE) ||
+                            (NVQUEUE_offset(NVQUEUE_POS(pEnt)) <
+                             NVQUEUE_offset(pS->qEnd)));
+                    prx->len = pEnt->len;
+                }
+                NVQUEUE_UNLOCK(qKey);
+            }
+        }
+        while(skip);
+    }
+
+    NVQUEUE_nv.unlockNV(dKey);
+
+    return (status);
+}
+
+//*****************************************************************************
+// Global Functions
+//*****************************************************************************
+
+/******************************************************************************
+ * @fn      NVQUEUE_loadApiPtrs
+ *
+ * @brief   Global function to return function pointers for the extended NV
+ *          driver API, with the write-behind queue once the NV task exists
+ *
+ * @param   pfn - pointer to caller's structure of NV function pointers
+ *
+ * @return  none
+ */
+void NVQUEUE_loadApiPtrs(NVINTF_nvFuncts_t *pfn)
+{
+    NVOCTP_loadApiPtrsExt(&NVQUEUE_nv);
+    *pfn = NVQUEUE_nv;
+
+    if(NVQUEUE_started)
+    {
+        pfn->compactNV   = &NVQUEUE_compactNvApi;
+        pfn->createItem  = &NVQUEUE_createItemApi;
+        pfn->deleteItem  = &NVQUEUE_deleteItemApi;
+        pfn->readItem    = &NVQUEUE_readItemApi;
+        pfn->writeItem   = &NVQUEUE_writeItemApi;
+        pfn->getItemLen  = &NVQUEUE_getItemLenApi;
+        pfn->doNext      = &NVQUEUE_doNextApi;
+        if(NVQUEUE_nv.appendItem != NULL)
+        {
+            pfn->appendItem   = &NVQUEUE_appendItemApi;
+            pfn->readStream   = &NVQUEUE_readStreamApi;
+            pfn->getStreamLen = &NVQUEUE_getStreamLenApi;
+            pfn->deleteStream = &NVQUEUE_deleteStreamApi;
+        }
+    }
+}
+
+/******************************************************************************
+ * @fn      NVQUEUE_flush
+ *
+ * @brief   Global function to do all queued operations before returning
+ *
+ * @return  NVINTF_SUCCESS or failure code of a queued operation
+ */
+uint8_t NVQUEUE_flush(void)
+{
+    NVQUEUE_drain();
+
+    return (NVQUEUE_started ? NVQUEUE_takeError() : NVINTF_SUCCESS);
+}
+
+/******************************************************************************
+ * @fn      NVQUEUE_getStats
+ *
+ * @brief   Global function to read the write-behind queue statistics
+ *
+ * @param   pStats - pointer to caller's statistics structure
+ *
+ * @return  none
+ */
+void NVQUEUE_getStats(NVQUEUE_stats_t *pStats)
+{
+    if(NVQUEUE_started)
+    {
+        IArg key = NVQUEUE_LOCK();
+
+        *pStats = NVQUEUE_stats;
+
+        NVQUEUE_UNLOCK(key);
+    }
+    else
+    {
+        memset(pStats, 0, sizeof(NVQUEUE_stats_t));
+    }
+}
+
+/******************************************************************************
+ * @fn      NVQUEUE_taskCreate
+ *
+ * @brief   Global function to create the NV task, called before BIOS_start()
+ *
+ * @return  none
+ */
+void NVQUEUE_taskCreate(void)
+{
+    pthread_t           thread;
+    pthread_attr_t      pAttrs;
+    struct sched_param  priParam;
+    GateMutexPri_Params gateParams;
+    Semaphore_Params    semParams;
+    int                 retc;
+
+    // Create a priority gate mutex for the queue
+    GateMutexPri_Params_init(&gateParams);
+    NVQUEUE_gMutexPri = GateMutexPri_create(&gateParams, NULL);
+
+    Semaphore_Params_init(&semParams);
+    semParams.mode = Semaphore_Mode_BINARY;
+    Semaphore_construct(&NVQUEUE_sem, 0, &semParams);
+
+    retc = pthread_attr_init(&pAttrs);
+    assert(retc == 0);
+
+    retc = pthread_attr_setdetachstate(&pAttrs, PTHREAD_CREATE_DETACHED);
+    assert(retc == 0);
+
+    priParam.sched_priority = TASK_CONFIG_NV_TASK_PRIORITY;
+    retc = pthread_attr_setschedparam(&pAttrs, &priParam);
+    assert(retc == 0);
+
+    retc = pthread_attr_setstack(&pAttrs, (void *)NVQUEUE_stack,
+                                 TASK_CONFIG_NV_TASK_STACK_SIZE);
+    assert(retc == 0);
+
+    retc = pthread_create(&thread, &pAttrs, NVQUEUE_task, NULL);
+    assert(retc == 0);
+
+    retc = pthread_attr_destroy(&pAttrs);
+    assert(retc == 0);
+
+    (void) retc;
+
+    NVQUEUE_started = true;
+}
@@ -0,0 +1,122 @@
+/******************************************************************************
+
+ @file nvqueue.h
+
+ @brief Write-behind queue for the NVOCTP driver, serviced by the NV task
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+#ifndef NVQUEUE_H
+#define NVQUEUE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "nvintf.h"
+
+//*****************************************************************************
+// Typedefs
+//*****************************************************************************
+
+// Write-behind queue statistics, latencies are in Clock ticks
+typedef struct
+{
+    uint16_t depth;       // Number of operations in the queue
+    uint16_t maxDepth;    // Highest number of operations in the queue
+    uint16_t bytes;       // Number of queue bytes in use
+    uint16_t maxBytes;    // Highest number of queue bytes in use
+    uint32_t ops;         // Number of queued operations done by the NV task
+    uint32_t flushOps;    // Number of queued operations done by a caller
+    uint16_t fullWaits;   // Number of times a caller had to make room
+    uint16_t errors;      // Number of queued operations that failed
+    uint32_t lastLatency; // Time from queuing to end of the last operation
+    uint32_t maxLatency;  // Highest time from queuing to end of an operation
+}
+NVQUEUE_stats_t;
+
+//*****************************************************************************
+// Functions
+//*****************************************************************************
+
+/**
+ * @fn      NVQUEUE_loadApiPtrs
+ *
+ * @brief   Global function to return function pointers for the extended NV
+ *          driver API. Once the NV task is created, item writes, deletes and
+ *          compactions are queued and done by the NV task, otherwise the
+ *          NVOCTP functions are returned unchanged.
+ *
+ * @param   pfn - pointer to caller's structure of NV function pointers
+ *
+ * @return  none
+ */
+extern void NVQUEUE_loadApiPtrs(NVINTF_nvFuncts_t *pfn);
+
+/**
+ * @fn      NVQUEUE_flush
+ *
+ * @brief   Global function to do all queued operations before returning.
+ *          Must be called before a software reset, queued operations are
+ *          lost otherwise. The first failure of a queued operation since
+ *          the last flush is returned, and then forgotten. It is reported
+ *          nowhere else, other API calls only return their own status.
+ *
+ * @return  NVINTF_SUCCESS or failure code of a queued operation
+ */
+extern uint8_t NVQUEUE_flush(void);
+
+/**
+ * @fn      NVQUEUE_getStats
+ *
+ * @brief   Global function to read the write-behind queue statistics
+ *
+ * @param   pStats - pointer to caller's statistics structure
+ *
+ * @return  none
+ */
+extern void NVQUEUE_getStats(NVQUEUE_stats_t *pStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NVQUEUE_H */
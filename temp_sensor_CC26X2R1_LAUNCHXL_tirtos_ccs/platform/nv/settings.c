@@ -59,6 +59,10 @@
  * search criteria, while only traversing a page once. This implementation
  * uses doNext heavily.
  *
+ * The driver is reached through the NVQUEUE write-behind queue, so writes and
+ * deletes return without waiting for Flash and are done by the NV task in
+ * order. Reads and enumerations see the queued operations.
+ *
  * OT keys can have multiple settings which act like a linked list. If a middle
  * setting is deleted, it is expected that there is no "empty" setting and the
  * settings adjacent to the deleted setting are now themselves adjacent. So
@@ -71,46 +75,1017 @@
  * Note that the order of NV items on the page may change on any write
  * operation as allowed by the settings.h API. This means that setting order is
  * unreliable after a write operation.
+ *
+ * Changes made between otPlatSettingsBeginChange() and
+ * otPlatSettingsCommitChange() are staged in RAM. The stage holds one record
+ * per changed key with the complete list of settings the key will have, so
+ * repeated writes to a key collapse into one record and reads of a staged key
+ * are served from RAM. On commit, the stage is first written to NV as a
+ * single journal item, then each record is applied to its key and the journal
+ * item is deleted once every record was applied. A journal item found at
+ * initialization belongs to an interrupted or failed commit, which is
+ * completed then.
+ * Applying a record writes the settings to sub IDs 0..N-1 before deleting any
+ * other sub ID of the key, so applying it again is harmless.
+ *
+ * OT reads the settings of a key one index at a time, and finding the Nth
+ * setting takes N doNext steps. To keep enumerating a key linear, the sub IDs
+ * of the last key accessed by index are cached in index order. The cached
+ * order is used until the next write, which may compact NV and reorder every
+ * key, except for Set, Add or Delete of the cached key, which keep the cache
+ * up to date. A key with more settings than the cache holds is remembered as
+ * such, and is then searched only up to the index asked for.
+ *
+ * Add needs a sub ID that is not used by the key. The sub IDs in use by the
+ * first keys are tracked in RAM bitmaps, built at initialization, so that a
+ * free sub ID is found without searching NV. Keys out of the range of the
+ * bitmaps, or with all mapped sub IDs in use, are searched in NV instead.
+ * The bitmaps also tell Set when a key has no other settings to delete, which
+ * saves the search in NV on every Set of a mapped key.
+ *
+ * OT reads the same few keys (active dataset, network info, parent info, child
+ * info) over and over. Whole keys are kept in a RAM value cache, with the sub
+ * ID of every setting, so Get and length queries of a cached key do not reach
+ * NV. A key is loaded on a Get if it fits in the free space of the cache, a
+ * key without settings is cached as an empty record. Set, Add, Delete and
+ * commits update the cache after writing NV and drop the least recently used
+ * keys to stay within SETTINGS_VALUE_CACHE_SIZE bytes, Wipe clears it. The
+ * value cache keeps the index order of a cached key, Delete by index and the
+ * stage use it, so the order only changes when a write drops the key.
+ *
+ * Writes and deletes go through the NV write-behind queue, which reports the
+ * failure of a queued operation only when the queue is flushed. Any failed
+ * write, delete or flush therefore drops both caches and rebuilds the bitmaps.
+ * Commits flush the queue before and after the journal and after applying it,
+ * so their status is that of the writes in NV.
  */
 
-#include <stdlib.h>
-#include <stddef.h>
-#include <assert.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include <openthread-core-config.h>
+#include <openthread/platform/settings.h>
+
+#include "nvintf.h"
+#include "nvqueue.h"
+
+/* CONSTANTS AND MACROS */
+#define SUBIDMAX    ((1 << 10) - 1)
+
+/* Size of the change set stage in bytes, must fit in one NV item (4095) */
+#ifndef SETTINGS_STAGE_SIZE
+#define SETTINGS_STAGE_SIZE    512
+#endif
+
+/* Item ID of the change set journal, outside the range of OT keys */
+#define SETTINGS_JOURNAL_KEY   0x3FF
+
+/* Number of sub IDs held by the index cache, 0 disables it */
+#ifndef SETTINGS_CACHE_SIZE
+#define SETTINGS_CACHE_SIZE    64
+#endif
+
+/* Number of keys with a sub ID bitmap, and sub IDs in each bitmap */
+#ifndef SETTINGS_MAP_KEYS
+#define SETTINGS_MAP_KEYS      16
+#endif
+#define SETTINGS_MAP_BITS      64
+
+/* sCacheCount of a key with more settings than the index cache holds */
+#define SETTINGS_CACHE_OVER    (-2)
+
+/* Size of the value cache in bytes, 0 disables it */
+#ifndef SETTINGS_VALUE_CACHE_SIZE
+#define SETTINGS_VALUE_CACHE_SIZE  512
+#endif
+
+/* Bitmap of the sub IDs 0..count-1 */
+#define SETTINGS_MAP_LOW(count) (((count) >= SETTINGS_MAP_BITS) ? \
+                                 ~(uint64_t)0 : \
+                                 (((uint64_t)1 << (count)) - 1))
+
+/* Stage record header: 16 bit key, 16 bit size of the settings that follow.
+ * Each setting is a 16 bit length followed by its value. A record without
+ * settings deletes the key. */
+#define SETTINGS_RECHDRLEN     (2 * sizeof(uint16_t))
+#define SETTINGS_VALHDRLEN     sizeof(uint16_t)
+
+/* Value cache records use the stage record header. Each setting is a 16 bit
+ * length and its 16 bit sub ID, followed by its value. */
+#define SETTINGS_VCHDRLEN      (2 * sizeof(uint16_t))
+
+/* Static local variables */
+static NVINTF_nvFuncts_t sNvoctpFps = { 0 };
+
+/* Change set stage, records are packed without alignment */
+static uint8_t sStage[SETTINGS_STAGE_SIZE];
+static uint16_t sStageLen = 0;
+
+/* Set between otPlatSettingsBeginChange() and commit or abandon */
+static bool sInChange = false;
+
+/* Sub IDs and lengths of the settings of sCacheKey in index order */
+static uint16_t sCacheKey;
+static int16_t sCacheCount = -1;   // -1 if the cache is not valid, -2 if
+                                   // sCacheKey has too many settings
+static uint16_t sCacheSubId[(SETTINGS_CACHE_SIZE > 0) ?
+                            SETTINGS_CACHE_SIZE : 1];
+static uint16_t sCacheLen[(SETTINGS_CACHE_SIZE > 0) ?
+                          SETTINGS_CACHE_SIZE : 1];
+
+/* Sub IDs in use by keys 0..SETTINGS_MAP_KEYS-1, a set bit may be unused */
+static uint64_t sSubIdMap[SETTINGS_MAP_KEYS];
+
+/* Set for a mapped key that may use sub IDs above the bitmap */
+static bool sMapOver[SETTINGS_MAP_KEYS];
+
+/* Value cache of whole keys, least recently used first */
+static uint8_t sValCache[(SETTINGS_VALUE_CACHE_SIZE > 0) ?
+                         SETTINGS_VALUE_CACHE_SIZE : 1];
+static uint16_t sValCacheLen = 0;
+
+/* Local functions */
+
+/* Mark a sub ID of aKey as used */
+static void mapMark(uint16_t aKey, uint16_t subId)
+{
+    if (aKey >= SETTINGS_MAP_KEYS)
+    {
+        return;
+    }
+
+    if (subId < SETTINGS_MAP_BITS)
+    {
+        sSubIdMap[aKey] |= (uint64_t)1 << subId;
+    }
+    else
+    {
+        sMapOver[aKey] = true;
+    }
+}
+
+/* Mark a sub ID of aKey as free */
+static void mapClear(uint16_t aKey, uint16_t subId)
+{
+    if ((aKey < SETTINGS_MAP_KEYS) && (subId < SETTINGS_MAP_BITS))
+    {
+        sSubIdMap[aKey] &= ~((uint64_t)1 << subId);
+    }
+}
+
+/* Mark all sub IDs of aKey from count on as free */
+static void mapKeep(uint16_t aKey, uint16_t count)
+{
+    if (aKey < SETTINGS_MAP_KEYS)
+    {
+        sSubIdMap[aKey] &= SETTINGS_MAP_LOW(count);
+        if (count <= SETTINGS_MAP_BITS)
+        {
+            sMapOver[aKey] = false;
+        }
+    }
+}
+
+/* Check whether aKey may use a sub ID of count or above */
+static bool mapAbove(uint16_t aKey, uint16_t count)
+{
+    if ((aKey >= SETTINGS_MAP_KEYS) || sMapOver[aKey])
+    {
+        return(true);
+    }
+
+    return((sSubIdMap[aKey] & ~SETTINGS_MAP_LOW(count)) != 0);
+}
+
+/* Find the lowest free sub ID of aKey, returns false if it is not known */
+static bool mapFindFree(uint16_t aKey, uint16_t *pSubId)
+{
+    uint64_t map;
+    uint16_t subId = 0;
+
+    if ((aKey >= SETTINGS_MAP_KEYS) || (sSubIdMap[aKey] == ~(uint64_t)0))
+    {
+        return(false);
+    }
+
+    for (map = sSubIdMap[aKey]; map & 1; map >>= 1)
+    {
+        subId++;
+    }
+    *pSubId = subId;
+
+    return(true);
+}
+
+/* Build the sub ID bitmaps from the items in NV */
+static void mapBuild(void)
+{
+    NVINTF_nvProxy_t nvProxy = {0};
+
+    memset(sSubIdMap, 0, sizeof(sSubIdMap));
+    memset(sMapOver, 0, sizeof(sMapOver));
+
+    /* Setup doNext call */
+    nvProxy.sysid = NVINTF_SYSID_TIOP;
+    nvProxy.flag  = NVINTF_DOSTART | NVINTF_DOSYSID | NVINTF_DOFIND;
+
+    /* Lock and visit all items with sysid TIOP */
+    intptr_t key = sNvoctpFps.lockNV();
+    while (!sNvoctpFps.doNext(&nvProxy))
+    {
+        mapMark(nvProxy.itemid, nvProxy.subid);
+    }
+    sNvoctpFps.unlockNV(key);
+}
+
+/* Drop the index cache before a write. A write may compact NV, which changes
+ * the index order of every key, not only the one written */
+static void cacheDrop(void)
+{
+    sCacheCount = -1;
+}
+
+/* Forget the caches and rebuild the bitmaps after a failed write, delete or
+ * flush. A failed flush is that of an earlier queued write or delete of any
+ * key */
+static void settingsResync(void)
+{
+    cacheDrop();
+    sValCacheLen = 0;
+    mapBuild();
+}
+
+/* Find the sub ID and length of the aIndex'th setting of aKey, returns false
+ * if the key has fewer settings. Fills the index cache with aKey if it can
+ * hold it. A key known not to fit is only searched up to aIndex */
+static bool settingsFindSubId(uint16_t aKey, int aIndex, uint16_t *pSubId,
+                              uint16_t *pLen)
+{
+    NVINTF_nvProxy_t nvProxy = {0};
+    uint8_t status = NVINTF_SUCCESS;
+    int count      = 0;
+    bool fill      = !((sCacheCount == SETTINGS_CACHE_OVER) &&
+                       (sCacheKey == aKey));
+
+    if (aIndex < 0)
+    {
+        return(false);
+    }
+
+    if ((sCacheCount >= 0) && (sCacheKey == aKey))
+    {
+        if (aIndex >= sCacheCount)
+        {
+            return(false);
+        }
+        *pSubId = sCacheSubId[aIndex];
+        *pLen   = sCacheLen[aIndex];
+        return(true);
+    }
+
+    /* Setup doNext call */
+    nvProxy.sysid  = NVINTF_SYSID_TIOP;
+    nvProxy.itemid = aKey;
+    nvProxy.flag   = NVINTF_DOSTART | NVINTF_DOITMID | NVINTF_DOFIND;
+
+    /* Lock and call doNext to find nth item of "aKey", caching all sub IDs
+     * of "aKey" on the way if there is room for them */
+    intptr_t key = sNvoctpFps.lockNV();
+    while (!(status = sNvoctpFps.doNext(&nvProxy)))
+    {
+        if (count == aIndex)
+        {
+            *pSubId = nvProxy.subid;
+            *pLen   = nvProxy.len;
+        }
+        if (fill && (count < SETTINGS_CACHE_SIZE))
+        {
+            sCacheSubId[count] = nvProxy.subid;
+            sCacheLen[count]   = nvProxy.len;
+        }
+        else if (count > aIndex)
+        {
+            break;
+        }
+        count++;
+    }
+    sNvoctpFps.unlockNV(key);
+
+    if (fill)
+    {
+        sCacheKey   = aKey;
+        sCacheCount = (status && (count <= SETTINGS_CACHE_SIZE)) ?
+                      count : SETTINGS_CACHE_OVER;
+    }
+
+    return(count > aIndex);
+}
+
+static uint16_t recGet16(const uint8_t *pBuf, uint16_t ofs)
+{
+    uint16_t val;
+
+    memcpy(&val, &pBuf[ofs], sizeof(val));
+
+    return(val);
+}
+
+static void recPut16(uint8_t *pBuf, uint16_t ofs, uint16_t val)
+{
+    memcpy(&pBuf[ofs], &val, sizeof(val));
+}
+
+/* Length of the record at ofs of a record buffer, header included */
+static uint16_t recLen(const uint8_t *pBuf, uint16_t ofs)
+{
+    return(SETTINGS_RECHDRLEN + recGet16(pBuf, ofs + sizeof(uint16_t)));
+}
+
+/* Find the record of aKey in the first len bytes of a record buffer, returns
+ * its offset or -1 */
+static int recFind(const uint8_t *pBuf, uint16_t len, uint16_t aKey)
+{
+    uint16_t ofs = 0;
+
+    while (ofs < len)
+    {
+        if (recGet16(pBuf, ofs) == aKey)
+        {
+            return(ofs);
+        }
+        ofs += recLen(pBuf, ofs);
+    }
+
+    return(-1);
+}
+
+/* Find the aIndex'th setting of the record at ofs of a record buffer with
+ * hdrLen bytes of setting header, returns its offset or -1 if the record has
+ * fewer settings */
+static int recFindValue(const uint8_t *pBuf, uint16_t ofs, int aIndex,
+                        uint16_t hdrLen)
+{
+    uint16_t endOfs = ofs + recLen(pBuf, ofs);
+
+    ofs += SETTINGS_RECHDRLEN;
+    while ((aIndex >= 0) && (ofs < endOfs))
+    {
+        if (aIndex-- == 0)
+        {
+            return(ofs);
+        }
+        ofs += hdrLen + recGet16(pBuf, ofs);
+    }
+
+    return(-1);
+}
+
+/* Return the setting at pVal, with hdrLen bytes of header starting with its
+ * length, to otPlatSettingsGet() */
+static otError recGetValue(const uint8_t *pVal, uint16_t hdrLen,
+                           uint8_t *aValue, uint16_t *aValueLength)
+{
+    uint16_t itemLen = recGet16(pVal, 0);
+
+    if (NULL != aValue)
+    {
+        if (NULL == aValueLength)
+        {
+            return(OT_ERROR_NOT_FOUND);
+        }
+        memcpy(aValue, &pVal[hdrLen], itemLen);
+    }
+    if (NULL != aValueLength)
+    {
+        *aValueLength = itemLen;
+    }
+
+    return(OT_ERROR_NONE);
+}
+
+static uint16_t stageGet16(uint16_t ofs)
+{
+    return(recGet16(sStage, ofs));
+}
+
+static void stagePut16(uint16_t ofs, uint16_t val)
+{
+    recPut16(sStage, ofs, val);
+}
+
+/* Length of the stage record at ofs, header included */
+static uint16_t stageRecLen(uint16_t ofs)
+{
+    return(recLen(sStage, ofs));
+}
+
+/* Find the stage record of aKey, returns its offset or -1 */
+static int stageFind(uint16_t aKey)
+{
+    return(recFind(sStage, sStageLen, aKey));
+}
+
+/* Open len bytes at stage offset ofs */
+static bool stageInsert(uint16_t ofs, uint16_t len)
+{
+    if ((uint32_t)sStageLen + len > SETTINGS_STAGE_SIZE)
+    {
+        return(false);
+    }
+
+    memmove(&sStage[ofs + len], &sStage[ofs], sStageLen - ofs);
+    sStageLen += len;
+
+    return(true);
+}
+
+/* Close len bytes at stage offset ofs */
+static void stageRemove(uint16_t ofs, uint16_t len)
+{
+    memmove(&sStage[ofs], &sStage[ofs + len], sStageLen - (ofs + len));
+    sStageLen -= len;
+}
+
+/* Find the aIndex'th setting of the stage record at ofs, returns its offset
+ * or -1 if the record has fewer settings */
+static int stageFindValue(uint16_t ofs, int aIndex)
+{
+    return(recFindValue(sStage, ofs, aIndex, SETTINGS_VALHDRLEN));
+}
+
+/* Append a setting to the stage record at ofs */
+static bool stageAddValue(uint16_t ofs, const uint8_t *aValue,
+                          uint16_t aValueLength)
+{
+    uint16_t valOfs = ofs + stageRecLen(ofs);
+
+    if (!stageInsert(valOfs, SETTINGS_VALHDRLEN + aValueLength))
+    {
+        return(false);
+    }
+
+    stagePut16(valOfs, aValueLength);
+    memcpy(&sStage[valOfs + SETTINGS_VALHDRLEN], aValue, aValueLength);
+    stagePut16(ofs + sizeof(uint16_t),
+               stageRecLen(ofs) - SETTINGS_RECHDRLEN +
+               SETTINGS_VALHDRLEN + aValueLength);
+
+    return(true);
+}
+
+/* Replace the stage record of aKey by an empty one with room for len more
+ * bytes. Returns its offset, or -1 with the stage unchanged if it is full */
+static int stageNewRecord(uint16_t aKey, uint16_t len)
+{
+    int ofs = stageFind(aKey);
+    uint32_t need = SETTINGS_RECHDRLEN + len;
+
+    if ((uint32_t)sStageLen + need -
+        (ofs >= 0 ? stageRecLen(ofs) : 0) > SETTINGS_STAGE_SIZE)
+    {
+        return(-1);
+    }
+
+    if (ofs >= 0)
+    {
+        /* Only the last change to a key is kept */
+        stageRemove(ofs, stageRecLen(ofs));
+    }
+
+    ofs = sStageLen;
+    (void)stageInsert(ofs, SETTINGS_RECHDRLEN);
+    stagePut16(ofs, aKey);
+    stagePut16(ofs + sizeof(uint16_t), 0);
+
+    return(ofs);
+}
+
+/* Close len bytes at value cache offset ofs */
+static void vcRemove(uint16_t ofs, uint16_t len)
+{
+    memmove(&sValCache[ofs], &sValCache[ofs + len],
+            sValCacheLen - (ofs + len));
+    sValCacheLen -= len;
+}
+
+/* Reverse len bytes at value cache offset ofs */
+static void vcReverse(uint16_t ofs, uint16_t len)
+{
+    uint8_t *pLo = &sValCache[ofs];
+    uint8_t *pHi = &sValCache[ofs + len - 1];
+
+    while (pLo < pHi)
+    {
+        uint8_t b = *pLo;
+
+        *pLo++ = *pHi;
+        *pHi-- = b;
+    }
+}
+
+/* Move the value cache record at ofs behind the others, returns its offset */
+static uint16_t vcTouch(uint16_t ofs)
+{
+    uint16_t len  = recLen(sValCache, ofs);
+    uint16_t rest = sValCacheLen - ofs;
+
+    if (len < rest)
+    {
+        /* Rotate the records from ofs on by len bytes */
+        vcReverse(ofs, len);
+        vcReverse(ofs + len, rest - len);
+        vcReverse(ofs, rest);
+    }
+
+    return(sValCacheLen - len);
+}
+
+/* Drop the value cache record of aKey */
+static void vcDrop(uint16_t aKey)
+{
+    int ofs = recFind(sValCache, sValCacheLen, aKey);
+
+    if (ofs >= 0)
+    {
+        vcRemove(ofs, recLen(sValCache, ofs));
+    }
+}
+
+/* Start a value cache record of aKey without settings, behind the others.
+ * Returns its offset or -1 if the cache can't hold it */
+static int vcNewRecord(uint16_t aKey)
+{
+    uint16_t ofs;
+
+    vcDrop(aKey);
+    if (SETTINGS_RECHDRLEN > SETTINGS_VALUE_CACHE_SIZE)
+    {
+        return(-1);
+    }
+
+    /* Drop the least recently used records to make room */
+    while (sValCacheLen + SETTINGS_RECHDRLEN > SETTINGS_VALUE_CACHE_SIZE)
+    {
+        vcRemove(0, recLen(sValCache, 0));
+    }
+
+    ofs = sValCacheLen;
+    recPut16(sValCache, ofs, aKey);
+    recPut16(sValCache, ofs + sizeof(uint16_t), 0);
+    sValCacheLen += SETTINGS_RECHDRLEN;
+
+    return(ofs);
+}
+
+/* Append a setting of len bytes to the last value cache record, at ofs, and
+ * return the offset of its value. The record moves when the least recently
+ * used records are dropped to make room, pOfs is updated. Returns -1, with the
+ * record dropped, if it does not fit. */
+static int vcAddValue(uint16_t *pOfs, uint16_t subId, uint16_t len)
+{
+    uint16_t ofs = *pOfs;
+    uint16_t valOfs;
+
+    if ((uint32_t)recLen(sValCache, ofs) + SETTINGS_VCHDRLEN + len >
+        SETTINGS_VALUE_CACHE_SIZE)
+    {
+        vcRemove(ofs, recLen(sValCache, ofs));
+        return(-1);
+    }
+
+    while ((uint32_t)sValCacheLen + SETTINGS_VCHDRLEN + len >
+           SETTINGS_VALUE_CACHE_SIZE)
+    {
+        uint16_t oldLen = recLen(sValCache, 0);
+
+        vcRemove(0, oldLen);
+        ofs -= oldLen;
+    }
+
+    valOfs = sValCacheLen;
+    recPut16(sValCache, valOfs, len);
+    recPut16(sValCache, valOfs + sizeof(uint16_t), subId);
+    recPut16(sValCache, ofs + sizeof(uint16_t), valOfs - ofs -
+             SETTINGS_RECHDRLEN + SETTINGS_VCHDRLEN + len);
+    sValCacheLen += SETTINGS_VCHDRLEN + len;
+    *pOfs = ofs;
+
+    return(valOfs + SETTINGS_VCHDRLEN);
+}
+
+/* Cache aKey with the single setting aValue at sub ID 0 */
+static void vcSet(uint16_t aKey, const uint8_t *aValue, uint16_t aValueLength)
+{
+    int ofs = vcNewRecord(aKey);
+    uint16_t recOfs;
+    int valOfs;
+
+    if (ofs >= 0)
+    {
+        recOfs = (uint16_t)ofs;
+        valOfs = vcAddValue(&recOfs, 0, aValueLength);
+        if (valOfs >= 0)
+        {
+            memcpy(&sValCache[valOfs], aValue, aValueLength);
+        }
+    }
+}
+
+/* Append a setting to aKey if it is cached */
+static void vcAdd(uint16_t aKey, uint16_t subId, const uint8_t *aValue,
+                  uint16_t aValueLength)
+{
+    int ofs = recFind(sValCache, sValCacheLen, aKey);
+    uint16_t recOfs;
+    int valOfs;
+
+    if (ofs >= 0)
+    {
+        recOfs = vcTouch(ofs);
+        valOfs = vcAddValue(&recOfs, subId, aValueLength);
+        if (valOfs >= 0)
+        {
+            memcpy(&sValCache[valOfs], aValue, aValueLength);
+        }
+    }
+}
+
+/* Cache a copy of the stage record at ofs, applied to sub IDs 0..N-1 */
+static void vcStore(uint16_t ofs)
+{
+    uint16_t endOfs = ofs + stageRecLen(ofs);
+    uint16_t subId  = 0;
+    uint16_t valOfs;
+    uint16_t recOfs;
+    int cOfs = vcNewRecord(stageGet16(ofs));
+
+    if (cOfs < 0)
+    {
+        return;
+    }
+
+    recOfs = (uint16_t)cOfs;
+    for (valOfs = ofs + SETTINGS_RECHDRLEN; valOfs < endOfs;
+         valOfs += SETTINGS_VALHDRLEN + stageGet16(valOfs))
+    {
+        cOfs = vcAddValue(&recOfs, subId++, stageGet16(valOfs));
+        if (cOfs < 0)
+        {
+            break;
+        }
+        memcpy(&sValCache[cOfs], &sStage[valOfs + SETTINGS_VALHDRLEN],
+               stageGet16(valOfs));
+    }
+}
+
+/* Find the value cache record of aKey, loading it from NV if it is not cached
+ * yet and fits in the free space. Returns its offset or -1 */
+static int vcLoad(uint16_t aKey)
+{
+    NVINTF_itemID_t nvID;
+    uint32_t size = SETTINGS_RECHDRLEN;
+    uint16_t recOfs;
+    uint16_t subId;
+    uint16_t len;
+    int ofs = recFind(sValCache, sValCacheLen, aKey);
+    int i;
+
+    if (ofs >= 0)
+    {
+        return(vcTouch(ofs));
+    }
+
+    /* The index cache gives the size of the key before anything is read */
+    (void)settingsFindSubId(aKey, 0, &subId, &len);
+    if ((sCacheKey != aKey) || (sCacheCount < 0))
+    {
+        return(-1);
+    }
+    for (i = 0; i < sCacheCount; i++)
+    {
+        size += SETTINGS_VCHDRLEN + sCacheLen[i];
+    }
+    /* Reads only fill free space, keys that do not fit together would
+     * otherwise evict each other on every read */
+    if (sValCacheLen + size > SETTINGS_VALUE_CACHE_SIZE)
+    {
+        return(-1);
+    }
+
+    ofs = vcNewRecord(aKey);
+    recOfs = (uint16_t)ofs;
+
+    nvID.systemID = NVINTF_SYSID_TIOP;
+    nvID.itemID   = aKey;
+
+    /* Copy the settings in the index order of the index cache */
+    for (i = 0; i < sCacheCount; i++)
+    {
+        int valOfs = vcAddValue(&recOfs, sCacheSubId[i], sCacheLen[i]);
+
+        nvID.subID = sCacheSubId[i];
+        if ((valOfs < 0) ||
+            sNvoctpFps.readItem(nvID, 0, sCacheLen[i], &sValCache[valOfs]))
+        {
+            vcDrop(aKey);
+            return(-1);
+        }
+    }
+
+    return(recOfs);
+}
+
+/* Find the stage record of aKey, creating it from the settings of the key in
+ * NV if it is not staged yet. Returns its offset or -1 if the stage is full */
+static int stageLoad(uint16_t aKey)
+{
+    NVINTF_itemID_t nvID;
+    uint16_t subId;
+    uint16_t len;
+    bool ok = true;
+    int ofs = stageFind(aKey);
+    int cOfs;
+    int i;
+
+    if (ofs >= 0)
+    {
+        return(ofs);
+    }
+
+    ofs = stageNewRecord(aKey, 0);
+    if (ofs < 0)
+    {
+        return(-1);
+    }
+
+    nvID.systemID = NVINTF_SYSID_TIOP;
+    nvID.itemID   = aKey;
+
+    /* Copy the settings in the index order OT reads them in, the one of the
+     * value cache or of the index cache, NV order may have changed since */
+    cOfs = vcLoad(aKey);
+    for (i = 0; ok; i++)
+    {
+        uint16_t valOfs = ofs + stageRecLen(ofs);
+        const uint8_t *pVal = NULL;
+
+        if (cOfs >= 0)
+        {
+            int vOfs = recFindValue(sValCache, cOfs, i, SETTINGS_VCHDRLEN);
+
+            if (vOfs < 0)
+            {
+                break;
+            }
+            len  = recGet16(sValCache, vOfs);
+            pVal = &sValCache[vOfs + SETTINGS_VCHDRLEN];
+        }
+        else if (!settingsFindSubId(aKey, i, &subId, &len))
+        {
+            break;
+        }
+
+        ok = stageInsert(valOfs, SETTINGS_VALHDRLEN + len);
+        if (ok)
+        {
+            stagePut16(valOfs, len);
+            stagePut16(ofs + sizeof(uint16_t), valOfs - ofs -
+                       SETTINGS_RECHDRLEN + SETTINGS_VALHDRLEN + len);
+            if (NULL != pVal)
+            {
+                memcpy(&sStage[valOfs + SETTINGS_VALHDRLEN], pVal, len);
+            }
+            else
+            {
+                nvID.subID = subId;
+                ok = !sNvoctpFps.readItem(nvID, 0, len,
+                                          &sStage[valOfs + SETTINGS_VALHDRLEN]);
+            }
+        }
+    }
 
-#include <openthread-core-config.h>
-#include <openthread/platform/settings.h>
+    if (!ok)
+    {
+        /* Key can't be staged */
+        stageRemove(ofs, stageRecLen(ofs));
+        return(-1);
+    }
 
-#include "nvintf.h"
-#include "nvoctp.h"
+    return(ofs);
+}
 
-/* CONSTANTS AND MACROS */
-#define SUBIDMAX    ((2 << 10) - 1)
+/* Delete all items of itemID "aKey" with a sub ID of count or above */
+static void settingsPrune(uint16_t aKey, uint16_t count)
+{
+    NVINTF_itemID_t nvID;
+    NVINTF_nvProxy_t nvProxy = {0};
 
-/* Static local variables */
-static NVINTF_nvFuncts_t sNvoctpFps = { 0 };
+    if (!mapAbove(aKey, count))
+    {
+        /* Nothing to delete */
+        return;
+    }
+
+    /* Setup doNext call */
+    nvProxy.sysid  = NVINTF_SYSID_TIOP;
+    nvProxy.itemid = aKey;
+    nvProxy.flag   = NVINTF_DOSTART | NVINTF_DOITMID | NVINTF_DOFIND;
+
+    nvID.systemID = NVINTF_SYSID_TIOP;
+    nvID.itemID   = aKey;
+
+    /* Lock and call doNext to visit all items of itemID "aKey" */
+    intptr_t key = sNvoctpFps.lockNV();
+    while (!sNvoctpFps.doNext(&nvProxy))
+    {
+        if (nvProxy.subid >= count)
+        {
+            nvID.subID = nvProxy.subid;
+            (void)sNvoctpFps.deleteItem(nvID);
+        }
+    }
+    sNvoctpFps.unlockNV(key);
+
+    mapKeep(aKey, count);
+}
+
+/* Make the key of the stage record at ofs hold exactly its settings */
+static otError settingsApply(uint16_t ofs)
+{
+    NVINTF_itemID_t nvID;
+    uint16_t endOfs = ofs + stageRecLen(ofs);
+    uint16_t count  = 0;
+    uint16_t valOfs;
+
+    nvID.systemID = NVINTF_SYSID_TIOP;
+    nvID.itemID   = stageGet16(ofs);
+
+    cacheDrop();
+    vcDrop(nvID.itemID);
+
+    /* Write the settings in index order to sub IDs 0..N-1 */
+    for (valOfs = ofs + SETTINGS_RECHDRLEN; valOfs < endOfs; count++)
+    {
+        nvID.subID = count;
+        mapMark(nvID.itemID, nvID.subID);
+        if (sNvoctpFps.writeItem(nvID, stageGet16(valOfs),
+                                 &sStage[valOfs + SETTINGS_VALHDRLEN]))
+        {
+            return(OT_ERROR_FAILED);
+        }
+        valOfs += SETTINGS_VALHDRLEN + stageGet16(valOfs);
+    }
+
+    settingsPrune(nvID.itemID, count);
+    vcStore(ofs);
+
+    return(OT_ERROR_NONE);
+}
+
+/* Apply all records of the stage */
+static otError stageApply(void)
+{
+    otError error = OT_ERROR_NONE;
+    uint16_t ofs;
+
+    for (ofs = 0; ofs < sStageLen; ofs += stageRecLen(ofs))
+    {
+        if (settingsApply(ofs) != OT_ERROR_NONE)
+        {
+            error = OT_ERROR_FAILED;
+        }
+    }
+
+    return(error);
+}
 
 /* settings API */
 void otPlatSettingsInit(otInstance *aInstance)
 {
-    /* Load NVOCTP function pointers, extended API */
-    NVOCTP_loadApiPtrsExt(&sNvoctpFps);
+    NVINTF_itemID_t nvID;
+    uint32_t itemLen;
+
+    /* Load NV function pointers, extended API behind the write-behind queue */
+    NVQUEUE_loadApiPtrs(&sNvoctpFps);
 
     /* Initialize NVOCTP */
     sNvoctpFps.initNV(NULL);
+
+    sStageLen    = 0;
+    sInChange    = false;
+    sCacheCount  = -1;
+    sValCacheLen = 0;
+
+    /* The bitmaps are needed to apply the change set journal */
+    mapBuild();
+
+    /* Complete a commit that was interrupted by a reset or failed to apply */
+    nvID.systemID = NVINTF_SYSID_TIOP;
+    nvID.itemID   = SETTINGS_JOURNAL_KEY;
+    nvID.subID    = 0;
+    itemLen = sNvoctpFps.getItemLen(nvID);
+    if (itemLen > 0)
+    {
+        otError error = OT_ERROR_NONE;
+
+        if ((itemLen <= SETTINGS_STAGE_SIZE) &&
+            !sNvoctpFps.readItem(nvID, 0, (uint16_t)itemLen, sStage))
+        {
+            sStageLen = (uint16_t)itemLen;
+            error = stageApply();
+            sStageLen = 0;
+        }
+
+        /* A journal that can not be read is dropped, a failed one is kept */
+        if (error == OT_ERROR_NONE)
+        {
+            (void)sNvoctpFps.deleteItem(nvID);
+        }
+    }
 }
 
 otError otPlatSettingsBeginChange(otInstance *aInstance)
 {
+    if (sInChange)
+    {
+        return(OT_ERROR_ALREADY);
+    }
+
+    sStageLen = 0;
+    sInChange = true;
+
     return(OT_ERROR_NONE);
 }
 
 otError otPlatSettingsCommitChange(otInstance *aInstance)
 {
-    return(OT_ERROR_NONE);
+    NVINTF_itemID_t nvID;
+    otError error = OT_ERROR_NONE;
+
+    if (!sInChange)
+    {
+        return(OT_ERROR_NONE);
+    }
+    sInChange = false;
+
+    if (sStageLen == 0)
+    {
+        return(OT_ERROR_NONE);
+    }
+
+    nvID.systemID = NVINTF_SYSID_TIOP;
+    nvID.itemID   = SETTINGS_JOURNAL_KEY;
+    nvID.subID    = 0;
+
+    /* Earlier writes go to NV before the journal. Their failure is not that
+     * of the commit, but the caches may not match NV any more */
+    if (NVQUEUE_flush())
+    {
+        settingsResync();
+    }
+
+    /* The journal must be in NV before any record is applied */
+    if (sNvoctpFps.writeItem(nvID, sStageLen, sStage) || NVQUEUE_flush())
+    {
+        /* Nothing has been changed */
+        settingsResync();
+        error = OT_ERROR_FAILED;
+    }
+    else
+    {
+        /* From here on a reset completes the commit at initialization */
+        error = stageApply();
+        if ((error == OT_ERROR_NONE) && NVQUEUE_flush())
+        {
+            error = OT_ERROR_FAILED;
+        }
+
+        /* Keep the journal of a failed commit, initialization replays it */
+        if (error == OT_ERROR_NONE)
+        {
+            if (sNvoctpFps.deleteItem(nvID) || NVQUEUE_flush())
+            {
+                error = OT_ERROR_FAILED;
+            }
+        }
+        if (error != OT_ERROR_NONE)
+        {
+            settingsResync();
+        }
+    }
+
+    sStageLen = 0;
+
+    return(error);
 }
 
 otError otPlatSettingsAbandonChange(otInstance *aInstance)
 {
+    sStageLen = 0;
+    sInChange = false;
+
     return(OT_ERROR_NONE);
 }
 
@@ -119,27 +1094,40 @@ otError otPlatSettingsGet(otInstance *aInstance, uint16_t aKey, int aIndex,
 {
     NVINTF_itemID_t nvID;
     uint8_t status = NVINTF_SUCCESS;
-    uint16_t count = 0;
     otError error  = OT_ERROR_NOT_FOUND;
     uint32_t itemLen;
+    uint16_t subId;
+    uint16_t len;
+    int ofs;
 
-    /* doNext search for nth item */
-    NVINTF_nvProxy_t nvProxy = {0};
-    nvProxy.sysid  = NVINTF_SYSID_TIOP;
-    nvProxy.itemid = aKey;
-    nvProxy.flag   = NVINTF_DOSTART | NVINTF_DOITMID | NVINTF_DOFIND;
+    /* Staged key, read from the stage */
+    if (sInChange && ((ofs = stageFind(aKey)) >= 0))
+    {
+        ofs = stageFindValue(ofs, aIndex);
+        if (ofs < 0)
+        {
+            return(OT_ERROR_NOT_FOUND);
+        }
 
-    /* Lock and call doNext to find nth item of "aKey" */
-    intptr_t key = sNvoctpFps.lockNV();
-    while(!status && (count <= aIndex))
+        return(recGetValue(&sStage[ofs], SETTINGS_VALHDRLEN, aValue,
+                           aValueLength));
+    }
+
+    /* Cached key, read from the value cache */
+    if ((ofs = vcLoad(aKey)) >= 0)
     {
-        status = sNvoctpFps.doNext(&nvProxy);
-        count++;
+        ofs = recFindValue(sValCache, ofs, aIndex, SETTINGS_VCHDRLEN);
+        if (ofs < 0)
+        {
+            return(OT_ERROR_NOT_FOUND);
+        }
+
+        return(recGetValue(&sValCache[ofs], SETTINGS_VCHDRLEN, aValue,
+                           aValueLength));
     }
-    sNvoctpFps.unlockNV(key);
 
-    /* If we didn't find the nth item, return */
-    if (NVINTF_NOTFOUND == status)
+    /* Find nth item, if we didn't find it, return */
+    if (!settingsFindSubId(aKey, aIndex, &subId, &len))
     {
         return(OT_ERROR_NOT_FOUND);
     }
@@ -147,10 +1135,10 @@ otError otPlatSettingsGet(otInstance *aInstance, uint16_t aKey, int aIndex,
     /* Make item ID */
     nvID.systemID = NVINTF_SYSID_TIOP;
     nvID.itemID   = aKey;
-    nvID.subID    = nvProxy.subid;
+    nvID.subID    = subId;
 
-    /* Get length */
-    itemLen = sNvoctpFps.getItemLen(nvID);
+    /* Length found by the search */
+    itemLen = len;
 
     /* Determine requested operation */
     if (NULL == aValue)
@@ -177,7 +1165,7 @@ otError otPlatSettingsGet(otInstance *aInstance, uint16_t aKey, int aIndex,
     else if (NULL != aValueLength)
     {
         /* Read operation requested */
-        status = sNvoctpFps.readItem(nvID, NULL, (uint16_t)itemLen, aValue);
+        status = sNvoctpFps.readItem(nvID, 0, (uint16_t)itemLen, aValue);
         /* Replace parameter with actual size of item */
         *aValueLength = itemLen;
         if (status)
@@ -200,35 +1188,51 @@ otError otPlatSettingsGet(otInstance *aInstance, uint16_t aKey, int aIndex,
 otError otPlatSettingsSet(otInstance *aInstance, uint16_t aKey,
                           const uint8_t *aValue, uint16_t aValueLength)
 {
-    /* Function deletes all items with specific itemID and writes one
-     *  item with that item ID */
+    /* Function writes one item with the item ID and deletes all other
+     *  items with that item ID */
     NVINTF_itemID_t nvID;
-    NVINTF_nvProxy_t nvProxy = {0};
     uint8_t status = NVINTF_SUCCESS;
-    otError error  = OT_ERROR_NONE;
-
-    /* Setup doNext call */
-    nvProxy.sysid  = NVINTF_SYSID_TIOP;
-    nvProxy.itemid = aKey;
-    nvProxy.flag   = NVINTF_DOSTART | NVINTF_DOITMID | NVINTF_DODELETE;
+    int ofs;
 
-    /* Lock and call doNext to delete all items with itemID of "aKey" */
-    intptr_t key = sNvoctpFps.lockNV();
-    while(!status)
+    if (sInChange)
     {
-        status = sNvoctpFps.doNext(&nvProxy);
+        /* Stage the key with this single setting */
+        ofs = stageNewRecord(aKey, SETTINGS_VALHDRLEN + aValueLength);
+        if (ofs < 0)
+        {
+            return(OT_ERROR_NO_BUFS);
+        }
+        (void)stageAddValue(ofs, aValue, aValueLength);
+
+        return(OT_ERROR_NONE);
     }
-    sNvoctpFps.unlockNV(key);
 
     /* Make item ID of new item */
     nvID.systemID = NVINTF_SYSID_TIOP;
     nvID.itemID   = aKey;
     nvID.subID    = 0;
 
-    /* Write item */
+    cacheDrop();
+    mapMark(aKey, 0);
+
+    /* Write item before removing the old ones */
     status = sNvoctpFps.writeItem(nvID, aValueLength, (void *)aValue);
+    if (status)
+    {
+        settingsResync();
+        return(OT_ERROR_FAILED);
+    }
 
-    return(error);
+    settingsPrune(aKey, 1);
+    vcSet(aKey, aValue, aValueLength);
+
+    /* The key now has this single setting */
+    sCacheKey      = aKey;
+    sCacheCount    = (SETTINGS_CACHE_SIZE > 0) ? 1 : -1;
+    sCacheSubId[0] = 0;
+    sCacheLen[0]   = aValueLength;
+
+    return(OT_ERROR_NONE);
 }
 
 otError otPlatSettingsAdd(otInstance *aInstance, uint16_t aKey,
@@ -241,67 +1245,110 @@ otError otPlatSettingsAdd(otInstance *aInstance, uint16_t aKey,
     uint32_t itemLen         = 1;
     uint16_t maxSubId        = 0;
     uint16_t minSubId        = 0;
+    int ofs;
 
-    /* Setup doNext call */
-    nvProxy.sysid  = NVINTF_SYSID_TIOP;
-    nvProxy.itemid = aKey;
-    nvProxy.subid  = 0;
-    nvProxy.flag   = NVINTF_DOSTART | NVINTF_DOITMID | NVINTF_DOFIND;
-
-    /* Lock and call doNext to iterate through all items of itemID "aKey" */
-    /* Store min/max of sub id's found */
-    intptr_t key = sNvoctpFps.lockNV();
-    while(!status)
+    if (sInChange)
     {
-        status    = sNvoctpFps.doNext(&nvProxy);
-        maxSubId  = (nvProxy.subid > maxSubId ? nvProxy.subid : maxSubId);
-        minSubId  = (nvProxy.subid < minSubId ? nvProxy.subid : minSubId);
+        /* Stage the key with this setting appended */
+        ofs = stageLoad(aKey);
+        if ((ofs < 0) || !stageAddValue(ofs, aValue, aValueLength))
+        {
+            return(OT_ERROR_NO_BUFS);
+        }
+
+        return(OT_ERROR_NONE);
     }
-    sNvoctpFps.unlockNV(key);
 
     /* Populate item ID */
     nvID.systemID = NVINTF_SYSID_TIOP;
     nvID.itemID   = aKey;
 
-    /* Look for an unused subid */
-    uint16_t count = 0;
-    bool looking   = TRUE;
-    while(looking && (count < SUBIDMAX))
+    /* Take the lowest free sub ID if the key is mapped */
+    if (mapFindFree(aKey, &nvID.subID))
     {
-        if (maxSubId < SUBIDMAX)
-        {
-            nvID.subID = ++maxSubId;
-            itemLen    = sNvoctpFps.getItemLen(nvID);
-            if (!itemLen)
-            {
-                looking = false;
-            }
-        }
-        else
+        itemLen = 0;
+    }
+    else
+    {
+        /* Setup doNext call */
+        nvProxy.sysid  = NVINTF_SYSID_TIOP;
+        nvProxy.itemid = aKey;
+        nvProxy.subid  = 0;
+        nvProxy.flag   = NVINTF_DOSTART | NVINTF_DOITMID | NVINTF_DOFIND;
+
+        /* Lock and call doNext to iterate through all items of itemID "aKey" */
+        /* Store min/max of sub id's found */
+        intptr_t key = sNvoctpFps.lockNV();
+        while(!status)
         {
-            maxSubId = 0;
+            status    = sNvoctpFps.doNext(&nvProxy);
+            maxSubId  = (nvProxy.subid > maxSubId ? nvProxy.subid : maxSubId);
+            minSubId  = (nvProxy.subid < minSubId ? nvProxy.subid : minSubId);
         }
-        if (minSubId > 0 && looking)
+        sNvoctpFps.unlockNV(key);
+
+        /* Look for an unused subid */
+        uint16_t count = 0;
+        bool looking   = TRUE;
+        while(looking && (count < SUBIDMAX))
         {
-            nvID.subID = --minSubId;
-            itemLen    = sNvoctpFps.getItemLen(nvID);
-            if (!itemLen)
+            if (maxSubId < SUBIDMAX)
             {
-                looking = false;
+                nvID.subID = ++maxSubId;
+                itemLen    = sNvoctpFps.getItemLen(nvID);
+                if (!itemLen)
+                {
+                    looking = false;
+                }
             }
+            else
+            {
+                maxSubId = 0;
+            }
+            if (minSubId > 0 && looking)
+            {
+                nvID.subID = --minSubId;
+                itemLen    = sNvoctpFps.getItemLen(nvID);
+                if (!itemLen)
+                {
+                    looking = false;
+                }
+            }
+            else
+            {
+                minSubId = SUBIDMAX;
+            }
+            count++;
         }
-        else
-        {
-            minSubId = SUBIDMAX;
-        }
-        count++;
     }
 
     /* Write item */
     if (!itemLen)
     {
+        mapMark(aKey, nvID.subID);
         status = sNvoctpFps.writeItem(nvID, aValueLength, (void *)aValue);
         error = (status == NVINTF_SUCCESS ? OT_ERROR_NONE : OT_ERROR_FAILED);
+
+        /* New item is the last setting of the key */
+        if (!error && (sCacheKey == aKey) && (sCacheCount >= 0) &&
+            (sCacheCount < SETTINGS_CACHE_SIZE))
+        {
+            sCacheSubId[sCacheCount] = nvID.subID;
+            sCacheLen[sCacheCount++] = aValueLength;
+        }
+        else
+        {
+            cacheDrop();
+        }
+
+        if (!error)
+        {
+            vcAdd(aKey, nvID.subID, aValue, aValueLength);
+        }
+        else
+        {
+            settingsResync();
+        }
     }
 
     return(error);
@@ -313,9 +1360,46 @@ otError otPlatSettingsDelete(otInstance *aInstance, uint16_t aKey, int aIndex)
     NVINTF_nvProxy_t nvProxy = {0};
     uint8_t status           = NVINTF_SUCCESS;
     otError error            = OT_ERROR_NONE;
+    int ofs;
+
+    if (sInChange)
+    {
+        /* Stage the key without all or the nth setting */
+        if (aIndex < 0)
+        {
+            ofs = stageNewRecord(aKey, 0);
+        }
+        else
+        {
+            ofs = stageLoad(aKey);
+        }
+        if (ofs < 0)
+        {
+            return(OT_ERROR_NO_BUFS);
+        }
+        if (aIndex >= 0)
+        {
+            int valOfs = stageFindValue(ofs, aIndex);
+            uint16_t len;
+
+            if (valOfs < 0)
+            {
+                return(OT_ERROR_NOT_FOUND);
+            }
+            len = SETTINGS_VALHDRLEN + stageGet16(valOfs);
+            stageRemove(valOfs, len);
+            stagePut16(ofs + sizeof(uint16_t), stageRecLen(ofs) -
+                       SETTINGS_RECHDRLEN - len);
+        }
+
+        return(OT_ERROR_NONE);
+    }
 
     if (aIndex < 0)
     {
+        cacheDrop();
+        mapKeep(aKey, 0);
+
         /* Setup doNext call */
         nvProxy.sysid  = NVINTF_SYSID_TIOP;
         nvProxy.itemid = aKey;
@@ -328,34 +1412,78 @@ otError otPlatSettingsDelete(otInstance *aInstance, uint16_t aKey, int aIndex)
            status = sNvoctpFps.doNext(&nvProxy);
         }
         sNvoctpFps.unlockNV(key);
+
+        /* The key has no settings left */
+        (void)vcNewRecord(aKey);
     }
     else
     {
-        /* Setup doNext call */
-        nvProxy.sysid  = NVINTF_SYSID_TIOP;
-        nvProxy.itemid = aKey;
-        nvProxy.flag   = NVINTF_DOSTART | NVINTF_DOITMID | NVINTF_DOFIND;
+        uint16_t subId;
+        uint16_t len;
+        int valOfs = -1;
 
-        /* Call doNext to find nth matching item, where n = (aIndex - 1) */
-        int itemCount = 0;
-        intptr_t key  = sNvoctpFps.lockNV();
-        while(!status && (itemCount <= aIndex))
+        /* The index order of a cached key is the one of the value cache */
+        ofs = vcLoad(aKey);
+        if (ofs >= 0)
         {
-           status = sNvoctpFps.doNext(&nvProxy);
-           itemCount++;
+            valOfs = recFindValue(sValCache, ofs, aIndex, SETTINGS_VCHDRLEN);
+            if (valOfs < 0)
+            {
+                return(OT_ERROR_NOT_FOUND);
+            }
+            subId = recGet16(sValCache, valOfs + sizeof(uint16_t));
+            cacheDrop();
         }
-        sNvoctpFps.unlockNV(key);
 
-        /* If we found our nth item, delete it */
-        if (!status)
+        /* Find nth matching item, if we found it, delete it */
+        status = NVINTF_NOTFOUND;
+        if ((valOfs >= 0) || settingsFindSubId(aKey, aIndex, &subId, &len))
         {
             nvID.systemID = NVINTF_SYSID_TIOP;
             nvID.itemID   = aKey;
-            nvID.subID    = nvProxy.subid;
+            nvID.subID    = subId;
             status = sNvoctpFps.deleteItem(nvID);
+            if (!status)
+            {
+                mapClear(aKey, subId);
+            }
+        }
+
+        /* Following settings move down one index */
+        if (!status && (sCacheKey == aKey) && (sCacheCount > aIndex))
+        {
+            memmove(&sCacheSubId[aIndex], &sCacheSubId[aIndex + 1],
+                    (sCacheCount - aIndex - 1) * sizeof(uint16_t));
+            memmove(&sCacheLen[aIndex], &sCacheLen[aIndex + 1],
+                    (sCacheCount - aIndex - 1) * sizeof(uint16_t));
+            sCacheCount--;
+        }
+        else
+        {
+            cacheDrop();
+        }
+
+        if (!status && (valOfs >= 0))
+        {
+            len = SETTINGS_VCHDRLEN + recGet16(sValCache, valOfs);
+            vcRemove(valOfs, len);
+            recPut16(sValCache, ofs + sizeof(uint16_t),
+                     recLen(sValCache, ofs) - SETTINGS_RECHDRLEN - len);
+        }
+        else
+        {
+            vcDrop(aKey);
         }
 
-        error = (status == NVINTF_SUCCESS ? error : OT_ERROR_NOT_FOUND);
+        if (status == NVINTF_NOTFOUND)
+        {
+            error = OT_ERROR_NOT_FOUND;
+        }
+        else if (status != NVINTF_SUCCESS)
+        {
+            settingsResync();
+            error = OT_ERROR_FAILED;
+        }
     }
 
     return(error);
@@ -366,6 +1494,14 @@ void otPlatSettingsWipe(otInstance *aInstance)
     NVINTF_nvProxy_t nvProxy = {0};
     uint8_t status           = NVINTF_SUCCESS;
 
+    /* Pending changes are wiped as well */
+    sStageLen    = 0;
+    sInChange    = false;
+    sCacheCount  = -1;
+    sValCacheLen = 0;
+    memset(sSubIdMap, 0, sizeof(sSubIdMap));
+    memset(sMapOver, 0, sizeof(sMapOver));
+
     /* Setup doNext call */
     nvProxy.sysid = NVINTF_SYSID_TIOP;
     nvProxy.flag  = NVINTF_DOSTART | NVINTF_DOSYSID | NVINTF_DODELETE;
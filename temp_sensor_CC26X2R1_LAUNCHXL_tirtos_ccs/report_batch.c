@@ -0,0 +1,164 @@
+/******************************************************************************
+
+ @file report_batch.c
+
+ @brief Ring of temperature samples and their batched report payload
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+/******************************************************************************
+ Includes
+ *****************************************************************************/
+#include <stddef.h>
+
+#include "report_batch.h"
+
+/******************************************************************************
+ External Functions
+ *****************************************************************************/
+
+/*
+ * Documented in report_batch.h
+ */
+void ReportBatch_init(ReportBatch_t *batch, ReportBatch_sample_t *ring,
+                      uint8_t size)
+{
+    batch->ring  = ring;
+    batch->size  = size;
+    batch->head  = 0;
+    batch->count = 0;
+}
+
+/*
+ * Documented in report_batch.h
+ */
+void ReportBatch_add(ReportBatch_t *batch, int16_t value, uint32_t time)
+{
+    ReportBatch_sample_t *sample = &batch->ring[batch->head];
+
+    sample->time  = time;
+    sample->value = value;
+    batch->head = (batch->head + 1) % batch->size;
+    if(batch->count < batch->size)
+    {
+        batch->count++;
+    }
+}
+
+/*
+ * Documented in report_batch.h
+ */
+uint16_t ReportBatch_encode(const ReportBatch_t *batch, uint8_t *buf,
+                            uint32_t now)
+{
+    uint8_t i;
+    uint16_t len = 0;
+    uint8_t idx = (batch->head + batch->size - batch->count) % batch->size;
+
+    buf[len++] = REPORT_BATCH_FORMAT;
+    buf[len++] = batch->count;
+    buf[len++] = (uint8_t)(now >> 24);
+    buf[len++] = (uint8_t)(now >> 16);
+    buf[len++] = (uint8_t)(now >> 8);
+    buf[len++] = (uint8_t)now;
+
+    for(i = 0; i < batch->count; i++)
+    {
+        const ReportBatch_sample_t *sample = &batch->ring[idx];
+        uint32_t age = (now - sample->time) / REPORT_BATCH_AGE_UNIT;
+
+        if(age > REPORT_BATCH_AGE_MAX)
+        {
+            age = REPORT_BATCH_AGE_MAX;
+        }
+        buf[len++] = (uint8_t)(age >> 8);
+        buf[len++] = (uint8_t)age;
+        buf[len++] = (uint8_t)((uint16_t)sample->value >> 8);
+        buf[len++] = (uint8_t)sample->value;
+        idx = (idx + 1) % batch->size;
+    }
+
+    return len;
+}
+
+/*
+ * Documented in report_batch.h
+ */
+void ReportBatch_clear(ReportBatch_t *batch)
+{
+    batch->count = 0;
+}
+
+/*
+ * Documented in report_batch.h
+ */
+int ReportBatch_decode(const uint8_t *buf, uint16_t len, uint32_t *now,
+                       ReportBatch_sample_t *samples, uint8_t max)
+{
+    uint8_t i;
+    uint8_t count;
+
+    if((len < REPORT_BATCH_HDR_LEN) || (buf[0] != REPORT_BATCH_FORMAT))
+    {
+        return -1;
+    }
+
+    count = buf[1];
+    if((len != REPORT_BATCH_LEN(count)) || (count > max))
+    {
+        return -1;
+    }
+
+    *now = ((uint32_t)buf[2] << 24) | ((uint32_t)buf[3] << 16) |
+           ((uint32_t)buf[4] << 8) | buf[5];
+    buf += REPORT_BATCH_HDR_LEN;
+
+    for(i = 0; i < count; i++)
+    {
+        uint16_t age = ((uint16_t)buf[0] << 8) | buf[1];
+
+        samples[i].time  = *now - ((uint32_t)age * REPORT_BATCH_AGE_UNIT);
+        samples[i].value = (int16_t)(((uint16_t)buf[2] << 8) | buf[3]);
+        buf += REPORT_BATCH_SAMPLE_LEN;
+    }
+
+    return count;
+}
@@ -0,0 +1,161 @@
+/******************************************************************************
+
+ @file report_batch.h
+
+ @brief Ring of temperature samples and their batched report payload
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+#ifndef REPORT_BATCH_H
+#define REPORT_BATCH_H
+
+/******************************************************************************
+ Includes
+ *****************************************************************************/
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************
+ Constants and definitions
+ *****************************************************************************/
+
+/* Batched report payload: format, sample count and report time, followed by
+ * the age and value of each sample, oldest first, all big endian */
+#define REPORT_BATCH_FORMAT     1
+#define REPORT_BATCH_HDR_LEN    6
+#define REPORT_BATCH_SAMPLE_LEN 4
+
+/* Sample ages are in units of 100 ms, older samples have the largest age */
+#define REPORT_BATCH_AGE_UNIT   100
+#define REPORT_BATCH_AGE_MAX    0xFFFF
+
+/* Payload length of a report of n samples */
+#define REPORT_BATCH_LEN(n)     (REPORT_BATCH_HDR_LEN + \
+                                 (REPORT_BATCH_SAMPLE_LEN * (n)))
+
+/******************************************************************************
+ Typedefs
+ *****************************************************************************/
+
+/* One sample */
+typedef struct
+{
+    uint32_t time;      /* milliseconds since boot */
+    int16_t  value;
+} ReportBatch_sample_t;
+
+/* Samples not reported yet, the ring overwrites the oldest one when full */
+typedef struct
+{
+    ReportBatch_sample_t *ring;
+    uint8_t  size;      /* number of samples the ring holds */
+    uint8_t  head;      /* next sample to write */
+    uint8_t  count;     /* samples not reported yet */
+} ReportBatch_t;
+
+/******************************************************************************
+ External Functions
+ *****************************************************************************/
+/**
+ * @brief   Initialize an empty sample ring.
+ *
+ * @param   batch - ring state
+ * @param   ring  - storage of size samples, must stay valid
+ * @param   size  - number of samples, 1 to 255
+ */
+extern void ReportBatch_init(ReportBatch_t *batch, ReportBatch_sample_t *ring,
+                             uint8_t size);
+
+/**
+ * @brief   Add a sample, overwriting the oldest one when the ring is full.
+ *
+ * @param   batch - ring state
+ * @param   value - sampled value
+ * @param   time  - sample time in milliseconds
+ */
+extern void ReportBatch_add(ReportBatch_t *batch, int16_t value,
+                            uint32_t time);
+
+/**
+ * @brief   Encode the samples in the ring as a batched report payload. The
+ *          samples stay in the ring until ReportBatch_clear().
+ *
+ * @param   batch - ring state
+ * @param   buf   - buffer of at least REPORT_BATCH_LEN(batch->size) bytes
+ * @param   now   - report time in milliseconds
+ *
+ * @return  Payload length
+ */
+extern uint16_t ReportBatch_encode(const ReportBatch_t *batch, uint8_t *buf,
+                                   uint32_t now);
+
+/**
+ * @brief   Drop the samples in the ring once they have been reported.
+ *
+ * @param   batch - ring state
+ */
+extern void ReportBatch_clear(ReportBatch_t *batch);
+
+/**
+ * @brief   Decode a batched report payload, as the receiver of the reports
+ *          does. Sample times are the report time less the sample age, so
+ *          they are up to REPORT_BATCH_AGE_UNIT - 1 ms later than sampled.
+ *
+ * @param   buf     - payload
+ * @param   len     - payload length
+ * @param   now     - returns the report time
+ * @param   samples - returns the samples, oldest first
+ * @param   max     - number of samples that fit in samples
+ *
+ * @return  Number of samples, -1 if the payload is malformed or does not fit
+ */
+extern int ReportBatch_decode(const uint8_t *buf, uint16_t len,
+                              uint32_t *now, ReportBatch_sample_t *samples,
+                              uint8_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REPORT_BATCH_H */
@@ -0,0 +1,169 @@
+/******************************************************************************
+
+ @file report_policy.c
+
+ @brief Change driven reporting policy for sensor values
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+/******************************************************************************
+ Includes
+ *****************************************************************************/
+#include <stddef.h>
+
+#include "report_policy.h"
+
+/******************************************************************************
+ Local Functions
+ *****************************************************************************/
+
+/**
+ * @brief Checks if a value moved far enough from the last reported value.
+ *        Turning back from the direction of the last reported change takes
+ *        the hysteresis on top of the deadband, so a value that toggles
+ *        between two readings is not reported on every toggle.
+ *
+ * @param policy policy state
+ * @param value  sampled value
+ *
+ * @return true if the change is significant
+ */
+static bool ReportPolicy_changed(const ReportPolicy_t *policy, int32_t value)
+{
+    const ReportPolicy_config_t *config = policy->config;
+    int32_t diff = value - policy->lastValue;
+    int32_t last = policy->lastValue;
+    int8_t dir = (diff > 0) ? 1 : -1;
+
+    if(0 == diff)
+    {
+        return false;
+    }
+
+    if(diff < 0)
+    {
+        diff = -diff;
+    }
+    if(last < 0)
+    {
+        last = -last;
+    }
+    if(dir == -policy->lastDir)
+    {
+        diff -= config->hysteresis;
+    }
+
+    if(diff <= 0)
+    {
+        /* within the hysteresis, also for a relative deadband around 0 */
+        return false;
+    }
+
+    if((0 == config->absDeadband) && (0 == config->relDeadband))
+    {
+        /* no deadband, any change counts */
+        return true;
+    }
+
+    return (((config->absDeadband != 0) && (diff >= config->absDeadband)) ||
+            ((config->relDeadband != 0) &&
+             ((int64_t)diff * 100 >= (int64_t)last * config->relDeadband)));
+}
+
+/******************************************************************************
+ External Functions
+ *****************************************************************************/
+
+/*
+ * Documented in report_policy.h
+ */
+void ReportPolicy_init(ReportPolicy_t *policy,
+                       const ReportPolicy_config_t *config)
+{
+    policy->config    = config;
+    policy->lastValue = 0;
+    policy->lastTime  = 0;
+    policy->lastDir   = 0;
+    policy->reported  = false;
+    policy->pending   = false;
+}
+
+/*
+ * Documented in report_policy.h
+ */
+uint32_t ReportPolicy_sample(ReportPolicy_t *policy, int32_t value,
+                             uint32_t now)
+{
+    uint32_t elapsed = now - policy->lastTime;
+    uint32_t limit;
+
+    if(!policy->reported)
+    {
+        return 0;
+    }
+
+    if(ReportPolicy_changed(policy, value))
+    {
+        /* reported once the minimum interval is over, even if it goes back */
+        policy->pending = true;
+    }
+
+    limit = policy->pending ? policy->config->minInterval :
+                              policy->config->maxInterval;
+
+    return (elapsed >= limit) ? 0 : (limit - elapsed);
+}
+
+/*
+ * Documented in report_policy.h
+ */
+void ReportPolicy_reported(ReportPolicy_t *policy, int32_t value,
+                           uint32_t now)
+{
+    if(policy->reported && (value != policy->lastValue))
+    {
+        policy->lastDir = (value > policy->lastValue) ? 1 : -1;
+    }
+    policy->lastValue = value;
+    policy->lastTime  = now;
+    policy->reported  = true;
+    policy->pending   = false;
+}
@@ -0,0 +1,124 @@
+/******************************************************************************
+
+ @file report_policy.h
+
+ @brief Change driven reporting policy for sensor values
+
+ Group: CMCU, LPC
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2017-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+#ifndef REPORT_POLICY_H
+#define REPORT_POLICY_H
+
+/******************************************************************************
+ Includes
+ *****************************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************
+ Typedefs
+ *****************************************************************************/
+
+/* Reporting policy configuration, times are in milliseconds */
+typedef struct
+{
+    int32_t  absDeadband;  /* change from the last report that is reported, 0 if unused */
+    uint16_t relDeadband;  /* same in percent of the last reported value, 0 if unused */
+    int32_t  hysteresis;   /* extra change needed when the value turns back */
+    uint32_t minInterval;  /* shortest time between two reports */
+    uint32_t maxInterval;  /* longest time between two reports (heartbeat) */
+} ReportPolicy_config_t;
+
+/* Reporting policy state of one value */
+typedef struct
+{
+    const ReportPolicy_config_t *config;
+    int32_t  lastValue;    /* last reported value */
+    uint32_t lastTime;     /* time of the last report */
+    int8_t   lastDir;      /* direction of the last reported change, 0 if none */
+    bool     reported;     /* a report has been sent */
+    bool     pending;      /* a change waits for the minimum interval */
+} ReportPolicy_t;
+
+/******************************************************************************
+ External Functions
+ *****************************************************************************/
+/**
+ * @brief   Initialize the reporting policy of a value, the first sample is
+ *          reported right away.
+ *
+ * @param   policy - policy state
+ * @param   config - policy configuration, must stay valid
+ */
+extern void ReportPolicy_init(ReportPolicy_t *policy,
+                              const ReportPolicy_config_t *config);
+
+/**
+ * @brief   Evaluate a new sample of the value.
+ *
+ * @param   policy - policy state
+ * @param   value  - sampled value
+ * @param   now    - sample time in milliseconds, may wrap around
+ *
+ * @return  Milliseconds until a report is due, 0 to report now
+ */
+extern uint32_t ReportPolicy_sample(ReportPolicy_t *policy, int32_t value,
+                                    uint32_t now);
+
+/**
+ * @brief   Record that the value has been reported.
+ *
+ * @param   policy - policy state
+ * @param   value  - reported value
+ * @param   now    - report time in milliseconds
+ */
+extern void ReportPolicy_reported(ReportPolicy_t *policy, int32_t value,
+                                  uint32_t now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REPORT_POLICY_H */
@@ -83,6 +83,34 @@ extern "C"
 #define TASK_CONFIG_TEMPSENSOR_TASK_STACK_SIZE 2048
 #endif
 
+/**
+ * Priority of the NV task, which does the queued Flash operations.
+ */
+#ifndef TASK_CONFIG_NV_TASK_PRIORITY
+#define TASK_CONFIG_NV_TASK_PRIORITY    1
+#endif
+
+/**
+ * Size of the NV task call stack.
+ */
+#ifndef TASK_CONFIG_NV_TASK_STACK_SIZE
+#define TASK_CONFIG_NV_TASK_STACK_SIZE  1024
+#endif
+
+/**
+ * Priority of the NV log task, which programs and erases the external Flash.
+ */
+#ifndef TASK_CONFIG_NVLOG_TASK_PRIORITY
+#define TASK_CONFIG_NVLOG_TASK_PRIORITY    1
+#endif
+
+/**
+ * Size of the NV log task call stack.
+ */
+#ifndef TASK_CONFIG_NVLOG_TASK_STACK_SIZE
+#define TASK_CONFIG_NVLOG_TASK_STACK_SIZE  1024
+#endif
+
 /******************************************************************************
  External functions
  *****************************************************************************/
@@ -97,6 +125,16 @@ extern void OtStack_taskCreate(void);
  */
 extern void TempSensor_taskCreate(void);
 
+/**
+ * Creation function for the NV task.
+ */
+extern void NVQUEUE_taskCreate(void);
+
+/**
+ * Creation function for the NV log task.
+ */
+extern void NVLOG_taskCreate(void);
+
 #ifdef __cplusplus
 }
 #endif
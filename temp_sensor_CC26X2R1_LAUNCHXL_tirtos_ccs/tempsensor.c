@@ -96,6 +96,16 @@
 #include "disp_utils.h"
 #include "keys_utils.h"
 #include "otstack.h"
+#include "report_policy.h"
+#include "report_batch.h"
+#include "coap_observe.h"
+#include "cbor.h"
+#include "coap_template.h"
+
+#ifdef NVOCTP_STATS
+#include "platform/nv/nvoctp.h"
+#include "platform/nv/nvqueue.h"
+#endif
 
 /* Private configuration Header files */
 #include "task_config.h"
@@ -116,19 +126,81 @@
 /* report attribute */
 #define ATTR_REPORT   0x04
 
-/* Reporting interval in milliseconds */
+/* Sampling interval in milliseconds */
+#ifndef TIOP_TEMPSENSOR_SAMPLING_INTERVAL
+#define TIOP_TEMPSENSOR_SAMPLING_INTERVAL  10000
+#endif
+
+/* Number of samples held for one report */
+#ifndef TIOP_TEMPSENSOR_REPORT_SAMPLES
+#define TIOP_TEMPSENSOR_REPORT_SAMPLES     8
+#endif
+
+/* Longest time between two reports (heartbeat) in milliseconds */
 #ifndef TIOP_TEMPSENSOR_REPORTING_INTERVAL
-#define TIOP_TEMPSENSOR_REPORTING_INTERVAL 10000
+#define TIOP_TEMPSENSOR_REPORTING_INTERVAL 900000
+#endif
+
+/* Shortest time between two reports in milliseconds */
+#ifndef TIOP_TEMPSENSOR_REPORT_MIN_INTERVAL
+#define TIOP_TEMPSENSOR_REPORT_MIN_INTERVAL 30000
+#endif
+
+/* Temperature change in degrees F that is reported, 0 if unused */
+#ifndef TIOP_TEMPSENSOR_REPORT_DEADBAND
+#define TIOP_TEMPSENSOR_REPORT_DEADBAND    1
+#endif
+
+/* Temperature change in percent that is reported, 0 if unused */
+#ifndef TIOP_TEMPSENSOR_REPORT_DEADBAND_PCT
+#define TIOP_TEMPSENSOR_REPORT_DEADBAND_PCT 0
+#endif
+
+/* Extra change in degrees F needed when the temperature turns back */
+#ifndef TIOP_TEMPSENSOR_REPORT_HYSTERESIS
+#define TIOP_TEMPSENSOR_REPORT_HYSTERESIS  1
+#endif
+
+/* Battery voltage in millivolts below which the status flags a low battery */
+#ifndef TIOP_TEMPSENSOR_LOW_BATTERY
+#define TIOP_TEMPSENSOR_LOW_BATTERY        2000
+#endif
+
+#if (TIOP_TEMPSENSOR_REPORT_SAMPLES < 1) || (TIOP_TEMPSENSOR_REPORT_SAMPLES > 255)
+#error "TIOP_TEMPSENSOR_REPORT_SAMPLES must be 1 to 255"
 #endif
 
+/* Max-Age of the temperature notifications in seconds, a stable temperature
+ * is notified on the first sample after the heartbeat interval */
+#define OBSERVE_MAX_AGE         ((TIOP_TEMPSENSOR_REPORTING_INTERVAL + \
+                                  (2 * TIOP_TEMPSENSOR_SAMPLING_INTERVAL)) / 1000)
+
+/* Content-Formats of the temperature resource, text when no Accept option */
+#define TEMP_FORMAT_TEXT        0   /* text/plain;charset=utf-8 */
+#define TEMP_FORMAT_CBOR        60  /* application/cbor */
+
+/* Keys of the CBOR temperature map */
+#define TEMP_KEY_VALUE          1   /* decimal fraction [exponent, mantissa] */
+#define TEMP_KEY_UNIT           2   /* unit name */
+#define TEMP_KEY_TIME           3   /* sample time, milliseconds since boot */
+#define TEMP_KEY_SEQ            4   /* sample sequence number */
+#define TEMP_KEY_STATUS         5   /* device status flags */
+#define TEMP_KEYS               5
+
+/* Value in whole degrees Celsius, the resolution of the BATMON sensor */
+#define TEMP_EXPONENT           0
+#define TEMP_UNIT               "Cel"
+
+/* Device status flags */
+#define TEMP_STATUS_STALE       0x01 /* no new reading since the last sample */
+#define TEMP_STATUS_LOW_BATTERY 0x02 /* battery below TIOP_TEMPSENSOR_LOW_BATTERY */
+
 /* Address to report temperature */
 #ifndef TIOP_TEMPSENSOR_REPORTING_ADDRESS
 #define TIOP_TEMPSENSOR_REPORTING_ADDRESS  "ff03::1"
 #define TIOP_OWN_REPORTING_ADDRESS "64:ff9b::8e5d:886d"
 #endif
 
-#define DEFAULT_COAP_HEADER_TOKEN_LEN      2
-
 /* coap attribute descriptor */
 typedef struct
 {
@@ -145,6 +217,30 @@ typedef struct
 /* Timer ID */
 static timer_t reportTimerID;
 
+/* Sampling timer ID */
+static timer_t sampleTimerID;
+
+/* Set once the reporting timer has been started */
+static bool reporting;
+
+/* Reporting policy of the temperature */
+static const ReportPolicy_config_t reportConfig = {
+    TIOP_TEMPSENSOR_REPORT_DEADBAND,
+    TIOP_TEMPSENSOR_REPORT_DEADBAND_PCT,
+    TIOP_TEMPSENSOR_REPORT_HYSTERESIS,
+    TIOP_TEMPSENSOR_REPORT_MIN_INTERVAL,
+    TIOP_TEMPSENSOR_REPORTING_INTERVAL,
+};
+static ReportPolicy_t reportPolicy;
+
+/* Observers of the temperature resource, notified by the same policy */
+static CoapObserve_t tempObservers;
+static ReportPolicy_t observePolicy;
+
+/* Samples in degrees Fahrenheit not reported yet */
+static ReportBatch_sample_t sampleRing[TIOP_TEMPSENSOR_REPORT_SAMPLES];
+static ReportBatch_t samples;
+
 /* Global IPv6 address configured via SLAAC update */
 static otIp6Address globalAddress;
 
@@ -154,6 +250,10 @@ static otIp6Address thermostatAddress;
 /* Port to report the temperature to */
 static uint16_t peerPort = OT_DEFAULT_COAP_PORT;
 
+/* Report requests to the thermostat and to the own reporting address */
+static CoapTemplate_t reportTemplate;
+static CoapTemplate_t ownTemplate;
+
 /* TI-RTOS events structure for passing state to the processing loop */
 static Event_Struct tempSensorEvents;
 
@@ -163,10 +263,24 @@ static char stack[TASK_CONFIG_TEMPSENSOR_TASK_STACK_SIZE];
 /* coap resource for the application */
 static otCoapResource coapResource;
 
+/* coap resource for the temperature value */
+static otCoapResource tempResource;
+
+#ifdef NVOCTP_STATS
+/* coap resource for the NV driver diagnostics */
+static otCoapResource nvDiagResource;
+#endif
+
 /* coap attribute state of the application */
 static uint8_t attrTemperature[11] = "70";
 static int temperatureValue = 70;
 
+/* last sample for the CBOR representation */
+static int32_t temperatureCelsius = 21;
+static uint32_t sampleTime;
+static uint32_t sampleSeq;
+static uint8_t sampleStatus;
+
 /* coap attribute descriptor for the application */
 const attrDesc_t coapAttr = {
     TEMPSENSOR_TEMP_URI,
@@ -188,6 +302,11 @@ static bool serverSetup;
 static void *TempSensor_task(void *arg0);
 /* Timeout callback for reporting. */
 static void reportingTimeoutCB(union sigval val);
+/* Timeout callback for sampling. */
+static void samplingTimeoutCB(union sigval val);
+/* Encodes the temperature resource. */
+static uint16_t tempSensorEncodeValue(uint16_t format, uint8_t *buf,
+                                      uint16_t size);
 
 /******************************************************************************
  Local Functions
@@ -209,6 +328,42 @@ static void configureReportingTimer(void)
     timer_create(CLOCK_MONOTONIC, &event, &reportTimerID);
 }
 
+/**
+ * @brief Configure and start the periodic sampling timer.
+ *
+ * @return None
+ */
+static void startSamplingTimer(void)
+{
+    struct sigevent event =
+    {
+        .sigev_notify_function = samplingTimeoutCB,
+        .sigev_notify          = SIGEV_SIGNAL,
+    };
+    struct itimerspec period = {0};
+
+    period.it_value.tv_sec  = (TIOP_TEMPSENSOR_SAMPLING_INTERVAL / 1000U);
+    period.it_value.tv_nsec = ((TIOP_TEMPSENSOR_SAMPLING_INTERVAL % 1000U) *
+                               1000000U);
+    period.it_interval = period.it_value;
+
+    timer_create(CLOCK_MONOTONIC, &event, &sampleTimerID);
+    timer_settime(sampleTimerID, 0, &period, NULL);
+}
+
+/**
+ * @brief Milliseconds since boot, wraps around after 49 days.
+ *
+ * @return Current time
+ */
+static uint32_t getTimeMs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint32_t)now.tv_sec * 1000U) + (uint32_t)(now.tv_nsec / 1000000U);
+}
+
 /**
 * Handler for ICMPv6 messages.
 */
@@ -254,6 +409,7 @@ static void startReportingTimer(uint32_t timeout)
 
     /* Arm timer */
     timer_settime(reportTimerID, 0, &newTime, NULL);
+    reporting = true;
 }
 
 /**
@@ -272,128 +428,199 @@ static void reportingTimeoutCB(union sigval val)
 }
 
 /**
- * @brief Reports the temperature to another coap device.
+ * @brief Callback function of the sampling timer.
+ *
+ * @param val Argument passed by the clock if set up.
  *
  * @return None
  */
-static void tempSensorReport(void)
+static void samplingTimeoutCB(union sigval val)
 {
-    otError error = OT_ERROR_NONE;
-    otMessage *requestMessage = NULL;
-    otMessageInfo messageInfo;
-    otCoapHeader requestHeader;
-    otInstance *instance = OtInstance_get();
-    int32_t celsiusTemp;
+    TempSensor_postEvt(TempSensor_evtSampleTemp);
 
-    /* make sure there is a new temperature reading otherwise just report the previous temperature */
+    (void) val;
+}
+
+/**
+ * @brief Reads the temperature into the sample ring. Once reporting has
+ *        started, the reporting policy decides when the next report is due,
+ *        a ring full of unreported samples is reported right away.
+ *
+ * @return None
+ */
+static void tempSensorSample(void)
+{
+    uint32_t now = getTimeMs();
+    uint8_t status = 0;
+    int32_t celsius = temperatureCelsius;
+    int fahrenheit = temperatureValue;
+
+    /* make sure there is a new temperature reading otherwise just sample the previous temperature */
     if(AONBatMonNewTempMeasureReady())
     {
         /* Read the temperature in degrees C from the internal temp sensor */
-        celsiusTemp = AONBatMonTemperatureGetDegC();
+        celsius = AONBatMonTemperatureGetDegC();
 
         /* convert temp to Fahrenheit */
-        temperatureValue = (int)((celsiusTemp * 9) / 5) + 32;
-        /* convert temperature to string attribute */
-        snprintf((char*)attrTemperature, sizeof(attrTemperature), "%d",
-                 temperatureValue);
+        fahrenheit = (int)((celsius * 9) / 5) + 32;
+    }
+    else
+    {
+        status |= TEMP_STATUS_STALE;
     }
 
-    /* print the reported value to the terminal */
-    DISPUTILS_SERIALPRINTF(0, 0, "Reporting Temperature:");
-    DISPUTILS_SERIALPRINTF(0, 0, (char*)attrTemperature);
-
+    /* battery voltage has 8 fractional bits */
+    if(((AONBatMonBatteryVoltageGet() * 1000U) >> 8) <
+       TIOP_TEMPSENSOR_LOW_BATTERY)
+    {
+        status |= TEMP_STATUS_LOW_BATTERY;
+    }
 
-    OtRtosApi_lock();
-    otCoapHeaderInit(&requestHeader, OT_COAP_TYPE_NON_CONFIRMABLE, OT_COAP_CODE_POST);
-    otCoapHeaderGenerateToken(&requestHeader, DEFAULT_COAP_HEADER_TOKEN_LEN);
-    error = otCoapHeaderAppendUriPathOptions(&requestHeader,
-                                             THERMOSTAT_TEMP_URI);
-    OtRtosApi_unlock();
-    otEXPECT(OT_ERROR_NONE == error);
+    ReportBatch_add(&samples, (int16_t)fahrenheit, now);
 
+    /* the representations are read by the CoAP server, one significant
+     * change is notified to all observers at once */
     OtRtosApi_lock();
-    otCoapHeaderSetPayloadMarker(&requestHeader);
-    requestMessage = otCoapNewMessage(instance, &requestHeader);
-    OtRtosApi_unlock();
-    otEXPECT_ACTION(requestMessage != NULL, error = OT_ERROR_NO_BUFS);
-
-    OtRtosApi_lock();
-    error = otMessageAppend(requestMessage, attrTemperature,
-                            strlen((const char*) attrTemperature));
+    temperatureCelsius = celsius;
+    temperatureValue = fahrenheit;
+    snprintf((char*)attrTemperature, sizeof(attrTemperature), "%d",
+             temperatureValue);
+    sampleTime = now;
+    sampleSeq++;
+    sampleStatus = status;
+    if((CoapObserve_count(&tempObservers) != 0) &&
+       (0 == ReportPolicy_sample(&observePolicy, fahrenheit, now)))
+    {
+        CoapObserve_notify(&tempObservers, tempSensorEncodeValue, now);
+        ReportPolicy_reported(&observePolicy, fahrenheit, now);
+    }
     OtRtosApi_unlock();
-    otEXPECT(OT_ERROR_NONE == error);
 
-    memset(&messageInfo, 0, sizeof(messageInfo));
-    messageInfo.mPeerAddr = thermostatAddress;
-    messageInfo.mPeerPort = peerPort;
-    messageInfo.mInterfaceId = OT_NETIF_INTERFACE_ID_THREAD;
+    if(reporting)
+    {
+        uint32_t due = ReportPolicy_sample(&reportPolicy, fahrenheit, now);
 
-    OtRtosApi_lock();
-    error = otCoapSendRequest(instance, requestMessage, &messageInfo, NULL,
-                              NULL);
-    OtRtosApi_unlock();
+        /* the next sample would overwrite the oldest unreported one */
+        if((0 == due) || (TIOP_TEMPSENSOR_REPORT_SAMPLES == samples.count))
+        {
+            TempSensor_postEvt(TempSensor_evtReportTemp);
+        }
+        else
+        {
+            startReportingTimer(due);
+        }
+    }
+}
 
-    /* Restart the clock */
-    startReportingTimer(TIOP_TEMPSENSOR_REPORTING_INTERVAL);
-    exit:
+/**
+ * @brief Encodes the last sample as a representation of the temperature
+ *        resource. Text is the temperature in degrees Fahrenheit, CBOR is a
+ *        map of the value in whole degrees Celsius, the resolution of the
+ *        sensor, the unit, the sample time, the sample sequence number and
+ *        the device status.
+ *
+ * @param format Content-Format, TEMP_FORMAT_TEXT or TEMP_FORMAT_CBOR.
+ * @param buf    Output buffer.
+ * @param size   Size of the output buffer.
+ *
+ * @return Length of the representation, 0 if the format is not supported
+ */
+static uint16_t tempSensorEncodeValue(uint16_t format, uint8_t *buf,
+                                      uint16_t size)
+{
+    Cbor_writer_t writer;
+    uint16_t len = 0;
 
-    if(error != OT_ERROR_NONE && requestMessage != NULL)
+    switch(format)
     {
-        OtRtosApi_lock();
-        otMessageFree(requestMessage);
-        OtRtosApi_unlock();
-    }
-}
+    case TEMP_FORMAT_TEXT:
+        len = strlen((const char*)attrTemperature);
+        if(len <= size)
+        {
+            memcpy(buf, attrTemperature, len);
+        }
+        else
+        {
+            len = 0;
+        }
+        break;
 
-static void sendMessage(void) {
+    case TEMP_FORMAT_CBOR:
+        Cbor_writerInit(&writer, buf, size);
+        Cbor_putMap(&writer, TEMP_KEYS);
+        Cbor_putUint(&writer, TEMP_KEY_VALUE);
+        Cbor_putTag(&writer, CBOR_TAG_DECIMAL_FRACTION);
+        Cbor_putArray(&writer, 2);
+        Cbor_putInt(&writer, TEMP_EXPONENT);
+        Cbor_putInt(&writer, temperatureCelsius);
+        Cbor_putUint(&writer, TEMP_KEY_UNIT);
+        Cbor_putText(&writer, TEMP_UNIT, sizeof(TEMP_UNIT) - 1);
+        Cbor_putUint(&writer, TEMP_KEY_TIME);
+        Cbor_putUint(&writer, sampleTime);
+        Cbor_putUint(&writer, TEMP_KEY_SEQ);
+        Cbor_putUint(&writer, sampleSeq);
+        Cbor_putUint(&writer, TEMP_KEY_STATUS);
+        Cbor_putUint(&writer, sampleStatus);
+        len = Cbor_writerLen(&writer);
+        break;
 
+    default:
+        break;
+    }
 
-    otError error = OT_ERROR_NONE;
-    otMessage *requestMessage = NULL;
-    otMessageInfo messageInfo;
-    otCoapHeader requestHeader;
-    otInstance *instance = OtInstance_get();
+    return len;
+}
 
-    /* print the reported value to the terminal */
-    DISPUTILS_SERIALPRINTF(0, 0, "Attempting to send coap:");
+/**
+ * @brief Reports the sampled temperatures to another coap device, in one
+ *        message.
+ *
+ * @return None
+ */
+static void tempSensorReport(void)
+{
+    uint8_t payload[REPORT_BATCH_LEN(TIOP_TEMPSENSOR_REPORT_SAMPLES)];
+    uint16_t payloadLen;
 
-    OtRtosApi_lock();
-    otCoapHeaderInit(&requestHeader, OT_COAP_TYPE_NON_CONFIRMABLE, OT_COAP_CODE_POST);
-    otCoapHeaderGenerateToken(&requestHeader, DEFAULT_COAP_HEADER_TOKEN_LEN);
-    error = otCoapHeaderAppendUriPathOptions(&requestHeader,
-                                             THERMOSTAT_TEMP_URI);
-    OtRtosApi_unlock();
-    otEXPECT(OT_ERROR_NONE == error);
+    /* Restart the clock */
+    startReportingTimer(TIOP_TEMPSENSOR_REPORTING_INTERVAL);
 
-    OtRtosApi_lock();
-    otCoapHeaderSetPayloadMarker(&requestHeader);
-    requestMessage = otCoapNewMessage(instance, &requestHeader);
-    OtRtosApi_unlock();
-    otEXPECT_ACTION(requestMessage != NULL, error = OT_ERROR_NO_BUFS);
+    /* reported on a sample, nothing sampled since */
+    if(0 == samples.count)
+    {
+        return;
+    }
 
-    OtRtosApi_lock();
-    error = otMessageAppend(requestMessage, attrTemperature,
-                            strlen((const char*) attrTemperature));
-    OtRtosApi_unlock();
-    otEXPECT(OT_ERROR_NONE == error);
+    payloadLen = ReportBatch_encode(&samples, payload, getTimeMs());
 
-    memset(&messageInfo, 0, sizeof(messageInfo));
-    otIp6AddressFromString(TIOP_OWN_REPORTING_ADDRESS, &messageInfo.mPeerAddr);
-    messageInfo.mInterfaceId = OT_NETIF_INTERFACE_ID_THREAD;
+    /* print the reported value to the terminal */
+    DISPUTILS_SERIALPRINTF(0, 0, "Reporting %d samples, last:",
+                           samples.count);
+    DISPUTILS_SERIALPRINTF(0, 0, (char*)attrTemperature);
 
-    OtRtosApi_lock();
-    error = otCoapSendRequest(instance, requestMessage, &messageInfo, NULL, NULL);
-    OtRtosApi_unlock();
+    if(OT_ERROR_NONE == CoapTemplate_send(&reportTemplate, payload, payloadLen))
+    {
+        /* samples are on their way, a failed send keeps them for the next report */
+        ReportBatch_clear(&samples);
+        ReportPolicy_reported(&reportPolicy, temperatureValue, getTimeMs());
+    }
+}
 
+/**
+ * @brief Sends the current temperature to the own reporting address.
+ *
+ * @return None
+ */
+static void sendMessage(void)
+{
     /* print the reported value to the terminal */
-       DISPUTILS_SERIALPRINTF(0, 0, "Message Send!");
+    DISPUTILS_SERIALPRINTF(0, 0, "Attempting to send coap:");
 
-    exit:
-    if(error != OT_ERROR_NONE && requestMessage != NULL)
+    if(OT_ERROR_NONE == CoapTemplate_send(&ownTemplate, attrTemperature,
+                                          strlen((const char*)attrTemperature)))
     {
-        OtRtosApi_lock();
-        otMessageFree(requestMessage);
-        OtRtosApi_unlock();
+        /* print the reported value to the terminal */
+        DISPUTILS_SERIALPRINTF(0, 0, "Message Send!");
     }
 }
 
@@ -460,6 +687,147 @@ exit:
     }
 }
 
+/**
+ * @brief Callback function registered with the Coap server.
+ *        Responds to a GET with the current temperature, as text or as CBOR
+ *        when asked for with the Accept option. A GET with the Observe
+ *        option registers or deregisters the client as an observer of the
+ *        temperature.
+ *
+ * @param  aContext      A pointer to the context information.
+ * @param  aHeader       A pointer to the CoAP header.
+ * @param  aMessage      A pointer to the message.
+ * @param  aMessageInfo  A pointer to the message info.
+ *
+ * @return None
+ */
+static void coapHandleTemperature(void *aContext, otCoapHeader *aHeader,
+                                  otMessage *aMessage,
+                                  const otMessageInfo *aMessageInfo)
+{
+    otError error = OT_ERROR_NONE;
+    otCoapHeader responseHeader;
+    otMessage *responseMessage = NULL;
+    otCoapType responseType = OT_COAP_TYPE_NON_CONFIRMABLE;
+    uint32_t format = TEMP_FORMAT_TEXT;
+    uint8_t payload[COAP_OBSERVE_PAYLOAD_MAX];
+    uint16_t payloadLen = 0;
+    bool observed;
+
+    otEXPECT(OT_COAP_CODE_GET == otCoapHeaderGetCode(aHeader));
+
+    if(OT_COAP_TYPE_CONFIRMABLE == otCoapHeaderGetType(aHeader))
+    {
+        responseType = OT_COAP_TYPE_ACKNOWLEDGMENT;
+    }
+
+    (void)CoapObserve_getOption(aHeader, OT_COAP_OPTION_ACCEPT, &format);
+    if(format <= UINT16_MAX)
+    {
+        payloadLen = tempSensorEncodeValue((uint16_t)format, payload,
+                                           sizeof(payload));
+    }
+
+    otCoapHeaderInit(&responseHeader, responseType,
+                     (payloadLen != 0) ? OT_COAP_CODE_CONTENT :
+                                         OT_COAP_CODE_NOT_ACCEPTABLE);
+    otCoapHeaderSetMessageId(&responseHeader,
+                             otCoapHeaderGetMessageId(aHeader));
+    otCoapHeaderSetToken(&responseHeader, otCoapHeaderGetToken(aHeader),
+                         otCoapHeaderGetTokenLength(aHeader));
+
+    if(payloadLen != 0)
+    {
+        observed = (CoapObserve_count(&tempObservers) != 0);
+        if(CoapObserve_request(&tempObservers, aHeader, aMessageInfo,
+                               &responseHeader, (uint16_t)format,
+                               getTimeMs()) && !observed)
+        {
+            /* the first observer gets the current value in this response */
+            ReportPolicy_reported(&observePolicy, temperatureValue,
+                                  getTimeMs());
+        }
+        otCoapHeaderSetPayloadMarker(&responseHeader);
+    }
+
+    responseMessage = otCoapNewMessage((otInstance*)aContext,
+                                       &responseHeader);
+    otEXPECT_ACTION(responseMessage != NULL, error = OT_ERROR_NO_BUFS);
+    if(payloadLen != 0)
+    {
+        error = otMessageAppend(responseMessage, payload, payloadLen);
+        otEXPECT(OT_ERROR_NONE == error);
+    }
+
+    error = otCoapSendResponse((otInstance*)aContext, responseMessage,
+                               aMessageInfo);
+    otEXPECT(OT_ERROR_NONE == error);
+
+exit:
+
+    if(error != OT_ERROR_NONE && responseMessage != NULL)
+    {
+        otMessageFree(responseMessage);
+    }
+}
+
+#ifdef NVOCTP_STATS
+/**
+ * @brief Callback function registered with the Coap server.
+ *        Responds to a GET with the NV driver diagnostics, the
+ *        NVOCTP_diag_t followed by the NVQUEUE_stats_t structure.
+ *
+ * @param  aContext      A pointer to the context information.
+ * @param  aHeader       A pointer to the CoAP header.
+ * @param  aMessage      A pointer to the message.
+ * @param  aMessageInfo  A pointer to the message info.
+ *
+ * @return None
+ */
+static void coapHandleNvDiag(void *aContext, otCoapHeader *aHeader,
+                             otMessage *aMessage,
+                             const otMessageInfo *aMessageInfo)
+{
+    otError error = OT_ERROR_NONE;
+    otCoapHeader responseHeader;
+    otMessage *responseMessage = NULL;
+    NVOCTP_diag_t diags;
+    NVQUEUE_stats_t queueStats;
+
+    otEXPECT(OT_COAP_CODE_GET == otCoapHeaderGetCode(aHeader));
+
+    NVOCTP_getDiags(&diags);
+    NVQUEUE_getStats(&queueStats);
+
+    otCoapHeaderInit(&responseHeader, OT_COAP_TYPE_ACKNOWLEDGMENT,
+                     OT_COAP_CODE_CONTENT);
+    otCoapHeaderSetMessageId(&responseHeader,
+                             otCoapHeaderGetMessageId(aHeader));
+    otCoapHeaderSetToken(&responseHeader, otCoapHeaderGetToken(aHeader),
+                         otCoapHeaderGetTokenLength(aHeader));
+    otCoapHeaderSetPayloadMarker(&responseHeader);
+
+    responseMessage = otCoapNewMessage((otInstance*)aContext,
+                                       &responseHeader);
+    otEXPECT_ACTION(responseMessage != NULL, error = OT_ERROR_NO_BUFS);
+    error = otMessageAppend(responseMessage, &diags, sizeof(diags));
+    otEXPECT(OT_ERROR_NONE == error);
+    error = otMessageAppend(responseMessage, &queueStats, sizeof(queueStats));
+    otEXPECT(OT_ERROR_NONE == error);
+
+    error = otCoapSendResponse((otInstance*)aContext, responseMessage,
+                               aMessageInfo);
+    otEXPECT(OT_ERROR_NONE == error);
+
+exit:
+
+    if(error != OT_ERROR_NONE && responseMessage != NULL)
+    {
+        otMessageFree(responseMessage);
+    }
+}
+#endif
+
 /**
  * @brief sets up the application coap server.
  *
@@ -489,6 +857,25 @@ static otError setupCoapServer(otInstance *aInstance, const attrDesc_t *attr)
         otEXPECT(OT_ERROR_NONE == error);
     }
 
+    tempResource.mHandler = &coapHandleTemperature;
+    tempResource.mUriPath = TEMPSENSOR_TEMPERATURE_URI;
+    tempResource.mContext = aInstance;
+
+    OtRtosApi_lock();
+    error = otCoapAddResource(aInstance, &tempResource);
+    OtRtosApi_unlock();
+    otEXPECT(OT_ERROR_NONE == error);
+
+#ifdef NVOCTP_STATS
+    nvDiagResource.mHandler = &coapHandleNvDiag;
+    nvDiagResource.mUriPath = TEMPSENSOR_NVDIAG_URI;
+    nvDiagResource.mContext = aInstance;
+
+    OtRtosApi_lock();
+    error = otCoapAddResource(aInstance, &nvDiagResource);
+    OtRtosApi_unlock();
+#endif
+
 exit:
     return error;
 }
@@ -505,6 +892,7 @@ static void setReportingAddress(void)
     thermostatAddress = globalAddress;
     thermostatAddress.mFields.m8[OT_IP6_ADDRESS_SIZE - 1]
         = THERMOSTAT_ADDRESS_LSB;
+    CoapTemplate_setPeer(&reportTemplate, &thermostatAddress, peerPort);
     Event_post(Event_handle(&tempSensorEvents), TempSensor_evtAddressValid);
 }
 
@@ -582,9 +970,20 @@ static int processEvents(void)
                              (TempSensor_evtReportTemp | TempSensor_evtNwkSetup |
                               TempSensor_evtAddressValid | TempSensor_evtKeyRight |
                               TempSensor_evtNwkJoined | TempSensor_evtNwkJoinFailure |
-                              TempSensor_evtNotifyGlobalAddress | TempSensor_evtKeyLeft),
+                              TempSensor_evtNotifyGlobalAddress | TempSensor_evtKeyLeft |
+                              TempSensor_evtSampleTemp),
                              BIOS_WAIT_FOREVER);
 
+    if(events & TempSensor_evtSampleTemp)
+    {
+        tempSensorSample();
+    }
+
+    if(events & TempSensor_evtReportTemp)
+    {
+        tempSensorReport();
+    }
+
     if(events & TempSensor_evtNwkSetup)
     {
         if (false == serverSetup)
@@ -749,6 +1148,7 @@ void *TempSensor_task(void *arg0)
 #endif /* !TIOP_CONFIG_SET_NW_ID */
 
     otInstance *instance;
+    otIp6Address ownAddress;
     initEvent();
 
     KeysUtils_initialize(processKeyChangeCB);
@@ -796,9 +1196,25 @@ void *TempSensor_task(void *arg0)
 
     OtRtosApi_lock();
     otIp6AddressFromString(TIOP_TEMPSENSOR_REPORTING_ADDRESS, &thermostatAddress);
+    otIp6AddressFromString(TIOP_OWN_REPORTING_ADDRESS, &ownAddress);
     OtRtosApi_unlock();
 
+    /* the report requests are built once, a report only adds the payload */
+    (void)CoapTemplate_init(&reportTemplate, instance,
+                            OT_COAP_TYPE_NON_CONFIRMABLE, OT_COAP_CODE_POST,
+                            THERMOSTAT_TEMP_URI);
+    CoapTemplate_setPeer(&reportTemplate, &thermostatAddress, peerPort);
+    (void)CoapTemplate_init(&ownTemplate, instance,
+                            OT_COAP_TYPE_NON_CONFIRMABLE, OT_COAP_CODE_POST,
+                            THERMOSTAT_TEMP_URI);
+    CoapTemplate_setPeer(&ownTemplate, &ownAddress, OT_DEFAULT_COAP_PORT);
+
+    ReportBatch_init(&samples, sampleRing, TIOP_TEMPSENSOR_REPORT_SAMPLES);
+    ReportPolicy_init(&reportPolicy, &reportConfig);
+    ReportPolicy_init(&observePolicy, &reportConfig);
+    CoapObserve_init(&tempObservers, instance, OBSERVE_MAX_AGE);
     configureReportingTimer();
+    startSamplingTimer();
 
     memset(&cli_icmpHandler, sizeof(cli_icmpHandler), 0U);
        cli_icmpHandler.mReceiveCallback = cli_icmp6RxCallback;
@@ -61,6 +61,12 @@ extern "C"
 
 #define THERMOSTAT_TEMP_URI     "evaq/id"
 
+/* Temperature value, observable */
+#define TEMPSENSOR_TEMPERATURE_URI "tempsensor/temperature"
+
+/* NV driver diagnostics, for builds with NVOCTP_STATS */
+#define TEMPSENSOR_NVDIAG_URI   "tempsensor/nvdiag"
+
 #ifndef THERMOSTAT_ADDRESS_LSB
 #define THERMOSTAT_ADDRESS_LSB  7
 #endif
@@ -77,7 +83,8 @@ typedef enum
     TempSensor_evtNwkJoined            = Event_Id_04, /* Joined the network */
     TempSensor_evtNwkJoinFailure       = Event_Id_05, /* Failed joining network */
     TempSensor_evtNotifyGlobalAddress  = Event_Id_06, /* Register reporting address */
-    TempSensor_evtKeyLeft              = Event_Id_07  /* Left key is pressed */
+    TempSensor_evtKeyLeft              = Event_Id_07, /* Left key is pressed */
+    TempSensor_evtSampleTemp           = Event_Id_08  /* sampling timeout event */
 } TempSensor_evt;
 
 /******************************************************************************